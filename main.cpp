@@ -22,6 +22,7 @@
 #endif
 
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <getopt.h>
 #include <vector>
@@ -62,6 +63,10 @@
 #include "pv/util.hpp"
 #include "pv/data/segment.hpp"
 
+#ifdef ENABLE_DECODE
+#include "pv/data/decode/decodeprocess.hpp"
+#endif
+
 #ifdef ANDROID
 #include <libsigrokandroidutils/libsigrokandroidutils.h>
 #include "android/assetreader.hpp"
@@ -178,6 +183,13 @@ int main(int argc, char *argv[])
 	bool do_scan = true;
 	bool show_version = false;
 
+#ifdef ENABLE_DECODE
+	// Decoder stacks may run in helper processes, which need neither the
+	// user interface nor libsigrok
+	if ((argc == 2) && (strcmp(argv[1], pv::data::decode::DecodeProcess::WorkerOption) == 0))
+		return pv::data::decode::DecodeProcess::run_worker();
+#endif
+
 #ifdef ENABLE_FLOW
 	// Initialise gstreamermm. Must be called before any other GLib stuff.
 	Gst::init();
@@ -91,6 +91,22 @@ uint64_t Analog::max_sample_count() const
 	return l;
 }
 
+uint64_t Analog::get_memory_usage() const
+{
+	uint64_t size = 0;
+	for (const shared_ptr<AnalogSegment>& s : segments_)
+		size += s->get_memory_usage();
+	return size;
+}
+
+uint64_t Analog::get_mipmap_memory_usage() const
+{
+	uint64_t size = 0;
+	for (const shared_ptr<AnalogSegment>& s : segments_)
+		size += s->get_envelope_memory_usage();
+	return size;
+}
+
 void Analog::notify_samples_added(shared_ptr<Segment> segment, uint64_t start_sample,
 	uint64_t end_sample)
 {
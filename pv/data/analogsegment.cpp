@@ -30,8 +30,11 @@
 #include "analog.hpp"
 #include "analogsegment.hpp"
 
+using std::defer_lock;
 using std::lock_guard;
+using std::mutex;
 using std::recursive_mutex;
+using std::unique_lock;
 using std::make_pair;
 using std::max;
 using std::max_element;
@@ -54,12 +57,18 @@ AnalogSegment::AnalogSegment(Analog& owner, uint32_t segment_id, uint64_t sample
 	min_value_(0),
 	max_value_(0)
 {
-	lock_guard<recursive_mutex> lock(mutex_);
-	memset(envelope_levels_, 0, sizeof(envelope_levels_));
+	for (Envelope &e : envelope_levels_) {
+		e.length = 0;
+		e.start = 0;
+		e.data_length = 0;
+		e.samples = nullptr;
+	}
 }
 
 AnalogSegment::~AnalogSegment()
 {
+	stop_builder();
+
 	lock_guard<recursive_mutex> lock(mutex_);
 	for (Envelope &e : envelope_levels_)
 		free(e.samples);
@@ -70,8 +79,6 @@ void AnalogSegment::append_interleaved_samples(const float *data,
 {
 	assert(unit_size_ == sizeof(float));
 
-	lock_guard<recursive_mutex> lock(mutex_);
-
 	uint64_t prev_sample_count = sample_count_;
 
 	// Deinterleave the samples and add them
@@ -85,8 +92,8 @@ void AnalogSegment::append_interleaved_samples(const float *data,
 
 	append_samples(deint_data.get(), sample_count);
 
-	// Generate the first mip-map from the data
-	append_payload_to_envelope_levels();
+	// Generate the envelope, either right away or on the builder thread
+	update_derived_data();
 
 	if (sample_count > 1)
 		owner_.notify_samples_added(shared_ptr<Segment>(shared_from_this()),
@@ -99,9 +106,9 @@ void AnalogSegment::append_interleaved_samples(const float *data,
 float AnalogSegment::get_sample(int64_t sample_num) const
 {
 	assert(sample_num >= 0);
-	assert(sample_num <= (int64_t)sample_count_);
+	assert(sample_num < (int64_t)sample_count_);
 
-	lock_guard<recursive_mutex> lock(mutex_);  // Because of free_unused_memory()
+	MemoryPin pin(*this);  // Because of free_unused_memory()
 
 	return *((const float*)get_raw_sample(sample_num));
 }
@@ -116,8 +123,6 @@ void AnalogSegment::get_samples(int64_t start_sample, int64_t end_sample,
 	assert(start_sample <= end_sample);
 	assert(dest != nullptr);
 
-	lock_guard<recursive_mutex> lock(mutex_);
-
 	get_raw_samples(start_sample, (end_sample - start_sample), (uint8_t*)dest);
 }
 
@@ -140,7 +145,12 @@ void AnalogSegment::get_envelope_section(EnvelopeSection &s,
 	assert(start <= end);
 	assert(min_length > 0);
 
-	lock_guard<recursive_mutex> lock(mutex_);
+	MemoryPin pin(*this);
+	lock_guard<mutex> envelope_lock(envelope_mutex_);
+
+	// Samples dropped in ring buffer mode have no envelope
+	start = max(start, get_first_sample());
+	end = max(end, start);
 
 	const unsigned int min_level = max((int)floorf(logf(min_length) /
 		LogEnvelopeScaleFactor) - 1, 0);
@@ -149,23 +159,114 @@ void AnalogSegment::get_envelope_section(EnvelopeSection &s,
 	start >>= scale_power;
 	end >>= scale_power;
 
+	const Envelope &e = envelope_levels_[min_level];
+	const uint64_t length = e.length;
+	const EnvelopeSample *samples = e.samples;
+	start = min(max(start, e.start), end);
+
 	s.start = start << scale_power;
 	s.scale = 1 << scale_power;
 	s.length = end - start;
 	s.samples = new EnvelopeSample[s.length];
-	memcpy(s.samples, envelope_levels_[min_level].samples + start,
-		s.length * sizeof(EnvelopeSample));
+
+	const uint64_t built_end = min(max(length, start), end);
+	if (built_end > start)
+		memcpy(s.samples, samples + (start - e.start),
+			(built_end - start) * sizeof(EnvelopeSample));
+
+	// The envelope lags behind the sample data while it's being built, the
+	// rest of the section is computed from the samples
+	if (built_end < end) {
+		DataView view(*this, built_end << scale_power, end << scale_power);
+		EnvelopeSample *dest = s.samples + (built_end - start);
+		uint64_t count = 0;
+
+		for (const DataSpan &span : view.spans()) {
+			const float *ptr = (const float*)span.data;
+
+			for (uint64_t i = 0; i < span.sample_count; i++, ptr++) {
+				if (count == 0) {
+					*dest = {*ptr, *ptr};
+				} else {
+					dest->min = min(dest->min, *ptr);
+					dest->max = max(dest->max, *ptr);
+				}
+
+				if (++count == s.scale) {
+					count = 0;
+					dest++;
+				}
+			}
+		}
+	}
+}
+
+uint64_t AnalogSegment::get_envelope_memory_usage() const
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	uint64_t size = 0;
+	for (const Envelope &e : envelope_levels_)
+		if (e.samples)
+			size += e.data_length * sizeof(EnvelopeSample);
+
+	return size;
+}
+
+void AnalogSegment::build_derived_data()
+{
+	append_payload_to_envelope_levels();
+
+	// Old chunks may go in ring buffer mode once the envelope covers them
+	lock_guard<recursive_mutex> lock(mutex_);
+	drop_old_chunks(envelope_levels_[0].length * EnvelopeScaleFactor);
 }
 
-void AnalogSegment::reallocate_envelope(Envelope &e)
+void AnalogSegment::reallocate_envelope(unsigned int level, uint64_t new_length)
 {
-	const uint64_t new_data_length = ((e.length + EnvelopeDataUnit - 1) /
-		EnvelopeDataUnit) * EnvelopeDataUnit;
-	if (new_data_length > e.data_length) {
-		e.data_length = new_data_length;
-		e.samples = (EnvelopeSample*)realloc(e.samples,
-			new_data_length * sizeof(EnvelopeSample));
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	Envelope &e = envelope_levels_[level];
+
+	if (new_length - e.start <= e.data_length)
+		return;
+
+	// Samples that only cover dropped sample data can be removed, except for
+	// those that the next level wasn't built from yet. This is skipped while
+	// a reader is active, the level then simply grows instead.
+	uint64_t new_start = e.start;
+	unique_lock<mutex> envelope_lock(envelope_mutex_, defer_lock);
+
+	if ((sample_limit_ > 0) && envelope_lock.try_lock()) {
+		uint64_t start = get_first_sample() >> ((level + 1) * EnvelopeScalePower);
+		if (level + 1 < ScaleStepCount)
+			start = min(start, envelope_levels_[level + 1].length * EnvelopeScaleFactor);
+		new_start = max(new_start, min(start, (uint64_t)e.length));
 	}
+
+	// Grow geometrically so that the number of copies stays low
+	const uint64_t kept_length = e.length - new_start;
+	const uint64_t new_data_length = ((max(new_length - new_start, 2 * kept_length) +
+		EnvelopeDataUnit - 1) / EnvelopeDataUnit) * EnvelopeDataUnit;
+
+	// Readers may still access the old buffer, so we can't realloc() it
+	EnvelopeSample *new_samples = (EnvelopeSample*)malloc(
+		new_data_length * sizeof(EnvelopeSample));
+	if (!new_samples)
+		throw std::bad_alloc();
+
+	EnvelopeSample *old_samples = e.samples;
+	if (old_samples)
+		memcpy(new_samples, old_samples + (new_start - e.start),
+			kept_length * sizeof(EnvelopeSample));
+
+	// The start is only written while readers are locked out
+	e.data_length = new_data_length;
+	if (new_start != e.start)
+		e.start = new_start;
+	e.samples = new_samples;
+
+	retire_buffer(old_samples);
 }
 
 void AnalogSegment::append_payload_to_envelope_levels()
@@ -175,15 +276,18 @@ void AnalogSegment::append_payload_to_envelope_levels()
 	EnvelopeSample *dest_ptr;
 	SegmentDataIterator* it;
 
+	// The writer may add samples meanwhile
+	const uint64_t sample_count = sample_count_;
+
 	// Expand the data buffer to fit the new samples
 	prev_length = e0.length;
-	e0.length = sample_count_ / EnvelopeScaleFactor;
+	const uint64_t e0_length = sample_count / EnvelopeScaleFactor;
 
 	// Calculate min/max values in case we have too few samples for an envelope
 	const float old_min_value = min_value_, old_max_value = max_value_;
-	if (sample_count_ < EnvelopeScaleFactor) {
+	if (sample_count < EnvelopeScaleFactor) {
 		it = begin_sample_iteration(0);
-		for (uint64_t i = 0; i < sample_count_; i++) {
+		for (uint64_t i = 0; i < sample_count; i++) {
 			const float sample = *get_iterator_value_ptr(it);
 			if (sample < min_value_)
 				min_value_ = sample;
@@ -195,16 +299,16 @@ void AnalogSegment::append_payload_to_envelope_levels()
 	}
 
 	// Break off if there are no new samples to compute
-	if (e0.length == prev_length)
+	if (e0_length == prev_length)
 		return;
 
-	reallocate_envelope(e0);
+	reallocate_envelope(0, e0_length);
 
-	dest_ptr = e0.samples + prev_length;
+	dest_ptr = e0.samples.load() + (prev_length - e0.start);
 
 	// Iterate through the samples to populate the first level mipmap
 	uint64_t start_sample = prev_length * EnvelopeScaleFactor;
-	uint64_t end_sample = e0.length * EnvelopeScaleFactor;
+	uint64_t end_sample = e0_length * EnvelopeScaleFactor;
 
 	it = begin_sample_iteration(start_sample);
 	for (uint64_t i = start_sample; i < end_sample; i += EnvelopeScaleFactor) {
@@ -225,6 +329,9 @@ void AnalogSegment::append_payload_to_envelope_levels()
 	}
 	end_sample_iteration(it);
 
+	// Only publish the new samples once they're complete
+	e0.length = e0_length;
+
 	// Compute higher level mipmaps
 	for (unsigned int level = 1; level < ScaleStepCount; level++) {
 		Envelope &e = envelope_levels_[level];
@@ -232,20 +339,21 @@ void AnalogSegment::append_payload_to_envelope_levels()
 
 		// Expand the data buffer to fit the new samples
 		prev_length = e.length;
-		e.length = el.length / EnvelopeScaleFactor;
+		const uint64_t e_length = el.length / EnvelopeScaleFactor;
 
 		// Break off if there are no more samples to be computed
-		if (e.length == prev_length)
+		if (e_length == prev_length)
 			break;
 
-		reallocate_envelope(e);
+		reallocate_envelope(level, e_length);
 
 		// Subsample the lower level
 		const EnvelopeSample *src_ptr =
-			el.samples + prev_length * EnvelopeScaleFactor;
-		const EnvelopeSample *const end_dest_ptr = e.samples + e.length;
+			el.samples.load() + (prev_length * EnvelopeScaleFactor - el.start);
+		const EnvelopeSample *const end_dest_ptr =
+			e.samples.load() + (e_length - e.start);
 
-		for (dest_ptr = e.samples + prev_length;
+		for (dest_ptr = e.samples.load() + (prev_length - e.start);
 				dest_ptr < end_dest_ptr; dest_ptr++) {
 			const EnvelopeSample *const end_src_ptr =
 				src_ptr + EnvelopeScaleFactor;
@@ -259,6 +367,8 @@ void AnalogSegment::append_payload_to_envelope_levels()
 
 			*dest_ptr = sub_sample;
 		}
+
+		e.length = e_length;
 	}
 
 	// Notify if the min or max value changed
@@ -22,12 +22,14 @@
 
 #include "segment.hpp"
 
+#include <mutex>
 #include <utility>
 #include <vector>
 
 #include <QObject>
 
 using std::enable_shared_from_this;
+using std::mutex;
 using std::pair;
 
 namespace AnalogSegmentTest {
@@ -59,11 +61,20 @@ public:
 	};
 
 private:
+	/**
+	 * Envelope levels are extended while readers may access them. New
+	 * samples are written first, then the buffer and the length published.
+	 * In ring buffer mode, samples that only cover dropped sample data are
+	 * removed when the level is reallocated. @c start is the index of the
+	 * sample stored at the beginning of @c samples and only changes while
+	 * envelope_mutex_ is held.
+	 */
 	struct Envelope
 	{
-		uint64_t length;
+		atomic<uint64_t> length;
+		uint64_t start;
 		uint64_t data_length;
-		EnvelopeSample *samples;
+		atomic<EnvelopeSample*> samples;
 	};
 
 private:
@@ -91,8 +102,14 @@ public:
 	void get_envelope_section(EnvelopeSection &s,
 		uint64_t start, uint64_t end, float min_length) const;
 
+	uint64_t get_envelope_memory_usage() const;
+
+protected:
+	/// Builds the envelope, get_envelope_section() computes the rest
+	virtual void build_derived_data();
+
 private:
-	void reallocate_envelope(Envelope &e);
+	void reallocate_envelope(unsigned int level, uint64_t new_length);
 
 	void append_payload_to_envelope_levels();
 
@@ -100,6 +117,8 @@ private:
 	Analog& owner_;
 
 	struct Envelope envelope_levels_[ScaleStepCount];
+	/// Keeps the envelope from being compacted while it's read
+	mutable mutex envelope_mutex_;
 
 	float min_value_, max_value_;
 
@@ -0,0 +1,198 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cstring>
+#include <new>
+
+#include <QDebug>
+
+#include "chunkpool.hpp"
+
+using std::bad_alloc;
+using std::lock_guard;
+
+namespace pv {
+namespace data {
+
+const uint64_t ChunkPool::HeadroomSize = 32 * 1024 * 1024;  /* 32MiB */
+
+ChunkPool::ChunkPool() :
+	used_size_(0),
+	pooled_size_(0),
+	memory_ceiling_(0),
+	headroom_(nullptr),
+	pressure_signalled_(false)
+{
+}
+
+ChunkPool::~ChunkPool()
+{
+	// All segments must have returned their chunks by now
+	assert(used_size_ == 0);
+
+	trim_unlocked();
+	delete[] headroom_;
+}
+
+void ChunkPool::set_memory_ceiling(uint64_t size)
+{
+	lock_guard<mutex> lock(mutex_);
+
+	memory_ceiling_ = size;
+}
+
+uint64_t ChunkPool::memory_ceiling() const
+{
+	lock_guard<mutex> lock(mutex_);
+
+	return memory_ceiling_;
+}
+
+uint64_t ChunkPool::used_size() const
+{
+	lock_guard<mutex> lock(mutex_);
+
+	return used_size_;
+}
+
+uint64_t ChunkPool::pooled_size() const
+{
+	lock_guard<mutex> lock(mutex_);
+
+	return pooled_size_;
+}
+
+void ChunkPool::reserve_headroom()
+{
+	lock_guard<mutex> lock(mutex_);
+
+	pressure_signalled_ = false;
+
+	if (headroom_)
+		return;
+
+	try {
+		headroom_ = new uint8_t[HeadroomSize];
+
+		// Touch the memory so that it's actually committed by the OS
+		memset(headroom_, 0xFF, HeadroomSize);
+	} catch (bad_alloc&) {
+		qWarning() << "Failed to reserve memory headroom";
+	}
+}
+
+uint8_t* ChunkPool::allocate(uint64_t size)
+{
+	bool pressure = false;
+	uint8_t *chunk = nullptr;
+
+	{
+		lock_guard<mutex> lock(mutex_);
+
+		auto it = free_chunks_.find(size);
+		if ((it != free_chunks_.end()) && !it->second.empty()) {
+			chunk = it->second.back();
+			it->second.pop_back();
+			pooled_size_ -= size;
+		} else {
+			// Pooled chunks of other sizes are given up before the
+			// ceiling is exceeded
+			if (memory_ceiling_ && (used_size_ + pooled_size_ + size > memory_ceiling_))
+				trim_unlocked();
+
+			if (!memory_ceiling_ || (used_size_ + size <= memory_ceiling_)) {
+				try {
+					chunk = new uint8_t[size];
+				} catch (bad_alloc&) {
+					// Give the application some memory to work with
+					delete[] headroom_;
+					headroom_ = nullptr;
+					trim_unlocked();
+				}
+			}
+		}
+
+		if (chunk) {
+			used_size_ += size;
+
+			// Leave the size of the headroom as margin for the data that
+			// will arrive until the acquisition is stopped
+			pressure = memory_ceiling_ &&
+				(used_size_ + HeadroomSize > memory_ceiling_);
+		} else
+			pressure = true;
+	}
+
+	if (pressure)
+		signal_memory_pressure();
+
+	if (!chunk)
+		throw bad_alloc();
+
+	return chunk;
+}
+
+void ChunkPool::release(uint8_t *chunk, uint64_t size)
+{
+	if (!chunk)
+		return;
+
+	lock_guard<mutex> lock(mutex_);
+
+	assert(used_size_ >= size);
+	used_size_ -= size;
+
+	free_chunks_[size].push_back(chunk);
+	pooled_size_ += size;
+}
+
+void ChunkPool::trim()
+{
+	lock_guard<mutex> lock(mutex_);
+
+	trim_unlocked();
+}
+
+void ChunkPool::trim_unlocked()
+{
+	for (auto& entry : free_chunks_)
+		for (uint8_t* chunk : entry.second)
+			delete[] chunk;
+
+	free_chunks_.clear();
+	pooled_size_ = 0;
+}
+
+void ChunkPool::signal_memory_pressure()
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+
+		if (pressure_signalled_)
+			return;
+
+		pressure_signalled_ = true;
+	}
+
+	memory_pressure();
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,106 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_CHUNKPOOL_HPP
+#define PULSEVIEW_PV_DATA_CHUNKPOOL_HPP
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <QObject>
+
+using std::map;
+using std::mutex;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+/**
+ * Provides the memory for the sample data chunks of a session.
+ *
+ * Chunks that are released are kept and handed out again, so that a new
+ * acquisition can reuse the memory of the previous one instead of having
+ * the OS provide (and zero) fresh pages. The pool also keeps a headroom
+ * arena that is given up when the system runs out of memory, so that the
+ * application can still stop the acquisition and remain usable.
+ *
+ * An optional memory ceiling limits the total amount of chunk memory.
+ * memory_pressure() is emitted once the chunks come close to it or when
+ * an allocation failed, allocations beyond the ceiling throw
+ * std::bad_alloc.
+ */
+class ChunkPool : public QObject
+{
+	Q_OBJECT
+
+public:
+	static const uint64_t HeadroomSize;
+
+public:
+	ChunkPool();
+	~ChunkPool();
+
+	/**
+	 * Sets the maximum amount of memory used for chunks in bytes,
+	 * 0 means there is no limit.
+	 */
+	void set_memory_ceiling(uint64_t size);
+	uint64_t memory_ceiling() const;
+
+	/// Returns the amount of memory used by chunks that are in use
+	uint64_t used_size() const;
+
+	/// Returns the amount of memory kept for reuse
+	uint64_t pooled_size() const;
+
+	/**
+	 * Reserves the headroom arena unless it already exists and re-arms
+	 * memory_pressure(). To be called whenever an acquisition starts.
+	 */
+	void reserve_headroom();
+
+	uint8_t* allocate(uint64_t size);
+	void release(uint8_t *chunk, uint64_t size);
+
+	/// Frees all chunks that are kept for reuse
+	void trim();
+
+Q_SIGNALS:
+	void memory_pressure();
+
+private:
+	void trim_unlocked();
+	void signal_memory_pressure();
+
+private:
+	mutable mutex mutex_;
+	map< uint64_t, vector<uint8_t*> > free_chunks_;
+	uint64_t used_size_, pooled_size_;
+	uint64_t memory_ceiling_;
+	uint8_t *headroom_;
+	bool pressure_signalled_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CHUNKPOOL_HPP
@@ -20,6 +20,7 @@
 #include <libsigrokdecode/libsigrokdecode.h>
 
 #include <cassert>
+#include <cstring>
 #include <vector>
 
 #include <pv/data/decode/annotation.hpp>
@@ -32,38 +33,18 @@ namespace pv {
 namespace data {
 namespace decode {
 
-Annotation::Annotation(uint64_t start_sample, uint64_t end_sample,
-	const vector<QString>* texts, uint32_t ann_class_id, const RowData *data) :
-	start_sample_(start_sample),
-	end_sample_(end_sample),
-	texts_(texts),
-	ann_class_id_(ann_class_id),
-	data_(data)
+Annotation::Annotation() :
+	data_(nullptr),
+	index_(0)
 {
 }
 
-Annotation::Annotation(Annotation&& a) :
-	start_sample_(a.start_sample_),
-	end_sample_(a.end_sample_),
-	texts_(a.texts_),
-	ann_class_id_(a.ann_class_id_),
-	data_(a.data_)
+Annotation::Annotation(const RowData *data, uint32_t index) :
+	data_(data),
+	index_(index)
 {
 }
 
-Annotation& Annotation::operator=(Annotation&& a)
-{
-	if (&a != this) {
-		start_sample_ = a.start_sample_;
-		end_sample_ = a.end_sample_;
-		texts_ = a.texts_;
-		ann_class_id_ = a.ann_class_id_;
-		data_ = a.data_;
-	}
-
-	return *this;
-}
-
 const RowData* Annotation::row_data() const
 {
 	return data_;
@@ -74,30 +55,35 @@ const Row* Annotation::row() const
 	return data_->row();
 }
 
+uint32_t Annotation::index() const
+{
+	return index_;
+}
+
 uint64_t Annotation::start_sample() const
 {
-	return start_sample_;
+	return data_->start_sample(index_);
 }
 
 uint64_t Annotation::end_sample() const
 {
-	return end_sample_;
+	return data_->end_sample(index_);
 }
 
 uint64_t Annotation::length() const
 {
-	return end_sample_ - start_sample_;
+	return end_sample() - start_sample();
 }
 
 uint32_t Annotation::ann_class_id() const
 {
-	return ann_class_id_;
+	return data_->ann_class_id(index_);
 }
 
 const QString Annotation::ann_class_name() const
 {
 	const AnnotationClass* ann_class =
-		data_->row()->decoder()->get_ann_class_by_id(ann_class_id_);
+		data_->row()->decoder()->get_ann_class_by_id(ann_class_id());
 
 	return QString(ann_class->name);
 }
@@ -105,47 +91,63 @@ const QString Annotation::ann_class_name() const
 const QString Annotation::ann_class_description() const
 {
 	const AnnotationClass* ann_class =
-		data_->row()->decoder()->get_ann_class_by_id(ann_class_id_);
+		data_->row()->decoder()->get_ann_class_by_id(ann_class_id());
 
 	return QString(ann_class->description);
 }
 
-const vector<QString>* Annotation::annotations() const
+const vector<QString> Annotation::annotations() const
 {
-	return texts_;
+	vector<QString> result;
+
+	// The texts follow each other and end with an empty one
+	for (const char* text = data_->texts(index_); *text; text += strlen(text) + 1)
+		result.emplace_back(QString::fromUtf8(text));
+
+	return result;
 }
 
 const QString Annotation::longest_annotation() const
 {
-	return texts_->front();
+	return QString::fromUtf8(data_->texts(index_));
 }
 
 bool Annotation::visible() const
 {
 	const Row* row = data_->row();
 
-	return (row->visible() && row->class_is_visible(ann_class_id_)
+	return (row->visible() && row->class_is_visible(ann_class_id())
 		&& row->decoder()->visible());
 }
 
 const QColor Annotation::color() const
 {
-	return data_->row()->get_class_color(ann_class_id_);
+	return data_->row()->get_class_color(ann_class_id());
 }
 
 const QColor Annotation::bright_color() const
 {
-	return data_->row()->get_bright_class_color(ann_class_id_);
+	return data_->row()->get_bright_class_color(ann_class_id());
 }
 
 const QColor Annotation::dark_color() const
 {
-	return data_->row()->get_dark_class_color(ann_class_id_);
+	return data_->row()->get_dark_class_color(ann_class_id());
 }
 
 bool Annotation::operator<(const Annotation &other) const
 {
-	return (start_sample_ < other.start_sample_);
+	return (start_sample() < other.start_sample());
+}
+
+bool Annotation::operator==(const Annotation &other) const
+{
+	return (data_ == other.data_) && (index_ == other.index_);
+}
+
+bool Annotation::operator!=(const Annotation &other) const
+{
+	return !(*this == other);
 }
 
 } // namespace decode
@@ -38,16 +38,20 @@ namespace decode {
 
 class RowData;
 
+/**
+ * Refers to an annotation that a RowData keeps in its columns. Instances
+ * are cheap to create and copy, they remain valid as long as the RowData
+ * exists.
+ */
 class Annotation
 {
 public:
-	Annotation(uint64_t start_sample, uint64_t end_sample,
-		const vector<QString>* texts, uint32_t ann_class_id, const RowData *data);
-	Annotation(Annotation&& a);
-	Annotation& operator=(Annotation&& a);
+	Annotation();
+	Annotation(const RowData *data, uint32_t index);
 
 	const RowData* row_data() const;
 	const Row* row() const;
+	uint32_t index() const;
 
 	uint64_t start_sample() const;
 	uint64_t end_sample() const;
@@ -57,7 +61,8 @@ public:
 	const QString ann_class_name() const;
 	const QString ann_class_description() const;
 
-	const vector<QString>* annotations() const;
+	/// Returns the texts of the annotation, longest first
+	const vector<QString> annotations() const;
 	const QString longest_annotation() const;
 
 	bool visible() const;
@@ -67,13 +72,12 @@ public:
 	const QColor dark_color() const;
 
 	bool operator<(const Annotation &other) const;
+	bool operator==(const Annotation &other) const;
+	bool operator!=(const Annotation &other) const;
 
 private:
-	uint64_t start_sample_;
-	uint64_t end_sample_;
-	const vector<QString>* texts_;
-	uint32_t ann_class_id_;
 	const RowData* data_;
+	uint32_t index_;
 };
 
 } // namespace decode
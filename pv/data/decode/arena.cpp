@@ -0,0 +1,101 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <utility>
+
+#include "arena.hpp"
+
+using std::max;
+using std::move;
+
+namespace pv {
+namespace data {
+namespace decode {
+
+const size_t Arena::BlockSize = 256 * 1024;
+
+Arena::Arena() :
+	first_block_(0),
+	used_(0)
+{
+}
+
+void* Arena::allocate(size_t size)
+{
+	size = (size + 7) & ~(size_t)7;
+
+	if (blocks_.empty() || (used_ + size > blocks_.back().size)) {
+		// Oversized allocations get a block of their own
+		const size_t block_size = max(size, BlockSize);
+		blocks_.push_back({unique_ptr<uint8_t[]>(new uint8_t[block_size]), block_size, 0});
+		used_ = 0;
+	}
+
+	void* result = blocks_.back().data.get() + used_;
+	used_ += size;
+
+	return result;
+}
+
+uint64_t Arena::current_block() const
+{
+	return blocks_.empty() ? first_block_ : first_block_ + blocks_.size() - 1;
+}
+
+uint64_t Arena::first_block() const
+{
+	return first_block_;
+}
+
+void Arena::keep_block(uint64_t block, uint64_t end_sample)
+{
+	assert(block >= first_block_);
+	assert(block - first_block_ < blocks_.size());
+
+	Block& b = blocks_[block - first_block_];
+	b.end_sample = max(b.end_sample, end_sample);
+}
+
+vector< unique_ptr<uint8_t[]> > Arena::release_blocks(uint64_t sample)
+{
+	vector< unique_ptr<uint8_t[]> > released;
+
+	while ((blocks_.size() > 1) && (blocks_.front().end_sample <= sample)) {
+		released.push_back(move(blocks_.front().data));
+		blocks_.pop_front();
+		first_block_++;
+	}
+
+	return released;
+}
+
+uint64_t Arena::get_memory_usage() const
+{
+	uint64_t size = 0;
+
+	for (const Block& block : blocks_)
+		size += block.size;
+
+	return size;
+}
+
+} // namespace decode
+} // namespace data
+} // namespace pv
@@ -0,0 +1,176 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_DECODE_ARENA_HPP
+#define PULSEVIEW_PV_DATA_DECODE_ARENA_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+using std::deque;
+using std::unique_ptr;
+using std::vector;
+
+namespace pv {
+namespace data {
+namespace decode {
+
+/**
+ * Hands out memory from a few large blocks. Allocations can't be freed on
+ * their own, only whole blocks are freed. This suits the annotations of a
+ * segment, which are only ever added until the segment is dropped as a whole
+ * or, in ring buffer mode, until the samples they cover were dropped.
+ *
+ * For that, the blocks are numbered in the order they were taken into use
+ * and the user tells for every block up to which sample its memory is used.
+ *
+ * Allocations are aligned to 8 bytes. The arena isn't thread-safe.
+ */
+class Arena
+{
+public:
+	static const size_t BlockSize;
+
+public:
+	Arena();
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void* allocate(size_t size);
+
+	/// Returns the number of the block that the last allocation came from
+	uint64_t current_block() const;
+
+	/// Returns the number of the oldest block that wasn't released
+	uint64_t first_block() const;
+
+	/**
+	 * Notes that memory of @c block is used by something that ends at
+	 * @c end_sample, so that the block isn't released before.
+	 */
+	void keep_block(uint64_t block, uint64_t end_sample);
+
+	/**
+	 * Removes the oldest blocks for as long as their memory is only used by
+	 * things that end at or before @c sample. The current block is always
+	 * kept. The blocks are handed to the caller, who frees them once nothing
+	 * refers to their memory anymore.
+	 */
+	vector< unique_ptr<uint8_t[]> > release_blocks(uint64_t sample);
+
+	/// Returns the number of bytes that the blocks take up
+	uint64_t get_memory_usage() const;
+
+private:
+	struct Block
+	{
+		unique_ptr<uint8_t[]> data;
+		size_t size;
+		uint64_t end_sample;
+	};
+
+	deque<Block> blocks_;
+	uint64_t first_block_;  ///< The number of the block in blocks_.front()
+	size_t used_;  ///< Bytes handed out from the last block
+};
+
+/**
+ * An array that only grows at its end and whose elements never move. It is
+ * stored in blocks that double in length, which are found through a
+ * directory of fixed size.
+ *
+ * This lets other threads read the elements that were published to them,
+ * e.g. under a mutex, while more are appended: unlike with a vector or a
+ * deque, appending doesn't touch any memory that such a reader accesses.
+ * The blocks are taken from the heap rather than from an arena, as they
+ * hold elements of all ages.
+ */
+template<typename T>
+class StableArray
+{
+private:
+	static const size_t FirstBlockLength = 64;
+	static const unsigned int MaxBlockCount = 32;
+
+public:
+	StableArray() :
+		size_(0),
+		block_count_(0)
+	{
+	}
+
+	StableArray(const StableArray&) = delete;
+	StableArray& operator=(const StableArray&) = delete;
+
+	size_t size() const
+	{
+		return size_;
+	}
+
+	/// Returns the number of elements that fit into the allocated blocks
+	size_t capacity() const
+	{
+		return FirstBlockLength * ((1ULL << block_count_) - 1);
+	}
+
+	const T& operator[](size_t index) const
+	{
+		// Block b holds FirstBlockLength << b elements and starts at index
+		// FirstBlockLength * (2^b - 1)
+		const uint64_t n = index / FirstBlockLength + 1;
+		const unsigned int b = 63 - __builtin_clzll(n);
+		return blocks_[b][index - FirstBlockLength * ((1ULL << b) - 1)];
+	}
+
+	T& operator[](size_t index)
+	{
+		return const_cast<T&>(static_cast<const StableArray&>(*this)[index]);
+	}
+
+	void push_back(const T& value)
+	{
+		const uint64_t n = size_ / FirstBlockLength + 1;
+		const unsigned int b = 63 - __builtin_clzll(n);
+		assert(b < MaxBlockCount);
+
+		if (b == block_count_) {
+			blocks_[b].reset(new T[FirstBlockLength << b]);
+			block_count_++;
+		}
+
+		blocks_[b][size_ - FirstBlockLength * ((1ULL << b) - 1)] = value;
+		size_++;
+	}
+
+private:
+	unique_ptr<T[]> blocks_[MaxBlockCount];
+	size_t size_;
+	unsigned int block_count_;
+};
+
+} // namespace decode
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_DECODE_ARENA_HPP
@@ -0,0 +1,669 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <libsigrokdecode/libsigrokdecode.h> /* First, so we avoid a _POSIX_C_SOURCE warning. */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QList>
+
+#include "decodeprocess.hpp"
+
+#include <pv/data/decodesignal.hpp>
+#include <pv/data/decode/decoder.hpp>
+
+using std::find;
+using std::lock_guard;
+using std::mutex;
+using std::pair;
+using std::string;
+
+namespace pv {
+namespace data {
+namespace decode {
+
+namespace {
+
+/*
+ * Every message is a header of two uint32_t, its type and the size of its
+ * payload, followed by the payload serialized with QDataStream. Each
+ * request to the helper is answered by a Done message holding the SRD
+ * return code, after any output that handling the request produced.
+ */
+enum MessageType : uint32_t {
+	// Requests to the helper
+	SetupRequest,
+	SamplesRequest,
+	EofRequest,
+	ResetRequest,
+
+	// Messages from the helper
+	AnnotationOutput,
+	BinaryOutput,
+	LogicOutput,
+	Done
+};
+
+const size_t HeaderSize = 2 * sizeof(uint32_t);
+
+/// Time in ms to wait for the helper before checking for an interruption
+const int PollInterval = 100;
+
+/// Bytes of output that the helper collects before it writes them out,
+/// unless a Done message completes the request before that
+const size_t OutputBufferSize = 256 * 1024;
+
+bool read_all(FILE *file, char *data, size_t size)
+{
+	return (size == 0) || (fread(data, size, 1, file) == 1);
+}
+
+bool read_message(FILE *file, uint32_t &type, QByteArray &payload)
+{
+	uint32_t header[2];
+	if (!read_all(file, (char*)header, sizeof(header)))
+		return false;
+
+	type = header[0];
+	payload.resize(header[1]);
+
+	return read_all(file, payload.data(), payload.size());
+}
+
+/**
+ * The state of the helper process. The output is written from the threads
+ * of the decoders, hence the mutex.
+ */
+struct Worker
+{
+	Worker(FILE *out) :
+		out(out), session(nullptr) { };
+
+	void write_message(uint32_t type, const QByteArray &payload);
+
+	int setup(const QByteArray &payload);
+	int send_samples(const QByteArray &payload);
+	int send_eof();
+	int reset(const QByteArray &payload);
+
+	void set_samplerate(uint64_t samplerate);
+	void apply_options();
+
+	/// Returns the index of the decoder that produced the output
+	quint32 decoder_index(const srd_proto_data *pdata) const;
+
+	static void annotation_callback(srd_proto_data *pdata, void *worker);
+	static void binary_callback(srd_proto_data *pdata, void *worker);
+	static void logic_output_callback(srd_proto_data *pdata, void *worker);
+
+	FILE *const out;
+	mutex out_mutex;
+
+	QSharedMemory buffer;
+	srd_session *session;
+	vector<srd_decoder_inst*> instances;
+	vector< vector< pair<string, GVariant*> > > options;
+	/// Bytes holding the logic output states of each decoder
+	vector<int> logic_output_sizes;
+};
+
+void Worker::write_message(uint32_t type, const QByteArray &payload)
+{
+	const uint32_t header[2] = {type, (uint32_t)payload.size()};
+
+	lock_guard<mutex> lock(out_mutex);
+	fwrite(header, sizeof(header), 1, out);
+	fwrite(payload.constData(), payload.size(), 1, out);
+
+	// The output is buffered, as high-rate decoders produce a lot of small
+	// messages. The parent waits for the Done message, so that one must be
+	// sent along with the output before it right away.
+	if (type == Done)
+		fflush(out);
+}
+
+int Worker::setup(const QByteArray &payload)
+{
+	QDataStream stream(payload);
+
+	QString key;
+	quint64 samplerate;
+	quint32 decoder_count;
+	stream >> key >> samplerate >> decoder_count;
+
+	buffer.setKey(key);
+	if (!buffer.attach(QSharedMemory::ReadOnly)) {
+		qWarning() << "Decoder process can't access the sample buffer:" <<
+			buffer.errorString();
+		return SRD_ERR;
+	}
+
+	srd_session_new(&session);
+	assert(session);
+
+	srd_decoder_inst *prev_di = nullptr;
+	for (quint32 i = 0; i < decoder_count; i++) {
+		QByteArray id;
+		quint32 option_count;
+		stream >> id >> option_count;
+
+		if (srd_decoder_load(id.constData()) != SRD_OK)
+			return SRD_ERR;
+
+		// The option values are passed in their text format
+		options.emplace_back();
+		for (quint32 j = 0; j < option_count; j++) {
+			QByteArray option_id, value_text;
+			stream >> option_id >> value_text;
+
+			GVariant *const value = g_variant_parse(nullptr,
+				value_text.constData(), nullptr, nullptr, nullptr);
+			if (value)
+				options.back().emplace_back(option_id.toStdString(), value);
+		}
+
+		GHashTable *const opt_hash = g_hash_table_new_full(g_str_hash,
+			g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+		for (const pair<string, GVariant*>& option : options.back())
+			g_hash_table_replace(opt_hash, (void*)g_strdup(option.first.c_str()),
+				g_variant_ref(option.second));
+
+		srd_decoder_inst *const di = srd_inst_new(session, id.constData(), opt_hash);
+		g_hash_table_destroy(opt_hash);
+
+		if (!di)
+			return SRD_ERR;
+
+		// Set up the channels like Decoder::create_decoder_inst() does
+		quint32 channel_count, assigned_count;
+		stream >> channel_count >> assigned_count;
+
+		GArray *const init_pin_states = g_array_sized_new(false, true,
+			sizeof(uint8_t), channel_count);
+		g_array_set_size(init_pin_states, channel_count);
+
+		GHashTable *const channels = g_hash_table_new_full(g_str_hash,
+			g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+
+		for (quint32 j = 0; j < assigned_count; j++) {
+			QByteArray channel_id;
+			quint32 index;
+			qint32 bit_id, initial_pin_state;
+			stream >> channel_id >> index >> bit_id >> initial_pin_state;
+
+			if (index < channel_count)
+				init_pin_states->data[index] = initial_pin_state;
+
+			GVariant *const gvar = g_variant_new_int32(bit_id);
+			g_variant_ref_sink(gvar);
+			g_hash_table_insert(channels, g_strdup(channel_id.constData()), gvar);
+		}
+
+		srd_inst_channel_set_all(di, channels);
+		g_hash_table_destroy(channels);
+
+		srd_inst_initial_pins_set_all(di, init_pin_states);
+		g_array_free(init_pin_states, true);
+
+		if (prev_di)
+			srd_inst_stack(session, prev_di, di);
+
+		instances.push_back(di);
+		logic_output_sizes.push_back(
+			(g_slist_length(di->decoder->logic_output_channels) + 7) / 8);
+		prev_di = di;
+	}
+
+	if (stream.status() != QDataStream::Ok)
+		return SRD_ERR;
+
+	set_samplerate(samplerate);
+
+	srd_pd_output_callback_add(session, SRD_OUTPUT_ANN,
+		Worker::annotation_callback, this);
+	srd_pd_output_callback_add(session, SRD_OUTPUT_BINARY,
+		Worker::binary_callback, this);
+	srd_pd_output_callback_add(session, SRD_OUTPUT_LOGIC,
+		Worker::logic_output_callback, this);
+
+	return srd_session_start(session);
+}
+
+int Worker::send_samples(const QByteArray &payload)
+{
+	QDataStream stream(payload);
+
+	quint64 start_sample, end_sample, size;
+	quint32 unit_size;
+	stream >> start_sample >> end_sample >> size >> unit_size;
+
+	if (!session || (size > (quint64)buffer.size()))
+		return SRD_ERR;
+
+	return srd_session_send(session, start_sample, end_sample,
+		(const uint8_t*)buffer.constData(), size, unit_size);
+}
+
+int Worker::send_eof()
+{
+	if (!session)
+		return SRD_ERR;
+
+#if defined HAVE_SRD_SESSION_SEND_EOF && HAVE_SRD_SESSION_SEND_EOF
+	return srd_session_send_eof(session);
+#else
+	return SRD_OK;
+#endif
+}
+
+int Worker::reset(const QByteArray &payload)
+{
+	QDataStream stream(payload);
+
+	quint64 samplerate;
+	stream >> samplerate;
+
+	if (!session)
+		return SRD_ERR;
+
+	// Like DecodeSignal::terminate_srd_session()
+#if defined HAVE_SRD_SESSION_SEND_EOF && HAVE_SRD_SESSION_SEND_EOF
+	(void)srd_session_send_eof(session);
+#endif
+	const int ret = srd_session_terminate_reset(session);
+
+	set_samplerate(samplerate);
+	apply_options();
+
+	return ret;
+}
+
+void Worker::set_samplerate(uint64_t samplerate)
+{
+	if (samplerate)
+		srd_session_metadata_set(session, SRD_CONF_SAMPLERATE,
+			g_variant_new_uint64(samplerate));
+}
+
+void Worker::apply_options()
+{
+	for (size_t i = 0; i < instances.size(); i++) {
+		GHashTable *const opt_hash = g_hash_table_new_full(g_str_hash,
+			g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+		for (const pair<string, GVariant*>& option : options[i])
+			g_hash_table_replace(opt_hash, (void*)g_strdup(option.first.c_str()),
+				g_variant_ref(option.second));
+
+		srd_inst_option_set(instances[i], opt_hash);
+		g_hash_table_destroy(opt_hash);
+	}
+}
+
+quint32 Worker::decoder_index(const srd_proto_data *pdata) const
+{
+	assert(pdata->pdo);
+	return find(instances.begin(), instances.end(), pdata->pdo->di) - instances.begin();
+}
+
+void Worker::annotation_callback(srd_proto_data *pdata, void *worker)
+{
+	Worker *const w = (Worker*)worker;
+	const srd_proto_data_annotation *const pda = (const srd_proto_data_annotation*)pdata->data;
+
+	QList<QByteArray> texts;
+	for (const char* const* text = (const char* const*)pda->ann_text; *text; text++)
+		texts.append(QByteArray(*text));
+
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+	stream << w->decoder_index(pdata) << (quint32)pda->ann_class <<
+		(quint64)pdata->start_sample << (quint64)pdata->end_sample << texts;
+
+	w->write_message(AnnotationOutput, payload);
+}
+
+void Worker::binary_callback(srd_proto_data *pdata, void *worker)
+{
+	Worker *const w = (Worker*)worker;
+	const srd_proto_data_binary *const pdb = (const srd_proto_data_binary*)pdata->data;
+
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+	stream << w->decoder_index(pdata) << (quint32)pdb->bin_class <<
+		(quint64)pdata->start_sample <<
+		QByteArray((const char*)pdb->data, pdb->size);
+
+	w->write_message(BinaryOutput, payload);
+}
+
+void Worker::logic_output_callback(srd_proto_data *pdata, void *worker)
+{
+	Worker *const w = (Worker*)worker;
+	const srd_proto_data_logic *const pdl = (const srd_proto_data_logic*)pdata->data;
+
+	const quint32 index = w->decoder_index(pdata);
+	if (index >= w->logic_output_sizes.size())
+		return;
+
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+	stream << index << (quint32)pdl->logic_group << (quint64)pdata->start_sample <<
+		(quint64)pdata->end_sample << (quint64)pdl->repeat_count <<
+		QByteArray((const char*)pdl->data, w->logic_output_sizes[index]);
+
+	w->write_message(LogicOutput, payload);
+}
+
+} // namespace
+
+const char* const DecodeProcess::WorkerOption = "--decode-worker";
+
+DecodeProcess::DecodeProcess(DecodeContext &context, const atomic<bool> &interrupt) :
+	context_(context),
+	interrupt_(interrupt)
+{
+}
+
+DecodeProcess::~DecodeProcess()
+{
+	if (process_.state() == QProcess::NotRunning)
+		return;
+
+	// The helper exits once its stdin is closed
+	process_.closeWriteChannel();
+	if (!process_.waitForFinished(1000)) {
+		process_.kill();
+		process_.waitForFinished();
+	}
+}
+
+bool DecodeProcess::start(const vector< shared_ptr<Decoder> > &stack, uint64_t samplerate)
+{
+	static atomic<unsigned int> buffer_count(0);
+
+	// The decoders never get more than a chunk of samples at once
+	buffer_.setKey(QString("pulseview-decode-%1-%2").arg(
+		QCoreApplication::applicationPid()).arg(buffer_count++));
+	if (!buffer_.create(DecodeSignal::MaxDecodeChunkLength)) {
+		qWarning() << "Can't create the sample buffer for a decoder process:" <<
+			buffer_.errorString();
+		return false;
+	}
+
+	process_.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	process_.start(QCoreApplication::applicationFilePath(), {WorkerOption});
+	if (!process_.waitForStarted()) {
+		qWarning() << "Can't start a decoder process:" << process_.errorString();
+		return false;
+	}
+
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+	stream << buffer_.key() << (quint64)samplerate << (quint32)stack.size();
+
+	decoders_.clear();
+	for (const shared_ptr<Decoder>& dec : stack) {
+		decoders_.push_back(dec->get_srd_decoder());
+		stream << QByteArray(dec->get_srd_decoder()->id);
+
+		stream << (quint32)dec->options().size();
+		for (const auto& option : dec->options()) {
+			gchar *const value_text = g_variant_print(option.second, true);
+			stream << QByteArray(option.first.c_str()) << QByteArray(value_text);
+			g_free(value_text);
+		}
+
+		// Only the assigned channels are set, see Decoder::create_decoder_inst()
+		quint32 assigned_count = 0;
+		for (const DecodeChannel *ch : dec->channels())
+			if (ch->assigned_signal)
+				assigned_count++;
+
+		stream << (quint32)dec->channels().size() << assigned_count;
+		for (const DecodeChannel *ch : dec->channels())
+			if (ch->assigned_signal)
+				stream << QByteArray(ch->pdch_->id) << (quint32)ch->id <<
+					(qint32)ch->bit_id << (qint32)ch->initial_pin_state;
+	}
+
+	return request(SetupRequest, payload);
+}
+
+bool DecodeProcess::send(uint64_t start_sample, uint64_t end_sample,
+	const uint8_t *data, uint64_t size, unsigned int unit_size)
+{
+	if (size > (uint64_t)buffer_.size())
+		return false;
+
+	// The helper only reads the buffer while it handles the request
+	memcpy(buffer_.data(), data, size);
+
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+	stream << (quint64)start_sample << (quint64)end_sample << (quint64)size <<
+		(quint32)unit_size;
+
+	return request(SamplesRequest, payload);
+}
+
+bool DecodeProcess::send_eof()
+{
+	return request(EofRequest, QByteArray());
+}
+
+bool DecodeProcess::reset(uint64_t samplerate)
+{
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+	stream << (quint64)samplerate;
+
+	return request(ResetRequest, payload);
+}
+
+bool DecodeProcess::request(uint32_t type, const QByteArray &payload)
+{
+	const uint32_t header[2] = {type, (uint32_t)payload.size()};
+	process_.write((const char*)header, sizeof(header));
+	process_.write(payload);
+
+	while (true) {
+		// Handle all messages that were received completely
+		int pos = 0;
+		while (received_.size() - pos >= (int)HeaderSize) {
+			uint32_t msg_header[2];
+			memcpy(msg_header, received_.constData() + pos, HeaderSize);
+			if ((uint32_t)(received_.size() - pos) - HeaderSize < msg_header[1])
+				break;
+
+			const QByteArray msg_payload = received_.mid(pos + (int)HeaderSize,
+				(int)msg_header[1]);
+			pos += (int)HeaderSize + (int)msg_header[1];
+
+			if (msg_header[0] == Done) {
+				received_.remove(0, pos);
+
+				QDataStream stream(msg_payload);
+				qint32 ret;
+				stream >> ret;
+				return (ret == SRD_OK);
+			}
+
+			handle_output(msg_header[0], msg_payload);
+		}
+		received_.remove(0, pos);
+
+		if (interrupt_) {
+			process_.kill();
+			process_.waitForFinished();
+			return false;
+		}
+
+		if (process_.waitForReadyRead(PollInterval))
+			received_.append(process_.readAll());
+		else if (process_.state() == QProcess::NotRunning) {
+			qWarning() << "Decoder process exited unexpectedly";
+			return false;
+		}
+	}
+}
+
+void DecodeProcess::handle_output(uint32_t type, const QByteArray &payload)
+{
+	QDataStream stream(payload);
+
+	quint32 decoder_index;
+	stream >> decoder_index;
+	if (decoder_index >= decoders_.size())
+		return;
+
+	DecodeSignal *const signal = context_.signal;
+
+	switch (type) {
+	case AnnotationOutput:
+	{
+		quint32 ann_class;
+		quint64 start_sample, end_sample;
+		QList<QByteArray> texts;
+		stream >> ann_class >> start_sample >> end_sample >> texts;
+
+		vector<const char*> ann_texts;
+		for (const QByteArray& text : texts)
+			ann_texts.push_back(text.constData());
+		ann_texts.push_back(nullptr);
+
+		if (texts.size() > 0)
+			signal->add_annotation(context_, decoder_index, ann_class,
+				start_sample, end_sample, ann_texts.data());
+		break;
+	}
+
+	case BinaryOutput:
+	{
+		quint32 bin_class;
+		quint64 sample;
+		QByteArray data;
+		stream >> bin_class >> sample >> data;
+
+		signal->add_binary_data(context_, decoder_index, bin_class,
+			sample, data.constData(), data.size());
+		break;
+	}
+
+	case LogicOutput:
+	{
+		quint32 logic_group;
+		quint64 start_sample, end_sample, repeat_count;
+		QByteArray state;
+		stream >> logic_group >> start_sample >> end_sample >> repeat_count >> state;
+
+		// The state is read in words of up to 8 bytes
+		state.append(QByteArray(8, '\0'));
+
+		signal->add_logic_output(context_, decoder_index, logic_group, start_sample,
+			end_sample, repeat_count, state.constData());
+		break;
+	}
+
+	default:
+		qWarning() << "Unknown message" << type << "from decoder process";
+	}
+}
+
+int DecodeProcess::run_worker()
+{
+	// The messages go through stdout, so anything that the decoders print
+	// goes to stderr instead
+	const int out_fd = dup(fileno(stdout));
+	dup2(fileno(stderr), fileno(stdout));
+
+#ifdef _WIN32
+	_setmode(fileno(stdin), _O_BINARY);
+	_setmode(out_fd, _O_BINARY);
+#endif
+
+	FILE *const out = fdopen(out_fd, "wb");
+	if (!out)
+		return 1;
+
+	setvbuf(out, nullptr, _IOFBF, OutputBufferSize);
+
+	if (srd_init(nullptr) != SRD_OK) {
+		qWarning() << "ERROR: libsigrokdecode init failed.";
+		return 1;
+	}
+
+	{
+		Worker worker(out);
+
+		// Handle requests until the parent closes our stdin
+		uint32_t type;
+		QByteArray payload;
+		while (read_message(stdin, type, payload)) {
+			int ret = SRD_ERR_ARG;
+
+			if (type == SetupRequest)
+				ret = worker.setup(payload);
+			else if (type == SamplesRequest)
+				ret = worker.send_samples(payload);
+			else if (type == EofRequest)
+				ret = worker.send_eof();
+			else if (type == ResetRequest)
+				ret = worker.reset(payload);
+
+			QByteArray result;
+			QDataStream stream(&result, QIODevice::WriteOnly);
+			stream << (qint32)ret;
+			worker.write_message(Done, result);
+		}
+
+		if (worker.session)
+			srd_session_destroy(worker.session);
+
+		for (const vector< pair<string, GVariant*> >& decoder_options : worker.options)
+			for (const pair<string, GVariant*>& option : decoder_options)
+				g_variant_unref(option.second);
+	}
+
+	srd_exit();
+	fclose(out);
+
+	return 0;
+}
+
+} // namespace decode
+} // namespace data
+} // namespace pv
@@ -0,0 +1,109 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_DECODE_DECODEPROCESS_HPP
+#define PULSEVIEW_PV_DATA_DECODE_DECODEPROCESS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+#include <QProcess>
+#include <QSharedMemory>
+
+using std::atomic;
+using std::shared_ptr;
+using std::vector;
+
+struct srd_decoder;
+
+namespace pv {
+namespace data {
+
+struct DecodeContext;
+
+namespace decode {
+
+class Decoder;
+
+/**
+ * Runs a decoder stack in a helper process instead of the session of a
+ * DecodeContext, so that the stacks don't share the interpreter lock of
+ * the embedded Python and decoding scales with the CPU cores.
+ *
+ * The helper is this executable, started with WorkerOption. The samples
+ * are handed to it in shared memory while the output of its decoders is
+ * streamed back through its stdout and added to the segment that the
+ * context decodes. Every call blocks until the helper handled it.
+ *
+ * Like QProcess, an instance must only be used by the thread that created it.
+ */
+class DecodeProcess
+{
+public:
+	/// The command line option that makes this executable run as a helper
+	static const char* const WorkerOption;
+
+	/**
+	 * @param interrupt Makes any call return false once it is set, the
+	 * helper is then killed.
+	 */
+	DecodeProcess(DecodeContext &context, const atomic<bool> &interrupt);
+	~DecodeProcess();
+
+	/**
+	 * Starts the helper and creates the decoder stack in it.
+	 * @return false if either failed.
+	 */
+	bool start(const vector< shared_ptr<Decoder> > &stack, uint64_t samplerate);
+
+	bool send(uint64_t start_sample, uint64_t end_sample, const uint8_t *data,
+		uint64_t size, unsigned int unit_size);
+	bool send_eof();
+
+	/// Resets the decoders for another segment, keeping the stack intact
+	bool reset(uint64_t samplerate);
+
+	/// The main function of the helper process
+	static int run_worker();
+
+private:
+	/// Sends a request and handles the output of the helper until it's done
+	bool request(uint32_t type, const QByteArray &payload);
+	void handle_output(uint32_t type, const QByteArray &payload);
+
+private:
+	DecodeContext &context_;
+	const atomic<bool> &interrupt_;
+
+	QProcess process_;
+	QSharedMemory buffer_;
+	QByteArray received_;
+
+	/// The decoders of the stack, indexed like in the output of the helper
+	vector<const srd_decoder*> decoders_;
+};
+
+} // namespace decode
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_DECODE_DECODEPROCESS_HPP
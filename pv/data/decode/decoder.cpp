@@ -169,20 +169,15 @@ void Decoder::set_option(const char *id, GVariant *value)
 
 void Decoder::apply_all_options()
 {
-	if (decoder_inst_) {
-		GHashTable *const opt_hash = g_hash_table_new_full(g_str_hash,
-			g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
-
-		for (const auto& option : options_) {
-			GVariant *const value = option.second;
-			g_variant_ref(value);
-			g_hash_table_replace(opt_hash, (void*)g_strdup(
-				option.first.c_str()), value);
-		}
-
-		srd_inst_option_set(decoder_inst_, opt_hash);
-		g_hash_table_destroy(opt_hash);
-	}
+	if (decoder_inst_)
+		apply_all_options(decoder_inst_);
+}
+
+void Decoder::apply_all_options(srd_decoder_inst *inst) const
+{
+	GHashTable *const opt_hash = create_option_hash();
+	srd_inst_option_set(inst, opt_hash);
+	g_hash_table_destroy(opt_hash);
 }
 
 bool Decoder::have_required_channels() const
@@ -196,23 +191,21 @@ bool Decoder::have_required_channels() const
 
 srd_decoder_inst* Decoder::create_decoder_inst(srd_session *session)
 {
-	GHashTable *const opt_hash = g_hash_table_new_full(g_str_hash,
-		g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
-
-	for (const auto& option : options_) {
-		GVariant *const value = option.second;
-		g_variant_ref(value);
-		g_hash_table_replace(opt_hash, (void*)g_strdup(
-			option.first.c_str()), value);
-	}
-
 	if (decoder_inst_)
 		qDebug() << "WARNING: previous decoder instance" << decoder_inst_ << "exists";
 
-	decoder_inst_ = srd_inst_new(session, srd_decoder_->id, opt_hash);
+	decoder_inst_ = create_extra_decoder_inst(session);
+
+	return decoder_inst_;
+}
+
+srd_decoder_inst* Decoder::create_extra_decoder_inst(srd_session *session) const
+{
+	GHashTable *const opt_hash = create_option_hash();
+	srd_decoder_inst *const inst = srd_inst_new(session, srd_decoder_->id, opt_hash);
 	g_hash_table_destroy(opt_hash);
 
-	if (!decoder_inst_)
+	if (!inst)
 		return nullptr;
 
 	// Setup the channels
@@ -236,12 +229,12 @@ srd_decoder_inst* Decoder::create_decoder_inst(srd_session *session)
 		g_hash_table_insert(channels, ch->pdch_->id, gvar);
 	}
 
-	srd_inst_channel_set_all(decoder_inst_, channels);
+	srd_inst_channel_set_all(inst, channels);
 
-	srd_inst_initial_pins_set_all(decoder_inst_, init_pin_states);
+	srd_inst_initial_pins_set_all(inst, init_pin_states);
 	g_array_free(init_pin_states, true);
 
-	return decoder_inst_;
+	return inst;
 }
 
 void Decoder::invalidate_decoder_inst()
@@ -249,6 +242,21 @@ void Decoder::invalidate_decoder_inst()
 	decoder_inst_ = nullptr;
 }
 
+GHashTable* Decoder::create_option_hash() const
+{
+	GHashTable *const opt_hash = g_hash_table_new_full(g_str_hash,
+		g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+
+	for (const auto& option : options_) {
+		GVariant *const value = option.second;
+		g_variant_ref(value);
+		g_hash_table_replace(opt_hash, (void*)g_strdup(
+			option.first.c_str()), value);
+	}
+
+	return opt_hash;
+}
+
 vector<Row*> Decoder::get_rows()
 {
 	vector<Row*> result;
@@ -128,12 +128,21 @@ public:
 	void set_option(const char *id, GVariant *value);
 
 	void apply_all_options();
+	void apply_all_options(srd_decoder_inst *inst) const;
 
 	bool have_required_channels() const;
 
 	srd_decoder_inst* create_decoder_inst(srd_session *session);
 	void invalidate_decoder_inst();
 
+	/**
+	 * Creates an instance in a session that decodes alongside the one of
+	 * create_decoder_inst(), e.g. to decode another segment concurrently.
+	 * The decoder doesn't keep track of it, so its options must be applied
+	 * with apply_all_options(srd_decoder_inst*).
+	 */
+	srd_decoder_inst* create_extra_decoder_inst(srd_session *session) const;
+
 	vector<Row*> get_rows();
 	Row* get_row_by_id(size_t id);
 
@@ -155,6 +164,9 @@ private Q_SLOTS:
 	void on_row_visibility_changed();
 	void on_class_visibility_changed();
 
+private:
+	GHashTable* create_option_hash() const;
+
 private:
 	const srd_decoder* const srd_decoder_;
 	uint8_t stack_level_;
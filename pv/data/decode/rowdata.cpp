@@ -17,23 +17,52 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <bitset>
 #include <cassert>
+#include <cstring>
 
+#include <pv/data/decode/arena.hpp>
 #include <pv/data/decode/decoder.hpp>
 #include <pv/data/decode/row.hpp>
 #include <pv/data/decode/rowdata.hpp>
 
+using std::bitset;
+using std::max;
+using std::min;
+using std::remove_if;
 using std::vector;
 
 namespace pv {
 namespace data {
 namespace decode {
 
-RowData::RowData(Row* row) :
+const uint32_t RowData::ChunkLength;
+
+/// What dropped annotations read as, an empty list of texts
+static const char NoTexts[] = "";
+
+static uint32_t text_hash(const char* text)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (; *text; text++)
+		hash = (hash ^ (uint8_t)*text) * 16777619u;
+
+	return hash;
+}
+
+RowData::RowData(Row* row, Arena* arena) :
 	row_(row),
-	prev_ann_start_sample_(0)
+	arena_(arena),
+	count_(0),
+	first_index_(0),
+	prev_ann_start_sample_(0),
+	text_count_(0),
+	text_block_(0)
 {
 	assert(row);
+	assert(arena);
 }
 
 const Row* RowData::row() const
@@ -43,115 +72,319 @@ const Row* RowData::row() const
 
 uint64_t RowData::get_max_sample() const
 {
-	if (annotations_.empty())
+	if (position_count() == 0)
 		return 0;
-	return annotations_.back().end_sample();
+	return end_sample(index_at(position_count() - 1));
 }
 
 uint64_t RowData::get_annotation_count() const
 {
-	return annotations_.size();
+	return position_count();
 }
 
-void RowData::get_annotation_subset(
-	deque<const pv::data::decode::Annotation*> &dest,
+uint32_t RowData::first_index() const
+{
+	return first_index_;
+}
+
+void RowData::get_annotation_subset(deque<Annotation> &dest,
 	uint64_t start_sample, uint64_t end_sample) const
 {
+	if (position_count() == 0)
+		return;
+
 	// Determine whether we must apply per-class filtering or not
 	bool all_ann_classes_enabled = true;
 	bool all_ann_classes_disabled = true;
 
-	uint32_t max_ann_class_id = 0;
-	for (AnnotationClass* c : row_->ann_classes()) {
+	// Class IDs are stored in 16 bits, so this covers all of them
+	bitset<1 << 16> class_visible;
+
+	for (const AnnotationClass* c : row_->ann_classes()) {
 		if (!c->visible())
 			all_ann_classes_enabled = false;
-		else
+		else {
 			all_ann_classes_disabled = false;
-		if (c->id > max_ann_class_id)
-			max_ann_class_id = c->id;
+			class_visible.set((uint16_t)c->id);
+		}
 	}
 
-	if (all_ann_classes_enabled) {
-		// No filtering, send everyting out as-is
-		for (const auto& annotation : annotations_)
-			if ((annotation.end_sample() > start_sample) &&
-				(annotation.start_sample() <= end_sample))
-				dest.push_back(&annotation);
-	} else {
-		if (!all_ann_classes_disabled) {
-			// Filter out invisible annotation classes
-			vector<size_t> class_visible;
-			class_visible.resize(max_ann_class_id + 1, 0);
-			for (AnnotationClass* c : row_->ann_classes())
-				if (c->visible())
-					class_visible[c->id] = 1;
-
-			for (const auto& annotation : annotations_)
-				if ((class_visible[annotation.ann_class_id()]) &&
-					(annotation.end_sample() > start_sample) &&
-					(annotation.start_sample() <= end_sample))
-					dest.push_back(&annotation);
+	if (all_ann_classes_disabled && !all_ann_classes_enabled)
+		return;
+
+	// The prefix maxima never decrease, so the first block holding any
+	// annotation that ends after start_sample can be found by bisection
+	size_t first = 0, last = prefix_max_end_samples_.size();
+	while (first < last) {
+		const size_t mid = (first + last) / 2;
+		if (prefix_max_end_samples_[mid] > start_sample)
+			last = mid;
+		else
+			first = mid + 1;
+	}
+
+	const uint32_t end_position = upper_bound_start(end_sample);
+
+	for (size_t b = first; (b * ChunkLength) < end_position; b++) {
+		// Skip blocks that only hold annotations ending before the range,
+		// which happens if an earlier annotation is very long
+		if (max_end_samples_[b] <= start_sample)
+			continue;
+
+		const uint32_t block_end = min<uint32_t>((b + 1) * ChunkLength, end_position);
+
+		for (uint32_t position = b * ChunkLength; position < block_end; position++) {
+			const uint32_t index = index_at(position);
+			const Chunk* chunk = chunks_[index / ChunkLength];
+			const uint32_t n = index % ChunkLength;
+
+			if (chunk->end_sample[n] <= start_sample)
+				continue;
+
+			if (!all_ann_classes_enabled && !class_visible[chunk->ann_class_id[n]])
+				continue;
+
+			dest.emplace_back(this, index);
 		}
 	}
 }
 
-const deque<Annotation>& RowData::annotations() const
+Annotation RowData::get_annotation(uint32_t index) const
 {
-	return annotations_;
+	return Annotation(this, index);
 }
 
-const Annotation* RowData::emplace_annotation(srd_proto_data *pdata)
+uint64_t RowData::start_sample(uint32_t index) const
 {
-	const srd_proto_data_annotation *const pda = (const srd_proto_data_annotation*)pdata->data;
+	if (index < first_index_)
+		return 0;
+	return chunks_[index / ChunkLength]->start_sample[index % ChunkLength];
+}
 
-	uint32_t ann_class_id = pda->ann_class;
+uint64_t RowData::end_sample(uint32_t index) const
+{
+	if (index < first_index_)
+		return 0;
+	return chunks_[index / ChunkLength]->end_sample[index % ChunkLength];
+}
 
-	// Look up the longest annotation text to see if we have it in storage.
-	// This implies that if the longest text is the same, the shorter texts
-	// are expected to be the same, too. PDs that violate this assumption
-	// should be considered broken.
-	const char* const* ann_texts = (char**)pda->ann_text;
-	const QString ann0 = QString::fromUtf8(ann_texts[0]);
-	vector<QString>* storage_entry = &(ann_texts_[ann0]);
+uint32_t RowData::ann_class_id(uint32_t index) const
+{
+	if (index < first_index_)
+		return 0;
+	return chunks_[index / ChunkLength]->ann_class_id[index % ChunkLength];
+}
 
-	if (storage_entry->empty()) {
-		while (*ann_texts) {
-			storage_entry->emplace_back(QString::fromUtf8(*ann_texts));
-			ann_texts++;
-		}
-		storage_entry->shrink_to_fit();
+const char* RowData::texts(uint32_t index) const
+{
+	if (index < first_index_)
+		return NoTexts;
+	return chunks_[index / ChunkLength]->texts[index % ChunkLength];
+}
+
+uint32_t RowData::emplace_annotation(uint64_t start_sample,
+	uint64_t end_sample, uint32_t ann_class_id, const char* ann_texts)
+{
+	const char* const texts = intern_texts(ann_texts);
+	const uint64_t text_block = arena_->current_block();
+
+	if (count_ == chunks_.size() * ChunkLength) {
+		Chunk* const chunk = static_cast<Chunk*>(arena_->allocate(sizeof(Chunk)));
+		chunk->block = arena_->current_block();
+		chunks_.push_back(chunk);
 	}
 
+	const uint32_t index = count_;
 
-	const Annotation* result = nullptr;
+	Chunk* chunk = chunks_[index / ChunkLength];
+	const uint32_t n = index % ChunkLength;
 
-	// We insert the annotation in a way so that the annotation list
-	// is sorted by start sample. Otherwise, we'd have to sort when
-	// painting, which is expensive
+	chunk->start_sample[n] = start_sample;
+	chunk->end_sample[n] = end_sample;
+	chunk->texts[n] = texts;
+	chunk->ann_class_id[n] = ann_class_id;
 
-	if (pdata->start_sample < prev_ann_start_sample_) {
-		// Find location to insert the annotation at
+	// The blocks holding the annotation and its texts must be kept until
+	// the samples it covers are dropped
+	arena_->keep_block(chunk->block, end_sample);
+	arena_->keep_block(text_block, end_sample);
 
-		auto it = annotations_.end();
-		do {
-			it--;
-		} while ((it->start_sample() > pdata->start_sample) && (it != annotations_.begin()));
+	// Keep track of the order by start sample. Otherwise, we'd have to sort
+	// when painting, which is expensive
+	const uint32_t first_index = first_index_;
+	const uint32_t count = position_count();
+	uint32_t position = count;
 
-		// Allow inserting at the front
-		if (it != annotations_.begin())
-			it++;
+	if (start_sample < prev_ann_start_sample_) {
+		if (order_.empty()) {
+			order_.resize(count);
+			for (uint32_t i = 0; i < count; i++)
+				order_[i] = first_index + i;
+		}
 
-		it = annotations_.emplace(it, pdata->start_sample, pdata->end_sample,
-			storage_entry, ann_class_id, this);
-		result = &(*it);
+		position = upper_bound_start(start_sample);
+		order_.insert(order_.begin() + position, index);
 	} else {
-		annotations_.emplace_back(pdata->start_sample, pdata->end_sample,
-			storage_entry, ann_class_id, this);
-		result = &(annotations_.back());
-		prev_ann_start_sample_ = pdata->start_sample;
+		if (!order_.empty())
+			order_.push_back(index);
+		prev_ann_start_sample_ = start_sample;
+	}
+
+	count_++;
+
+	if (position == count) {
+		// Appended, so only the last block's maxima can change
+		const size_t b = position / ChunkLength;
+		if (b == max_end_samples_.size()) {
+			max_end_samples_.push_back(end_sample);
+			prefix_max_end_samples_.push_back((b == 0) ? end_sample :
+				max(prefix_max_end_samples_[b - 1], end_sample));
+		} else {
+			max_end_samples_[b] = max(max_end_samples_[b], end_sample);
+			prefix_max_end_samples_[b] = max(prefix_max_end_samples_[b], end_sample);
+		}
+	} else
+		update_max_end_samples(position / ChunkLength);
+
+	return index;
+}
+
+void RowData::drop_released_annotations()
+{
+	// Chunks are taken from the arena one after the other, so the ones in
+	// released blocks come first
+	const uint64_t first_block = arena_->first_block();
+
+	size_t chunk_id = first_index_ / ChunkLength;
+	while ((chunk_id < chunks_.size()) && (chunks_[chunk_id]->block < first_block))
+		chunk_id++;
+
+	const uint32_t first_index = chunk_id * ChunkLength;
+	if (first_index == first_index_)
+		return;
+
+	// If the chunk that was being filled was dropped as well, the next
+	// annotation starts a new one
+	count_ = max(count_, first_index);
+	first_index_ = first_index;
+
+	if (!order_.empty())
+		order_.erase(remove_if(order_.begin(), order_.end(),
+			[first_index](uint32_t index) { return index < first_index; }),
+			order_.end());
+
+	update_max_end_samples(0);
+}
+
+uint32_t RowData::position_count() const
+{
+	return count_ - first_index_;
+}
+
+uint32_t RowData::index_at(uint32_t position) const
+{
+	return order_.empty() ? first_index_ + position : order_[position];
+}
+
+uint32_t RowData::upper_bound_start(uint64_t sample) const
+{
+	uint32_t first = 0, last = position_count();
+
+	while (first < last) {
+		const uint32_t mid = first + (last - first) / 2;
+		if (start_sample(index_at(mid)) > sample)
+			last = mid;
+		else
+			first = mid + 1;
+	}
+
+	return first;
+}
+
+void RowData::update_max_end_samples(size_t first_block)
+{
+	const uint32_t count = position_count();
+	const size_t block_count = (count + ChunkLength - 1) / ChunkLength;
+	max_end_samples_.resize(block_count);
+	prefix_max_end_samples_.resize(block_count);
+
+	for (size_t b = first_block; b < block_count; b++) {
+		const uint32_t block_end = min<uint32_t>((b + 1) * ChunkLength, count);
+
+		max_end_samples_[b] = 0;
+		for (uint32_t position = b * ChunkLength; position < block_end; position++)
+			max_end_samples_[b] = max(max_end_samples_[b], end_sample(index_at(position)));
+
+		prefix_max_end_samples_[b] = (b == 0) ? max_end_samples_[b] :
+			max(prefix_max_end_samples_[b - 1], max_end_samples_[b]);
 	}
+}
+
+uint64_t RowData::get_memory_usage() const
+{
+	return chunks_.capacity() * sizeof(Chunk*) +
+		order_.capacity() * sizeof(uint32_t) +
+		(max_end_samples_.capacity() + prefix_max_end_samples_.capacity()) * sizeof(uint64_t) +
+		text_table_.capacity() * sizeof(const char*);
+}
+
+const char* RowData::intern_texts(const char* ann_texts)
+{
+	// Only the texts in the current block of the arena are shared
+	const auto update_text_block = [this]() {
+		if (text_block_ != arena_->current_block()) {
+			text_table_.clear();
+			text_count_ = 0;
+			text_block_ = arena_->current_block();
+		}
+	};
+
+	update_text_block();
+
+	const uint32_t mask = text_table_.size() - 1;
+
+	if (!text_table_.empty())
+		for (uint32_t slot = text_hash(ann_texts) & mask; text_table_[slot];
+			slot = (slot + 1) & mask)
+			if (strcmp(text_table_[slot], ann_texts) == 0)
+				return text_table_[slot];
+
+	// Copy the texts into the arena, including the empty text at the end
+	const char* text = ann_texts;
+	while (*text)
+		text += strlen(text) + 1;
+	const size_t size = text - ann_texts + 1;
+
+	char* dest = static_cast<char*>(arena_->allocate(size));
+	memcpy(dest, ann_texts, size);
+
+	// The copy may have been put into a new block
+	update_text_block();
+	text_count_++;
+
+	// Keep the hash table at most half full
+	if (text_count_ * 2 > text_table_.size()) {
+		vector<const char*> old_table(text_table_.empty() ? 64 : text_table_.size() * 2, nullptr);
+		old_table.swap(text_table_);
+		for (const char* texts : old_table)
+			if (texts)
+				set_text_slot(texts);
+	}
+
+	set_text_slot(dest);
+
+	return dest;
+}
+
+void RowData::set_text_slot(const char* texts)
+{
+	const uint32_t mask = text_table_.size() - 1;
+
+	uint32_t slot = text_hash(texts) & mask;
+	while (text_table_[slot])
+		slot = (slot + 1) & mask;
 
-	return result;
+	text_table_[slot] = texts;
 }
 
 }  // namespace decode
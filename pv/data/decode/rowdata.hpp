@@ -20,29 +20,18 @@
 #ifndef PULSEVIEW_PV_DATA_DECODE_ROWDATA_HPP
 #define PULSEVIEW_PV_DATA_DECODE_ROWDATA_HPP
 
-#include <unordered_map>
+#include <atomic>
+#include <deque>
 #include <vector>
 
-#include <QtGlobal>
-#include <QHash>
-#include <QString>
-
 #include <libsigrokdecode/libsigrokdecode.h>
 
 #include <pv/data/decode/annotation.hpp>
+#include <pv/data/decode/arena.hpp>
 
+using std::atomic;
 using std::deque;
-using std::unordered_map;
-
-#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
-namespace std {
-	template<> struct hash<QString> {
-		std::size_t operator()(const QString& s) const noexcept {
-			return (size_t) qHash(s);
-		}
-	};
-}
-#endif
+using std::vector;
 
 namespace pv {
 namespace data {
@@ -50,34 +39,156 @@ namespace decode {
 
 class Row;
 
+/**
+ * Holds the annotations of a row for one segment.
+ *
+ * The annotations aren't stored as objects but in columns, which are split
+ * into chunks of ChunkLength annotations that are taken from an arena. This
+ * keeps the memory needed per annotation at about 26 bytes. Their texts are
+ * interned as UTF-8 and converted to QString only when they're requested.
+ *
+ * In ring buffer mode, the oldest blocks of the arena are released once the
+ * annotations in them end before the oldest sample that is still stored.
+ * The annotations of the chunks in those blocks are dropped then.
+ *
+ * The columns hold the annotations in the order they were added, so their
+ * indices never change. Their order by start sample is kept separately, but
+ * only once an annotation arrived out of that order, which is rare.
+ *
+ * For every ChunkLength annotations in start sample order, the highest end
+ * sample among them and among all before them is known as well. Along with
+ * the sorted start samples, this lets range queries skip everything that
+ * ends before or starts after the range.
+ */
 class RowData
 {
 public:
-	RowData(Row* row);
+	/// Number of annotations per chunk of the columns
+	static const uint32_t ChunkLength = 256;
+
+public:
+	/**
+	 * @param arena The arena that the chunks are taken from. It must exist
+	 * as long as the RowData.
+	 */
+	RowData(Row* row, Arena* arena);
 
 	const Row* row() const;
 
 	uint64_t get_max_sample() const;
 
+	/// Returns the number of annotations that weren't dropped
 	uint64_t get_annotation_count() const;
 
+	/// Returns the index of the oldest annotation that wasn't dropped
+	uint32_t first_index() const;
+
 	/**
-	 * Extracts annotations between the given sample range into a vector.
-	 * Note: The annotations are unsorted and only annotations that fully
-	 * fit into the sample range are considered.
+	 * Extracts the annotations of visible classes that overlap the given
+	 * sample range, sorted by start sample.
 	 */
-	void get_annotation_subset(deque<const pv::data::decode::Annotation*> &dest,
+	void get_annotation_subset(deque<Annotation> &dest,
 		uint64_t start_sample, uint64_t end_sample) const;
 
-	const deque<Annotation>& annotations() const;
+	Annotation get_annotation(uint32_t index) const;
 
-	const Annotation* emplace_annotation(srd_proto_data *pdata);
+	/*
+	 * The annotations that were dropped read as empty annotations at
+	 * sample 0, as views may still refer to them until they're updated
+	 */
+	uint64_t start_sample(uint32_t index) const;
+	uint64_t end_sample(uint32_t index) const;
+	uint32_t ann_class_id(uint32_t index) const;
+
+	/**
+	 * Returns the texts of an annotation, longest first. They're stored one
+	 * after another, each terminated by a NUL and followed by an empty text.
+	 */
+	const char* texts(uint32_t index) const;
+
+	/**
+	 * Adds an annotation.
+	 * @param ann_texts The texts of the annotation, longest first and packed
+	 * the same way that texts() returns them.
+	 * @return The index of the annotation, which is the number of annotations
+	 * added before it.
+	 */
+	uint32_t emplace_annotation(uint64_t start_sample, uint64_t end_sample,
+		uint32_t ann_class_id, const char* ann_texts);
+
+	/**
+	 * Drops the annotations of the chunks that were in arena blocks which
+	 * were released, see Arena::release_blocks(). Their indices aren't
+	 * reused. The caller must make sure that no reader accesses the chunks
+	 * before the blocks are freed.
+	 */
+	void drop_released_annotations();
+
+	/// Returns the number of bytes used besides the chunks and texts in the arena
+	uint64_t get_memory_usage() const;
+
+private:
+	struct Chunk
+	{
+		uint64_t start_sample[ChunkLength];
+		uint64_t end_sample[ChunkLength];
+		const char* texts[ChunkLength];
+		uint16_t ann_class_id[ChunkLength];
+		uint64_t block;  ///< The arena block that holds the chunk
+	};
+
+	/// Returns the number of annotations that weren't dropped, which is also
+	/// the number of positions in start sample order
+	uint32_t position_count() const;
+
+	/// Returns the index of the annotation at @c position in start sample order
+	uint32_t index_at(uint32_t position) const;
+
+	/// Returns the position of the first annotation that starts after @c sample
+	uint32_t upper_bound_start(uint64_t sample) const;
+
+	/// Recomputes the end sample maxima from the block at @c first_block on
+	void update_max_end_samples(size_t first_block);
+
+	/**
+	 * Returns a copy of the given texts in the arena, adding it if needed.
+	 * Only the longest text is compared, so if the longest text is the same,
+	 * the shorter texts are expected to be the same, too. PDs that violate
+	 * this assumption should be considered broken.
+	 *
+	 * Only texts in the current block of the arena are shared, as the older
+	 * blocks may have been released.
+	 */
+	const char* intern_texts(const char* ann_texts);
+
+	void set_text_slot(const char* texts);
 
 private:
-	deque<Annotation> annotations_;
-	unordered_map<QString, vector<QString> > ann_texts_;  // unordered_map since pointers must not change
 	Row* row_;
+	Arena* arena_;
+
+	/// Readers may use the annotations they were handed while more are
+	/// added, so the chunks are kept in an array that never moves
+	StableArray<Chunk*> chunks_;
+	uint32_t count_;
+	/// The annotations before this index were dropped. Readers that don't
+	/// hold the lock of the owner check it, so it is atomic.
+	atomic<uint32_t> first_index_;
 	uint64_t prev_ann_start_sample_;
+
+	/// The annotation indices in start sample order, empty while that's the
+	/// order they were added in
+	vector<uint32_t> order_;
+
+	/// The highest end sample in each block of ChunkLength annotations in
+	/// start sample order, and in that block and all before it
+	vector<uint64_t> max_end_samples_;
+	vector<uint64_t> prefix_max_end_samples_;
+
+	/// A hash table of the interned texts in the arena block text_block_
+	vector<const char*> text_table_;
+	uint32_t text_count_;
+	uint64_t text_block_;
 };
 
 }  // namespace decode
@@ -19,11 +19,15 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <cstring>
 #include <forward_list>
+#include <iterator>
 #include <limits>
+#include <tuple>
 
 #include <QDebug>
+#include <QElapsedTimer>
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include <QRegularExpression>
 #endif
@@ -32,19 +36,34 @@
 #include "logicsegment.hpp"
 #include "decodesignal.hpp"
 #include "signaldata.hpp"
+#include "simd.hpp"
 
 #include <pv/data/decode/decoder.hpp>
 #include <pv/data/decode/row.hpp>
 #include <pv/globalsettings.hpp>
 #include <pv/session.hpp>
 
+using std::any_of;
+using std::back_inserter;
 using std::dynamic_pointer_cast;
+using std::find;
+using std::forward_as_tuple;
+using std::get;
 using std::lock_guard;
 using std::make_shared;
+using std::max;
+using std::merge;
 using std::min;
+using std::move;
 using std::out_of_range;
+using std::pair;
+using std::piecewise_construct;
+using std::remove_if;
 using std::shared_ptr;
+using std::stable_sort;
+using std::tuple;
 using std::unique_lock;
+using std::upper_bound;
 using pv::data::decode::AnnotationClass;
 using pv::data::decode::DecodeChannel;
 
@@ -54,18 +73,29 @@ namespace data {
 const double DecodeSignal::DecodeMargin = 1.0;
 const double DecodeSignal::DecodeThreshold = 0.2;
 const int64_t DecodeSignal::DecodeChunkLength = 256 * 1024;
+const int64_t DecodeSignal::MinDecodeChunkLength = 16 * 1024;
+const int64_t DecodeSignal::MaxDecodeChunkLength = 16 * 1024 * 1024;
+const int DecodeSignal::DecodeChunkDuration = 100;
+const int64_t DecodeSignal::MinDecodeSpanLength = 64 * 1024;
+const size_t DecodeSignal::MergeHistoryLength = 1024;
 
 
 DecodeSignal::DecodeSignal(pv::Session &session) :
 	SignalBase(nullptr, SignalBase::DecodeChannel),
 	session_(session),
-	srd_session_(nullptr),
+	decode_context_(this),
 	logic_mux_data_invalid_(false),
+	logic_mux_bypassed_(false),
 	stack_config_changed_(true),
-	current_segment_id_(0)
+	next_segment_id_(0),
+	decode_worker_count_(1),
+	decode_in_processes_(false),
+	all_segments_decoded_(false)
 {
 	connect(&session_, SIGNAL(capture_state_changed(int)),
 		this, SLOT(on_capture_state_changed(int)));
+	connect(this, SIGNAL(old_output_dropped()),
+		this, SLOT(on_old_output_dropped()));
 }
 
 DecodeSignal::~DecodeSignal()
@@ -170,7 +200,7 @@ void DecodeSignal::reset_decode(bool shutting_down)
 	if (stack_config_changed_ || shutting_down)
 		stop_srd_session();
 	else
-		terminate_srd_session();
+		terminate_srd_session(decode_context_);
 
 	if (decode_thread_.joinable()) {
 		decode_interrupt_ = true;
@@ -184,8 +214,11 @@ void DecodeSignal::reset_decode(bool shutting_down)
 		logic_mux_thread_.join();
 	}
 
-	current_segment_id_ = 0;
+	decode_context_.segment_id = 0;
+	decode_context_.clear_staged_output();
+	next_segment_id_ = 0;
 	segments_.clear();
+	all_segments_decoded_ = false;
 
 	for (const shared_ptr<decode::Decoder>& dec : stack_)
 		if (dec->has_logic_output())
@@ -246,11 +279,24 @@ void DecodeSignal::begin_decode()
 			return;
 		}
 
+	// The decoder instances are created with the channels' bit positions,
+	// so they must be recreated if switching between the input and the
+	// muxed data moved the channels
+	if (assign_bit_ids())
+		stop_srd_session();
+
 	// Free the logic data and its segment(s) if it needs to be updated
-	if (logic_mux_data_invalid_)
+	if (logic_mux_data_invalid_ || logic_mux_bypassed_)
 		logic_mux_data_.reset();
 
-	if (!logic_mux_data_) {
+	// If all channels come from the same data, which is the case for the
+	// channels of a single device, the decoders read it in place
+	const shared_ptr<Logic> shared_input = get_shared_input_data();
+	logic_mux_bypassed_ = (shared_input != nullptr);
+
+	if (logic_mux_bypassed_)
+		logic_mux_data_ = shared_input;
+	else if (!logic_mux_data_) {
 		const uint32_t ch_count = get_assigned_signal_count();
 		logic_mux_unit_size_ = (ch_count + 7) / 8;
 		logic_mux_data_ = make_shared<Logic>(ch_count);
@@ -259,6 +305,17 @@ void DecodeSignal::begin_decode()
 	if (get_input_segment_count() == 0)
 		set_error_message(tr("No input data"));
 
+	GlobalSettings settings;
+	decode_worker_count_ = max(1, settings.value(GlobalSettings::Key_Dec_WorkerCount).toInt());
+
+	// The session of the decoder stack is only kept if it's still used
+	const bool in_processes = settings.value(GlobalSettings::Key_Dec_RunInProcesses).toBool();
+	if (in_processes != decode_in_processes_)
+		stop_srd_session();
+	decode_in_processes_ = in_processes;
+
+	update_output_targets();
+
 	// Make sure the logic output data is complete and up-to-date
 	logic_mux_interrupt_ = false;
 	logic_mux_thread_ = std::thread(&DecodeSignal::logic_mux_proc, this);
@@ -276,9 +333,9 @@ void DecodeSignal::pause_decode()
 void DecodeSignal::resume_decode()
 {
 	// Manual unlocking is done before notifying, to avoid waking up the
-	// waiting thread only to block again (see notify_one for details)
+	// waiting threads only to block again (see notify_all for details)
 	decode_pause_mutex_.unlock();
-	decode_pause_cond_.notify_one();
+	decode_pause_cond_.notify_all();
 	decode_paused_ = false;
 }
 
@@ -579,7 +636,7 @@ uint64_t DecodeSignal::get_annotation_count(const Row* row, uint32_t segment_id)
 	return rd->get_annotation_count();
 }
 
-void DecodeSignal::get_annotation_subset(deque<const Annotation*> &dest,
+void DecodeSignal::get_annotation_subset(deque<Annotation> &dest,
 	const Row* row, uint32_t segment_id, uint64_t start_sample,
 	uint64_t end_sample) const
 {
@@ -601,7 +658,7 @@ void DecodeSignal::get_annotation_subset(deque<const Annotation*> &dest,
 	rd->get_annotation_subset(dest, start_sample, end_sample);
 }
 
-void DecodeSignal::get_annotation_subset(deque<const Annotation*> &dest,
+void DecodeSignal::get_annotation_subset(deque<Annotation> &dest,
 	uint32_t segment_id, uint64_t start_sample, uint64_t end_sample) const
 {
 	for (const Row* row : get_rows())
@@ -736,15 +793,111 @@ const DecodeBinaryClass* DecodeSignal::get_binary_data_class(uint32_t segment_id
 	return nullptr;
 }
 
-const deque<const Annotation*>* DecodeSignal::get_all_annotations_by_segment(
-	uint32_t segment_id) const
+const DecodeSegment* DecodeSignal::get_decode_segment(uint32_t segment_id) const
 {
 	if (segment_id >= segments_.size())
 		return nullptr;
 
-	const DecodeSegment *segment = &(segments_[segment_id]);
+	return &(segments_[segment_id]);
+}
+
+void DecodeSignal::update_all_annotations_copy(uint32_t segment_id,
+	deque<AnnotationRef> &dest, uint64_t &merge_count) const
+{
+	lock_guard<mutex> lock(output_mutex_);
+
+	if (segment_id >= segments_.size()) {
+		dest.clear();
+		merge_count = 0;
+		return;
+	}
+
+	const DecodeSegment& segment = segments_[segment_id];
+	const uint64_t history_start = segment.merge_count - segment.merge_positions.size();
+
+	// A merge only changes the list from where it started on, so the copy
+	// is still valid up to the earliest position of the merges it missed.
+	// If it missed more than are remembered, or the segment was reset, it
+	// is copied as a whole
+	size_t unchanged = 0;
+	if ((merge_count >= history_start) && (merge_count <= segment.merge_count)) {
+		unchanged = dest.size();
+		for (uint64_t i = merge_count; i < segment.merge_count; i++)
+			unchanged = min<size_t>(unchanged, segment.merge_positions[i - history_start]);
+	}
+
+	dest.erase(dest.begin() + unchanged, dest.end());
+	dest.insert(dest.end(), segment.all_annotations.begin() + unchanged,
+		segment.all_annotations.end());
+	merge_count = segment.merge_count;
+}
+
+vector< pair<uint64_t, uint64_t> > DecodeSignal::get_skipped_ranges(uint32_t segment_id) const
+{
+	lock_guard<mutex> lock(output_mutex_);
+
+	if (segment_id >= segments_.size())
+		return vector< pair<uint64_t, uint64_t> >();
+
+	const deque< pair<uint64_t, uint64_t> >& ranges = segments_[segment_id].skipped_ranges;
+	return vector< pair<uint64_t, uint64_t> >(ranges.begin(), ranges.end());
+}
+
+uint64_t DecodeSignal::get_mux_data_memory_usage() const
+{
+	if (!logic_mux_data_ || logic_mux_bypassed_)
+		return 0;
 
-	return &(segment->all_annotations);
+	return logic_mux_data_->get_memory_usage() +
+		logic_mux_data_->get_mipmap_memory_usage();
+}
+
+uint64_t DecodeSignal::get_annotation_memory_usage() const
+{
+	lock_guard<mutex> lock(output_mutex_);
+
+	uint64_t size = 0;
+
+	for (const DecodeSegment& segment : segments_) {
+		size += segment.annotation_arena.get_memory_usage();
+		for (const auto& row_data : segment.annotation_rows)
+			size += row_data.second.get_memory_usage();
+
+		size += segment.all_annotations.size() * sizeof(AnnotationRef);
+
+		for (const DecodeBinaryClass& bin_class : segment.binary_classes)
+			for (const DecodeBinaryDataChunk& chunk : bin_class.chunks)
+				size += sizeof(DecodeBinaryDataChunk) + chunk.data.size();
+	}
+
+	return size;
+}
+
+bool DecodeSignal::discard_mux_data()
+{
+	if (!logic_mux_data_ || logic_mux_bypassed_ || !all_segments_decoded_ ||
+		(session_.get_capture_state() != Session::Stopped))
+		return false;
+
+	// The threads only wait for more input data at this point, so they
+	// can be stopped without losing any results. The decoder session is
+	// kept as it is, reset_decode() takes care of it.
+	if (decode_thread_.joinable()) {
+		decode_interrupt_ = true;
+		decode_input_cond_.notify_one();
+		decode_thread_.join();
+	}
+
+	if (logic_mux_thread_.joinable()) {
+		logic_mux_interrupt_ = true;
+		logic_mux_cond_.notify_one();
+		logic_mux_thread_.join();
+	}
+
+	logic_mux_data_.reset();
+	logic_mux_data_invalid_ = true;
+
+	return true;
 }
 
 void DecodeSignal::save_settings(QSettings &settings) const
@@ -1006,13 +1159,89 @@ double DecodeSignal::get_input_samplerate(uint32_t segment_id) const
 	return samplerate;
 }
 
-Decoder* DecodeSignal::get_decoder_by_instance(const srd_decoder *const srd_dec)
+uint64_t DecodeSignal::get_input_sample_limit(uint32_t segment_id) const
 {
-	for (shared_ptr<Decoder>& d : stack_)
-		if (d->get_srd_decoder() == srd_dec)
-			return d.get();
+	uint64_t limit = 0;
 
-	return nullptr;
+	for (const decode::DecodeChannel& ch : channels_)
+		if (ch.assigned_signal) {
+			const shared_ptr<Logic> logic_data = ch.assigned_signal->logic_data();
+			if (!logic_data || (segment_id >= logic_data->logic_segments().size()))
+				continue;
+
+			const uint64_t segment_limit =
+				logic_data->logic_segments()[segment_id]->sample_limit();
+			if ((segment_limit > 0) && ((limit == 0) || (segment_limit < limit)))
+				limit = segment_limit;
+		}
+
+	return limit;
+}
+
+uint64_t DecodeSignal::get_input_first_sample(uint32_t segment_id) const
+{
+	uint64_t first_sample = 0;
+
+	for (const decode::DecodeChannel& ch : channels_)
+		if (ch.assigned_signal) {
+			const shared_ptr<Logic> logic_data = ch.assigned_signal->logic_data();
+			if (!logic_data || (segment_id >= logic_data->logic_segments().size()))
+				continue;
+
+			first_sample = max(first_sample,
+				logic_data->logic_segments()[segment_id]->get_first_sample());
+		}
+
+	return first_sample;
+}
+
+shared_ptr<Logic> DecodeSignal::get_shared_input_data() const
+{
+	shared_ptr<Logic> data;
+
+	for (const decode::DecodeChannel& ch : channels_)
+		if (ch.assigned_signal) {
+			const shared_ptr<Logic> logic_data = ch.assigned_signal->logic_data();
+			if (!logic_data || (data && (logic_data != data)))
+				return nullptr;
+
+			data = logic_data;
+		}
+
+	return data;
+}
+
+void DecodeSignal::update_output_targets()
+{
+	output_targets_.clear();
+
+	// The rows and binary classes are counted in the order that
+	// create_decode_segment() adds them to a segment in
+	uint32_t row_data_count = 0, binary_class_count = 0;
+
+	for (const shared_ptr<Decoder>& dec : stack_) {
+		DecoderOutputTarget target;
+		target.decoder = dec.get();
+		target.srd_dec = dec->get_srd_decoder();
+
+		const vector<Row*> rows = dec->get_rows();
+		for (const AnnotationClass* ann_class : dec->ann_classes()) {
+			// Classes that aren't assigned to a row go to the first one
+			const Row* row = ann_class->row ? ann_class->row : dec->get_row_by_id(0);
+			target.row_data_ids.push_back(row_data_count +
+				(find(rows.begin(), rows.end(), row) - rows.begin()));
+		}
+		row_data_count += rows.size();
+
+		target.first_binary_class = binary_class_count;
+		target.binary_class_count = dec->get_binary_class_count();
+		binary_class_count += target.binary_class_count;
+
+		target.logic_unit_size = dec->has_logic_output() ?
+			(dec->logic_output_channels().size() + 7) / 8 : 0;
+
+		output_targets_.push_back(target);
+	}
 }
 
 void DecodeSignal::update_channel_list()
@@ -1109,11 +1338,26 @@ void DecodeSignal::commit_decoder_channels()
 		dec->set_channels(channel_list);
 	}
 
-	// Channel bit IDs must be in sync with the channel's apperance in channels_
-	int id = 0;
+	assign_bit_ids();
+}
+
+bool DecodeSignal::assign_bit_ids()
+{
+	// Channels read in place keep their bit in the input samples, muxed
+	// channels are numbered in the order of their appearance in channels_
+	const bool in_place = (get_shared_input_data() != nullptr);
+	bool changed = false;
+	uint16_t id = 0;
+
 	for (decode::DecodeChannel& ch : channels_)
-		if (ch.assigned_signal)
-			ch.bit_id = id++;
+		if (ch.assigned_signal) {
+			const uint16_t bit_id = in_place ?
+				ch.assigned_signal->logic_bit_index() : id++;
+			changed = changed || (ch.bit_id != bit_id);
+			ch.bit_id = bit_id;
+		}
+
+	return changed;
 }
 
 void DecodeSignal::mux_logic_samples(uint32_t segment_id, const int64_t start, const int64_t end)
@@ -1122,11 +1366,12 @@ void DecodeSignal::mux_logic_samples(uint32_t segment_id, const int64_t start, c
 	if (end <= start)
 		return;
 
-	// Fetch the channel segments and their data
+	// Fetch the channel segments. The channels of a device share a segment,
+	// so the bits of all channels taken from the same one are gathered at
+	// once, input channel first going to output bit second.
 	vector<shared_ptr<const LogicSegment> > segments;
-	vector<const uint8_t*> signal_data;
-	vector<uint8_t> signal_in_bytepos;
-	vector<uint8_t> signal_in_bitpos;
+	vector< vector< pair<unsigned int, unsigned int> > > segment_bits;
+	unsigned int out_bit = 0;
 
 	for (decode::DecodeChannel& ch : channels_)
 		if (ch.assigned_signal) {
@@ -1145,15 +1390,15 @@ void DecodeSignal::mux_logic_samples(uint32_t segment_id, const int64_t start, c
 			if (!segment)
 				return;
 
-			segments.push_back(segment);
-
-			uint8_t* data = new uint8_t[(end - start) * segment->unit_size()];
-			segment->get_samples(start, end, data);
-			signal_data.push_back(data);
+			const auto it = find(segments.begin(), segments.end(), segment);
+			const size_t index = it - segments.begin();
+			if (it == segments.end()) {
+				segments.push_back(segment);
+				segment_bits.emplace_back();
+			}
 
-			const int bitpos = ch.assigned_signal->logic_bit_index();
-			signal_in_bytepos.push_back(bitpos / 8);
-			signal_in_bitpos.push_back(bitpos % 8);
+			segment_bits[index].emplace_back(
+				ch.assigned_signal->logic_bit_index(), out_bit++);
 		}
 
 	shared_ptr<LogicSegment> output_segment;
@@ -1167,42 +1412,36 @@ void DecodeSignal::mux_logic_samples(uint32_t segment_id, const int64_t start, c
 		return;
 	}
 
-	// Perform the muxing of signal data into the output data
-	uint8_t* output = new uint8_t[(end - start) * output_segment->unit_size()];
-	unsigned int signal_count = signal_data.size();
-
-	for (int64_t sample_cnt = 0; !logic_mux_interrupt_ && (sample_cnt < (end - start));
-		sample_cnt++) {
-
-		int bitpos = 0;
-		uint8_t bytepos = 0;
+	// The output samples are gathered as words, directly from the spans of
+	// the input data, into buffers that are kept for the next call
+	const uint64_t sample_count = end - start;
+	mux_gather_buffer_.assign(sample_count, 0);
 
-		const int out_sample_pos = sample_cnt * output_segment->unit_size();
-		for (unsigned int i = 0; i < output_segment->unit_size(); i++)
-			output[out_sample_pos + i] = 0;
+	for (size_t i = 0; (i < segments.size()) && !logic_mux_interrupt_; i++) {
+		const simd::BitGatherMap map(segments[i]->unit_size(), segment_bits[i]);
+		const Segment::DataView view(*segments[i], start, end);
 
-		for (unsigned int i = 0; i < signal_count; i++) {
-			const int in_sample_pos = sample_cnt * segments[i]->unit_size();
-			const uint8_t in_sample = 1 &
-				((signal_data[i][in_sample_pos + signal_in_bytepos[i]]) >> (signal_in_bitpos[i]));
+		uint64_t *out = mux_gather_buffer_.data();
+		for (const Segment::DataSpan& span : view.spans()) {
+			simd::gather_bits(span.data, out, span.sample_count, map);
+			out += span.sample_count;
+		}
+	}
 
-			const uint8_t out_sample = output[out_sample_pos + bytepos];
+	if (logic_mux_interrupt_)
+		return;
 
-			output[out_sample_pos + bytepos] = out_sample | (in_sample << bitpos);
+	const unsigned int unit_size = output_segment->unit_size();
+	mux_output_buffer_.resize(sample_count * unit_size);
 
-			bitpos++;
-			if (bitpos > 7) {
-				bitpos = 0;
-				bytepos++;
-			}
-		}
+	uint8_t *out = mux_output_buffer_.data();
+	for (uint64_t i = 0; i < sample_count; i++) {
+		const uint64_t value = mux_gather_buffer_[i];
+		for (unsigned int byte = 0; byte < unit_size; byte++)
+			*out++ = value >> (8 * byte);
 	}
 
-	output_segment->append_payload(output, (end - start) * output_segment->unit_size());
-	delete[] output;
-
-	for (const uint8_t* data : signal_data)
-		delete[] data;
+	output_segment->append_payload(mux_output_buffer_.data(), sample_count * unit_size);
 }
 
 void DecodeSignal::logic_mux_proc()
@@ -1222,6 +1461,18 @@ void DecodeSignal::logic_mux_proc()
 
 	assert(logic_mux_data_);
 
+	// The decoder reads the input segments in place, so new input data only
+	// needs to be passed on to it
+	if (logic_mux_bypassed_) {
+		while (!logic_mux_interrupt_) {
+			decode_input_cond_.notify_one();
+
+			unique_lock<mutex> logic_mux_lock(logic_mux_mutex_);
+			logic_mux_cond_.wait(logic_mux_lock);
+		}
+		return;
+	}
+
 	uint32_t segment_id = 0;
 
 	// Create initial logic mux segment
@@ -1231,6 +1482,9 @@ void DecodeSignal::logic_mux_proc()
 
 	output_segment->set_samplerate(get_input_samplerate(0));
 
+	// Don't keep more of the input than the input segments do
+	output_segment->set_sample_limit(get_input_sample_limit(0));
+
 	// Logic mux data is being updated
 	logic_mux_data_invalid_ = false;
 
@@ -1282,6 +1536,7 @@ void DecodeSignal::logic_mux_proc()
 					logic_mux_data_->push_segment(output_segment);
 
 					output_segment->set_samplerate(get_input_samplerate(segment_id));
+					output_segment->set_sample_limit(get_input_sample_limit(segment_id));
 				} else {
 					// Wait for more input data if we're processing the currently last segment
 					unique_lock<mutex> logic_mux_lock(logic_mux_mutex_);
@@ -1296,44 +1551,137 @@ void DecodeSignal::logic_mux_proc()
 	} while (!logic_mux_interrupt_);
 }
 
-void DecodeSignal::decode_data(
+bool DecodeSignal::claim_decode_segment(uint32_t &segment_id, bool complete_only)
+{
+	const deque< shared_ptr<LogicSegment> >& input_segments =
+		logic_mux_data_->logic_segments();
+
+	lock_guard<mutex> lock(output_mutex_);
+
+	if (next_segment_id_ >= input_segments.size())
+		return false;
+
+	const shared_ptr<LogicSegment> input_segment = input_segments.at(next_segment_id_);
+	if (complete_only && !input_segment->is_complete())
+		return false;
+
+	segment_id = next_segment_id_++;
+
+	// Create the segment and set its metadata. The segments are claimed in
+	// order, so its index matches the segment ID
+	create_decode_segment();
+	segments_.back().samplerate = input_segment->samplerate();
+	segments_.back().start_time = input_segment->start_time();
+
+	return true;
+}
+
+void DecodeSignal::decode_data(DecodeContext &context,
 	const int64_t abs_start_samplenum, const int64_t sample_count,
 	const shared_ptr<const LogicSegment> input_segment)
 {
 	const int64_t unit_size = input_segment->unit_size();
-	const int64_t chunk_sample_count = DecodeChunkLength / unit_size;
-
-	for (int64_t i = abs_start_samplenum;
-		!decode_interrupt_ && (i < (abs_start_samplenum + sample_count));
-		i += chunk_sample_count) {
-
-		const int64_t chunk_end = min(i + chunk_sample_count,
-			abs_start_samplenum + sample_count);
+	const int64_t end_samplenum = abs_start_samplenum + sample_count;
+	const bool ring_buffer = (input_segment->sample_limit() > 0);
+
+	// With the muxer in between, the input segment is the mux output, which
+	// may hold zeros in place of input samples it read after they were
+	// dropped. Those count as dropped as well.
+	const auto first_stored_sample = [&]() -> int64_t {
+		return max(input_segment->get_first_sample(),
+			get_input_first_sample(context.segment_id)); };
+
+	for (int64_t i = abs_start_samplenum; !decode_interrupt_ && (i < end_samplenum);) {
+		const int64_t chunk_sample_count = context.chunk_length / unit_size;
+		const int64_t chunk_end = min(i + chunk_sample_count, end_samplenum);
+
+		// If the input is a ring buffer and we fell behind, the samples we
+		// missed are gone and read as zeros. Rather than decoding those, the
+		// decoders continue with the oldest sample that is still stored
+		if (ring_buffer && (i < first_stored_sample())) {
+			const int64_t first_sample = min(first_stored_sample(), end_samplenum);
+			skip_dropped_samples(context, i, first_sample);
+			i = first_sample;
+			continue;
+		}
 
 		{
 			lock_guard<mutex> lock(output_mutex_);
 			// Update the sample count showing the samples including currently processed ones
-			segments_.at(current_segment_id_).samples_decoded_incl = chunk_end;
+			segments_.at(context.segment_id).samples_decoded_incl = chunk_end;
 		}
 
-		int64_t data_size = (chunk_end - i) * unit_size;
-		uint8_t* chunk = new uint8_t[data_size];
-		input_segment->get_samples(i, chunk_end, chunk);
+		QElapsedTimer decode_time;
+		decode_time.start();
+
+		// Hand the samples to the decoder right from the segment's storage.
+		// Where a chunk boundary of the segment leaves a short span, the
+		// chunk is sent in one piece from the staging buffer instead, as
+		// every call has some overhead in the decoders.
+		{
+			Segment::DataView view(*input_segment, i, chunk_end);
+
+			// The view keeps the chunks it refers to, but some of them may
+			// have been dropped before it was created
+			if (ring_buffer && (i < first_stored_sample()))
+				continue;
+
+			vector<Segment::DataSpan> spans = view.spans();
+
+			if ((spans.size() > 1) && any_of(spans.begin(), spans.end(),
+				[&](const Segment::DataSpan& span) {
+					return (int64_t)span.sample_count * unit_size < MinDecodeSpanLength; }))
+				spans = {{view.contiguous_data(context.staging_buffer),
+					(uint64_t)(chunk_end - i)}};
+
+			int64_t span_start = i;
+			for (const Segment::DataSpan& span : spans) {
+				const int64_t span_end = span_start + span.sample_count;
 
-		if (srd_session_send(srd_session_, i, chunk_end, chunk,
-				data_size, unit_size) != SRD_OK) {
-			set_error_message(tr("Decoder reported an error"));
-			decode_interrupt_ = true;
+				if (!send_samples(context, span_start, span_end, span.data,
+						span.sample_count * unit_size, unit_size)) {
+					if (!decode_interrupt_)
+						set_error_message(tr("Decoder reported an error"));
+					decode_interrupt_ = true;
+					break;
+				}
+
+				span_start = span_end;
+			}
 		}
 
-		delete[] chunk;
+		// Slow decoders get shorter chunks so that their progress is shown
+		// often, fast ones longer chunks so that they're called less often
+		if (chunk_end - i == chunk_sample_count) {
+			if (decode_time.elapsed() < DecodeChunkDuration / 2)
+				context.chunk_length = min(2 * context.chunk_length, MaxDecodeChunkLength);
+			else if (decode_time.elapsed() > 2 * DecodeChunkDuration)
+				context.chunk_length = max(context.chunk_length / 2,
+					max(MinDecodeChunkLength, unit_size));
+		}
 
+		// The output of the chunk is added at once, so that the lock isn't
+		// taken for every annotation
+		vector< pair<Decoder*, uint32_t> > bin_classes;
 		{
 			lock_guard<mutex> lock(output_mutex_);
+			DecodeSegment& segment = segments_.at(context.segment_id);
+			bin_classes = commit_staged_output(context, segment);
 			// Now that all samples are processed, the exclusive sample count catches up
-			segments_.at(current_segment_id_).samples_decoded_excl = chunk_end;
+			segment.samples_decoded_excl = chunk_end;
+
+			if (ring_buffer)
+				drop_old_output(segment, first_stored_sample());
 		}
 
+		for (const pair<Decoder*, uint32_t>& bin_class : bin_classes)
+			new_binary_data(context.segment_id, (void*)bin_class.first, bin_class.second);
+
+		if (ring_buffer)
+			old_output_dropped();
+
+		i = chunk_end;
+
 		// Notify the frontend that we processed some data and
 		// possibly have new annotations as well
 		new_annotations();
@@ -1345,9 +1693,32 @@ void DecodeSignal::decode_data(
 	}
 }
 
+void DecodeSignal::skip_dropped_samples(DecodeContext &context,
+	uint64_t start, uint64_t end)
+{
+	qWarning().nospace() << name() << ": decoder fell behind the ring buffer, " <<
+		"input samples " << start << " to " << end << " were dropped before they were decoded";
+
+	// The decoders expect the sample numbers to be continuous, so they must
+	// start over unless they didn't get any samples since they were reset
+	if (start > context.sample_offset)
+		reset_decoders(context);
+	context.sample_offset = end;
+
+	// The skipped samples are shown as not decoded
+	lock_guard<mutex> lock(output_mutex_);
+	deque< pair<uint64_t, uint64_t> >& ranges =
+		segments_.at(context.segment_id).skipped_ranges;
+
+	if (!ranges.empty() && (ranges.back().second >= start))
+		ranges.back().second = max(ranges.back().second, end);
+	else
+		ranges.emplace_back(start, end);
+}
+
 void DecodeSignal::decode_proc()
 {
-	current_segment_id_ = 0;
+	decode_context_.chunk_length = DecodeChunkLength;
 
 	// If there is no input data available yet, wait until it is or we're interrupted
 	do {
@@ -1361,16 +1732,16 @@ void DecodeSignal::decode_proc()
 	if (decode_interrupt_)
 		return;
 
+	// Claim the initial segment so that we can pass its sample rate to SRD
+	if (!claim_decode_segment(decode_context_.segment_id, false))
+		return;
+
 	shared_ptr<const LogicSegment> input_segment = logic_mux_data_->logic_segments().front()->get_shared_ptr();
 	if (!input_segment)
 		return;
 
-	// Create the initial segment and set its sample rate so that we can pass it to SRD
-	create_decode_segment();
-	segments_.at(current_segment_id_).samplerate = input_segment->samplerate();
-	segments_.at(current_segment_id_).start_time = input_segment->start_time();
-
 	start_srd_session();
+	start_decode_workers();
 
 	uint64_t samples_to_process = 0;
 	uint64_t abs_start_samplenum = 0;
@@ -1380,7 +1751,7 @@ void DecodeSignal::decode_proc()
 			samples_to_process = input_segment->get_sample_count() - abs_start_samplenum;
 
 			if (samples_to_process > 0) {
-				decode_data(abs_start_samplenum, samples_to_process, input_segment);
+				decode_data(decode_context_, abs_start_samplenum, samples_to_process, input_segment);
 				abs_start_samplenum += samples_to_process;
 			}
 		} while (!decode_interrupt_ && (samples_to_process > 0));
@@ -1390,40 +1761,37 @@ void DecodeSignal::decode_proc()
 
 			// If the input segment is complete, we've exhausted this segment
 			if (input_segment->is_complete()) {
-#if defined HAVE_SRD_SESSION_SEND_EOF && HAVE_SRD_SESSION_SEND_EOF
 				// Tell protocol decoders about the end of
 				// the input data, which may result in more
 				// annotations being emitted
-				(void)srd_session_send_eof(srd_session_);
+				send_eof(decode_context_);
 				new_annotations();
-#endif
-
-				if (current_segment_id_ < (logic_mux_data_->logic_segments().size() - 1)) {
-					// Process next segment
-					current_segment_id_++;
 
+				// Process the next segment that no worker took yet
+				if (claim_decode_segment(decode_context_.segment_id, false)) {
 					try {
-						input_segment = logic_mux_data_->logic_segments().at(current_segment_id_);
+						input_segment = logic_mux_data_->logic_segments().at(decode_context_.segment_id);
 					} catch (out_of_range&) {
 						qDebug() << "Decode error for" << name() << ": no logic mux segment" \
-							<< current_segment_id_ << "in decode_proc(), mux segments size is" \
+							<< decode_context_.segment_id << "in decode_proc(), mux segments size is" \
 							<< logic_mux_data_->logic_segments().size();
 						decode_interrupt_ = true;
-						return;
+						break;
 					}
 					abs_start_samplenum = 0;
 
-					// Create the next segment and set its metadata
-					create_decode_segment();
-					segments_.at(current_segment_id_).samplerate = input_segment->samplerate();
-					segments_.at(current_segment_id_).start_time = input_segment->start_time();
-
 					// Reset decoder state but keep the decoder stack intact
-					terminate_srd_session();
+					reset_decoders(decode_context_);
+
+					start_decode_workers();
 				} else {
-					// All segments have been processed
-					if (!decode_interrupt_)
+					// All segments have been processed once the workers are done
+					join_decode_workers();
+
+					if (!decode_interrupt_) {
+						all_segments_decoded_ = true;
 						decode_finished();
+					}
 
 					// Wait for more input data
 					unique_lock<mutex> input_wait_lock(input_mutex_);
@@ -1437,113 +1805,204 @@ void DecodeSignal::decode_proc()
 
 		}
 	} while (!decode_interrupt_);
+
+	join_decode_workers();
+
+	// The helper process belongs to this thread
+	decode_context_.process.reset();
 }
 
-void DecodeSignal::start_srd_session()
+void DecodeSignal::start_decode_workers()
 {
-	// If there were stack changes, the session has been destroyed by now, so if
-	// it hasn't been destroyed, we can just reset and re-use it
-	if (srd_session_) {
-		// When a decoder stack was created before, re-use it
-		// for the next stream of input data, after terminating
-		// potentially still executing operations, and resetting
-		// internal state. Skip the rather expensive (teardown
-		// and) construction of another decoder stack.
+	// The logic output of a decoder is appended to a single segment, so it
+	// must be generated one segment after the other
+	for (const shared_ptr<Decoder>& dec : stack_)
+		if (dec->has_logic_output())
+			return;
 
-		// TODO Reduce redundancy, use a common code path for
-		// the meta/start sequence?
-		terminate_srd_session();
+	const deque< shared_ptr<LogicSegment> >& input_segments =
+		logic_mux_data_->logic_segments();
 
-		// Metadata is cleared also, so re-set it
-		uint64_t samplerate = 0;
-		if (segments_.size() > 0)
-			samplerate = segments_.at(current_segment_id_).samplerate;
-		if (samplerate)
-			srd_session_metadata_set(srd_session_, SRD_CONF_SAMPLERATE,
-				g_variant_new_uint64(samplerate));
-		for (const shared_ptr<Decoder>& dec : stack_)
-			dec->apply_all_options();
-		srd_session_start(srd_session_);
+	while ((int)decode_workers_.size() < decode_worker_count_ - 1) {
+		{
+			lock_guard<mutex> lock(output_mutex_);
+			if ((next_segment_id_ >= input_segments.size()) ||
+				!input_segments.at(next_segment_id_)->is_complete())
+				return;
+		}
 
-		return;
+		decode_workers_.emplace_back(&DecodeSignal::decode_worker_proc, this);
 	}
+}
 
-	// Update the samplerates for the output logic channels
-	update_output_signals();
+void DecodeSignal::join_decode_workers()
+{
+	for (std::thread& worker : decode_workers_)
+		worker.join();
+
+	decode_workers_.clear();
+}
+
+void DecodeSignal::decode_worker_proc()
+{
+	DecodeContext context(this);
+	context.chunk_length = DecodeChunkLength;
+
+	while (!decode_interrupt_ && claim_decode_segment(context.segment_id, true)) {
+		const shared_ptr<const LogicSegment> input_segment =
+			logic_mux_data_->logic_segments().at(context.segment_id);
+
+		// Like decode_proc(), keep the decoder stack for the next segment
+		if (context.session || context.process)
+			reset_decoders(context);
+		else if (!create_srd_session(context, false))
+			break;
+
+		decode_data(context, 0, input_segment->get_sample_count(), input_segment);
+
+		if (!decode_interrupt_) {
+			send_eof(context);
+			new_annotations();
+		}
+	}
+
+	if (context.session)
+		srd_session_destroy(context.session);
+}
+
+uint64_t DecodeSignal::get_decode_segment_samplerate(uint32_t segment_id) const
+{
+	lock_guard<mutex> lock(output_mutex_);
+
+	if (segment_id >= segments_.size())
+		return 0;
+
+	return segments_[segment_id].samplerate;
+}
+
+bool DecodeSignal::create_srd_session(DecodeContext &context, bool main_session)
+{
+	context.sample_offset = 0;
+
+	if (decode_in_processes_) {
+		context.process.reset(new decode::DecodeProcess(context, decode_interrupt_));
+
+		if (!context.process->start(stack_, get_decode_segment_samplerate(context.segment_id))) {
+			set_error_message(tr("Failed to start decoder process"));
+			context.process.reset();
+			return false;
+		}
+
+		return true;
+	}
 
 	// Create the session
-	srd_session_new(&srd_session_);
-	assert(srd_session_);
+	srd_session_new(&context.session);
+	assert(context.session);
 
 	// Create the decoders
+	context.instances.clear();
 	srd_decoder_inst *prev_di = nullptr;
 	for (const shared_ptr<Decoder>& dec : stack_) {
-		srd_decoder_inst *const di = dec->create_decoder_inst(srd_session_);
+		srd_decoder_inst *const di = main_session ?
+			dec->create_decoder_inst(context.session) :
+			dec->create_extra_decoder_inst(context.session);
 
 		if (!di) {
 			set_error_message(tr("Failed to create decoder instance"));
-			srd_session_destroy(srd_session_);
-			srd_session_ = nullptr;
-			return;
+			srd_session_destroy(context.session);
+			context.session = nullptr;
+			return false;
 		}
 
 		if (prev_di)
-			srd_inst_stack(srd_session_, prev_di, di);
+			srd_inst_stack(context.session, prev_di, di);
 
+		context.instances.push_back(di);
 		prev_di = di;
 	}
 
 	// Start the session
-	if (segments_.size() > 0)
-		srd_session_metadata_set(srd_session_, SRD_CONF_SAMPLERATE,
-			g_variant_new_uint64(segments_.at(current_segment_id_).samplerate));
+	const uint64_t samplerate = get_decode_segment_samplerate(context.segment_id);
+	if (samplerate)
+		srd_session_metadata_set(context.session, SRD_CONF_SAMPLERATE,
+			g_variant_new_uint64(samplerate));
 
-	srd_pd_output_callback_add(srd_session_, SRD_OUTPUT_ANN,
-		DecodeSignal::annotation_callback, this);
+	srd_pd_output_callback_add(context.session, SRD_OUTPUT_ANN,
+		DecodeSignal::annotation_callback, &context);
 
-	srd_pd_output_callback_add(srd_session_, SRD_OUTPUT_BINARY,
-		DecodeSignal::binary_callback, this);
+	srd_pd_output_callback_add(context.session, SRD_OUTPUT_BINARY,
+		DecodeSignal::binary_callback, &context);
 
-	srd_pd_output_callback_add(srd_session_, SRD_OUTPUT_LOGIC,
-		DecodeSignal::logic_output_callback, this);
+	srd_pd_output_callback_add(context.session, SRD_OUTPUT_LOGIC,
+		DecodeSignal::logic_output_callback, &context);
+
+	srd_session_start(context.session);
+
+	return true;
+}
 
-	srd_session_start(srd_session_);
+void DecodeSignal::start_srd_session()
+{
+	decode_context_.sample_offset = 0;
+
+	// If there were stack changes, the session has been destroyed by now, so if
+	// it hasn't been destroyed, we can just reset and re-use it
+	if (decode_context_.session) {
+		// When a decoder stack was created before, re-use it
+		// for the next stream of input data, after terminating
+		// potentially still executing operations, and resetting
+		// internal state. Skip the rather expensive (teardown
+		// and) construction of another decoder stack.
+
+		// TODO Reduce redundancy, use a common code path for
+		// the meta/start sequence?
+		terminate_srd_session(decode_context_);
+		srd_session_start(decode_context_.session);
+
+		return;
+	}
+
+	// Update the samplerates for the output logic channels
+	update_output_signals();
+
+	if (!create_srd_session(decode_context_, true))
+		return;
 
 	// We just recreated the srd session, so all stack changes are applied now
 	stack_config_changed_ = false;
 }
 
-void DecodeSignal::terminate_srd_session()
+void DecodeSignal::terminate_srd_session(DecodeContext &context)
 {
 	// Call the "terminate and reset" routine for the decoder stack
 	// (if available). This does not harm those stacks which already
 	// have completed their operation, and reduces response time for
 	// those stacks which still are processing data while the
 	// application no longer wants them to.
-	if (srd_session_) {
+	if (context.session) {
 #if defined HAVE_SRD_SESSION_SEND_EOF && HAVE_SRD_SESSION_SEND_EOF
-		(void)srd_session_send_eof(srd_session_);
+		(void)srd_session_send_eof(context.session);
 #endif
-		srd_session_terminate_reset(srd_session_);
+		srd_session_terminate_reset(context.session);
 
 		// Metadata is cleared also, so re-set it
-		uint64_t samplerate = 0;
-		if (segments_.size() > 0)
-			samplerate = segments_.at(current_segment_id_).samplerate;
+		const uint64_t samplerate = get_decode_segment_samplerate(context.segment_id);
 		if (samplerate)
-			srd_session_metadata_set(srd_session_, SRD_CONF_SAMPLERATE,
+			srd_session_metadata_set(context.session, SRD_CONF_SAMPLERATE,
 				g_variant_new_uint64(samplerate));
-		for (const shared_ptr<Decoder>& dec : stack_)
-			dec->apply_all_options();
+		for (size_t i = 0; i < context.instances.size(); i++)
+			stack_.at(i)->apply_all_options(context.instances[i]);
 	}
 }
 
 void DecodeSignal::stop_srd_session()
 {
-	if (srd_session_) {
+	if (decode_context_.session) {
 		// Destroy the session
-		srd_session_destroy(srd_session_);
-		srd_session_ = nullptr;
+		srd_session_destroy(decode_context_.session);
+		decode_context_.session = nullptr;
+		decode_context_.instances.clear();
 
 		// Mark the decoder instances as non-existant since they were deleted
 		for (const shared_ptr<Decoder>& dec : stack_)
@@ -1551,6 +2010,54 @@ void DecodeSignal::stop_srd_session()
 	}
 }
 
+void DecodeSignal::reset_decoders(DecodeContext &context)
+{
+	if (context.process)
+		context.process->reset(get_decode_segment_samplerate(context.segment_id));
+	else
+		terminate_srd_session(context);
+
+	context.sample_offset = 0;
+}
+
+bool DecodeSignal::send_samples(DecodeContext &context, uint64_t start_sample,
+	uint64_t end_sample, const uint8_t *data, uint64_t size, unsigned int unit_size)
+{
+	// The decoders count the samples from where they started, the callbacks
+	// add the offset back to their output
+	start_sample -= context.sample_offset;
+	end_sample -= context.sample_offset;
+
+	if (context.process)
+		return context.process->send(start_sample, end_sample, data, size, unit_size);
+
+	return (srd_session_send(context.session, start_sample, end_sample, data,
+		size, unit_size) == SRD_OK);
+}
+
+void DecodeSignal::send_eof(DecodeContext &context)
+{
+	if (context.process)
+		context.process->send_eof();
+#if defined HAVE_SRD_SESSION_SEND_EOF && HAVE_SRD_SESSION_SEND_EOF
+	else
+		(void)srd_session_send_eof(context.session);
+#endif
+
+	// The decoders may have flushed their output
+	vector< pair<Decoder*, uint32_t> > bin_classes;
+	{
+		lock_guard<mutex> lock(output_mutex_);
+		if (context.segment_id < segments_.size())
+			bin_classes = commit_staged_output(context, segments_[context.segment_id]);
+		else
+			context.clear_staged_output();
+	}
+
+	for (const pair<Decoder*, uint32_t>& bin_class : bin_classes)
+		new_binary_data(context.segment_id, (void*)bin_class.first, bin_class.second);
+}
+
 void DecodeSignal::connect_input_notifiers()
 {
 	// Connect the currently used signals to our slot
@@ -1591,9 +2098,15 @@ void DecodeSignal::create_decode_segment()
 	segments_.emplace_back();
 
 	// Add annotation classes
+	DecodeSegment& segment = segments_.back();
 	for (const shared_ptr<Decoder>& dec : stack_)
-		for (Row* row : dec->get_rows())
-			segments_.back().annotation_rows.emplace(row, RowData(row));
+		for (Row* row : dec->get_rows()) {
+			// RowData can't be moved, so it's constructed in place
+			RowData& row_data = segment.annotation_rows.emplace(piecewise_construct,
+				forward_as_tuple(row),
+				forward_as_tuple(row, &segment.annotation_arena)).first->second;
+			segment.row_data.push_back(&row_data);
+		}
 
 	// Prepare our binary output classes
 	for (const shared_ptr<Decoder>& dec : stack_) {
@@ -1605,229 +2118,328 @@ void DecodeSignal::create_decode_segment()
 	}
 }
 
-void DecodeSignal::annotation_callback(srd_proto_data *pdata, void *decode_signal)
+void DecodeSignal::merge_pending_annotations(DecodeSegment &segment)
 {
-	assert(pdata);
-	assert(decode_signal);
-
-	DecodeSignal *const ds = (DecodeSignal*)decode_signal;
-	assert(ds);
+	vector<AnnotationRef>& pending = segment.pending_annotations;
+	deque<AnnotationRef>& all_annotations = segment.all_annotations;
 
-	if (ds->decode_interrupt_)
+	if (pending.empty())
 		return;
 
-	if (ds->segments_.empty())
-		return;
+	// The global annotation list is sorted by start sample and length, so
+	// that the model doesn't need to be sorted, which is expensive
+	const auto less = [&segment](const AnnotationRef& a, const AnnotationRef& b) {
+		const Annotation ann_a = segment.annotation(a);
+		const Annotation ann_b = segment.annotation(b);
+		return (ann_a.start_sample() < ann_b.start_sample()) ||
+			((ann_a.start_sample() == ann_b.start_sample()) &&
+			(ann_a.length() > ann_b.length()));
+	};
 
-	lock_guard<mutex> lock(ds->output_mutex_);
+	stable_sort(pending.begin(), pending.end(), less);
 
-	// Get the decoder and the annotation data
-	assert(pdata->pdo);
-	assert(pdata->pdo->di);
-	const srd_decoder *const srd_dec = pdata->pdo->di->decoder;
-	assert(srd_dec);
+	// Only the tail of the list that sorts after the first new annotation
+	// needs to be merged, which usually is short. Annotations that sort the
+	// same stay in the order they were added in
+	const auto tail_start = upper_bound(all_annotations.begin(),
+		all_annotations.end(), pending.front(), less);
+	const vector<AnnotationRef> tail(tail_start, all_annotations.end());
 
-	const srd_proto_data_annotation *const pda = (const srd_proto_data_annotation*)pdata->data;
-	assert(pda);
+	add_merge_position(segment, tail_start - all_annotations.begin());
+
+	all_annotations.erase(tail_start, all_annotations.end());
+	merge(tail.begin(), tail.end(), pending.begin(), pending.end(),
+		back_inserter(all_annotations), less);
 
-	// Find the row
-	Decoder* dec = ds->get_decoder_by_instance(srd_dec);
-	assert(dec);
+	pending.clear();
+}
 
-	AnnotationClass* ann_class = dec->get_ann_class_by_id(pda->ann_class);
-	if (!ann_class) {
-		qWarning() << "Decoder" << ds->display_name() << "wanted to add annotation" <<
-			"with class ID" << pda->ann_class << "but there are only" <<
-			dec->ann_classes().size() << "known classes";
+void DecodeSignal::add_merge_position(DecodeSegment &segment, uint64_t position)
+{
+	segment.merge_positions.push_back(position);
+	if (segment.merge_positions.size() > MergeHistoryLength)
+		segment.merge_positions.pop_front();
+	segment.merge_count++;
+}
+
+void DecodeSignal::drop_old_output(DecodeSegment &segment, uint64_t first_sample)
+{
+	segment.first_sample = first_sample;
+
+	while (!segment.skipped_ranges.empty() &&
+		(segment.skipped_ranges.front().second <= first_sample))
+		segment.skipped_ranges.pop_front();
+
+	vector< unique_ptr<uint8_t[]> > blocks =
+		segment.annotation_arena.release_blocks(first_sample);
+	if (blocks.empty())
 		return;
+
+	for (RowData* row_data : segment.row_data)
+		row_data->drop_released_annotations();
+
+	// The annotations were dropped by chunk, so there may be any number of
+	// them in all_annotations. Copies of the list are replaced as a whole.
+	deque<AnnotationRef>& all_annotations = segment.all_annotations;
+	all_annotations.erase(remove_if(all_annotations.begin(), all_annotations.end(),
+		[&segment](const AnnotationRef& ref) {
+			return ref.index < segment.row_data[ref.row]->first_index(); }),
+		all_annotations.end());
+
+	add_merge_position(segment, 0);
+
+	for (unique_ptr<uint8_t[]>& block : blocks)
+		dropped_output_.push_back(move(block));
+}
+
+vector< pair<Decoder*, uint32_t> > DecodeSignal::commit_staged_output(
+	DecodeContext &context, DecodeSegment &segment)
+{
+	for (const DecodeContext::StagedAnnotation& ann : context.staged_annotations) {
+		const uint32_t index = segment.row_data[ann.row_data_id]->emplace_annotation(
+			ann.start_sample, ann.end_sample, ann.ann_class_id,
+			context.staged_texts.data() + ann.text_offset);
+		segment.pending_annotations.push_back({ann.row_data_id, index});
 	}
 
-	const Row* row = ann_class->row;
+	merge_pending_annotations(segment);
 
-	if (!row)
-		row = dec->get_row_by_id(0);
+	vector< pair<Decoder*, uint32_t> > bin_classes;
 
-	RowData& row_data = ds->segments_[ds->current_segment_id_].annotation_rows.at(row);
+	for (DecodeContext::StagedBinaryData& data : context.staged_binary_data) {
+		const DecoderOutputTarget& target = output_targets_[data.decoder_index];
+		segment.binary_classes[target.first_binary_class + data.bin_class_id]
+			.chunks.push_back(move(data.chunk));
 
-	// Add the annotation to the row
-	const Annotation* ann = row_data.emplace_annotation(pdata);
+		const pair<Decoder*, uint32_t> bin_class(target.decoder, data.bin_class_id);
+		if (find(bin_classes.begin(), bin_classes.end(), bin_class) == bin_classes.end())
+			bin_classes.push_back(bin_class);
+	}
 
-	// We insert the annotation into the global annotation list in a way so that
-	// the annotation list is sorted by start sample and length. Otherwise, we'd
-	// have to sort the model, which is expensive
-	deque<const Annotation*>& all_annotations =
-		ds->segments_[ds->current_segment_id_].all_annotations;
+	for (const DecodeContext::StagedLogicOutput& output : context.staged_logic_output) {
+		shared_ptr<Logic> output_logic =
+			output_logic_.at(output_targets_[output.decoder_index].srd_dec);
 
-	if (all_annotations.empty()) {
-		all_annotations.emplace_back(ann);
-	} else {
-		const uint64_t new_ann_len = (pdata->end_sample - pdata->start_sample);
-		bool ann_has_earlier_start = (pdata->start_sample < all_annotations.back()->start_sample());
-		bool ann_is_longer = (new_ann_len >
-			(all_annotations.back()->end_sample() - all_annotations.back()->start_sample()));
-
-		if (ann_has_earlier_start && ann_is_longer) {
-			bool ann_has_same_start;
-			auto it = all_annotations.end();
-
-			do {
-				it--;
-				ann_has_earlier_start = (pdata->start_sample < (*it)->start_sample());
-				ann_has_same_start = (pdata->start_sample == (*it)->start_sample());
-				ann_is_longer = (new_ann_len > (*it)->length());
-			} while ((ann_has_earlier_start || (ann_has_same_start && ann_is_longer)) && (it != all_annotations.begin()));
-
-			// Allow inserting at the front
-			if (it != all_annotations.begin())
-				it++;
-
-			all_annotations.emplace(it, ann);
-		} else
-			all_annotations.emplace_back(ann);
+		vector< shared_ptr<Segment> > segments = output_logic->segments();
+
+		shared_ptr<LogicSegment> last_segment;
+
+		if (!segments.empty())
+			last_segment = dynamic_pointer_cast<LogicSegment>(segments.back());
+		else {
+			// Happens when the data was cleared - all segments are gone then
+			// segment_id is always 0 as it's the first segment
+			last_segment = make_shared<data::LogicSegment>(
+				*output_logic, 0, (output_logic->num_channels() + 7) / 8, output_logic->get_samplerate());
+			output_logic->push_segment(last_segment);
+		}
+
+		last_segment->append_payload(context.staged_logic_data.data() + output.data_offset,
+			output.data_size);
 	}
 
-	// When emplace_annotation() inserts instead of appends an annotation,
-	// the pointers in all_annotations that follow the inserted annotation and
-	// point to annotations for this row are off by one and must be updated
-	if (&(row_data.annotations().back()) != ann) {
-		// Search backwards until we find the annotation we just added
-		auto row_it = row_data.annotations().end();
-		auto all_it = all_annotations.end();
-		do {
-			all_it--;
-			if ((*all_it)->row_data() == &row_data)
-				row_it--;
-		} while (&(*row_it) != ann);
+	context.clear_staged_output();
 
-		// Update the annotation addresses for this row's annotations until the end
-		do {
-			if ((*all_it)->row_data() == &row_data) {
-				*all_it = &(*row_it);
-				row_it++;
-			}
-			all_it++;
-		} while (all_it != all_annotations.end());
+	return bin_classes;
+}
+
+void DecodeSignal::add_annotation(DecodeContext &context, uint32_t decoder_index,
+	uint32_t ann_class_id, uint64_t start_sample, uint64_t end_sample,
+	const char* const* ann_texts)
+{
+	if (decode_interrupt_)
+		return;
+
+	assert(decoder_index < output_targets_.size());
+	const DecoderOutputTarget& target = output_targets_[decoder_index];
+
+	if (ann_class_id >= target.row_data_ids.size()) {
+		qWarning() << "Decoder" << display_name() << "wanted to add annotation" <<
+			"with class ID" << ann_class_id << "but there are only" <<
+			target.row_data_ids.size() << "known classes";
+		return;
 	}
+
+	// Pack the texts the way that RowData stores them
+	vector<char>& texts = context.staged_texts;
+	const uint32_t text_offset = texts.size();
+	for (const char* const* text = ann_texts; *text; text++)
+		texts.insert(texts.end(), *text, *text + strlen(*text) + 1);
+	texts.push_back('\0');
+
+	context.staged_annotations.push_back({context.sample_offset + start_sample,
+		context.sample_offset + end_sample, target.row_data_ids[ann_class_id],
+		ann_class_id, text_offset});
 }
 
-void DecodeSignal::binary_callback(srd_proto_data *pdata, void *decode_signal)
+void DecodeSignal::add_binary_data(DecodeContext &context, uint32_t decoder_index,
+	uint32_t bin_class_id, uint64_t sample, const void *data, uint64_t size)
 {
-	assert(pdata);
-	assert(decode_signal);
+	if (decode_interrupt_)
+		return;
 
-	DecodeSignal *const ds = (DecodeSignal*)decode_signal;
-	assert(ds);
+	assert(decoder_index < output_targets_.size());
+	const DecoderOutputTarget& target = output_targets_[decoder_index];
 
-	if (ds->decode_interrupt_)
+	if (bin_class_id >= target.binary_class_count) {
+		qWarning() << "Decoder" << display_name() << "wanted to add binary data" <<
+			"with class ID" << bin_class_id << "but there are only" <<
+			target.binary_class_count << "known classes";
 		return;
+	}
 
-	// Get the decoder and the binary data
-	assert(pdata->pdo);
-	assert(pdata->pdo->di);
-	const srd_decoder *const srd_dec = pdata->pdo->di->decoder;
-	assert(srd_dec);
+	context.staged_binary_data.emplace_back();
+	DecodeContext::StagedBinaryData& staged = context.staged_binary_data.back();
 
-	const srd_proto_data_binary *const pdb = (const srd_proto_data_binary*)pdata->data;
-	assert(pdb);
+	staged.decoder_index = decoder_index;
+	staged.bin_class_id = bin_class_id;
+	staged.chunk.sample = context.sample_offset + sample;
+	staged.chunk.data.assign((const uint8_t*)data, (const uint8_t*)data + size);
+}
 
-	// Find the matching DecodeBinaryClass
-	DecodeSegment* segment = &(ds->segments_.at(ds->current_segment_id_));
+void DecodeSignal::add_logic_output(DecodeContext &context, uint32_t decoder_index,
+	uint32_t logic_group, uint64_t start_sample, uint64_t end_sample,
+	uint64_t repeat_count, const void *state)
+{
+	if (decode_interrupt_)
+		return;
 
-	DecodeBinaryClass* bin_class = nullptr;
-	for (DecodeBinaryClass& bc : segment->binary_classes)
-		if ((bc.decoder->get_srd_decoder() == srd_dec) &&
-			(bc.info->bin_class_id == (uint32_t)pdb->bin_class))
-			bin_class = &bc;
+	assert(decoder_index < output_targets_.size());
+	const DecoderOutputTarget& target = output_targets_[decoder_index];
+
+	if (target.logic_unit_size == 0)
+		return;
 
-	if (!bin_class) {
-		qWarning() << "Could not find valid DecodeBinaryClass in segment" <<
-				ds->current_segment_id_ << "for binary class ID" << pdb->bin_class <<
-				", segment only knows" << segment->binary_classes.size() << "classes";
+	// FIXME Only one group supported for now
+	if (logic_group > 0) {
+		qWarning() << "Received logic output state change for group" << logic_group << "from decoder" \
+			<< QString::fromUtf8(target.srd_dec->name) << "but only group 0 is currently supported";
 		return;
 	}
 
-	// Add the data chunk
-	bin_class->chunks.emplace_back();
-	DecodeBinaryDataChunk* chunk = &(bin_class->chunks.back());
+	if (start_sample >= end_sample) {
+		qWarning() << "Ignoring malformed logic output state change for group" << logic_group << "from decoder" \
+			<< QString::fromUtf8(target.srd_dec->name) << "from" << start_sample << "to" << end_sample;
+		return;
+	}
 
-	chunk->sample = pdata->start_sample;
-	chunk->data.resize(pdb->size);
-	memcpy(chunk->data.data(), pdb->data, pdb->size);
+	// The state is repeated for every sample
+	const uint32_t unit_size = target.logic_unit_size;
+	const uint32_t size = (1 + repeat_count) * unit_size;
 
-	Decoder* dec = ds->get_decoder_by_instance(srd_dec);
+	vector<uint8_t>& data = context.staged_logic_data;
+	const uint32_t offset = data.size();
+	data.resize(offset + size);
+	for (uint32_t i = 0; i < size; i += unit_size)
+		memcpy(data.data() + offset + i, state, unit_size);
 
-	ds->new_binary_data(ds->current_segment_id_, (void*)dec, pdb->bin_class);
+	// Consecutive output of the same decoder is appended in one go
+	vector<DecodeContext::StagedLogicOutput>& output = context.staged_logic_output;
+	if (!output.empty() && (output.back().decoder_index == decoder_index))
+		output.back().data_size += size;
+	else
+		output.push_back({decoder_index, offset, size});
 }
 
-void DecodeSignal::logic_output_callback(srd_proto_data *pdata, void *decode_signal)
+static uint32_t get_decoder_index(const DecodeContext *context,
+	const srd_proto_data *pdata)
+{
+	assert(pdata->pdo);
+	assert(pdata->pdo->di);
+
+	// The instances are in the order of the stack
+	const vector<srd_decoder_inst*>& instances = context->instances;
+	const uint32_t index = find(instances.begin(), instances.end(), pdata->pdo->di) -
+		instances.begin();
+	assert(index < instances.size());
+
+	return index;
+}
+
+void DecodeSignal::annotation_callback(srd_proto_data *pdata, void *decode_context)
 {
 	assert(pdata);
-	assert(decode_signal);
+	assert(decode_context);
 
-	DecodeSignal *const ds = (DecodeSignal*)decode_signal;
+	DecodeContext *const context = (DecodeContext*)decode_context;
+	DecodeSignal *const ds = context->signal;
 	assert(ds);
 
-	if (ds->decode_interrupt_)
-		return;
+	// Get the decoder and the annotation data
+	const uint32_t decoder_index = get_decoder_index(context, pdata);
 
-	lock_guard<mutex> lock(ds->output_mutex_);
+	const srd_proto_data_annotation *const pda = (const srd_proto_data_annotation*)pdata->data;
+	assert(pda);
 
-	assert(pdata->pdo);
-	assert(pdata->pdo->di);
-	const srd_decoder *const decc = pdata->pdo->di->decoder;
-	assert(decc);
+	ds->add_annotation(*context, decoder_index, pda->ann_class,
+		pdata->start_sample, pdata->end_sample, (const char* const*)pda->ann_text);
+}
+
+void DecodeSignal::binary_callback(srd_proto_data *pdata, void *decode_context)
+{
+	assert(pdata);
+	assert(decode_context);
+
+	DecodeContext *const context = (DecodeContext*)decode_context;
+	DecodeSignal *const ds = context->signal;
+	assert(ds);
+
+	// Get the decoder and the binary data
+	const uint32_t decoder_index = get_decoder_index(context, pdata);
+
+	const srd_proto_data_binary *const pdb = (const srd_proto_data_binary*)pdata->data;
+	assert(pdb);
+
+	ds->add_binary_data(*context, decoder_index, pdb->bin_class,
+		pdata->start_sample, pdb->data, pdb->size);
+}
+
+void DecodeSignal::logic_output_callback(srd_proto_data *pdata, void *decode_context)
+{
+	assert(pdata);
+	assert(decode_context);
+
+	// Decoders with logic output are only run by the main session
+	DecodeContext *const context = (DecodeContext*)decode_context;
+	DecodeSignal *const ds = context->signal;
+	assert(ds);
+
+	const uint32_t decoder_index = get_decoder_index(context, pdata);
 
 	const srd_proto_data_logic *const pdl = (const srd_proto_data_logic*)pdata->data;
 	assert(pdl);
 
-	// FIXME Only one group supported for now
-	if (pdl->logic_group > 0) {
-		qWarning() << "Received logic output state change for group" << pdl->logic_group << "from decoder" \
-			<< QString::fromUtf8(decc->name) << "but only group 0 is currently supported";
-		return;
-	}
+	ds->add_logic_output(*context, decoder_index, pdl->logic_group,
+		pdata->start_sample, pdata->end_sample, pdl->repeat_count, pdl->data);
+}
 
-	shared_ptr<Logic> output_logic = ds->output_logic_.at(decc);
+void DecodeSignal::on_old_output_dropped()
+{
+	vector< unique_ptr<uint8_t[]> > blocks;
+	vector< tuple<uint32_t, const Decoder*, uint32_t> > trimmed_classes;
 
-	vector< shared_ptr<Segment> > segments = output_logic->segments();
+	{
+		lock_guard<mutex> lock(output_mutex_);
 
-	shared_ptr<LogicSegment> last_segment;
+		// Freed once the lock is released
+		blocks.swap(dropped_output_);
 
-	if (!segments.empty())
-		last_segment = dynamic_pointer_cast<LogicSegment>(segments.back());
-	else {
-		// Happens when the data was cleared - all segments are gone then
-		// segment_id is always 0 as it's the first segment
-		last_segment = make_shared<data::LogicSegment>(
-			*output_logic, 0, (output_logic->num_channels() + 7) / 8, output_logic->get_samplerate());
-		output_logic->push_segment(last_segment);
-	}
+		for (uint32_t segment_id = 0; segment_id < segments_.size(); segment_id++) {
+			DecodeSegment& segment = segments_[segment_id];
 
-	if (pdata->start_sample < pdata->end_sample) {
-		vector<uint8_t> data;
-		const unsigned int unit_size = last_segment->unit_size();
-		data.resize(unit_size * (1 + pdl->repeat_count));
-
-		if (unit_size == 1)
-			for (unsigned int i = 0; i <= pdl->repeat_count; i++)
-				data.data()[i * unit_size] = *((uint8_t*)pdl->data);
-		else if (unit_size == 2)
-			for (unsigned int i = 0; i <= pdl->repeat_count; i++)
-				data.data()[i * unit_size] = *((uint16_t*)pdl->data);
-		else if (unit_size <= 4)
-			for (unsigned int i = 0; i <= pdl->repeat_count; i++)
-				data.data()[i * unit_size] = *((uint32_t*)pdl->data);
-		else if (unit_size <= 8)
-			for (unsigned int i = 0; i <= pdl->repeat_count; i++)
-				data.data()[i * unit_size] = *((uint64_t*)pdl->data);
-		else
-			for (unsigned int i = 0; i <= pdl->repeat_count; i++)
-				memcpy((void*)&data.data()[i * unit_size], (void*)pdl->data, unit_size);
+			for (DecodeBinaryClass& bc : segment.binary_classes) {
+				if (bc.chunks.empty() || (bc.chunks.front().sample >= segment.first_sample))
+					continue;
 
-		last_segment->append_payload(data.data(), data.size());
-	} else
-		qWarning() << "Ignoring malformed logic output state change for group" << pdl->logic_group << "from decoder" \
-			<< QString::fromUtf8(decc->name) << "from" << pdata->start_sample << "to" << pdata->end_sample;
+				while (!bc.chunks.empty() && (bc.chunks.front().sample < segment.first_sample))
+					bc.chunks.pop_front();
+				trimmed_classes.emplace_back(segment_id, bc.decoder, bc.info->bin_class_id);
+			}
+		}
+	}
+
+	for (const tuple<uint32_t, const Decoder*, uint32_t>& bc : trimmed_classes)
+		new_binary_data(get<0>(bc), (void*)get<1>(bc), get<2>(bc));
 }
 
 void DecodeSignal::on_capture_state_changed(int state)
@@ -1868,6 +2480,10 @@ void DecodeSignal::on_input_segment_completed()
 {
 	if (!logic_mux_thread_.joinable())
 		logic_mux_cond_.notify_one();
+
+	// Without the muxer, the decoder must notice the completion itself
+	if (logic_mux_bypassed_)
+		decode_input_cond_.notify_one();
 }
 
 void DecodeSignal::on_annotation_visibility_changed()
@@ -23,7 +23,9 @@
 #include <atomic>
 #include <deque>
 #include <condition_variable>
+#include <memory>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <QDebug>
@@ -31,6 +33,8 @@
 
 #include <libsigrokdecode/libsigrokdecode.h>
 
+#include <pv/data/decode/arena.hpp>
+#include <pv/data/decode/decodeprocess.hpp>
 #include <pv/data/decode/decoder.hpp>
 #include <pv/data/decode/row.hpp>
 #include <pv/data/decode/rowdata.hpp>
@@ -42,6 +46,8 @@ using std::condition_variable;
 using std::deque;
 using std::map;
 using std::mutex;
+using std::pair;
+using std::unique_ptr;
 using std::vector;
 using std::shared_ptr;
 
@@ -75,29 +81,149 @@ struct DecodeBinaryClass
 	deque<DecodeBinaryDataChunk> chunks;
 };
 
+/**
+ * Where the output of a decoder of the stack goes, so that it needn't be
+ * looked up for every item that the decoder outputs.
+ */
+struct DecoderOutputTarget
+{
+	Decoder* decoder;
+	const srd_decoder* srd_dec;
+	/// The index into DecodeSegment::row_data for each annotation class
+	vector<uint32_t> row_data_ids;
+	/// The index into DecodeSegment::binary_classes of the first binary class
+	uint32_t first_binary_class;
+	uint32_t binary_class_count;
+	/// Bytes per sample of the logic output, 0 if the decoder has none
+	uint32_t logic_unit_size;
+};
+
+/**
+ * Refers to an annotation of a DecodeSegment by the index of its RowData in
+ * DecodeSegment::row_data and its index within that RowData. It takes half
+ * the memory of an Annotation.
+ */
+struct AnnotationRef
+{
+	uint32_t row;
+	uint32_t index;
+};
+
 struct DecodeSegment
 {
-	// Constructor is a no-op
-	DecodeSegment() { };
+	DecodeSegment() : merge_count(0), first_sample(0) { };
 	// Copy constructor is a no-op
 	DecodeSegment(DecodeSegment&& ds) { (void)ds; qCritical() << "Empty DecodeSegment copy constructor called"; };
 
+	Annotation annotation(AnnotationRef ref) const
+		{ return row_data[ref.row]->get_annotation(ref.index); }
+
+	/// Holds the annotations and their texts, so it must outlive annotation_rows
+	decode::Arena annotation_arena;
 	map<const Row*, RowData> annotation_rows;  // Note: Row is the same for all segments while RowData is not
+	/// The RowData of annotation_rows in the order that AnnotationRef::row uses
+	vector<RowData*> row_data;
 	pv::util::Timestamp start_time;
 	double samplerate;
 	int64_t samples_decoded_incl, samples_decoded_excl;
 	vector<DecodeBinaryClass> binary_classes;
-	deque<const Annotation*> all_annotations;
+	/// All annotations, sorted by start sample and then longest first
+	deque<AnnotationRef> all_annotations;
+	/// Annotations that are yet to be merged into all_annotations
+	vector<AnnotationRef> pending_annotations;
+	/// The number of merges into all_annotations, and for the most recent
+	/// of them the position in all_annotations that they started at
+	uint64_t merge_count;
+	deque<uint64_t> merge_positions;
+	/// In ring buffer mode, the oldest input sample that is still stored.
+	/// The output that ends before it is dropped.
+	uint64_t first_sample;
+	/// The sample ranges that weren't decoded because the ring buffer
+	/// dropped them before the decoders got to them
+	deque< pair<uint64_t, uint64_t> > skipped_ranges;
+};
+
+class DecodeSignal;
+
+/**
+ * An srd session along with the state it needs for decoding a segment. The
+ * session's callbacks receive it as well, so that the output of every
+ * session goes to the segment that it decodes.
+ */
+struct DecodeContext
+{
+	DecodeContext(DecodeSignal *signal) :
+		signal(signal), session(nullptr), segment_id(0), chunk_length(0),
+		sample_offset(0) { };
+
+	DecodeSignal *const signal;
+	struct srd_session *session;
+	/// Used instead of the session if the stack runs in a helper process
+	unique_ptr<decode::DecodeProcess> process;
+	/// The decoder instances of the session, in the order of the stack
+	vector<srd_decoder_inst*> instances;
+	uint32_t segment_id;
+	/// Bytes of input data that decode_data() hands to the decoders at once,
+	/// adapted to their throughput
+	int64_t chunk_length;
+	vector<uint8_t> staging_buffer;
+	/// The sample that the decoders got as their first one since they were
+	/// reset. It isn't 0 if they had to skip samples, as they count from 0.
+	uint64_t sample_offset;
+
+	/*
+	 * The output of the decoders is staged here while they decode a chunk
+	 * and then committed to the segment at once, see
+	 * DecodeSignal::commit_staged_output()
+	 */
+	struct StagedAnnotation {
+		uint64_t start_sample, end_sample;
+		uint32_t row_data_id, ann_class_id;
+		uint32_t text_offset;  ///< Packed texts in staged_texts, see RowData::texts()
+	};
+	struct StagedBinaryData {
+		uint32_t decoder_index, bin_class_id;
+		DecodeBinaryDataChunk chunk;
+	};
+	struct StagedLogicOutput {
+		uint32_t decoder_index;
+		uint32_t data_offset, data_size;  ///< Bytes in staged_logic_data
+	};
+	vector<StagedAnnotation> staged_annotations;
+	vector<char> staged_texts;
+	vector<StagedBinaryData> staged_binary_data;
+	vector<StagedLogicOutput> staged_logic_output;
+	vector<uint8_t> staged_logic_data;
+
+	void clear_staged_output()
+	{
+		staged_annotations.clear();
+		staged_texts.clear();
+		staged_binary_data.clear();
+		staged_logic_output.clear();
+		staged_logic_data.clear();
+	}
 };
 
 class DecodeSignal : public SignalBase
 {
 	Q_OBJECT
 
+	friend class decode::DecodeProcess;
+
 private:
 	static const double DecodeMargin;
 	static const double DecodeThreshold;
 	static const int64_t DecodeChunkLength;
+	/// Range that the length of the chunks handed to the decoders adapts in
+	static const int64_t MinDecodeChunkLength, MaxDecodeChunkLength;
+	/// Time in ms that the decoders should take for one chunk
+	static const int DecodeChunkDuration;
+	/// Spans of input data shorter than this are sent in one piece with
+	/// the rest of their chunk
+	static const int64_t MinDecodeSpanLength;
+	/// Number of merges that DecodeSegment::merge_positions remembers
+	static const size_t MergeHistoryLength;
 
 public:
 	DecodeSignal(pv::Session &session);
@@ -162,11 +288,10 @@ public:
 	uint64_t get_annotation_count(const Row* row, uint32_t segment_id) const;
 
 	/**
-	 * Extracts annotations from a single row into a vector.
-	 * Note: The annotations may be unsorted and only annotations that fully
-	 * fit into the sample range are considered.
+	 * Extracts the annotations of a single row that overlap the sample range
+	 * into a vector, sorted by start sample.
 	 */
-	void get_annotation_subset(deque<const Annotation*> &dest, const Row* row,
+	void get_annotation_subset(deque<Annotation> &dest, const Row* row,
 		uint32_t segment_id, uint64_t start_sample, uint64_t end_sample) const;
 
 	/**
@@ -174,7 +299,7 @@ public:
 	 * Note: The annotations may be unsorted and only annotations that fully
 	 * fit into the sample range are considered.
 	 */
-	void get_annotation_subset(deque<const Annotation*> &dest, uint32_t segment_id,
+	void get_annotation_subset(deque<Annotation> &dest, uint32_t segment_id,
 		uint64_t start_sample, uint64_t end_sample) const;
 
 	uint32_t get_binary_data_chunk_count(uint32_t segment_id,
@@ -193,7 +318,44 @@ public:
 	const DecodeBinaryClass* get_binary_data_class(uint32_t segment_id,
 		const Decoder* dec, uint32_t bin_class_id) const;
 
-	const deque<const Annotation*>* get_all_annotations_by_segment(uint32_t segment_id) const;
+	/// Gives access to the annotations of a segment, or nullptr
+	const DecodeSegment* get_decode_segment(uint32_t segment_id) const;
+
+	/**
+	 * Brings @c dest, a copy of the all_annotations list of a segment, up
+	 * to date. The list is changed while annotations are decoded, so it may
+	 * only be read through such a copy. Usually, only its end is copied.
+	 * @param merge_count The number of merges that @c dest reflects, 0 for
+	 * a new copy. It is updated along with @c dest.
+	 */
+	void update_all_annotations_copy(uint32_t segment_id,
+		deque<AnnotationRef> &dest, uint64_t &merge_count) const;
+
+	/**
+	 * Returns the sample ranges of a segment that weren't decoded because
+	 * the ring buffer dropped them before the decoders got to them.
+	 */
+	vector< pair<uint64_t, uint64_t> > get_skipped_ranges(uint32_t segment_id) const;
+
+	/**
+	 * Returns the number of bytes of heap memory used by the muxed logic
+	 * data that is fed to the decoders, including its mip-maps. This is 0
+	 * if the decoders read the input data in place.
+	 */
+	uint64_t get_mux_data_memory_usage() const;
+
+	/**
+	 * Returns an estimate of the heap memory used by the annotations and
+	 * binary data of all segments.
+	 */
+	uint64_t get_annotation_memory_usage() const;
+
+	/**
+	 * Frees the muxed logic data once all segments were decoded and the
+	 * acquisition has stopped. It is recreated when decoding restarts.
+	 * @return true if the data was freed.
+	 */
+	bool discard_mux_data();
 
 	virtual void save_settings(QSettings &settings) const;
 
@@ -204,31 +366,141 @@ private:
 	uint32_t get_input_segment_count() const;
 	double get_input_samplerate(uint32_t segment_id) const;
 
-	Decoder* get_decoder_by_instance(const srd_decoder *const srd_dec);
+	/// Returns the smallest sample limit of the input segments, 0 if none
+	/// of them is a ring buffer
+	uint64_t get_input_sample_limit(uint32_t segment_id) const;
+
+	/**
+	 * Returns the oldest sample that all input segments still hold. The
+	 * muxer reads dropped input samples as zeros, so the mux output is only
+	 * valid from there on even if it holds older samples itself.
+	 */
+	uint64_t get_input_first_sample(uint32_t segment_id) const;
+
+	/**
+	 * Returns the logic data that all assigned channels take their samples
+	 * from, or nullptr if they come from different data. The decoders then
+	 * read its segments in place instead of a muxed copy.
+	 */
+	shared_ptr<Logic> get_shared_input_data() const;
+
+	/**
+	 * Builds output_targets_ for the decoder stack. Must not be called while
+	 * the decoders run.
+	 */
+	void update_output_targets();
 
 	void update_channel_list();
 
 	void commit_decoder_channels();
 
+	/**
+	 * Sets the bit of every assigned channel in the samples that the
+	 * decoders read. Returns true if any of them changed.
+	 */
+	bool assign_bit_ids();
+
 	void mux_logic_samples(uint32_t segment_id, const int64_t start, const int64_t end);
 	void logic_mux_proc();
 
-	void decode_data(const int64_t abs_start_samplenum, const int64_t sample_count,
-		const shared_ptr<const LogicSegment> input_segment);
+	/**
+	 * Hands out the next segment that no session decodes yet and creates
+	 * its DecodeSegment.
+	 * @param complete_only If set, the segment is only handed out if its
+	 * input is complete already.
+	 * @return false if there is no such segment.
+	 */
+	bool claim_decode_segment(uint32_t &segment_id, bool complete_only);
+
+	void decode_data(DecodeContext &context, const int64_t abs_start_samplenum,
+		const int64_t sample_count, const shared_ptr<const LogicSegment> input_segment);
+
+	/**
+	 * Resets the decoders of @c context so that they continue at @c end,
+	 * as the ring buffer dropped the samples from @c start on before they
+	 * were decoded.
+	 */
+	void skip_dropped_samples(DecodeContext &context, uint64_t start, uint64_t end);
 	void decode_proc();
 
+	/**
+	 * Starts as many workers as the settings allow while there are complete
+	 * segments left, so that they are decoded alongside the one that
+	 * decode_proc() works on. Each worker decodes whole segments with its
+	 * own session.
+	 */
+	void start_decode_workers();
+	void join_decode_workers();
+	void decode_worker_proc();
+
+	uint64_t get_decode_segment_samplerate(uint32_t segment_id) const;
+
+	/**
+	 * Creates the session and the decoder instances of @c context and starts
+	 * the session. Only the instances of the main session are tracked by the
+	 * decoders, see Decoder::create_decoder_inst().
+	 */
+	bool create_srd_session(DecodeContext &context, bool main_session);
 	void start_srd_session();
-	void terminate_srd_session();
+	void terminate_srd_session(DecodeContext &context);
 	void stop_srd_session();
 
+	/// Resets the state of the decoders of @c context between segments,
+	/// keeping the decoder stack intact
+	void reset_decoders(DecodeContext &context);
+	bool send_samples(DecodeContext &context, uint64_t start_sample,
+		uint64_t end_sample, const uint8_t *data, uint64_t size, unsigned int unit_size);
+	void send_eof(DecodeContext &context);
+
 	void connect_input_notifiers();
 	void disconnect_input_notifiers();
 
 	void create_decode_segment();
 
-	static void annotation_callback(srd_proto_data *pdata, void *decode_signal);
-	static void binary_callback(srd_proto_data *pdata, void *decode_signal);
-	static void logic_output_callback(srd_proto_data *pdata, void *decode_signal);
+	/**
+	 * Sorts the pending annotations of a segment and merges them into its
+	 * all_annotations list. The caller must hold output_mutex_.
+	 */
+	void merge_pending_annotations(DecodeSegment &segment);
+
+	/// Notes that all_annotations of @c segment changed from @c position on
+	void add_merge_position(DecodeSegment &segment, uint64_t position);
+
+	/**
+	 * Drops the annotations of @c segment that end before @c first_sample,
+	 * the oldest sample still in the ring buffer. The arena blocks that held
+	 * them are freed by on_old_output_dropped(), as views may still read
+	 * them. The caller must hold output_mutex_.
+	 */
+	void drop_old_output(DecodeSegment &segment, uint64_t first_sample);
+
+	/**
+	 * Adds the output that the decoders of @c context staged to @c segment
+	 * and merges the new annotations into its list. The caller must hold
+	 * output_mutex_.
+	 * @return The decoders and binary class IDs that received binary data.
+	 * new_binary_data() should be emitted for them once the lock is released.
+	 */
+	vector< pair<Decoder*, uint32_t> > commit_staged_output(
+		DecodeContext &context, DecodeSegment &segment);
+
+	/*
+	 * The output of the decoders, from the srd callbacks below or from the
+	 * helper processes. It is staged in the context that decodes it.
+	 * @param decoder_index The position of the decoder in the stack
+	 */
+	void add_annotation(DecodeContext &context, uint32_t decoder_index,
+		uint32_t ann_class_id, uint64_t start_sample, uint64_t end_sample,
+		const char* const* ann_texts);
+	void add_binary_data(DecodeContext &context, uint32_t decoder_index,
+		uint32_t bin_class_id, uint64_t sample, const void *data, uint64_t size);
+	void add_logic_output(DecodeContext &context, uint32_t decoder_index,
+		uint32_t logic_group, uint64_t start_sample, uint64_t end_sample,
+		uint64_t repeat_count, const void *state);
+
+	static void annotation_callback(srd_proto_data *pdata, void *decode_context);
+	static void binary_callback(srd_proto_data *pdata, void *decode_context);
+	static void logic_output_callback(srd_proto_data *pdata, void *decode_context);
 
 Q_SIGNALS:
 	void decoder_stacked(void* decoder); ///< decoder is of type decode::Decoder*
@@ -240,6 +512,9 @@ Q_SIGNALS:
 	void channels_updated();
 	void annotation_visibility_changed();
 
+	/// Emitted from the decode threads, see on_old_output_dropped()
+	void old_output_dropped();
+
 private Q_SLOTS:
 	void on_capture_state_changed(int state);
 	void on_data_cleared();
@@ -248,29 +523,55 @@ private Q_SLOTS:
 
 	void on_annotation_visibility_changed();
 
+	/**
+	 * Frees the annotations that drop_old_output() dropped and drops the
+	 * binary data of the same samples. This happens on the GUI thread, so
+	 * that the views don't read them meanwhile.
+	 */
+	void on_old_output_dropped();
+
 private:
 	pv::Session &session_;
 
 	vector<decode::DecodeChannel> channels_;
 
-	struct srd_session *srd_session_;
+	/// The session that decodes the segments in order, including the one
+	/// that is still being acquired
+	DecodeContext decode_context_;
 
 	shared_ptr<Logic> logic_mux_data_;
 	uint32_t logic_mux_unit_size_;
+	/// Reused by mux_logic_samples() for every chunk it muxes
+	vector<uint64_t> mux_gather_buffer_;
+	vector<uint8_t> mux_output_buffer_;
 	bool logic_mux_data_invalid_;
+	/// Set if logic_mux_data_ is the input data itself rather than a copy
+	bool logic_mux_bypassed_;
 
 	vector< shared_ptr<Decoder> > stack_;
 	bool stack_config_changed_;
+	/// Where the output of each decoder of stack_ goes, in the same order
+	vector<DecoderOutputTarget> output_targets_;
 
 	deque<DecodeSegment> segments_;
-	uint32_t current_segment_id_;
+	/// The next segment to be claimed by a session, guarded by output_mutex_
+	uint32_t next_segment_id_;
+	/// The arena blocks that drop_old_output() released, which are freed on
+	/// the GUI thread. Guarded by output_mutex_.
+	vector< unique_ptr<uint8_t[]> > dropped_output_;
 
 	mutable mutex input_mutex_, output_mutex_, decode_pause_mutex_, logic_mux_mutex_;
 	mutable condition_variable decode_input_cond_, decode_pause_cond_,
 		logic_mux_cond_;
 
 	std::thread decode_thread_, logic_mux_thread_;
+	/// Maximum number of sessions that decode segments at the same time
+	int decode_worker_count_;
+	vector<std::thread> decode_workers_;
+	/// Set if the decoder stacks run in helper processes
+	bool decode_in_processes_;
 	atomic<bool> decode_interrupt_, logic_mux_interrupt_;
+	atomic<bool> all_segments_decoded_;
 
 	bool decode_paused_;
 
@@ -0,0 +1,177 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "edgeindex.hpp"
+
+using std::lower_bound;
+using std::upper_bound;
+
+namespace pv {
+namespace data {
+
+const unsigned int EdgeIndex::BlockEdges = 128;
+
+namespace {
+
+/// Reads a delta that is stored with 7 bits per byte, least significant first
+inline uint64_t read_delta(const uint8_t *&ptr)
+{
+	uint64_t value = 0;
+	unsigned int shift = 0;
+
+	while (*ptr & 0x80) {
+		value |= (uint64_t)(*ptr++ & 0x7f) << shift;
+		shift += 7;
+	}
+
+	return value | ((uint64_t)*ptr++ << shift);
+}
+
+inline void write_delta(vector<uint8_t> &dest, uint64_t value)
+{
+	while (value >= 0x80) {
+		dest.push_back((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+
+	dest.push_back(value);
+}
+
+} // namespace
+
+EdgeIndex::EdgeIndex() :
+	edge_count_(0),
+	delta_bytes_(0)
+{
+}
+
+void EdgeIndex::append(const vector<uint64_t> &positions)
+{
+	for (uint64_t position : positions) {
+		if (blocks_.empty() || (blocks_.back().count == BlockEdges)) {
+			assert(blocks_.empty() || (position > blocks_.back().last_position));
+
+			// The previous block won't grow anymore
+			if (!blocks_.empty()) {
+				vector<uint8_t> &deltas = blocks_.back().deltas;
+				deltas.shrink_to_fit();
+				delta_bytes_ += deltas.capacity();
+			}
+
+			blocks_.push_back({position, position, edge_count_, 1, {}});
+		} else {
+			Block &b = blocks_.back();
+			assert(position > b.last_position);
+
+			write_delta(b.deltas, position - b.last_position);
+			b.last_position = position;
+			b.count++;
+		}
+
+		edge_count_++;
+	}
+}
+
+void EdgeIndex::drop_before(uint64_t sample)
+{
+	// The last block is kept even if it's outdated, it holds the position
+	// that the next edge is encoded relative to
+	while ((blocks_.size() > 1) && (blocks_.front().last_position < sample)) {
+		delta_bytes_ -= blocks_.front().deltas.capacity();
+		blocks_.pop_front();
+	}
+}
+
+void EdgeIndex::clear()
+{
+	blocks_.clear();
+	edge_count_ = 0;
+	delta_bytes_ = 0;
+}
+
+uint64_t EdgeIndex::first_rank() const
+{
+	return blocks_.empty() ? edge_count_ : blocks_.front().rank;
+}
+
+uint64_t EdgeIndex::end_rank() const
+{
+	return edge_count_;
+}
+
+uint64_t EdgeIndex::rank(uint64_t sample) const
+{
+	// Find the last block that starts before the sample
+	auto it = lower_bound(blocks_.begin(), blocks_.end(), sample,
+		[](const Block &b, uint64_t s) { return b.first_position < s; });
+
+	if (it == blocks_.begin())
+		return first_rank();
+
+	const Block &b = *(--it);
+	if (b.last_position < sample)
+		return b.rank + b.count;
+
+	const uint8_t *ptr = b.deltas.data();
+	uint64_t position = b.first_position;
+	uint64_t r = b.rank + 1;
+
+	while (true) {
+		position += read_delta(ptr);
+		if (position >= sample)
+			return r;
+		r++;
+	}
+}
+
+uint64_t EdgeIndex::select(uint64_t rank) const
+{
+	assert(rank >= first_rank());
+	assert(rank < end_rank());
+
+	// Find the last block whose first edge has at most this rank
+	auto it = upper_bound(blocks_.begin(), blocks_.end(), rank,
+		[](uint64_t r, const Block &b) { return r < b.rank; });
+	const Block &b = *(--it);
+
+	const uint8_t *ptr = b.deltas.data();
+	uint64_t position = b.first_position;
+
+	for (uint64_t i = b.rank; i < rank; i++)
+		position += read_delta(ptr);
+
+	return position;
+}
+
+uint64_t EdgeIndex::memory_usage() const
+{
+	uint64_t size = delta_bytes_ + blocks_.size() * sizeof(Block);
+
+	// The deltas of the last block are still growing
+	if (!blocks_.empty())
+		size += blocks_.back().deltas.capacity();
+
+	return size;
+}
+
+} // namespace data
+} // namespace pv
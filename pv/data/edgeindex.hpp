@@ -0,0 +1,105 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_EDGEINDEX_HPP
+#define PULSEVIEW_PV_DATA_EDGEINDEX_HPP
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+using std::deque;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+/**
+ * Compact index of the edges of a single logic channel.
+ *
+ * An edge at sample i means that sample i differs from sample i - 1. The
+ * edge positions are stored as variable-length deltas in blocks of up to
+ * BlockEdges edges. The blocks are found by binary search on either their
+ * first position or the rank of their first edge, so locating the edges
+ * around a sample, counting the edges in a range and finding the n-th edge
+ * all take logarithmic time.
+ *
+ * The rank of an edge is the number of edges that were appended before it.
+ * Ranks stay the same when old edges are dropped.
+ *
+ * The index isn't thread-safe, its owner must serialize the accesses.
+ */
+class EdgeIndex
+{
+public:
+	/// Number of edges per block, a block is decoded sequentially
+	static const unsigned int BlockEdges;
+
+public:
+	EdgeIndex();
+
+	/**
+	 * Appends edges. The positions must be ascending and follow the last
+	 * edge that was appended.
+	 */
+	void append(const vector<uint64_t> &positions);
+
+	/// Removes the blocks that only contain edges before @c sample
+	void drop_before(uint64_t sample);
+
+	void clear();
+
+	/// Returns the rank of the oldest edge that is still stored
+	uint64_t first_rank() const;
+
+	/// Returns the number of edges that were appended in total
+	uint64_t end_rank() const;
+
+	/**
+	 * Returns the number of edges before @c sample, including those that
+	 * were dropped. Samples before the oldest stored edge give first_rank().
+	 */
+	uint64_t rank(uint64_t sample) const;
+
+	/**
+	 * Returns the position of the edge with the given rank, which must be
+	 * in the range [first_rank(), end_rank()).
+	 */
+	uint64_t select(uint64_t rank) const;
+
+	uint64_t memory_usage() const;
+
+private:
+	struct Block
+	{
+		uint64_t first_position, last_position;
+		uint64_t rank;
+		uint32_t count;
+		vector<uint8_t> deltas;
+	};
+
+	deque<Block> blocks_;
+	uint64_t edge_count_;
+	uint64_t delta_bytes_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_EDGEINDEX_HPP
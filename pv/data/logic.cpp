@@ -102,6 +102,28 @@ uint64_t Logic::max_sample_count() const
 	return l;
 }
 
+uint64_t Logic::get_memory_usage() const
+{
+	uint64_t size = 0;
+	for (const shared_ptr<LogicSegment>& s : segments_)
+		size += s->get_memory_usage();
+	return size;
+}
+
+uint64_t Logic::get_mipmap_memory_usage() const
+{
+	uint64_t size = 0;
+	for (const shared_ptr<LogicSegment>& s : segments_)
+		size += s->get_mipmap_memory_usage();
+	return size;
+}
+
+void Logic::discard_mipmaps()
+{
+	for (shared_ptr<LogicSegment>& s : segments_)
+		s->discard_mipmap();
+}
+
 void Logic::notify_samples_added(shared_ptr<Segment> segment, uint64_t start_sample,
 	uint64_t end_sample)
 {
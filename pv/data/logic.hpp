@@ -62,6 +62,12 @@ public:
 
 	uint64_t max_sample_count() const;
 
+	uint64_t get_memory_usage() const;
+	uint64_t get_mipmap_memory_usage() const;
+
+	/// Frees the mip-maps of all complete segments
+	void discard_mipmaps();
+
 	void notify_samples_added(shared_ptr<Segment> segment, uint64_t start_sample,
 		uint64_t end_sample);
 
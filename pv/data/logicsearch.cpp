@@ -0,0 +1,121 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "logicsearch.hpp"
+#include "logicsegment.hpp"
+
+using std::min;
+
+namespace pv {
+namespace data {
+
+const uint64_t LogicSearch::WindowLength = 16 * 1024 * 1024;
+
+LogicSearch::LogicSearch(shared_ptr<LogicSegment> segment) :
+	segment_(segment),
+	canceled_(false)
+{
+	assert(segment_);
+}
+
+bool LogicSearch::find_next(uint64_t start, uint64_t &match)
+{
+	if (is_empty())
+		return false;
+
+	const uint64_t end = segment_->get_sample_count();
+	uint64_t index = start;
+
+	while ((index < end) && !canceled_)
+		if (next_match(index, min(end, index + WindowLength), match))
+			return true;
+
+	return false;
+}
+
+bool LogicSearch::find_previous(uint64_t end, uint64_t &match)
+{
+	if (is_empty())
+		return false;
+
+	const uint64_t first_sample = segment_->get_first_sample();
+	end = min(end, segment_->get_sample_count());
+
+	// Search windows of growing size towards the beginning, the last match
+	// in the first window that has one is the result
+	uint64_t length = WindowLength / 256;
+
+	while ((end > first_sample) && !canceled_) {
+		const uint64_t start = (end - first_sample > length) ?
+			end - length : first_sample;
+
+		bool found = false;
+		uint64_t index = start, m;
+		while (next_match(index, end, m)) {
+			match = m;
+			found = true;
+		}
+
+		if (found)
+			return true;
+
+		end = start;
+		length = min(length * 4, WindowLength);
+	}
+
+	return false;
+}
+
+void LogicSearch::find_all(uint64_t start, uint64_t end, MatchCallback callback)
+{
+	// Signals that change all the time produce plenty of matches, they're
+	// reported in batches of limited size
+	const size_t max_batch_size = 4096;
+
+	if (is_empty())
+		return;
+
+	end = min(end, segment_->get_sample_count());
+	uint64_t index = start;
+	vector<uint64_t> batch;
+
+	while ((index < end) && !canceled_) {
+		const uint64_t window_end = min(end, index + WindowLength);
+
+		batch.clear();
+		uint64_t match;
+		while ((batch.size() < max_batch_size) &&
+			next_match(index, window_end, match))
+			batch.push_back(match);
+
+		if (!callback(batch, min(index, end)))
+			break;
+	}
+}
+
+void LogicSearch::cancel()
+{
+	canceled_ = true;
+}
+
+} // namespace data
+} // namespace pv
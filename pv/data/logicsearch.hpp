@@ -0,0 +1,96 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_LOGICSEARCH_HPP
+#define PULSEVIEW_PV_DATA_LOGICSEARCH_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using std::atomic;
+using std::function;
+using std::shared_ptr;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+class LogicSegment;
+
+/**
+ * Base class of the searches that find the samples of a logic segment at
+ * which a match begins. Derived classes only have to find the next match
+ * in a range, the searches in either direction and the search for all
+ * matches are built on that.
+ */
+class LogicSearch
+{
+public:
+	/// Number of samples searched between two reports of find_all()
+	static const uint64_t WindowLength;
+
+	/**
+	 * Receives the matches found in the last window and the sample that
+	 * the search reached. Returning false stops the search.
+	 */
+	typedef function<bool (const vector<uint64_t>&, uint64_t)> MatchCallback;
+
+public:
+	LogicSearch(shared_ptr<LogicSegment> segment);
+
+	virtual ~LogicSearch() = default;
+
+	/// Returns true if the search can't match anything
+	virtual bool is_empty() const = 0;
+
+	/// Returns the number of samples that the match at @c match spans
+	virtual uint64_t get_match_length(uint64_t match) = 0;
+
+	/// Finds the first match at or after @c start
+	bool find_next(uint64_t start, uint64_t &match);
+
+	/// Finds the last match before @c end
+	bool find_previous(uint64_t end, uint64_t &match);
+
+	/// Finds all matches in [start, end) and reports them window by window
+	void find_all(uint64_t start, uint64_t end, MatchCallback callback);
+
+	/// Stops a search running in another thread
+	void cancel();
+
+protected:
+	/**
+	 * Finds the first match in [index, end). @c index is moved on to where
+	 * the search has to continue, which may be beyond @c end.
+	 */
+	virtual bool next_match(uint64_t &index, uint64_t end, uint64_t &match) = 0;
+
+protected:
+	shared_ptr<LogicSegment> segment_;
+
+	atomic<bool> canceled_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_LOGICSEARCH_HPP
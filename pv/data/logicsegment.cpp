@@ -26,16 +26,22 @@
 #include <cstdlib>
 #include <cstring>
 #include <cstdint>
+#include <limits>
 
 #include "logic.hpp"
 #include "logicsegment.hpp"
+#include "simd.hpp"
 
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
+using std::defer_lock;
 using std::lock_guard;
+using std::mutex;
 using std::recursive_mutex;
+using std::unique_lock;
 using std::max;
 using std::min;
+using std::numeric_limits;
 using std::shared_ptr;
 using std::vector;
 
@@ -48,24 +54,65 @@ const int LogicSegment::MipMapScalePower = 4;
 const int LogicSegment::MipMapScaleFactor = 1 << MipMapScalePower;
 const float LogicSegment::LogMipMapScaleFactor = logf(MipMapScaleFactor);
 const uint64_t LogicSegment::MipMapDataUnit = 64 * 1024; // bytes
+const uint64_t LogicSegment::BitPlaneBlockWords = 4096; // 256k samples
+const uint64_t LogicSegment::BitPlaneBatchWords = 256;
+const uint64_t LogicSegment::EdgeIndexMinSpacing = 256;
+const uint64_t LogicSegment::EdgeIndexMinSize = 16 * 1024; // bytes
+const uint64_t LogicSegment::EdgeSearchWindow = 64 * 1024;
+const uint64_t LogicSegment::SampleScanLength = 64 * 1024;
+
+static_assert(LogicSegment::MipMapScaleFactor == (int)simd::BlockLength,
+	"The SIMD kernels must reduce as many samples as the mip-map does");
 
 LogicSegment::LogicSegment(pv::data::Logic& owner, uint32_t segment_id,
 	unsigned int unit_size,	uint64_t samplerate) :
 	Segment(segment_id, samplerate, unit_size),
 	owner_(owner),
+	mipmap_discarded_(false),
+	mipmap_rebuilding_(false),
 	last_append_sample_(0),
 	last_append_accumulator_(0),
-	last_append_extra_(0)
+	last_append_extra_(0),
+	bit_planes_enabled_(false),
+	bit_plane_blocks_(nullptr),
+	bit_plane_block_capacity_(0),
+	bit_plane_start_(0),
+	bit_plane_end_(0),
+	edge_indices_(8 * unit_size),
+	edge_index_mask_((unit_size >= 8) ? ~0ULL : ((1ULL << (8 * unit_size)) - 1)),
+	edge_index_end_(0),
+	edge_index_prev_(0),
+	stats_(unit_size)
 {
-	memset(mip_map_, 0, sizeof(mip_map_));
+	// Logic data is mostly idle, so full chunks are stored run-length encoded
+	compress_chunks_ = true;
+
+	for (MipMapLevel &l : mip_map_) {
+		l.length = 0;
+		l.start = 0;
+		l.data_length = 0;
+		l.data = nullptr;
+	}
 }
 
 LogicSegment::~LogicSegment()
 {
+	stop_builder();
+
+	if (mipmap_rebuild_thread_.joinable())
+		mipmap_rebuild_thread_.join();
+
 	lock_guard<recursive_mutex> lock(mutex_);
 
 	for (MipMapLevel &l : mip_map_)
 		free(l.data);
+
+	// Blocks before bit_plane_start_ were retired already
+	uint64_t **blocks = bit_plane_blocks_;
+	const uint64_t block_samples = BitPlaneBlockWords * simd::BitPlaneWordLength;
+	for (uint64_t b = bit_plane_start_ / block_samples; b < bit_plane_block_capacity_; b++)
+		free(blocks[b]);
+	free(blocks);
 }
 
 shared_ptr<const LogicSegment> LogicSegment::get_shared_ptr() const
@@ -174,6 +221,23 @@ void LogicSegment::downsampleT(const uint8_t *in_, uint8_t *&out_, uint64_t len)
 	}
 
 	// Handle complete blocks of MipMapScaleFactor samples
+	if ((len >= 2 * MipMapScaleFactor) && simd::available()) {
+		// The first block depends on the previous sample, which may not be
+		// stored in front of the samples we got
+		downsampleTmain<T>(in, acc, prev);
+		len -= MipMapScaleFactor;
+		*out++ = acc;
+		acc = 0;
+
+		const uint64_t block_count = len / MipMapScaleFactor;
+		simd::downsample_edges((const uint8_t*)in, (uint8_t*)out, block_count,
+			sizeof(T));
+		in += block_count * MipMapScaleFactor;
+		out += block_count;
+		len -= block_count * MipMapScaleFactor;
+		prev = in[-1];
+	}
+
 	while (len >= MipMapScaleFactor) {
 		downsampleTmain<T>(in, acc, prev);
 		len -= MipMapScaleFactor;
@@ -228,6 +292,28 @@ void LogicSegment::downsampleGeneric(const uint8_t *in, uint8_t *&out, uint64_t
 	}
 
 	// Handle complete blocks of MipMapScaleFactor samples
+	if ((len >= 2 * MipMapScaleFactor) && simd::available()) {
+		// The first block depends on the previous sample, which may not be
+		// stored in front of the samples we got
+		for (uint64_t i = 0; i < MipMapScaleFactor; i++) {
+			const uint64_t sample = unpack_sample(in);
+			in += unit_size_;
+			acc |= prev ^ sample;
+			prev = sample;
+		}
+		len -= MipMapScaleFactor;
+		pack_sample(out, acc);
+		out += unit_size_;
+		acc = 0;
+
+		const uint64_t block_count = len / MipMapScaleFactor;
+		simd::downsample_edges(in, out, block_count, unit_size_);
+		in += block_count * MipMapScaleFactor * unit_size_;
+		out += block_count * unit_size_;
+		len -= block_count * MipMapScaleFactor;
+		prev = unpack_sample(in - unit_size_);
+	}
+
 	while (len >= MipMapScaleFactor) {
 		// Accumulate one sample at a time
 		for (uint64_t i = 0; i < MipMapScaleFactor; i++) {
@@ -345,15 +431,13 @@ void LogicSegment::append_payload(void *data, uint64_t data_size)
 	assert(unit_size_ > 0);
 	assert((data_size % unit_size_) == 0);
 
-	lock_guard<recursive_mutex> lock(mutex_);
-
 	const uint64_t prev_sample_count = sample_count_;
 	const uint64_t sample_count = data_size / unit_size_;
 
 	append_samples(data, sample_count);
 
-	// Generate the first mip-map from the data
-	append_payload_to_mipmap();
+	// Generate the mip-map, either right away or on the builder thread
+	update_derived_data();
 
 	if (sample_count > 1)
 		owner_.notify_samples_added(SharedPtrToSegment(shared_from_this()),
@@ -398,8 +482,6 @@ void LogicSegment::get_samples(int64_t start_sample,
 	assert(start_sample <= end_sample);
 	assert(dest != nullptr);
 
-	lock_guard<recursive_mutex> lock(mutex_);
-
 	get_raw_samples(start_sample, (end_sample - start_sample), dest);
 }
 
@@ -409,142 +491,216 @@ void LogicSegment::get_subsampled_edges(
 	float min_length, int sig_index, bool first_change_only)
 {
 	uint64_t index = start;
-	unsigned int level;
 	bool last_sample;
-	bool fast_forward;
 
 	assert(start <= end);
 	assert(min_length > 0);
 	assert(sig_index >= 0);
 	assert(sig_index < 64);
 
-	lock_guard<recursive_mutex> lock(mutex_);
+	// Rebuild the mip-map if it was discarded to save memory
+	lock_guard<mutex> mipmap_lock(mipmap_mutex_);
+	rebuild_discarded_mipmap();
+
+	// Keep the mip-map buffers from being freed while we use them,
+	// the acquisition thread may continue to add samples meanwhile
+	MemoryPin pin(*this);
+
+	// Make sure we only process as many samples as we have
+	const uint64_t sample_count = get_sample_count();
+	if (end > sample_count)
+		end = sample_count;
+
+	// Samples dropped in ring buffer mode have no edges
+	const uint64_t first_sample = get_first_sample();
+	if (start < first_sample) {
+		start = first_sample;
+		index = start;
+		end = max(end, start);
+	}
+
+	// Store the initial state
+	last_sample = get_sample_bit(start, sig_index);
+	if (!first_change_only)
+		edges.emplace_back(index++, last_sample);
+
+	append_subsampled_edges(edges, index, end, end, min_length, sig_index,
+		last_sample, first_change_only);
+
+	// Add the final state
+	if (!first_change_only) {
+		const bool end_sample = get_sample_bit(end, sig_index);
+		if (last_sample != end_sample)
+			edges.emplace_back(end, end_sample);
+		edges.emplace_back(end + 1, end_sample);
+	}
+}
+
+void LogicSegment::get_subsampled_edges(vector< vector<EdgePair> > &edges,
+	uint64_t start, uint64_t end, float min_length,
+	const vector<int> &sig_indices)
+{
+	assert(start <= end);
+	assert(min_length > 0);
+
+	edges.clear();
+	edges.resize(sig_indices.size());
+
+	if (sig_indices.empty())
+		return;
+
+	// The edges of a channel are searched for the first signal using it
+	// and copied to the others at the end
+	struct Walk {
+		int sig_index;
+		vector<EdgePair> *edges;
+		uint64_t index;
+		bool last_sample;
+		bool done;
+	};
+
+	vector<int> slots(64, -1);
+	vector<Walk> walks;
+	for (size_t i = 0; i < sig_indices.size(); i++) {
+		const int sig_index = sig_indices[i];
+		assert(sig_index >= 0);
+		assert(sig_index < 64);
+
+		if (slots[sig_index] < 0) {
+			slots[sig_index] = i;
+			walks.push_back({sig_index, &edges[i], 0, false, false});
+		}
+	}
+
+	// Rebuild the mip-map if it was discarded to save memory
+	lock_guard<mutex> mipmap_lock(mipmap_mutex_);
+	rebuild_discarded_mipmap();
+
+	// Keep the mip-map buffers from being freed while we use them,
+	// the acquisition thread may continue to add samples meanwhile
+	MemoryPin pin(*this);
 
 	// Make sure we only process as many samples as we have
-	if (end > get_sample_count())
-		end = get_sample_count();
+	const uint64_t sample_count = get_sample_count();
+	if (end > sample_count)
+		end = sample_count;
+
+	// Samples dropped in ring buffer mode have no edges
+	const uint64_t first_sample = get_first_sample();
+	if (start < first_sample) {
+		start = first_sample;
+		end = max(end, start);
+	}
+
+	// Store the initial states
+	const uint64_t start_state = get_unpacked_sample(start);
+	for (Walk &w : walks) {
+		w.last_sample = (start_state >> w.sig_index) & 1;
+		w.edges->emplace_back(start, w.last_sample);
+		w.index = start + 1;
+	}
+
+	// Every channel is searched just like by the single channel version,
+	// but they're taken through the range together, a window at a time,
+	// so that the chunks and mip-map entries that one of them reads are
+	// still cached when the others get there
+	size_t remaining = walks.size();
+	while (remaining > 0) {
+		uint64_t stop = numeric_limits<uint64_t>::max();
+		for (const Walk &w : walks)
+			if (!w.done)
+				stop = min(stop, w.index);
+		stop += SampleScanLength;
+
+		for (Walk &w : walks) {
+			if (w.done || !append_subsampled_edges(*w.edges, w.index, end,
+				stop, min_length, w.sig_index, w.last_sample, false))
+				continue;
+
+			w.done = true;
+			remaining--;
+		}
+	}
+
+	// Add the final states
+	const uint64_t end_state = get_unpacked_sample(end);
+	for (Walk &w : walks) {
+		const bool end_sample = (end_state >> w.sig_index) & 1;
+		if (w.last_sample != end_sample)
+			w.edges->emplace_back(end, end_sample);
+		w.edges->emplace_back(end + 1, end_sample);
+	}
 
+	for (size_t i = 0; i < sig_indices.size(); i++)
+		if (slots[sig_indices[i]] != (int)i)
+			edges[i] = edges[slots[sig_indices[i]]];
+}
+
+bool LogicSegment::append_subsampled_edges(vector<EdgePair> &edges,
+	uint64_t &index, uint64_t end, uint64_t stop, float min_length,
+	int sig_index, bool &last_sample, bool first_change_only)
+{
+	bool fast_forward;
+
+	// Note: the caller must pin the memory and hold mipmap_mutex_
 	const uint64_t block_length = (uint64_t)max(min_length, 1.0f);
 	const unsigned int min_level = max((int)floorf(logf(min_length) /
 		LogMipMapScaleFactor) - 1, 0);
 	const uint64_t sig_mask = 1ULL << sig_index;
 
-	// Store the initial state
-	last_sample = (get_unpacked_sample(start) & sig_mask) != 0;
-	if (!first_change_only)
-		edges.emplace_back(index++, last_sample);
-
 	while (index + block_length <= end) {
+		if (index >= stop)
+			return false;
+
 		//----- Continue to search -----//
-		level = min_level;
 
 		// We cannot fast-forward if there is no mip-map data at
 		// the minimum level.
-		fast_forward = (mip_map_[level].data != nullptr);
+		fast_forward = (mip_map_[min_level].data != nullptr);
 
 		if (min_length < MipMapScaleFactor) {
 			// Search individual samples up to the beginning of
 			// the next first level mip map block
 			const uint64_t final_index = min(end, pow2_ceil(index, MipMapScalePower));
 
-			for (; index < final_index &&
-					(index & ~((uint64_t)(~0) << MipMapScalePower)) != 0;
-					index++) {
-
-				const bool sample = (get_unpacked_sample(index) & sig_mask) != 0;
+			index = find_next_change(index, final_index, sig_index, last_sample);
 
-				// If there was a change we cannot fast forward
-				if (sample != last_sample) {
-					fast_forward = false;
-					break;
-				}
-			}
+			// If there was a change we cannot fast forward
+			if (index < final_index)
+				fast_forward = false;
 		} else {
 			// If resolution is less than a mip map block,
 			// round up to the beginning of the mip-map block
 			// for this level of detail
-			const int min_level_scale_power = (level + 1) * MipMapScalePower;
+			const int min_level_scale_power = (min_level + 1) * MipMapScalePower;
 			index = pow2_ceil(index, min_level_scale_power);
 			if (index >= end)
 				break;
 
 			// We can fast forward only if there was no change
-			const bool sample = (get_unpacked_sample(index) & sig_mask) != 0;
+			const bool sample = get_sample_bit(index, sig_index);
 			if (last_sample != sample)
 				fast_forward = false;
 		}
 
 		if (fast_forward) {
-
-			// Fast forward: This involves zooming out to higher
-			// levels of the mip map searching for changes, then
-			// zooming in on them to find the point where the edge
-			// begins.
-
-			// Slide right and zoom out at the beginnings of mip-map
-			// blocks until we encounter a change
-			while (true) {
-				const int level_scale_power = (level + 1) * MipMapScalePower;
-				const uint64_t offset = index >> level_scale_power;
-
-				// Check if we reached the last block at this
-				// level, or if there was a change in this block
-				if (offset >= mip_map_[level].length ||
-					(get_subsample(level, offset) &	sig_mask))
-					break;
-
-				if ((offset & ~((uint64_t)(~0) << MipMapScalePower)) == 0) {
-					// If we are now at the beginning of a
-					// higher level mip-map block ascend one
-					// level
-					if ((level + 1 >= ScaleStepCount) || (!mip_map_[level + 1].data))
-						break;
-
-					level++;
-				} else {
-					// Slide right to the beginning of the
-					// next mip map block
-					index = pow2_ceil(index + 1, level_scale_power);
-				}
-			}
-
-			// Zoom in, and slide right until we encounter a change,
-			// and repeat until we reach min_level
-			while (true) {
-				assert(mip_map_[level].data);
-
-				const int level_scale_power = (level + 1) * MipMapScalePower;
-				const uint64_t offset = index >> level_scale_power;
-
-				// Check if we reached the last block at this
-				// level, or if there was a change in this block
-				if (offset >= mip_map_[level].length ||
-						(get_subsample(level, offset) & sig_mask)) {
-					// Zoom in unless we reached the minimum
-					// zoom
-					if (level == min_level)
-						break;
-
-					level--;
-				} else {
-					// Slide right to the beginning of the
-					// next mip map block
-					index = pow2_ceil(index + 1, level_scale_power);
-				}
-			}
+			index = skip_unchanged_blocks(index, sig_mask, min_level);
 
 			// If individual samples within the limit of resolution,
 			// do a linear search for the next transition within the
 			// block
-			if (min_length < MipMapScaleFactor) {
-				for (; index < end; index++) {
-					const bool sample = (get_unpacked_sample(index) & sig_mask) != 0;
-					if (sample != last_sample)
-						break;
-				}
-			}
+			if (min_length < MipMapScaleFactor)
+				index = find_next_change(index, end, sig_index, last_sample);
 		}
 
+		// The mip-map may not cover the samples yet, because they weren't
+		// processed by the builder or don't fill a block of this level.
+		// Those are searched sample by sample instead.
+		if ((index < end) &&
+			(index >= (mip_map_[min_level].length << ((min_level + 1) * MipMapScalePower))) &&
+			(get_sample_bit(index, sig_index) == last_sample))
+			index = find_next_change(index, end, sig_index, last_sample);
+
 		//----- Store the edge -----//
 
 		// Take the last sample of the quanization block
@@ -553,7 +709,7 @@ void LogicSegment::get_subsampled_edges(
 			break;
 
 		// Store the final state
-		const bool final_sample = (get_unpacked_sample(final_index - 1) & sig_mask) != 0;
+		const bool final_sample = get_sample_bit(final_index - 1, sig_index);
 		edges.emplace_back(index, final_sample);
 
 		index = final_index;
@@ -563,72 +719,583 @@ void LogicSegment::get_subsampled_edges(
 			break;
 	}
 
-	// Add the final state
-	if (!first_change_only) {
-		const bool end_sample = get_unpacked_sample(end) & sig_mask;
-		if (last_sample != end_sample)
-			edges.emplace_back(end, end_sample);
-		edges.emplace_back(end + 1, end_sample);
-	}
+	return true;
 }
 
 void LogicSegment::get_surrounding_edges(vector<EdgePair> &dest,
-	uint64_t origin_sample, float min_length, int sig_index)
+	uint64_t origin_sample, int sig_index)
 {
 	if (origin_sample >= sample_count_)
 		return;
 
-	// Put the edges vector on the heap, it can become quite big until we can
-	// use a get_subsampled_edges() implementation that searches backwards
-	vector<EdgePair>* edges = new vector<EdgePair>;
+	MemoryPin pin(*this);
+	uint64_t edge;
 
-	// Get all edges to the left of origin_sample
-	get_subsampled_edges(*edges, 0, origin_sample, min_length, sig_index, false);
+	if (find_previous_edge(sig_index, origin_sample, edge))
+		dest.emplace_back(edge, get_sample_bit(edge, sig_index));
 
-	// If we don't specify "first only", the first and last edge are the states
-	// at samples 0 and origin_sample. If only those exist, there are no edges
-	if (edges->size() == 2) {
-		delete edges;
-		return;
+	if (find_next_edge(sig_index, origin_sample, edge))
+		dest.emplace_back(edge, get_sample_bit(edge, sig_index));
+}
+
+bool LogicSegment::find_previous_edge(int sig_index, uint64_t sample,
+	uint64_t &edge)
+{
+	assert(sig_index >= 0);
+	assert(sig_index < 64);
+
+	// An edge at the oldest sample would refer to a dropped one
+	const uint64_t first_sample = get_first_sample();
+	const uint64_t sample_count = get_sample_count();
+	if (sample_count == 0)
+		return false;
+	sample = min(sample, sample_count - 1);
+
+	uint64_t indexed_end = 0;
+	bool indexed;
+	{
+		lock_guard<mutex> lock(edge_index_mutex_);
+		indexed = (edge_index_mask_ >> sig_index) & 1;
+		indexed_end = edge_index_end_;
+	}
+
+	if (indexed && (sample >= indexed_end) && (indexed_end > first_sample)) {
+		// Edges past the index are searched in the samples
+		if (search_last_edge(sig_index, indexed_end - 1, sample, edge))
+			return true;
+		sample = indexed_end - 1;
 	}
 
-	// Dismiss the entry for origin_sample so that back() gives us the
-	// real last entry
-	edges->pop_back();
-	dest.push_back(edges->back());
-	edges->clear();
+	if (sample <= first_sample)
+		return false;
+
+	if (indexed) {
+		lock_guard<mutex> lock(edge_index_mutex_);
+
+		// The index only grows, unless the channel was dropped from it
+		if ((edge_index_mask_ >> sig_index) & 1) {
+			const EdgeIndex &index = edge_indices_[sig_index];
+			const uint64_t rank = index.rank(sample + 1);
+			if (rank == index.first_rank())
+				return false;
+
+			edge = index.select(rank - 1);
+			return edge > first_sample;
+		}
+	}
+
+	// Search backwards in growing windows, the mip-map makes long stretches
+	// without edges cheap to skip
+	uint64_t window = EdgeSearchWindow;
+	while (sample > first_sample) {
+		const uint64_t start = (sample - first_sample > window) ?
+			sample - window : first_sample;
+		if (search_last_edge(sig_index, start, sample, edge))
+			return true;
+
+		sample = start;
+		window *= 4;
+	}
+
+	return false;
+}
+
+bool LogicSegment::find_next_edge(int sig_index, uint64_t sample, uint64_t &edge)
+{
+	assert(sig_index >= 0);
+	assert(sig_index < 64);
+
+	sample = max(sample, get_first_sample());
+
+	{
+		lock_guard<mutex> lock(edge_index_mutex_);
+
+		if (((edge_index_mask_ >> sig_index) & 1) && (edge_index_end_ > 0)) {
+			const EdgeIndex &index = edge_indices_[sig_index];
+			const uint64_t rank = index.rank(sample + 1);
+			if (rank < index.end_rank()) {
+				edge = index.select(rank);
+				return true;
+			}
+
+			// Continue with the samples past the index
+			sample = max(sample, edge_index_end_ - 1);
+		}
+	}
+
+	return search_next_edge(sig_index, sample, edge);
+}
+
+bool LogicSegment::find_next_state_change(uint64_t mask, uint64_t start,
+	uint64_t end, uint64_t &change)
+{
+	lock_guard<mutex> mipmap_lock(mipmap_mutex_);
+	rebuild_discarded_mipmap();
+
+	MemoryPin pin(*this);
+
+	// The first sample has no predecessor to differ from
+	end = min(end, get_sample_count());
+	uint64_t index = max(start, get_first_sample() + 1);
+	if (index >= end)
+		return false;
+
+	const uint64_t state = get_unpacked_sample(index - 1) & mask;
+
+	while (index < end) {
+		// Search the rest of the current mip-map block sample by sample
+		const uint64_t block_end = min(end, pow2_ceil(index + 1, MipMapScalePower));
+		index = search_next_state_change(index, block_end, mask, state);
+		if ((index < block_end) || (index >= end))
+			break;
+
+		if (mip_map_[0].data)
+			index = skip_unchanged_blocks(index, mask, 0);
+
+		// Samples the mip-map doesn't cover yet are searched one by one
+		if (!mip_map_[0].data ||
+			(index >= (mip_map_[0].length << MipMapScalePower))) {
+			index = search_next_state_change(min(index, end), end, mask, state);
+			break;
+		}
+	}
+
+	if (index >= end)
+		return false;
+
+	change = index;
+	return true;
+}
+
+bool LogicSegment::get_edges(int sig_index, uint64_t start, uint64_t end,
+	vector<uint64_t> &edges)
+{
+	assert(sig_index >= 0);
+	assert(sig_index < 64);
+
+	MemoryPin pin(*this);
+
+	// The first sample has no predecessor to differ from
+	end = min(end, get_sample_count());
+	uint64_t index = max(start, get_first_sample() + 1);
+	if (index >= end)
+		return (end > 0) &&
+			((get_unpacked_sample(min(index, end) - 1) >> sig_index) & 1);
+
+	const bool initial_state = (get_unpacked_sample(index - 1) >> sig_index) & 1;
+	bool state = initial_state;
+	vector< pair<uint64_t, uint64_t> > runs;
+
+	while (index < end) {
+		const uint64_t window_end = min(end, index + SampleScanLength);
+		runs.clear();
+
+		{
+			lock_guard<mutex> mipmap_lock(mipmap_mutex_);
+			rebuild_discarded_mipmap();
+
+			if (get_bit_plane_word(index, sig_index)) {
+				index = get_bit_plane_edges(sig_index, index, window_end, state, edges);
+				continue;
+			}
+
+			get_active_runs(1ULL << sig_index, index, window_end, runs);
+		}
+
+		// The samples are read without holding the mip-map lock, so that
+		// several threads can search a segment at the same time
+		for (const pair<uint64_t, uint64_t> &run : runs) {
+			DataView view(*this, run.first, run.second);
+			uint64_t i = run.first;
+
+			for (const DataSpan &span : view.spans()) {
+				const uint8_t *ptr = span.data;
+				for (uint64_t j = 0; j < span.sample_count; j++, i++) {
+					const bool bit = (unpack_sample(ptr) >> sig_index) & 1;
+					if (bit != state) {
+						edges.push_back(i);
+						state = bit;
+					}
+					ptr += unit_size_;
+				}
+			}
+		}
+
+		index = window_end;
+	}
+
+	return initial_state;
+}
+
+uint64_t LogicSegment::get_edge_count(int sig_index, uint64_t start, uint64_t end)
+{
+	assert(sig_index >= 0);
+	assert(sig_index < 64);
+
+	start = max(start, get_first_sample() + 1);
+	end = min(end, get_sample_count());
+	if (start >= end)
+		return 0;
+
+	uint64_t count = 0;
+	{
+		lock_guard<mutex> lock(edge_index_mutex_);
+
+		if ((edge_index_mask_ >> sig_index) & 1) {
+			const uint64_t split = min(end, edge_index_end_);
+			if (start < split) {
+				const EdgeIndex &index = edge_indices_[sig_index];
+				count = index.rank(split) - index.rank(start);
+				start = split;
+			}
+		}
+	}
+
+	if (start < end)
+		count += search_edge_count(sig_index, start - 1, end - 1);
+
+	return count;
+}
+
+bool LogicSegment::find_nth_edge(int sig_index, uint64_t start, uint64_t n,
+	uint64_t &edge)
+{
+	assert(sig_index >= 0);
+	assert(sig_index < 64);
+
+	start = max(start, get_first_sample() + 1);
+	uint64_t sample = start - 1;
+
+	{
+		lock_guard<mutex> lock(edge_index_mutex_);
+
+		if (((edge_index_mask_ >> sig_index) & 1) && (edge_index_end_ > 0)) {
+			const EdgeIndex &index = edge_indices_[sig_index];
+			const uint64_t rank = index.rank(start) + n;
+			if (rank < index.end_rank()) {
+				edge = index.select(rank);
+				return true;
+			}
+
+			// Count the remaining edges past the index
+			n = rank - index.end_rank();
+			sample = max(sample, edge_index_end_ - 1);
+		}
+	}
+
+	while (search_next_edge(sig_index, sample, edge)) {
+		if (n == 0)
+			return true;
+
+		n--;
+		sample = edge;
+	}
+
+	return false;
+}
+
+bool LogicSegment::is_edge_indexed(int sig_index) const
+{
+	lock_guard<mutex> lock(edge_index_mutex_);
+
+	return (edge_index_mask_ >> sig_index) & 1;
+}
+
+LogicSegment::ChannelStats LogicSegment::get_channel_stats(int sig_index,
+	uint64_t start, uint64_t end)
+{
+	assert(sig_index >= 0);
+	assert(sig_index < 64);
+
+	ChannelStats stats = ChannelStats();
+
+	// The whole blocks in the range are taken from the statistics, which
+	// still hold the block of the oldest sample in ring buffer mode
+	const uint64_t block_length = LogicStats::BlockLength;
+	uint64_t first_block, end_block;
+	bool have_blocks = false;
+
+	end = min(end, get_sample_count());
+
+	{
+		lock_guard<mutex> lock(stats_mutex_);
+
+		// In ring buffer mode the builder thread drops old samples along
+		// with their blocks, so the range is clamped while none of the
+		// blocks can go away
+		start = max(start, get_first_sample());
+		first_block = max((start + block_length - 1) / block_length,
+			stats_.first_block());
+		end_block = min(end / block_length, stats_.end_block());
+
+		if ((start < end) && (first_block < end_block)) {
+			stats.edge_count = stats_.edge_count(sig_index, end_block) -
+				stats_.edge_count(sig_index, first_block);
+			stats.high_count = stats_.high_count(sig_index, end_block) -
+				stats_.high_count(sig_index, first_block);
+			have_blocks = true;
+		}
+	}
+
+	if (start >= end)
+		return stats;
+
+	stats.sample_count = end - start;
+
+	if (have_blocks) {
+		count_samples(sig_index, start, first_block * block_length,
+			stats.edge_count, stats.high_count);
+		count_samples(sig_index, end_block * block_length, end,
+			stats.edge_count, stats.high_count);
+	} else
+		count_samples(sig_index, start, end, stats.edge_count, stats.high_count);
+
+	if (stats.edge_count > 0) {
+		stats.has_edges =
+			find_next_edge(sig_index, (start > 0) ? start - 1 : 0, stats.first_edge) &&
+			find_previous_edge(sig_index, end - 1, stats.last_edge);
+	}
+
+	return stats;
+}
+
+bool LogicSegment::search_last_edge(int sig_index, uint64_t start, uint64_t end,
+	uint64_t &edge)
+{
+	if (end <= start)
+		return false;
+
+	vector<EdgePair> edges;
+	get_subsampled_edges(edges, start, end, 1.0f, sig_index);
+
+	// The first and the last entry are the states at start and past end
+	if (edges.size() <= 2)
+		return false;
+
+	edge = edges[edges.size() - 2].first;
+	return true;
+}
+
+bool LogicSegment::search_next_edge(int sig_index, uint64_t sample, uint64_t &edge)
+{
+	const uint64_t sample_count = get_sample_count();
+	if (sample + 1 >= sample_count)
+		return false;
+
+	vector<EdgePair> edges;
+	get_subsampled_edges(edges, sample, sample_count, 1.0f, sig_index, true);
 
-	// Get first edge to the right of origin_sample
-	get_subsampled_edges(*edges, origin_sample, sample_count_, min_length, sig_index, true);
+	if (edges.empty())
+		return false;
 
-	// "first only" is specified, so nothing needs to be dismissed
-	if (edges->size() == 0) {
-		delete edges;
+	edge = edges.front().first;
+	return true;
+}
+
+uint64_t LogicSegment::search_edge_count(int sig_index, uint64_t start,
+	uint64_t end)
+{
+	if (end <= start)
+		return 0;
+
+	vector<EdgePair> edges;
+	get_subsampled_edges(edges, start, end, 1.0f, sig_index);
+
+	return edges.size() - 2;
+}
+
+uint64_t LogicSegment::get_mipmap_memory_usage() const
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	uint64_t size = 0;
+	for (const MipMapLevel &l : mip_map_)
+		if (l.data)
+			size += l.data_length * unit_size_ + sizeof(uint64_t);
+
+	// The bit planes, the edge index and the statistics are accounted for
+	// here as well, they're search structures just like the mip-map
+	if (bit_planes_enabled_) {
+		const uint64_t block_samples = BitPlaneBlockWords * simd::BitPlaneWordLength;
+		const uint64_t first_block = bit_plane_start_ / block_samples;
+		const uint64_t end_block =
+			(bit_plane_end_ + block_samples - 1) / block_samples;
+
+		size += (end_block - first_block) * 8 * unit_size_ *
+			BitPlaneBlockWords * sizeof(uint64_t);
+		size += bit_plane_block_capacity_ * sizeof(uint64_t*);
+	}
+
+	{
+		lock_guard<mutex> edge_index_lock(edge_index_mutex_);
+		for (const EdgeIndex &index : edge_indices_)
+			size += index.memory_usage();
+	}
+
+	lock_guard<mutex> stats_lock(stats_mutex_);
+	size += stats_.memory_usage();
+
+	return size;
+}
+
+void LogicSegment::discard_mipmap()
+{
+	lock_guard<mutex> mipmap_lock(mipmap_mutex_);
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	// The mip-map of an incomplete segment is still being extended
+	if (!is_complete_ || mipmap_discarded_)
 		return;
+
+	// The mip-map is rebuilt starting at the oldest sample that's still
+	// stored, so every level starts out empty at the matching entry
+	uint64_t start = get_first_sample() / MipMapScaleFactor;
+
+	// The first entry is built by comparing with the sample before it, like
+	// during the acquisition. The oldest stored sample stands in for it if
+	// it was dropped, so that no change is made up.
+	const uint64_t rebuild_start = start * MipMapScaleFactor;
+	{
+		MemoryPin pin(*this);
+		last_append_sample_ = (rebuild_start == 0) ? 0 :
+			get_unpacked_sample(max(rebuild_start - 1, get_first_sample()));
 	}
+	last_append_accumulator_ = 0;
+	last_append_extra_ = 0;
 
-	dest.push_back(edges->front());
+	for (MipMapLevel &l : mip_map_) {
+		void *data = l.data;
+		l.length = start;
+		l.start = start;
+		l.data = nullptr;
+		l.data_length = 0;
+
+		// Readers that pinned the memory may still be using the buffer
+		retire_buffer(data);
+
+		start = (start + MipMapScaleFactor - 1) / MipMapScaleFactor;
+	}
+
+	// The bit planes are rebuilt along with the mip-map, starting with the
+	// block that holds the oldest sample
+	if (bit_planes_enabled_) {
+		uint64_t **blocks = bit_plane_blocks_;
+		const uint64_t block_samples = BitPlaneBlockWords * simd::BitPlaneWordLength;
+
+		for (uint64_t b = bit_plane_start_ / block_samples; b < bit_plane_block_capacity_; b++)
+			retire_buffer(blocks[b]);
+		retire_buffer(blocks);
+
+		bit_plane_blocks_ = nullptr;
+		bit_plane_block_capacity_ = 0;
+		bit_plane_start_ = (get_first_sample() / block_samples) * block_samples;
+		bit_plane_end_ = bit_plane_start_.load();
+	}
 
-	delete edges;
+	mipmap_discarded_ = true;
 }
 
-void LogicSegment::reallocate_mipmap_level(MipMapLevel &m)
+void LogicSegment::enable_bit_planes()
 {
 	lock_guard<recursive_mutex> lock(mutex_);
 
-	const uint64_t new_data_length = ((m.length + MipMapDataUnit - 1) /
-		MipMapDataUnit) * MipMapDataUnit;
+	assert(sample_count_ == 0);
+	assert(unit_size_ <= 8);
 
-	if (new_data_length > m.data_length) {
-		m.data_length = new_data_length;
+	bit_planes_enabled_ = true;
+}
+
+bool LogicSegment::has_bit_planes() const
+{
+	return bit_planes_enabled_;
+}
+
+void LogicSegment::build_derived_data()
+{
+	// Only the mip-map levels and the bit plane table are replaced with
+	// mutex_ held, the samples are processed while the writer continues
+	append_payload_to_mipmap();
 
-		// Padding is added to allow for the uint64_t write word
-		m.data = realloc(m.data, new_data_length * unit_size_ +
-			sizeof(uint64_t));
+	if (bit_planes_enabled_)
+		append_payload_to_bit_planes();
+
+	append_payload_to_edge_index();
+	append_payload_to_stats();
+
+	// Chunks don't need to be decompressed for the mip-map and the bit
+	// planes once they cover them
+	uint64_t processed = mip_map_[0].length * MipMapScaleFactor;
+	if (bit_planes_enabled_)
+		processed = min(processed, bit_plane_end_.load());
+
+	// The statistics only take whole blocks, the samples of the last
+	// partial one are still needed
+	{
+		lock_guard<mutex> stats_lock(stats_mutex_);
+		processed = min(processed, stats_.end_block() * LogicStats::BlockLength);
 	}
+	compress_chunks_before(processed);
+
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	// Old chunks may go in ring buffer mode once nothing needs to be built
+	// from them anymore
+	drop_old_chunks(processed);
+	drop_old_bit_planes();
+	drop_old_edges();
+	drop_old_stats();
 }
 
-void LogicSegment::append_payload_to_mipmap()
+void LogicSegment::reallocate_mipmap_level(unsigned int level,
+	uint64_t new_length, bool have_mipmap_lock)
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	MipMapLevel &m = mip_map_[level];
+
+	if (new_length - m.start <= m.data_length)
+		return;
+
+	// Entries that only cover dropped samples can be removed, except for
+	// those that the next level wasn't built from yet. Readers don't expect
+	// the start to move while they hold the mip-map lock, so this is
+	// skipped if one of them is active and the level simply grows instead.
+	uint64_t new_start = m.start;
+	unique_lock<mutex> mipmap_lock(mipmap_mutex_, defer_lock);
+
+	if ((sample_limit_ > 0) && (have_mipmap_lock || mipmap_lock.try_lock())) {
+		uint64_t start = get_first_sample() >> ((level + 1) * MipMapScalePower);
+		if (level + 1 < ScaleStepCount)
+			start = min(start, mip_map_[level + 1].length * MipMapScaleFactor);
+		new_start = max(new_start, min(start, (uint64_t)m.length));
+	}
+
+	// Grow geometrically so that the number of copies stays low
+	const uint64_t kept_length = m.length - new_start;
+	const uint64_t new_data_length = ((max(new_length - new_start, 2 * kept_length) +
+		MipMapDataUnit - 1) / MipMapDataUnit) * MipMapDataUnit;
+
+	// Readers may still access the old buffer, so we can't realloc() it
+	// Padding is added to allow for the uint64_t write word
+	void *new_data = malloc(new_data_length * unit_size_ + sizeof(uint64_t));
+	if (!new_data)
+		throw std::bad_alloc();
+
+	uint8_t *old_data = (uint8_t*)m.data.load();
+	if (old_data)
+		memcpy(new_data, old_data + (new_start - m.start) * unit_size_,
+			kept_length * unit_size_);
+
+	// The start is only written while readers are locked out
+	m.data_length = new_data_length;
+	if (new_start != m.start)
+		m.start = new_start;
+	m.data = new_data;
+
+	retire_buffer(old_data);
+}
+
+void LogicSegment::append_payload_to_mipmap(bool have_mipmap_lock)
 {
 	MipMapLevel &m0 = mip_map_[0];
 	uint64_t prev_length;
@@ -639,19 +1306,19 @@ void LogicSegment::append_payload_to_mipmap()
 
 	// Expand the data buffer to fit the new samples
 	prev_length = m0.length;
-	m0.length = sample_count_ / MipMapScaleFactor;
+	const uint64_t m0_length = sample_count_ / MipMapScaleFactor;
 
 	// Break off if there are no new samples to compute
-	if (m0.length == prev_length)
+	if (m0_length == prev_length)
 		return;
 
-	reallocate_mipmap_level(m0);
+	reallocate_mipmap_level(0, m0_length, have_mipmap_lock);
 
-	dest_ptr = (uint8_t*)m0.data + prev_length * unit_size_;
+	dest_ptr = (uint8_t*)m0.data.load() + (prev_length - m0.start) * unit_size_;
 
 	// Iterate through the samples to populate the first level mipmap
 	const uint64_t start_sample = prev_length * MipMapScaleFactor;
-	const uint64_t end_sample = m0.length * MipMapScaleFactor;
+	const uint64_t end_sample = m0_length * MipMapScaleFactor;
 	uint64_t len_sample = end_sample - start_sample;
 	it = begin_sample_iteration(start_sample);
 	while (len_sample > 0) {
@@ -677,6 +1344,9 @@ void LogicSegment::append_payload_to_mipmap()
 	}
 	end_sample_iteration(it);
 
+	// Only publish the new entries once they're complete
+	m0.length = m0_length;
+
 	// Compute higher level mipmaps
 	for (unsigned int level = 1; level < ScaleStepCount; level++) {
 		MipMapLevel &m = mip_map_[level];
@@ -684,41 +1354,284 @@ void LogicSegment::append_payload_to_mipmap()
 
 		// Expand the data buffer to fit the new samples
 		prev_length = m.length;
-		m.length = ml.length / MipMapScaleFactor;
+		const uint64_t m_length = ml.length / MipMapScaleFactor;
 
 		// Break off if there are no more samples to be computed
-		if (m.length == prev_length)
+		if (m_length <= prev_length)
 			break;
 
-		reallocate_mipmap_level(m);
+		reallocate_mipmap_level(level, m_length, have_mipmap_lock);
 
 		// Subsample the lower level
-		const uint8_t* src_ptr = (uint8_t*)ml.data +
-			unit_size_ * prev_length * MipMapScaleFactor;
+		const uint8_t* src_ptr = (uint8_t*)ml.data.load() +
+			unit_size_ * (prev_length * MipMapScaleFactor - ml.start);
 		const uint8_t *const end_dest_ptr =
-			(uint8_t*)m.data + unit_size_ * m.length;
-
-		for (dest_ptr = (uint8_t*)m.data +
-				unit_size_ * prev_length;
-				dest_ptr < end_dest_ptr;
-				dest_ptr += unit_size_) {
-			accumulator = 0;
-			diff_counter = MipMapScaleFactor;
-			while (diff_counter-- > 0) {
-				accumulator |= unpack_sample(src_ptr);
-				src_ptr += unit_size_;
+			(uint8_t*)m.data.load() + unit_size_ * (m_length - m.start);
+
+		dest_ptr = (uint8_t*)m.data.load() + unit_size_ * (prev_length - m.start);
+
+		if (simd::available())
+			simd::reduce_or(src_ptr, dest_ptr, m_length - prev_length, unit_size_);
+		else
+			for (; dest_ptr < end_dest_ptr; dest_ptr += unit_size_) {
+				accumulator = 0;
+				diff_counter = MipMapScaleFactor;
+				while (diff_counter-- > 0) {
+					accumulator |= unpack_sample(src_ptr);
+					src_ptr += unit_size_;
+				}
+
+				pack_sample(dest_ptr, accumulator);
 			}
 
-			pack_sample(dest_ptr, accumulator);
+		m.length = m_length;
+	}
+}
+
+void LogicSegment::append_payload_to_bit_planes()
+{
+	const uint64_t channel_count = 8 * unit_size_;
+	const uint64_t word_length = simd::BitPlaneWordLength;
+
+	// Only complete words are transposed, the remaining samples are read
+	// from the chunks until the next payload completes them
+	const uint64_t end = (sample_count_ / word_length) * word_length;
+	uint64_t index = bit_plane_end_;
+
+	while (index < end) {
+		const uint64_t word = index / word_length;
+		const uint64_t block_num = word / BitPlaneBlockWords;
+		const uint64_t block_offset = word % BitPlaneBlockWords;
+
+		uint64_t **blocks = bit_plane_blocks_;
+
+		if (block_num >= bit_plane_block_capacity_) {
+			lock_guard<recursive_mutex> lock(mutex_);
+
+			// Readers may still access the old table, so we can't realloc() it
+			const uint64_t new_capacity = max(max(2 * bit_plane_block_capacity_,
+				block_num + 1), (uint64_t)64);
+			uint64_t **new_blocks = (uint64_t**)calloc(new_capacity, sizeof(uint64_t*));
+			if (!new_blocks)
+				throw std::bad_alloc();
+
+			if (blocks)
+				memcpy(new_blocks, blocks,
+					bit_plane_block_capacity_ * sizeof(uint64_t*));
+
+			bit_plane_blocks_ = new_blocks;
+			bit_plane_block_capacity_ = new_capacity;
+			retire_buffer(blocks);
+			blocks = new_blocks;
+		}
+
+		if (!blocks[block_num]) {
+			blocks[block_num] = (uint64_t*)malloc(
+				channel_count * BitPlaneBlockWords * sizeof(uint64_t));
+			if (!blocks[block_num])
+				throw std::bad_alloc();
 		}
+
+		const uint64_t word_count = min(min((end - index) / word_length,
+			BitPlaneBlockWords - block_offset), BitPlaneBatchWords);
+
+		// The words may span chunks, so the samples are copied first
+		bit_plane_buffer_.resize(word_count * word_length * unit_size_);
+		get_raw_samples(index, word_count * word_length, bit_plane_buffer_.data());
+
+		simd::transpose_bits(bit_plane_buffer_.data(),
+			blocks[block_num] + block_offset, word_count, BitPlaneBlockWords,
+			unit_size_);
+
+		// Only publish the new words once they're complete
+		index += word_count * word_length;
+		bit_plane_end_ = index;
 	}
 }
 
-uint64_t LogicSegment::get_unpacked_sample(uint64_t index) const
+void LogicSegment::drop_old_bit_planes()
+{
+	if (!bit_planes_enabled_ || (sample_limit_ == 0))
+		return;
+
+	const uint64_t block_samples = BitPlaneBlockWords * simd::BitPlaneWordLength;
+	const uint64_t first_sample = get_first_sample();
+
+	// Readers that passed the start check before it moved may still read
+	// the block, so it's only retired and stays in the table
+	while (bit_plane_start_ + block_samples <= first_sample) {
+		const uint64_t block_num = bit_plane_start_ / block_samples;
+		bit_plane_start_ += block_samples;
+		retire_buffer(bit_plane_blocks_.load()[block_num]);
+	}
+}
+
+void LogicSegment::append_payload_to_edge_index()
+{
+	const uint64_t channel_count = 8 * unit_size_;
+
+	// Edges are taken from the samples that the mip-map covers, blocks that
+	// its first level shows to be idle are skipped
+	const uint64_t end = mip_map_[0].length * MipMapScaleFactor;
+	uint64_t index = edge_index_end_;
+	uint64_t prev = edge_index_prev_;
+	uint64_t mask = edge_index_mask_;
+
+	if ((index >= end) || (mask == 0))
+		return;
+
+	// The first sample has no predecessor, so it can't be an edge
+	if (index == 0) {
+		prev = get_unpacked_sample(0);
+		index = 1;
+	}
+
+	vector< vector<uint64_t> > new_edges(channel_count);
+
+	while (index < end) {
+		// The edges are added in batches to limit the memory needed for
+		// channels that turn out to toggle too often to be indexed
+		const uint64_t batch_end = min(end, index + EdgeSearchWindow);
+
+		{
+			DataView view(*this, index, batch_end);
+
+			for (const DataSpan &span : view.spans()) {
+				const uint8_t *ptr = span.data;
+				const uint64_t span_end = index + span.sample_count;
+
+				while (index < span_end) {
+					const uint64_t block = index / MipMapScaleFactor;
+					const uint64_t block_end = min(span_end,
+						(block + 1) * MipMapScaleFactor);
+
+					if ((get_subsample(0, block) & mask) == 0) {
+						ptr += (block_end - index) * unit_size_;
+						index = block_end;
+						continue;
+					}
+
+					for (; index < block_end; index++, ptr += unit_size_) {
+						const uint64_t sample = unpack_sample(ptr);
+						uint64_t changes = (sample ^ prev) & mask;
+						prev = sample;
+
+						while (changes) {
+							new_edges[__builtin_ctzll(changes)].push_back(index);
+							changes &= changes - 1;
+						}
+					}
+				}
+			}
+		}
+
+		const uint64_t max_size = (batch_end - get_first_sample()) /
+			EdgeIndexMinSpacing + EdgeIndexMinSize;
+
+		lock_guard<mutex> lock(edge_index_mutex_);
+
+		for (uint64_t c = 0; c < channel_count; c++) {
+			if (!((mask >> c) & 1))
+				continue;
+
+			EdgeIndex &edge_index = edge_indices_[c];
+			edge_index.append(new_edges[c]);
+			new_edges[c].clear();
+
+			// The index of a channel that toggles often would grow large,
+			// while its edges are found quickly in the samples anyway
+			if (edge_index.memory_usage() > max_size) {
+				edge_index.clear();
+				mask &= ~(1ULL << c);
+			}
+		}
+
+		edge_index_mask_ = mask;
+		edge_index_end_ = batch_end;
+	}
+
+	edge_index_prev_ = prev;
+}
+
+void LogicSegment::drop_old_edges()
+{
+	if (sample_limit_ == 0)
+		return;
+
+	const uint64_t first_sample = get_first_sample();
+
+	lock_guard<mutex> lock(edge_index_mutex_);
+
+	for (EdgeIndex &index : edge_indices_)
+		index.drop_before(first_sample);
+}
+
+void LogicSegment::append_payload_to_stats()
+{
+	// Only blocks that the mip-map covers completely are summarized, the
+	// samples before its end are final
+	const uint64_t end_block =
+		(mip_map_[0].length * MipMapScaleFactor) / LogicStats::BlockLength;
+	uint64_t block = stats_.end_block();
+
+	while (block < end_block) {
+		const uint64_t batch_end = min(end_block,
+			block + EdgeSearchWindow / LogicStats::BlockLength);
+
+		DataView view(*this, block * LogicStats::BlockLength,
+			batch_end * LogicStats::BlockLength);
+		const uint8_t *samples = view.contiguous_data(stats_buffer_);
+
+		lock_guard<mutex> lock(stats_mutex_);
+		stats_.append(samples, batch_end - block);
+		block = batch_end;
+	}
+}
+
+void LogicSegment::drop_old_stats()
+{
+	if (sample_limit_ == 0)
+		return;
+
+	lock_guard<mutex> lock(stats_mutex_);
+	stats_.drop_before(get_first_sample());
+}
+
+void LogicSegment::count_samples(int sig_index, uint64_t start, uint64_t end,
+	uint64_t &edges, uint64_t &highs) const
 {
-	assert(index < sample_count_);
+	if (start >= end)
+		return;
+
+	// The oldest sample has no predecessor, so it can't be an edge
+	uint64_t prev = (get_unpacked_sample(
+		(start > get_first_sample()) ? start - 1 : start) >> sig_index) & 1;
+
+	DataView view(*this, start, end);
 
+	for (const DataSpan &span : view.spans()) {
+		const uint8_t *ptr = span.data;
+
+		for (uint64_t i = 0; i < span.sample_count; i++, ptr += unit_size_) {
+			const uint64_t bit = (unpack_sample(ptr) >> sig_index) & 1;
+			highs += bit;
+			edges += bit ^ prev;
+			prev = bit;
+		}
+	}
+}
+
+uint64_t LogicSegment::get_unpacked_sample(uint64_t index) const
+{
 	assert(unit_size_ <= 8);  // 8 * 8 = 64 channels
+
+	// Chunks are only allocated when needed, so the position just past the
+	// last sample may not be backed by any memory
+	const uint64_t sample_count = sample_count_;
+	assert(sample_count > 0);
+	if (index >= sample_count)
+		index = sample_count - 1;
+
 	uint8_t data[8];
 
 	get_raw_samples(index, 1, data);
@@ -726,12 +1639,277 @@ uint64_t LogicSegment::get_unpacked_sample(uint64_t index) const
 	return unpack_sample(data);
 }
 
+const uint64_t* LogicSegment::get_bit_plane_word(uint64_t index,
+	int sig_index) const
+{
+	if (!bit_planes_enabled_ || (sig_index >= 8 * (int)unit_size_))
+		return nullptr;
+
+	// The end is published after the table and the words it covers
+	if ((index >= bit_plane_end_) || (index < bit_plane_start_))
+		return nullptr;
+
+	const uint64_t word = index / simd::BitPlaneWordLength;
+	const uint64_t *block = bit_plane_blocks_.load()[word / BitPlaneBlockWords];
+
+	return block + sig_index * BitPlaneBlockWords + word % BitPlaneBlockWords;
+}
+
+bool LogicSegment::get_sample_bit(uint64_t index, int sig_index) const
+{
+	const uint64_t *word = get_bit_plane_word(index, sig_index);
+	if (word)
+		return (*word >> (index % simd::BitPlaneWordLength)) & 1;
+
+	return (get_unpacked_sample(index) >> sig_index) & 1;
+}
+
+uint64_t LogicSegment::find_next_change(uint64_t index, uint64_t end,
+	int sig_index, bool value) const
+{
+	const uint64_t word_length = simd::BitPlaneWordLength;
+	const uint64_t inverter = value ? ~0ULL : 0;
+
+	while (index < end) {
+		const uint64_t *word = get_bit_plane_word(index, sig_index);
+
+		if (!word) {
+			// Samples that weren't transposed are checked one by one, a
+			// limited number at a time so that compressed chunks are only
+			// unpacked as far as needed
+			DataView view(*this, index, min(end, index + SampleScanLength));
+
+			for (const DataSpan &span : view.spans()) {
+				const uint8_t *ptr = span.data;
+				for (uint64_t i = 0; i < span.sample_count; i++, index++) {
+					if (((unpack_sample(ptr) >> sig_index) & 1) != value)
+						return index;
+					ptr += unit_size_;
+				}
+			}
+			continue;
+		}
+
+		// Look for the first bit differing from value, starting at index
+		const uint64_t word_start = index - (index % word_length);
+		const uint64_t changes = (*word ^ inverter) & (~0ULL << (index % word_length));
+
+		if (changes)
+			return min(end, word_start + __builtin_ctzll(changes));
+
+		index = word_start + word_length;
+	}
+
+	return end;
+}
+
+uint64_t LogicSegment::search_next_state_change(uint64_t index, uint64_t end,
+	uint64_t mask, uint64_t state) const
+{
+	while (index < end) {
+		DataView view(*this, index, min(end, index + SampleScanLength));
+
+		for (const DataSpan &span : view.spans()) {
+			const uint8_t *ptr = span.data;
+			for (uint64_t i = 0; i < span.sample_count; i++, index++) {
+				if ((unpack_sample(ptr) & mask) != state)
+					return index;
+				ptr += unit_size_;
+			}
+		}
+	}
+
+	return end;
+}
+
+uint64_t LogicSegment::get_bit_plane_edges(int sig_index, uint64_t index,
+	uint64_t end, bool &state, vector<uint64_t> &edges) const
+{
+	const uint64_t word_length = simd::BitPlaneWordLength;
+	const uint64_t mask = 1ULL << sig_index;
+
+	while (index < end) {
+		if (mip_map_[0].data && ((index % MipMapScaleFactor) == 0)) {
+			index = min(end, skip_unchanged_blocks(index, mask, 0));
+			if (index >= end)
+				break;
+		}
+
+		const uint64_t *word = get_bit_plane_word(index, sig_index);
+		if (!word)
+			break;
+
+		// Bit i is set where sample i differs from the one before it,
+		// the state carries over from the previous word
+		const uint64_t word_start = index - (index % word_length);
+		const uint64_t word_end = min(end, word_start + word_length);
+		uint64_t changes = (*word ^ ((*word << 1) | (state ? 1 : 0))) &
+			(~0ULL << (index % word_length));
+		if (word_end - word_start < word_length)
+			changes &= (1ULL << (word_end - word_start)) - 1;
+
+		while (changes) {
+			edges.push_back(word_start + __builtin_ctzll(changes));
+			changes &= changes - 1;
+		}
+
+		state = (*word >> (word_end - 1 - word_start)) & 1;
+		index = word_end;
+	}
+
+	return index;
+}
+
+void LogicSegment::get_active_runs(uint64_t mask, uint64_t start, uint64_t end,
+	vector< pair<uint64_t, uint64_t> > &runs) const
+{
+	if (!mip_map_[0].data) {
+		runs.emplace_back(start, end);
+		return;
+	}
+
+	const uint64_t mipmap_length = mip_map_[0].length;
+	uint64_t index = start;
+
+	while (index < end) {
+		if ((index % MipMapScaleFactor) == 0)
+			index = min(end, skip_unchanged_blocks(index, mask, 0));
+		if (index >= end)
+			break;
+
+		// The run lasts up to the next block in which none of the channels
+		// change, blocks past the mip-map may always have changes
+		const uint64_t run_start = index;
+		index = pow2_ceil(index + 1, MipMapScalePower);
+		while (index < end) {
+			const uint64_t block = index / MipMapScaleFactor;
+			if ((block < mipmap_length) && !(get_subsample(0, block) & mask))
+				break;
+			index += MipMapScaleFactor;
+		}
+
+		runs.emplace_back(run_start, min(index, end));
+	}
+}
+
+void LogicSegment::rebuild_discarded_mipmap()
+{
+	// Note: the caller must hold mipmap_mutex_
+	if (!mipmap_discarded_ || mipmap_rebuilding_)
+		return;
+
+	// A previous rebuild thread is done once it cleared the flag
+	if (mipmap_rebuild_thread_.joinable())
+		mipmap_rebuild_thread_.join();
+
+	mipmap_rebuilding_ = true;
+	mipmap_rebuild_thread_ = thread(&LogicSegment::mipmap_rebuild_proc, this);
+}
+
+void LogicSegment::mipmap_rebuild_proc()
+{
+	// The segment is complete, so this thread is the only writer and
+	// extends the mip-map and bit planes while readers use them, just
+	// like the acquisition does
+	bool done = true;
+	try {
+		append_payload_to_mipmap(false);
+		if (bit_planes_enabled_)
+			append_payload_to_bit_planes();
+	} catch (std::bad_alloc&) {
+		// Readers keep scanning the samples, the next one tries again
+		done = false;
+	}
+
+	lock_guard<mutex> mipmap_lock(mipmap_mutex_);
+	mipmap_discarded_ = !done;
+	mipmap_rebuilding_ = false;
+}
+
+uint64_t LogicSegment::skip_unchanged_blocks(uint64_t index, uint64_t mask,
+	unsigned int min_level) const
+{
+	unsigned int level = min_level;
+
+	assert(mip_map_[min_level].data);
+
+	// Fast forward: This involves zooming out to higher
+	// levels of the mip map searching for changes, then
+	// zooming in on them to find the point where the edge
+	// begins.
+
+	// Slide right and zoom out at the beginnings of mip-map
+	// blocks until we encounter a change
+	while (true) {
+		const int level_scale_power = (level + 1) * MipMapScalePower;
+		const uint64_t offset = index >> level_scale_power;
+
+		// Check if we reached the last block at this
+		// level, or if there was a change in this block
+		if (offset >= mip_map_[level].length ||
+			(get_subsample(level, offset) &	mask))
+			break;
+
+		if ((offset & ~((uint64_t)(~0) << MipMapScalePower)) == 0) {
+			// If we are now at the beginning of a
+			// higher level mip-map block ascend one
+			// level
+			if ((level + 1 >= ScaleStepCount) || (!mip_map_[level + 1].data))
+				break;
+
+			level++;
+		} else {
+			// Slide right to the beginning of the
+			// next mip map block
+			index = pow2_ceil(index + 1, level_scale_power);
+		}
+	}
+
+	// Zoom in, and slide right until we encounter a change,
+	// and repeat until we reach min_level
+	while (true) {
+		assert(mip_map_[level].data);
+
+		const int level_scale_power = (level + 1) * MipMapScalePower;
+		const uint64_t offset = index >> level_scale_power;
+
+		// Check if we reached the last block at this
+		// level, or if there was a change in this block
+		if (offset >= mip_map_[level].length ||
+				(get_subsample(level, offset) & mask)) {
+			// Zoom in unless we reached the minimum
+			// zoom
+			if (level == min_level)
+				break;
+
+			level--;
+		} else {
+			// Slide right to the beginning of the
+			// next mip map block
+			index = pow2_ceil(index + 1, level_scale_power);
+		}
+	}
+
+	return index;
+}
+
 uint64_t LogicSegment::get_subsample(int level, uint64_t offset) const
 {
 	assert(level >= 0);
-	assert(mip_map_[level].data);
-	return unpack_sample((uint8_t*)mip_map_[level].data +
-		unit_size_ * offset);
+
+	// Note: the caller must pin the memory and hold mipmap_mutex_ while
+	// using the mip-map
+	const MipMapLevel &m = mip_map_[level];
+
+	// Entries that were removed in ring buffer mode or not rebuilt yet
+	// are reported as changed so that the search zooms in on the samples
+	if (offset < m.start)
+		return ~(uint64_t)0;
+
+	const uint8_t *data = (const uint8_t*)m.data.load();
+	assert(data);
+
+	return unpack_sample(data + unit_size_ * (offset - m.start));
 }
 
 uint64_t LogicSegment::pow2_ceil(uint64_t x, unsigned int power)
@@ -20,15 +20,21 @@
 #ifndef PULSEVIEW_PV_DATA_LOGICSEGMENT_HPP
 #define PULSEVIEW_PV_DATA_LOGICSEGMENT_HPP
 
+#include "edgeindex.hpp"
+#include "logicstats.hpp"
 #include "segment.hpp"
 
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <QObject>
 
 using std::enable_shared_from_this;
+using std::mutex;
 using std::pair;
 using std::shared_ptr;
+using std::thread;
 using std::vector;
 
 namespace sigrok {
@@ -61,12 +67,50 @@ public:
 	static const float LogMipMapScaleFactor;
 	static const uint64_t MipMapDataUnit;
 
+	/// Number of words per channel in a block of bit plane memory
+	static const uint64_t BitPlaneBlockWords;
+	/// Number of words that are transposed at once
+	static const uint64_t BitPlaneBatchWords;
+
+	/// Channels with edges closer together than this many samples on average
+	/// aren't indexed, searching their samples is quick enough
+	static const uint64_t EdgeIndexMinSpacing;
+	/// Size an edge index may reach regardless of the spacing of the edges
+	static const uint64_t EdgeIndexMinSize;
+	/// Size of the first window that edges are searched in backwards if
+	/// the channel isn't indexed
+	static const uint64_t EdgeSearchWindow;
+	/// Number of samples that are scanned at once where neither the mip-map
+	/// nor the bit planes cover them
+	static const uint64_t SampleScanLength;
+
 private:
+	/**
+	 * A mip-map level is written by the acquisition thread while readers
+	 * may access it. New entries are written first, then the data pointer
+	 * and lastly the length are published.
+	 * In ring buffer mode, entries that only cover dropped samples are
+	 * removed when the level is reallocated. @c start is the index of the
+	 * entry stored at the beginning of @c data and only changes while
+	 * mipmap_mutex_ is held.
+	 */
 	struct MipMapLevel
 	{
-		uint64_t length;
+		atomic<uint64_t> length;
+		uint64_t start;
 		uint64_t data_length;
-		void *data;
+		atomic<void*> data;
+	};
+
+public:
+	/// Statistics of a channel in a range of samples
+	struct ChannelStats
+	{
+		uint64_t sample_count;
+		uint64_t edge_count;
+		uint64_t high_count;
+		bool has_edges;
+		uint64_t first_edge, last_edge;
 	};
 
 public:
@@ -115,24 +159,202 @@ public:
 		uint64_t start, uint64_t end,
 		float min_length, int sig_index, bool first_change_only = false);
 
+	/**
+	 * Does the same as get_subsampled_edges() for several signals and
+	 * yields the same edges. The signals are searched together, a window
+	 * of samples at a time, so that the mip-map entries and chunks that
+	 * they read are only fetched once, and signals sharing a channel are
+	 * only searched once.
+	 * @param[out] edges Receives the edges of signal @c sig_indices[i] in
+	 * @c edges[i].
+	 */
+	void get_subsampled_edges(vector< vector<EdgePair> > &edges,
+		uint64_t start, uint64_t end, float min_length,
+		const vector<int> &sig_indices);
+
+	/**
+	 * Finds the last edge at or before @c origin_sample and the first edge
+	 * after it, either of which may not exist.
+	 */
 	void get_surrounding_edges(vector<EdgePair> &dest,
-		uint64_t origin_sample, float min_length, int sig_index);
+		uint64_t origin_sample, int sig_index);
+
+	/**
+	 * The edge queries use the edge index of a channel where possible and
+	 * search the samples otherwise. An edge at sample i means that sample i
+	 * differs from sample i - 1.
+	 */
+	bool find_previous_edge(int sig_index, uint64_t sample, uint64_t &edge);
+	bool find_next_edge(int sig_index, uint64_t sample, uint64_t &edge);
+
+	/**
+	 * Finds the first sample in [start, end) at which any channel in
+	 * @c mask differs from the sample before it. Mip-map blocks in which
+	 * none of these channels change are skipped.
+	 */
+	bool find_next_state_change(uint64_t mask, uint64_t start, uint64_t end,
+		uint64_t &change);
+
+	/**
+	 * Appends all edges of a channel in [start, end) to @c edges. Unlike
+	 * get_subsampled_edges(), the states aren't stored, they alternate
+	 * after the state that is returned, which is the one of the sample
+	 * before the first edge. Mip-map blocks in which the channel doesn't
+	 * change are skipped, and the bit planes are read a word at a time.
+	 * The mip-map lock isn't held while other samples are read, so several
+	 * threads may call this at once.
+	 */
+	bool get_edges(int sig_index, uint64_t start, uint64_t end,
+		vector<uint64_t> &edges);
+
+	/// Returns the number of edges in [start, end)
+	uint64_t get_edge_count(int sig_index, uint64_t start, uint64_t end);
+
+	/// Finds the n-th edge at or after @c start, counting from 0
+	bool find_nth_edge(int sig_index, uint64_t start, uint64_t n, uint64_t &edge);
+
+	bool is_edge_indexed(int sig_index) const;
+
+	/**
+	 * Returns the number of edges and high samples of a channel in
+	 * [start, end) along with its first and last edge there. The counts
+	 * are taken from the running statistics for the whole blocks of the
+	 * range, only the partial blocks at either end are read.
+	 */
+	ChannelStats get_channel_stats(int sig_index, uint64_t start, uint64_t end);
+
+	uint64_t get_mipmap_memory_usage() const;
+
+	/**
+	 * Frees the mip-map and the bit planes of a complete segment. They're
+	 * rebuilt the next time get_subsampled_edges() needs them.
+	 */
+	void discard_mipmap();
+
+	/**
+	 * Additionally stores the samples in a transposed layout, where every
+	 * channel has its own bit plane of words holding 64 samples each. Edge
+	 * searches then only touch the bits of the channel they look at instead
+	 * of reading all channels sample by sample. The bit planes take as much
+	 * memory as the samples themselves. Must be called before any samples
+	 * are added.
+	 */
+	void enable_bit_planes();
+	bool has_bit_planes() const;
+
+protected:
+	/**
+	 * Builds the mip-map, the bit planes and the edge index. Readers search
+	 * the samples themselves where these don't reach yet.
+	 */
+	virtual void build_derived_data();
 
 private:
 	uint64_t unpack_sample(const uint8_t *ptr) const;
 	void pack_sample(uint8_t *ptr, uint64_t value);
 
-	void reallocate_mipmap_level(MipMapLevel &m);
+	void reallocate_mipmap_level(unsigned int level, uint64_t new_length,
+		bool have_mipmap_lock);
+
+	void append_payload_to_mipmap(bool have_mipmap_lock = false);
+
+	void append_payload_to_bit_planes();
+	void drop_old_bit_planes();
 
-	void append_payload_to_mipmap();
+	void append_payload_to_edge_index();
+	void drop_old_edges();
+
+	/// Summarizes the blocks of samples that the mip-map covers completely
+	void append_payload_to_stats();
+	void drop_old_stats();
+
+	/// Counts the edges and the high samples of a channel in [start, end)
+	/// by reading the samples
+	void count_samples(int sig_index, uint64_t start, uint64_t end,
+		uint64_t &edges, uint64_t &highs) const;
+
+	/// Searches the samples for the last edge in (start, end]
+	bool search_last_edge(int sig_index, uint64_t start, uint64_t end,
+		uint64_t &edge);
+	/// Searches the samples for the first edge after @c sample
+	bool search_next_edge(int sig_index, uint64_t sample, uint64_t &edge);
+	/// Counts the edges in (start, end] by searching the samples
+	uint64_t search_edge_count(int sig_index, uint64_t start, uint64_t end);
 
 	uint64_t get_unpacked_sample(uint64_t index) const;
 
+	/**
+	 * Returns the bit plane word of a channel that holds the sample at
+	 * @c index, or nullptr if the sample wasn't transposed. The caller
+	 * must pin the memory while using the word.
+	 */
+	const uint64_t* get_bit_plane_word(uint64_t index, int sig_index) const;
+
+	bool get_sample_bit(uint64_t index, int sig_index) const;
+
+	/**
+	 * Returns the index of the first sample in [index, end) at which a
+	 * channel doesn't have the state @c value, or @c end if there is none.
+	 */
+	uint64_t find_next_change(uint64_t index, uint64_t end, int sig_index,
+		bool value) const;
+
+	/**
+	 * Searches the samples for the first one in [index, end) whose channels
+	 * in @c mask differ from @c state. Returns @c end if there is none.
+	 */
+	uint64_t search_next_state_change(uint64_t index, uint64_t end,
+		uint64_t mask, uint64_t state) const;
+
+	/**
+	 * Appends the edges of a channel in [index, end) that the bit planes
+	 * hold, starting with the channel in @c state. Returns the sample at
+	 * which the bit planes end. The caller must hold mipmap_mutex_.
+	 */
+	uint64_t get_bit_plane_edges(int sig_index, uint64_t index, uint64_t end,
+		bool &state, vector<uint64_t> &edges) const;
+
+	/**
+	 * Appends the ranges of [start, end) to @c runs that lie outside of
+	 * the mip-map blocks in which none of the channels in @c mask change.
+	 * The caller must hold mipmap_mutex_.
+	 */
+	void get_active_runs(uint64_t mask, uint64_t start, uint64_t end,
+		vector< pair<uint64_t, uint64_t> > &runs) const;
+
 	template <class T> void downsampleTmain(const T*&in, T &acc, T &prev);
 	template <class T> void downsampleT(const uint8_t *in, uint8_t *&out, uint64_t len);
 	void downsampleGeneric(const uint8_t *in, uint8_t *&out, uint64_t len);
 
 private:
+	/**
+	 * Starts rebuilding a discarded mip-map in the background, the caller
+	 * must hold mipmap_mutex_. Until the rebuild is done, readers see a
+	 * mip-map that covers fewer samples than are stored and scan the
+	 * remaining samples instead.
+	 */
+	void rebuild_discarded_mipmap();
+	void mipmap_rebuild_proc();
+
+	/**
+	 * Continues the edge search of get_subsampled_edges() for a signal at
+	 * @c index with the signal in @c last_sample, appending the edges it
+	 * finds. Returns false if it stopped because @c index reached
+	 * @c stop, so that the search can be resumed from there, and true once
+	 * it's done. The caller must pin the memory and hold mipmap_mutex_.
+	 */
+	bool append_subsampled_edges(vector<EdgePair> &edges, uint64_t &index,
+		uint64_t end, uint64_t stop, float min_length, int sig_index,
+		bool &last_sample, bool first_change_only);
+
+	/**
+	 * Slides right from @c index through the mip-map until it reaches a
+	 * block of @c min_level in which a channel of @c mask changes, or the
+	 * end of the mip-map. Returns the beginning of that block.
+	 */
+	uint64_t skip_unchanged_blocks(uint64_t index, uint64_t mask,
+		unsigned int min_level) const;
+
 	uint64_t get_subsample(int level, uint64_t offset) const;
 
 	static uint64_t pow2_ceil(uint64_t x, unsigned int power);
@@ -141,10 +363,43 @@ private:
 	Logic& owner_;
 
 	struct MipMapLevel mip_map_[ScaleStepCount];
+	/// Keeps the mip-map from being discarded, rebuilt or compacted while
+	/// it's searched
+	mutable mutex mipmap_mutex_;
+	bool mipmap_discarded_;
+	/// Set while mipmap_rebuild_thread_ extends a discarded mip-map, both
+	/// flags are protected by mipmap_mutex_
+	bool mipmap_rebuilding_;
+	thread mipmap_rebuild_thread_;
 	uint64_t last_append_sample_;
 	uint64_t last_append_accumulator_;
 	uint64_t last_append_extra_;
 
+	/// Each block holds BitPlaneBlockWords words of every channel, those of
+	/// channel c start at word c * BitPlaneBlockWords. The block table is
+	/// replaced when it grows, blocks dropped in ring buffer mode stay in it.
+	bool bit_planes_enabled_;
+	atomic<uint64_t**> bit_plane_blocks_;
+	uint64_t bit_plane_block_capacity_;
+	/// Samples [bit_plane_start_, bit_plane_end_) are available transposed
+	atomic<uint64_t> bit_plane_start_, bit_plane_end_;
+	vector<uint8_t> bit_plane_buffer_;
+
+	/// The edge index covers the samples before edge_index_end_ for every
+	/// channel in edge_index_mask_. It's accessed with edge_index_mutex_
+	/// held, except for edge_index_prev_ which is only used by the writer.
+	vector<EdgeIndex> edge_indices_;
+	uint64_t edge_index_mask_;
+	uint64_t edge_index_end_;
+	uint64_t edge_index_prev_;
+	mutable mutex edge_index_mutex_;
+
+	/// The statistics cover the blocks before stats_.end_block(). They're
+	/// accessed with stats_mutex_ held, except for reads by the writer.
+	LogicStats stats_;
+	vector<uint8_t> stats_buffer_;
+	mutable mutex stats_mutex_;
+
 	friend struct LogicSegmentTest::Pow2;
 	friend struct LogicSegmentTest::Basic;
 	friend struct LogicSegmentTest::LargeData;
@@ -0,0 +1,133 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "logicstats.hpp"
+#include "simd.hpp"
+
+using std::min;
+
+namespace pv {
+namespace data {
+
+const uint64_t LogicStats::BlockLength = 4096;
+
+LogicStats::LogicStats(unsigned int unit_size) :
+	unit_size_(unit_size),
+	channel_count_(8 * unit_size)
+{
+	clear();
+}
+
+void LogicStats::append(const uint8_t *samples, uint64_t block_count)
+{
+	const uint64_t words = BlockLength / simd::BitPlaneWordLength;
+	planes_.resize(channel_count_ * words);
+
+	for (uint64_t b = 0; b < block_count; b++) {
+		// Counting the bits of every channel is quicker on bit planes than
+		// on the samples, as whole words are handled at once
+		simd::transpose_bits(samples, planes_.data(), words, words, unit_size_);
+		samples += BlockLength * unit_size_;
+
+		// The first sample of the segment has no predecessor, so it must not
+		// become an edge
+		if (end_block() == 0) {
+			prev_ = 0;
+			for (unsigned int c = 0; c < channel_count_; c++)
+				prev_ |= (planes_[c * words] & 1) << c;
+		}
+
+		const uint64_t last = counts_.size() - 2 * channel_count_;
+		uint64_t state = 0;
+
+		for (unsigned int c = 0; c < channel_count_; c++) {
+			const uint64_t *plane = &planes_[c * words];
+			uint64_t prev = (prev_ >> c) & 1;
+			uint64_t edges = 0, highs = 0;
+
+			for (uint64_t w = 0; w < words; w++) {
+				const uint64_t word = plane[w];
+				highs += __builtin_popcountll(word);
+				edges += __builtin_popcountll(word ^ ((word << 1) | prev));
+				prev = word >> 63;
+			}
+
+			state |= prev << c;
+			counts_.push_back(counts_[last + 2 * c] + edges);
+			counts_.push_back(counts_[last + 2 * c + 1] + highs);
+		}
+
+		prev_ = state;
+	}
+}
+
+void LogicStats::drop_before(uint64_t sample)
+{
+	const uint64_t block = min(sample / BlockLength, end_block());
+	if (block <= first_block_)
+		return;
+
+	counts_.erase(counts_.begin(),
+		counts_.begin() + (block - first_block_) * 2 * channel_count_);
+	first_block_ = block;
+}
+
+void LogicStats::clear()
+{
+	counts_.assign(2 * channel_count_, 0);
+	first_block_ = 0;
+	prev_ = 0;
+}
+
+uint64_t LogicStats::first_block() const
+{
+	return first_block_;
+}
+
+uint64_t LogicStats::end_block() const
+{
+	return first_block_ + counts_.size() / (2 * channel_count_) - 1;
+}
+
+uint64_t LogicStats::edge_count(unsigned int channel, uint64_t block) const
+{
+	assert(channel < channel_count_);
+	assert((block >= first_block_) && (block <= end_block()));
+
+	return counts_[(block - first_block_) * 2 * channel_count_ + 2 * channel];
+}
+
+uint64_t LogicStats::high_count(unsigned int channel, uint64_t block) const
+{
+	assert(channel < channel_count_);
+	assert((block >= first_block_) && (block <= end_block()));
+
+	return counts_[(block - first_block_) * 2 * channel_count_ + 2 * channel + 1];
+}
+
+uint64_t LogicStats::memory_usage() const
+{
+	return (counts_.size() + planes_.capacity()) * sizeof(uint64_t);
+}
+
+} // namespace data
+} // namespace pv
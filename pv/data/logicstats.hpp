@@ -0,0 +1,100 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_LOGICSTATS_HPP
+#define PULSEVIEW_PV_DATA_LOGICSTATS_HPP
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+using std::deque;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+/**
+ * Running statistics of the channels of a logic segment.
+ *
+ * The samples are summarized in blocks of BlockLength samples. At every
+ * block boundary, the number of edges and the number of high samples from
+ * the beginning of the segment up to the boundary are stored per channel,
+ * so the counts of any range of whole blocks are the difference of two
+ * entries. An edge at sample i means that sample i differs from sample
+ * i - 1, the first sample of the segment is never an edge.
+ *
+ * Old boundaries can be dropped in ring buffer mode, the counts of the
+ * remaining ones keep including the dropped samples.
+ *
+ * The statistics aren't thread-safe, their owner must serialize the accesses.
+ */
+class LogicStats
+{
+public:
+	/// Number of samples per block, a multiple of simd::BitPlaneWordLength
+	static const uint64_t BlockLength;
+
+public:
+	LogicStats(unsigned int unit_size);
+
+	/**
+	 * Summarizes @c block_count blocks of samples that follow the last
+	 * block which was appended.
+	 */
+	void append(const uint8_t *samples, uint64_t block_count);
+
+	/// Removes the boundaries before the block that holds @c sample
+	void drop_before(uint64_t sample);
+
+	void clear();
+
+	/// Returns the oldest block boundary that is still stored
+	uint64_t first_block() const;
+
+	/// Returns the number of blocks that were appended in total
+	uint64_t end_block() const;
+
+	/**
+	 * Return the number of edges and high samples of a channel before the
+	 * boundary of @c block, which must be in [first_block(), end_block()].
+	 */
+	uint64_t edge_count(unsigned int channel, uint64_t block) const;
+	uint64_t high_count(unsigned int channel, uint64_t block) const;
+
+	uint64_t memory_usage() const;
+
+private:
+	const unsigned int unit_size_;
+	const unsigned int channel_count_;
+
+	/// The edge and the high count of channel c at a boundary are stored at
+	/// 2 * c and 2 * c + 1 of the boundary's entries
+	deque<uint64_t> counts_;
+	uint64_t first_block_;
+	/// The state of every channel at the last sample appended
+	uint64_t prev_;
+
+	vector<uint64_t> planes_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_LOGICSTATS_HPP
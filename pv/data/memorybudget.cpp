@@ -0,0 +1,262 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <map>
+#include <unordered_set>
+
+#include <QDebug>
+
+#include "logic.hpp"
+#include "memorybudget.hpp"
+#include "signalbase.hpp"
+#include "signaldata.hpp"
+
+#include <pv/session.hpp>
+
+#ifdef ENABLE_DECODE
+#include "decodesignal.hpp"
+#endif
+
+using std::dynamic_pointer_cast;
+using std::map;
+using std::unordered_set;
+
+namespace pv {
+namespace data {
+
+const int MemoryBudget::UpdateInterval = 1000;
+
+uint64_t MemoryBudget::SignalUsage::total() const
+{
+	return sample_data + mipmaps + converted_data + decoder_data + annotations;
+}
+
+MemoryBudget::MemoryBudget(Session &session) :
+	session_(session),
+	budget_(0),
+	total_usage_(0),
+	budget_exceeded_(false)
+{
+	GlobalSettings settings;
+	set_budget(settings.value(GlobalSettings::Key_Acq_MemoryBudget).toULongLong() *
+		1024 * 1024);
+
+	GlobalSettings::add_change_handler(this);
+
+	connect(&update_timer_, SIGNAL(timeout()), this, SLOT(on_update_timer()));
+	update_timer_.setInterval(UpdateInterval);
+	update_timer_.start();
+}
+
+MemoryBudget::~MemoryBudget()
+{
+	GlobalSettings::remove_change_handler(this);
+}
+
+void MemoryBudget::set_budget(uint64_t size)
+{
+	budget_ = size;
+}
+
+uint64_t MemoryBudget::budget() const
+{
+	return budget_;
+}
+
+uint64_t MemoryBudget::total_usage() const
+{
+	return total_usage_;
+}
+
+const vector<MemoryBudget::SignalUsage>& MemoryBudget::signal_usage() const
+{
+	return signal_usage_;
+}
+
+void MemoryBudget::update()
+{
+	update_usage();
+
+	if ((budget_ > 0) && (total_usage_ > budget_)) {
+		free_regenerable_data(total_usage_ - budget_);
+		update_usage();
+	}
+
+	const bool budget_exceeded = (budget_ > 0) && (total_usage_ > budget_);
+	if (budget_exceeded && !budget_exceeded_)
+		qDebug() << "Memory budget exceeded by" <<
+			(total_usage_ - budget_) / (1024 * 1024) << "MiB, nothing left to free";
+	else if (!budget_exceeded && budget_exceeded_)
+		qDebug() << "Memory usage is within the budget again";
+	budget_exceeded_ = budget_exceeded;
+
+	usage_changed();
+}
+
+void MemoryBudget::on_setting_changed(const QString &key, const QVariant &value)
+{
+	if (key == GlobalSettings::Key_Acq_MemoryBudget) {
+		set_budget(value.toULongLong() * 1024 * 1024);
+		update();
+	}
+}
+
+void MemoryBudget::update_usage()
+{
+	signal_usage_.clear();
+	total_usage_ = 0;
+
+	// The logic channels of a device share their data, so it must only
+	// be accounted for once
+	unordered_set<const SignalData*> accounted_data;
+
+	for (const shared_ptr<SignalBase>& signal : session_.signalbases()) {
+		SignalUsage usage = SignalUsage();
+		usage.name = signal->name();
+
+		const shared_ptr<SignalData> data = signal->data();
+		if (data && accounted_data.insert(data.get()).second) {
+			usage.sample_data = data->get_memory_usage();
+			usage.mipmaps = data->get_mipmap_memory_usage();
+
+			if ((signal->type() == SignalBase::LogicChannel) && !signal->is_generated())
+				usage.name = tr("Logic channels");
+		}
+
+		if (signal->type() == SignalBase::AnalogChannel) {
+			const shared_ptr<Logic> converted = signal->logic_data();
+			if (converted)
+				usage.converted_data = converted->get_memory_usage() +
+					converted->get_mipmap_memory_usage();
+		}
+
+#ifdef ENABLE_DECODE
+		if (signal->is_decode_signal()) {
+			const shared_ptr<DecodeSignal> decode_signal =
+				dynamic_pointer_cast<DecodeSignal>(signal);
+			usage.decoder_data = decode_signal->get_mux_data_memory_usage();
+			usage.annotations = decode_signal->get_annotation_memory_usage();
+		}
+#endif
+
+		if (usage.total() == 0)
+			continue;
+
+		total_usage_ += usage.total();
+		signal_usage_.push_back(usage);
+	}
+}
+
+bool MemoryBudget::is_decoder_input(const shared_ptr<SignalBase> signal) const
+{
+#ifdef ENABLE_DECODE
+	for (const shared_ptr<SignalBase>& s : session_.signalbases()) {
+		if (!s->is_decode_signal())
+			continue;
+
+		const shared_ptr<DecodeSignal> decode_signal = dynamic_pointer_cast<DecodeSignal>(s);
+		for (const decode::DecodeChannel& ch : decode_signal->get_channels())
+			if (ch.assigned_signal == signal)
+				return true;
+	}
+#else
+	(void)signal;
+#endif
+
+	return false;
+}
+
+void MemoryBudget::free_regenerable_data(uint64_t amount)
+{
+	const vector< shared_ptr<SignalBase> > signals = session_.signalbases();
+	uint64_t freed = 0;
+
+#ifdef ENABLE_DECODE
+	// Decoders only need their input again when decoding restarts, which
+	// recreates it anyway
+	for (const shared_ptr<SignalBase>& signal : signals) {
+		if (freed >= amount)
+			return;
+
+		if (!signal->is_decode_signal())
+			continue;
+
+		const shared_ptr<DecodeSignal> decode_signal =
+			dynamic_pointer_cast<DecodeSignal>(signal);
+		const uint64_t size = decode_signal->get_mux_data_memory_usage();
+		if ((size > 0) && decode_signal->discard_mux_data())
+			freed += size;
+	}
+#endif
+
+	// The mip-maps and bit planes speed up painting as well as searches,
+	// the edge index and the stats, but they can be rebuilt from the
+	// samples. They're discarded only for data whose signals are all
+	// hidden, and the rebuild runs in the background when a search or
+	// repaint needs them again, which scans the samples until it's done.
+	map<shared_ptr<Logic>, bool> logic_data_shown;
+	for (const shared_ptr<SignalBase>& signal : signals) {
+		if (signal->type() != SignalBase::LogicChannel)
+			continue;
+
+		const shared_ptr<Logic> logic = signal->logic_data();
+		if (logic)
+			logic_data_shown[logic] = logic_data_shown[logic] || signal->enabled();
+	}
+
+	for (auto& entry : logic_data_shown) {
+		if (freed >= amount)
+			return;
+
+		if (entry.second)
+			continue;
+
+		const uint64_t size = entry.first->get_mipmap_memory_usage();
+		entry.first->discard_mipmaps();
+		freed += size - entry.first->get_mipmap_memory_usage();
+	}
+
+	// Hidden analog signals convert their samples again once they're shown,
+	// unless a decoder depends on the converted data
+	for (const shared_ptr<SignalBase>& signal : signals) {
+		if (freed >= amount)
+			return;
+
+		if ((signal->type() != SignalBase::AnalogChannel) || signal->enabled() ||
+			is_decoder_input(signal))
+			continue;
+
+		const shared_ptr<Logic> converted = signal->logic_data();
+		if (!converted)
+			continue;
+
+		const uint64_t size = converted->get_memory_usage() +
+			converted->get_mipmap_memory_usage();
+		signal->discard_converted_data();
+		freed += size;
+	}
+}
+
+void MemoryBudget::on_update_timer()
+{
+	update();
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,123 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_MEMORYBUDGET_HPP
+#define PULSEVIEW_PV_DATA_MEMORYBUDGET_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <pv/globalsettings.hpp>
+
+using std::shared_ptr;
+using std::vector;
+
+namespace pv {
+
+class Session;
+
+namespace data {
+
+class SignalBase;
+
+/**
+ * Keeps track of the memory used by the signals of a session.
+ *
+ * The usage is determined periodically for every signal, broken down by
+ * the kind of data. If it exceeds the configured budget, data that can be
+ * regenerated from the samples is freed: the muxed input of decoders that
+ * have finished, the mip-maps of logic data that isn't shown and the
+ * converted logic data of hidden analog signals. The sample data itself
+ * and the annotations are never touched.
+ */
+class MemoryBudget : public QObject, public GlobalSettingsInterface
+{
+	Q_OBJECT
+
+public:
+	/// Interval in which the memory usage is updated, in ms
+	static const int UpdateInterval;
+
+	/// Memory used by a signal, all sizes are in bytes
+	struct SignalUsage
+	{
+		QString name;
+		uint64_t sample_data;
+		uint64_t mipmaps;  ///< Mip-maps and envelopes
+		uint64_t converted_data;
+		uint64_t decoder_data;  ///< Muxed input data of decoders
+		uint64_t annotations;
+
+		uint64_t total() const;
+	};
+
+public:
+	MemoryBudget(Session &session);
+	~MemoryBudget();
+
+	/// Sets the budget in bytes, 0 means there is no limit
+	void set_budget(uint64_t size);
+	uint64_t budget() const;
+
+	uint64_t total_usage() const;
+	const vector<SignalUsage>& signal_usage() const;
+
+	/**
+	 * Determines the memory usage of all signals and frees regenerable
+	 * data if the budget is exceeded.
+	 */
+	void update();
+
+	void on_setting_changed(const QString &key, const QVariant &value);
+
+Q_SIGNALS:
+	void usage_changed();
+
+private:
+	void update_usage();
+
+	bool is_decoder_input(const shared_ptr<SignalBase> signal) const;
+
+	/// Frees regenerable data until at least @c amount bytes were freed
+	void free_regenerable_data(uint64_t amount);
+
+private Q_SLOTS:
+	void on_update_timer();
+
+private:
+	Session &session_;
+
+	uint64_t budget_;
+	uint64_t total_usage_;
+	/// Set while the budget is exceeded, so that this is only logged once
+	bool budget_exceeded_;
+	vector<SignalUsage> signal_usage_;
+
+	QTimer update_timer_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_MEMORYBUDGET_HPP
@@ -0,0 +1,175 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "logicsegment.hpp"
+#include "patternsearch.hpp"
+
+using std::max;
+using std::min;
+
+namespace pv {
+namespace data {
+
+PatternSearch::PatternSearch(shared_ptr<LogicSegment> segment) :
+	LogicSearch(segment),
+	level_mask_(0),
+	level_value_(0),
+	edge_mask_(0),
+	rising_mask_(0),
+	falling_mask_(0),
+	min_duration_(0)
+{
+}
+
+void PatternSearch::set_condition(int sig_index, Condition condition)
+{
+	assert(sig_index >= 0);
+	assert(sig_index < 64);
+
+	const uint64_t bit = 1ULL << sig_index;
+
+	level_mask_ &= ~bit;
+	level_value_ &= ~bit;
+	edge_mask_ &= ~bit;
+	rising_mask_ &= ~bit;
+	falling_mask_ &= ~bit;
+
+	switch (condition) {
+	case Low:
+		level_mask_ |= bit;
+		break;
+	case High:
+		level_mask_ |= bit;
+		level_value_ |= bit;
+		break;
+	case Rising:
+		edge_mask_ |= bit;
+		rising_mask_ |= bit;
+		break;
+	case Falling:
+		edge_mask_ |= bit;
+		falling_mask_ |= bit;
+		break;
+	case AnyEdge:
+		edge_mask_ |= bit;
+		break;
+	default:
+		break;
+	}
+}
+
+void PatternSearch::set_min_duration(uint64_t samples)
+{
+	min_duration_ = samples;
+}
+
+bool PatternSearch::is_empty() const
+{
+	return !level_mask_ && !edge_mask_;
+}
+
+uint64_t PatternSearch::get_match_length(uint64_t match)
+{
+	(void)match;
+
+	return max<uint64_t>(min_duration_, 1);
+}
+
+bool PatternSearch::next_match(uint64_t &index, uint64_t end, uint64_t &match)
+{
+	const uint64_t first_sample = segment_->get_first_sample();
+	const uint64_t sample_count = segment_->get_sample_count();
+
+	// A match can only start where one of the channels with an edge changes,
+	// or without any edges, where one of the channels with a level does
+	const uint64_t change_mask = edge_mask_ ? edge_mask_ : level_mask_;
+
+	end = min(end, sample_count);
+	index = max(index, first_sample);
+
+	while (index < end) {
+		uint64_t candidate = index;
+
+		// A run of matching levels may also begin at the first sample
+		if (edge_mask_ || (index > first_sample))
+			if (!segment_->find_next_state_change(change_mask, index, end,
+				candidate)) {
+				index = end;
+				return false;
+			}
+
+		const uint64_t sample = get_sample(candidate);
+		const uint64_t prev = (candidate > first_sample) ?
+			get_sample(candidate - 1) : sample;
+		index = candidate + 1;
+
+		if (!matches(prev, sample))
+			continue;
+
+		if (min_duration_ > 1) {
+			// Later candidates can't hold long enough either
+			if (candidate + min_duration_ > sample_count) {
+				index = end;
+				return false;
+			}
+
+			// Nor can those before the levels change
+			uint64_t change;
+			if (level_mask_ && segment_->find_next_state_change(level_mask_,
+				candidate + 1, candidate + min_duration_, change)) {
+				index = change;
+				continue;
+			}
+		}
+
+		match = candidate;
+		return true;
+	}
+
+	return false;
+}
+
+bool PatternSearch::matches(uint64_t prev, uint64_t sample) const
+{
+	if (((prev ^ sample) & edge_mask_) != edge_mask_)
+		return false;
+
+	if (((sample & rising_mask_) != rising_mask_) || (sample & falling_mask_))
+		return false;
+
+	return (sample & level_mask_) == level_value_;
+}
+
+uint64_t PatternSearch::get_sample(uint64_t index) const
+{
+	uint8_t data[8];
+	segment_->get_samples(index, index + 1, data);
+
+	uint64_t sample = 0;
+	for (unsigned int i = 0; i < segment_->unit_size(); i++)
+		sample |= (uint64_t)data[i] << (8 * i);
+
+	return sample;
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,89 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_PATTERNSEARCH_HPP
+#define PULSEVIEW_PV_DATA_PATTERNSEARCH_HPP
+
+#include <cstdint>
+#include <memory>
+
+#include "logicsearch.hpp"
+
+using std::shared_ptr;
+
+namespace pv {
+namespace data {
+
+/**
+ * Searches a logic segment for the samples at which a condition on several
+ * channels is met, e.g. "CS low, CLK rising and D3 high".
+ *
+ * Every channel can be required to be at a level or to have an edge. A
+ * sample matches if all required edges happen at it and all channels with
+ * a required level have it. Without any edges, a match is the beginning of
+ * a run of samples with the required levels. Optionally, the levels must
+ * hold for a minimum number of samples.
+ *
+ * Matches can only start where one of the channels involved changes, so
+ * the search uses LogicSegment::find_next_state_change() to skip the parts
+ * of the segment in which none of them do.
+ */
+class PatternSearch : public LogicSearch
+{
+public:
+	enum Condition {
+		DontCare,
+		Low,
+		High,
+		Rising,
+		Falling,
+		AnyEdge
+	};
+
+public:
+	PatternSearch(shared_ptr<LogicSegment> segment);
+
+	void set_condition(int sig_index, Condition condition);
+
+	/// Requires the levels to hold for at least @c samples samples
+	void set_min_duration(uint64_t samples);
+
+	/// Returns true if no channel has a condition
+	bool is_empty() const override;
+
+	/// Returns the minimum duration, matches are at least one sample long
+	uint64_t get_match_length(uint64_t match) override;
+
+private:
+	bool next_match(uint64_t &index, uint64_t end, uint64_t &match) override;
+
+	bool matches(uint64_t prev, uint64_t sample) const;
+
+	uint64_t get_sample(uint64_t index) const;
+
+private:
+	uint64_t level_mask_, level_value_;
+	uint64_t edge_mask_, rising_mask_, falling_mask_;
+	uint64_t min_duration_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_PATTERNSEARCH_HPP
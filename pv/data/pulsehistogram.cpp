@@ -0,0 +1,278 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include "logicsegment.hpp"
+#include "pulsehistogram.hpp"
+
+using std::max;
+using std::min;
+using std::numeric_limits;
+using std::thread;
+
+namespace pv {
+namespace data {
+
+const uint64_t PulseHistogram::Histogram::DenseLength = 4096;
+
+const uint64_t PulseHistogram::MinPartLength = 4 * 1024 * 1024;
+const uint64_t PulseHistogram::EdgeWindowLength = 1024 * 1024;
+
+PulseHistogram::Histogram::Histogram() :
+	count_(0),
+	min_width_(numeric_limits<uint64_t>::max()),
+	max_width_(0)
+{
+}
+
+template<typename F>
+void PulseHistogram::Histogram::for_each(F f) const
+{
+	if (!dense_counts_.empty())
+		for (uint64_t w = min_width_; w < min(max_width_ + 1, DenseLength); w++)
+			if (dense_counts_[w])
+				f(w, dense_counts_[w]);
+
+	for (const auto &entry : sparse_counts_)
+		f(entry.first, entry.second);
+}
+
+void PulseHistogram::Histogram::add(uint64_t width)
+{
+	if (width < DenseLength) {
+		if (dense_counts_.empty())
+			dense_counts_.resize(DenseLength, 0);
+		dense_counts_[width]++;
+	} else
+		sparse_counts_[width]++;
+
+	count_++;
+	min_width_ = min(min_width_, width);
+	max_width_ = max(max_width_, width);
+}
+
+void PulseHistogram::Histogram::merge(const Histogram &other)
+{
+	if (!other.dense_counts_.empty()) {
+		if (dense_counts_.empty())
+			dense_counts_.resize(DenseLength, 0);
+		for (uint64_t w = 0; w < DenseLength; w++)
+			dense_counts_[w] += other.dense_counts_[w];
+	}
+
+	for (const auto &entry : other.sparse_counts_)
+		sparse_counts_[entry.first] += entry.second;
+
+	count_ += other.count_;
+	min_width_ = min(min_width_, other.min_width_);
+	max_width_ = max(max_width_, other.max_width_);
+}
+
+void PulseHistogram::Histogram::clear()
+{
+	dense_counts_.clear();
+	sparse_counts_.clear();
+	count_ = 0;
+	min_width_ = numeric_limits<uint64_t>::max();
+	max_width_ = 0;
+}
+
+uint64_t PulseHistogram::Histogram::count() const
+{
+	return count_;
+}
+
+uint64_t PulseHistogram::Histogram::min_width() const
+{
+	return (count_ > 0) ? min_width_ : 0;
+}
+
+uint64_t PulseHistogram::Histogram::max_width() const
+{
+	return max_width_;
+}
+
+double PulseHistogram::Histogram::mean() const
+{
+	if (count_ == 0)
+		return 0;
+
+	double sum = 0;
+	for_each([&](uint64_t width, uint64_t count) { sum += (double)width * count; });
+
+	return sum / count_;
+}
+
+double PulseHistogram::Histogram::std_dev() const
+{
+	if (count_ < 2)
+		return 0;
+
+	// The deviations are summed up from the counts, which is more precise
+	// than keeping a sum of squares
+	const double m = mean();
+	double sum = 0;
+	for_each([&](uint64_t width, uint64_t count) {
+		sum += (width - m) * (width - m) * count; });
+
+	return sqrt(sum / (count_ - 1));
+}
+
+vector<uint64_t> PulseHistogram::Histogram::get_bins(uint64_t first,
+	uint64_t last, unsigned int bin_count) const
+{
+	vector<uint64_t> bins(bin_count, 0);
+	if ((bin_count == 0) || (last < first))
+		return bins;
+
+	const double bin_width = (double)(last - first + 1) / bin_count;
+
+	for_each([&](uint64_t width, uint64_t count) {
+		if ((width < first) || (width > last))
+			return;
+		const unsigned int bin = (unsigned int)((width - first) / bin_width);
+		bins[min(bin, bin_count - 1)] += count; });
+
+	return bins;
+}
+
+PulseHistogram::PulseHistogram(shared_ptr<LogicSegment> segment, int sig_index) :
+	segment_(segment),
+	sig_index_(sig_index),
+	canceled_(false)
+{
+	assert(segment_);
+	assert(sig_index >= 0);
+	assert(sig_index < 64);
+}
+
+bool PulseHistogram::compute(uint64_t start, uint64_t end,
+	unsigned int thread_count)
+{
+	for (Histogram &h : histograms_)
+		h.clear();
+
+	start = max(start, segment_->get_first_sample());
+	end = min(end, segment_->get_sample_count());
+	if (start >= end)
+		return !canceled_;
+
+	if (thread_count == 0)
+		thread_count = max(thread::hardware_concurrency(), 1U);
+
+	const uint64_t part_count = max<uint64_t>(1,
+		min<uint64_t>(thread_count, (end - start) / MinPartLength));
+	const uint64_t part_length = (end - start) / part_count;
+
+	vector< vector<Histogram> > part_histograms(part_count,
+		vector<Histogram>(MeasurementCount));
+	vector<thread> threads;
+
+	for (uint64_t i = 0; i < part_count; i++) {
+		const uint64_t part_start = start + i * part_length;
+		const uint64_t part_end = (i + 1 < part_count) ?
+			part_start + part_length : end;
+
+		threads.emplace_back(&PulseHistogram::process_part, this,
+			part_start, part_end, end, part_histograms[i].data());
+	}
+
+	for (thread &t : threads)
+		t.join();
+
+	for (const vector<Histogram> &histograms : part_histograms)
+		for (int m = 0; m < MeasurementCount; m++)
+			histograms_[m].merge(histograms[m]);
+
+	return !canceled_;
+}
+
+const PulseHistogram::Histogram& PulseHistogram::histogram(
+	Measurement measurement) const
+{
+	assert(measurement < MeasurementCount);
+	return histograms_[measurement];
+}
+
+void PulseHistogram::cancel()
+{
+	canceled_ = true;
+}
+
+void PulseHistogram::process_part(uint64_t start, uint64_t end,
+	uint64_t range_end, Histogram *histograms)
+{
+	// Past the end of the part, only the edges that end the pending pulses
+	// are needed, so the windows start out small there
+	const uint64_t tail_window_length = 4096;
+
+	vector<uint64_t> edges;
+	uint64_t last_edge = 0, last_rising = 0;
+	bool have_edge = false, have_rising = false;
+	uint64_t index = start;
+	uint64_t tail_window = tail_window_length;
+
+	while ((index < range_end) && !canceled_) {
+		uint64_t window_end;
+		if (index < end)
+			window_end = min(end, index + EdgeWindowLength);
+		else {
+			window_end = min(range_end, index + tail_window);
+			tail_window = min(tail_window * 4, EdgeWindowLength);
+		}
+
+		edges.clear();
+		bool state = segment_->get_edges(sig_index_, index, window_end, edges);
+
+		for (uint64_t edge : edges) {
+			// The state following the edge
+			state = !state;
+
+			if (have_edge && (last_edge < end)) {
+				const uint64_t width = edge - last_edge;
+				histograms[EdgeInterval].add(width);
+				histograms[state ? LowTime : HighTime].add(width);
+			}
+
+			if (state) {
+				if (have_rising && (last_rising < end))
+					histograms[Period].add(edge - last_rising);
+				last_rising = edge;
+				have_rising = true;
+			}
+
+			last_edge = edge;
+			have_edge = true;
+
+			// Beyond the part, a rising edge ends all pending pulses
+			if ((edge >= end) && (state || !have_rising))
+				return;
+		}
+
+		index = window_end;
+	}
+}
+
+} // namespace data
+} // namespace pv
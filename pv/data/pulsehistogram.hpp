@@ -0,0 +1,144 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_PULSEHISTOGRAM_HPP
+#define PULSEVIEW_PV_DATA_PULSEHISTOGRAM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+using std::atomic;
+using std::map;
+using std::shared_ptr;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+class LogicSegment;
+
+/**
+ * Measures the high times, low times, periods and edge-to-edge intervals
+ * of a logic channel, e.g. to characterize the jitter of a clock or the
+ * duty cycles of a PWM signal.
+ *
+ * The range is split into parts that are processed by one thread each.
+ * Every thread measures the pulses beginning in its part, following the
+ * channel beyond the part as far as needed to find where they end, and
+ * the histograms of the threads are merged at the end. The edges are
+ * taken from LogicSegment::get_edges(), which skips the blocks of the
+ * mip-map in which the channel doesn't change.
+ */
+class PulseHistogram
+{
+public:
+	enum Measurement {
+		HighTime,
+		LowTime,
+		Period,
+		EdgeInterval,
+		MeasurementCount
+	};
+
+	/**
+	 * Counts how often every width, in samples, occurs. Short widths are
+	 * counted in an array, longer ones in a map, so that a few outliers
+	 * don't take much memory.
+	 */
+	class Histogram
+	{
+	public:
+		/// Widths below this are counted in the array
+		static const uint64_t DenseLength;
+
+	public:
+		Histogram();
+
+		void add(uint64_t width);
+		void merge(const Histogram &other);
+		void clear();
+
+		uint64_t count() const;
+		uint64_t min_width() const;
+		uint64_t max_width() const;
+		double mean() const;
+		double std_dev() const;
+
+		/**
+		 * Returns the number of widths in each of @c bin_count bins of
+		 * equal size that cover [first, last] together.
+		 */
+		vector<uint64_t> get_bins(uint64_t first, uint64_t last,
+			unsigned int bin_count) const;
+
+	private:
+		/// Calls @c f with every width that occurs and its count
+		template<typename F> void for_each(F f) const;
+
+	private:
+		vector<uint64_t> dense_counts_;
+		map<uint64_t, uint64_t> sparse_counts_;
+		uint64_t count_, min_width_, max_width_;
+	};
+
+	/// Ranges are only split into parts that are at least this long
+	static const uint64_t MinPartLength;
+	/// Number of samples whose edges are fetched at once
+	static const uint64_t EdgeWindowLength;
+
+public:
+	PulseHistogram(shared_ptr<LogicSegment> segment, int sig_index);
+
+	/**
+	 * Measures the pulses that lie completely in [start, end).
+	 * @param thread_count The maximum number of threads to use, or 0 to
+	 * use as many as the CPU can run at once.
+	 * @return false if the computation was canceled.
+	 */
+	bool compute(uint64_t start, uint64_t end, unsigned int thread_count = 0);
+
+	const Histogram& histogram(Measurement measurement) const;
+
+	/// Stops a computation running in another thread
+	void cancel();
+
+private:
+	/**
+	 * Measures the pulses beginning in [start, end) that end before
+	 * @c range_end.
+	 */
+	void process_part(uint64_t start, uint64_t end, uint64_t range_end,
+		Histogram *histograms);
+
+private:
+	shared_ptr<LogicSegment> segment_;
+	const int sig_index_;
+
+	Histogram histograms_[MeasurementCount];
+
+	atomic<bool> canceled_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_PULSEHISTOGRAM_HPP
@@ -0,0 +1,205 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "logicsegment.hpp"
+#include "pulsesearch.hpp"
+
+using std::lower_bound;
+using std::max;
+using std::min;
+using std::numeric_limits;
+
+namespace pv {
+namespace data {
+
+const uint64_t PulseSearch::EdgeWindowLength = 1024 * 1024;
+
+PulseSearch::PulseSearch(shared_ptr<LogicSegment> segment, int sig_index) :
+	LogicSearch(segment),
+	sig_index_(sig_index),
+	polarity_(AllPulses),
+	min_width_(1),
+	max_width_(numeric_limits<uint64_t>::max()),
+	narrowest_match_(numeric_limits<uint64_t>::max()),
+	widest_match_(0),
+	edges_start_(0),
+	edges_end_(0),
+	edges_pos_(0),
+	edges_state_(false)
+{
+	assert(sig_index >= 0);
+	assert(sig_index < 64);
+}
+
+void PulseSearch::set_polarity(Polarity polarity)
+{
+	polarity_ = polarity;
+}
+
+void PulseSearch::set_width_range(uint64_t min_width, uint64_t max_width)
+{
+	// Pulses are at least one sample wide
+	min_width_ = max<uint64_t>(min_width, 1);
+	max_width_ = max_width;
+}
+
+bool PulseSearch::is_empty() const
+{
+	return min_width_ > max_width_;
+}
+
+uint64_t PulseSearch::get_match_length(uint64_t match)
+{
+	uint64_t pulse_end;
+	bool state;
+
+	if (!next_edge(match + 1, pulse_end, state))
+		return 1;
+
+	return pulse_end - match;
+}
+
+uint64_t PulseSearch::narrowest_match() const
+{
+	return (widest_match_ > 0) ? narrowest_match_ : 0;
+}
+
+uint64_t PulseSearch::widest_match() const
+{
+	return widest_match_;
+}
+
+bool PulseSearch::next_match(uint64_t &index, uint64_t end, uint64_t &match)
+{
+	uint64_t edge, pulse_end;
+	bool state, next_state;
+
+	while ((index < end) && !canceled_) {
+		if (!next_edge(index, edge, state))
+			break;
+
+		// Pulses that end within the window of edges are checked right away
+		size_t pos = edges_pos_;
+		for (; (pos + 1 < edges_.size()) && (edges_[pos] < end); pos++)
+			if (check_pulse(edges_[pos + 1] - edges_[pos], get_state(pos))) {
+				edges_pos_ = pos + 1;
+				index = edges_[pos + 1];
+				match = edges_[pos];
+				return true;
+			}
+
+		edges_pos_ = pos;
+		edge = edges_[pos];
+		state = get_state(pos);
+		if (edge >= end) {
+			index = edge;
+			return false;
+		}
+
+		// The last pulse may not have ended within the capture
+		if (!next_edge(edge + 1, pulse_end, next_state))
+			break;
+
+		index = pulse_end;
+		if (check_pulse(pulse_end - edge, state)) {
+			match = edge;
+			return true;
+		}
+	}
+
+	index = max(index, end);
+	return false;
+}
+
+bool PulseSearch::check_pulse(uint64_t width, bool state)
+{
+	if ((polarity_ == HighPulses && !state) || (polarity_ == LowPulses && state))
+		return false;
+
+	if ((width < min_width_) || (width > max_width_))
+		return false;
+
+	narrowest_match_ = min(narrowest_match_, width);
+	widest_match_ = max(widest_match_, width);
+
+	return true;
+}
+
+bool PulseSearch::next_edge(uint64_t sample, uint64_t &edge, bool &state)
+{
+	if ((sample >= edges_start_) && (sample < edges_end_)) {
+		// The search mostly moves from one edge to the next, so those at
+		// and after the last one found are tried first
+		const size_t count = edges_.size();
+		const auto is_next = [&](size_t pos) {
+			return (pos < count) && (edges_[pos] >= sample) &&
+				((pos == 0) || (edges_[pos - 1] < sample)); };
+
+		if (is_next(edges_pos_ + 1))
+			edges_pos_++;
+		else if (!is_next(edges_pos_))
+			edges_pos_ = lower_bound(edges_.begin(), edges_.end(), sample) -
+				edges_.begin();
+
+		if (edges_pos_ < count) {
+			edge = edges_[edges_pos_];
+			state = get_state(edges_pos_);
+			return true;
+		}
+
+		sample = edges_end_;
+	}
+
+	const uint64_t sample_count = segment_->get_sample_count();
+
+	// An edge at the first sample would refer to the one before it
+	sample = max(sample, segment_->get_first_sample() + 1);
+
+	while ((sample < sample_count) && !canceled_) {
+		edges_.clear();
+		edges_start_ = sample;
+		edges_end_ = min(sample_count, sample + EdgeWindowLength);
+		edges_state_ = segment_->get_edges(sig_index_, edges_start_,
+			edges_end_, edges_);
+		edges_pos_ = 0;
+
+		if (!edges_.empty()) {
+			edge = edges_.front();
+			state = get_state(0);
+			return true;
+		}
+
+		sample = edges_end_;
+	}
+
+	return false;
+}
+
+bool PulseSearch::get_state(size_t pos) const
+{
+	// The state toggles at every edge
+	return edges_state_ != ((pos & 1) == 0);
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,114 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_PULSESEARCH_HPP
+#define PULSEVIEW_PV_DATA_PULSESEARCH_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "logicsearch.hpp"
+
+using std::shared_ptr;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+/**
+ * Searches a logic channel for high or low pulses whose width lies in a
+ * range, e.g. glitches shorter than a few samples or gaps longer than a
+ * timeout. A pulse lasts from one edge of the channel to the next, so the
+ * pulses that the capture cuts off at either end are never reported.
+ *
+ * The edges are taken from LogicSegment::get_edges(), which skips quiet
+ * parts of the channel using the mip-map and reads the bit planes where the
+ * segment has them. They're fetched in windows and kept until the search
+ * leaves the window.
+ */
+class PulseSearch : public LogicSearch
+{
+public:
+	enum Polarity {
+		HighPulses,
+		LowPulses,
+		AllPulses
+	};
+
+	/// Number of samples whose edges are fetched at once
+	static const uint64_t EdgeWindowLength;
+
+public:
+	PulseSearch(shared_ptr<LogicSegment> segment, int sig_index);
+
+	void set_polarity(Polarity polarity);
+
+	/// Only matches pulses that are [min_width, max_width] samples wide
+	void set_width_range(uint64_t min_width, uint64_t max_width);
+
+	/// Returns true if the width range is empty
+	bool is_empty() const override;
+
+	/// Returns the width of the pulse beginning at @c match
+	uint64_t get_match_length(uint64_t match) override;
+
+	/// Returns the width of the narrowest pulse that was matched so far
+	uint64_t narrowest_match() const;
+	/// Returns the width of the widest pulse that was matched so far
+	uint64_t widest_match() const;
+
+private:
+	bool next_match(uint64_t &index, uint64_t end, uint64_t &match) override;
+
+	/**
+	 * Returns true if a pulse with the width and the state matches, and
+	 * accounts for it in the widths of the matches.
+	 */
+	bool check_pulse(uint64_t width, bool state);
+
+	/**
+	 * Finds the first edge at or after @c sample and the state of the
+	 * channel following it.
+	 */
+	bool next_edge(uint64_t sample, uint64_t &edge, bool &state);
+
+	/// Returns the state of the channel after the edge at @c pos in edges_
+	bool get_state(size_t pos) const;
+
+private:
+	const int sig_index_;
+
+	Polarity polarity_;
+	uint64_t min_width_, max_width_;
+
+	uint64_t narrowest_match_, widest_match_;
+
+	/// The edges in [edges_start_, edges_end_) and the state before them
+	vector<uint64_t> edges_;
+	uint64_t edges_start_, edges_end_;
+	/// The position of the edge that was found last
+	size_t edges_pos_;
+	bool edges_state_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_PULSESEARCH_HPP
@@ -18,7 +18,9 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "chunkpool.hpp"
 #include "segment.hpp"
+#include "spillfile.hpp"
 
 #include <cassert>
 #include <cstdlib>
@@ -27,24 +29,67 @@
 #include <QDebug>
 
 using std::bad_alloc;
+using std::current_exception;
 using std::lock_guard;
+using std::max;
 using std::min;
+using std::move;
 using std::recursive_mutex;
+using std::rethrow_exception;
+using std::shared_ptr;
+using std::unique_lock;
+using std::unique_ptr;
 
 namespace pv {
 namespace data {
 
+template <class T>
+static uint64_t find_run_end(const uint8_t *data, uint64_t start, uint64_t count)
+{
+	const T* samples = (const T*)data;
+	const T value = samples[start];
+
+	uint64_t i = start + 1;
+	while ((i < count) && (samples[i] == value))
+		i++;
+
+	return i;
+}
+
+static uint64_t find_run_end_generic(const uint8_t *data, uint64_t start,
+	uint64_t count, unsigned int unit_size)
+{
+	const uint8_t* value = data + start * unit_size;
+
+	uint64_t i = start + 1;
+	while ((i < count) && (memcmp(data + i * unit_size, value, unit_size) == 0))
+		i++;
+
+	return i;
+}
+
 const uint64_t Segment::MaxChunkSize = 10 * 1024 * 1024;  /* 10MiB */
+const uint64_t Segment::MaxBuildBacklog = 32 * 1024 * 1024;  /* 32MiB */
 
 Segment::Segment(uint32_t segment_id, uint64_t samplerate, unsigned int unit_size) :
 	segment_id_(segment_id),
+	chunk_count_(0),
+	sample_limit_(0),
+	first_chunk_(0),
+	compress_chunks_(false),
+	next_chunk_to_compress_(0),
+	compressed_chunk_count_(0),
+	chunk_memory_usage_(0),
 	sample_count_(0),
+	pin_count_(0),
+	have_retired_memory_(false),
 	start_time_(0),
 	samplerate_(samplerate),
 	unit_size_(unit_size),
-	iterator_count_(0),
-	mem_optimization_requested_(false),
-	is_complete_(false)
+	is_complete_(false),
+	use_background_builder_(false),
+	builder_stopped_(false),
+	built_sample_count_(0)
 {
 	assert(unit_size_ > 0);
 
@@ -52,19 +97,66 @@ Segment::Segment(uint32_t segment_id, uint64_t samplerate, unsigned int unit_siz
 	// without exceeding MaxChunkSize
 	chunk_size_ = min(MaxChunkSize, (MaxChunkSize / unit_size_) * unit_size_);
 
-	// Create the initial chunk
-	current_chunk_ = new uint8_t[chunk_size_ + 7];  /* FIXME +7 is workaround for #1284 */
-	data_chunks_.push_back(current_chunk_);
+	for (ChunkEntry*& block : chunk_directory_)
+		block = nullptr;
+
+	// The initial chunk is created when the first samples arrive so that
+	// the storage backend can still be chosen after construction
+	current_chunk_ = nullptr;
+	resized_chunk_ = nullptr;
 	used_samples_ = 0;
-	unused_samples_ = chunk_size_ / unit_size_;
+	unused_samples_ = 0;
 }
 
 Segment::~Segment()
 {
+	// Subclasses that build derived data stop the builder themselves
+	stop_builder();
+
 	lock_guard<recursive_mutex> lock(mutex_);
 
-	for (uint8_t* chunk : data_chunks_)
-		delete[] chunk;
+	for (uint64_t i = first_chunk_; i < chunk_count_; i++) {
+		ChunkEntry &entry = get_chunk_entry(i);
+
+		if (entry.data)
+			free_chunk(entry.data);
+
+		CompressedChunk *compressed = entry.compressed;
+		if (compressed) {
+			free(compressed->data);
+			delete compressed;
+		}
+	}
+
+	for (ChunkEntry* block : chunk_directory_)
+		delete[] block;
+
+	for (pair<uint64_t, uint8_t*>& cached : chunk_cache_)
+		free(cached.second);
+
+	for (uint8_t* chunk : retired_chunks_)
+		free_chunk(chunk);
+
+	for (void* buffer : retired_buffers_)
+		free(buffer);
+
+	for (CompressedChunk* compressed : retired_compressed_chunks_) {
+		free(compressed->data);
+		delete compressed;
+	}
+}
+
+const uint8_t* Segment::get_zero_chunk()
+{
+	// Shared by all segments, calloc() lets the OS provide the zeroed pages
+	// on demand
+	static const uint8_t* const zero_chunk =
+		(const uint8_t*)calloc(1, MaxChunkSize + 7);  /* FIXME +7 is workaround for #1284 */
+
+	if (!zero_chunk)
+		throw bad_alloc();
+
+	return zero_chunk;
 }
 
 uint64_t Segment::get_sample_count() const
@@ -72,6 +164,23 @@ uint64_t Segment::get_sample_count() const
 	return sample_count_;
 }
 
+void Segment::set_sample_limit(uint64_t count)
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	sample_limit_ = count;
+}
+
+uint64_t Segment::sample_limit() const
+{
+	return sample_limit_;
+}
+
+uint64_t Segment::get_first_sample() const
+{
+	return first_chunk_.load(std::memory_order_acquire) * (chunk_size_ / unit_size_);
+}
+
 const pv::util::Timestamp& Segment::start_time() const
 {
 	return start_time_;
@@ -99,6 +208,9 @@ uint32_t Segment::segment_id() const
 
 void Segment::set_complete()
 {
+	// A complete segment has all of its derived data, too
+	stop_builder();
+
 	is_complete_ = true;
 
 	completed();
@@ -109,48 +221,572 @@ bool Segment::is_complete() const
 	return is_complete_;
 }
 
+bool Segment::use_disk_storage(const QString &directory)
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	assert(chunk_count_ == 0);
+
+	unique_ptr<SpillFile> file(new SpillFile(directory));
+	if (!file->is_open())
+		return false;
+
+	spill_file_ = move(file);
+
+	return true;
+}
+
+bool Segment::uses_disk_storage() const
+{
+	return (spill_file_ != nullptr);
+}
+
+void Segment::use_chunk_pool(shared_ptr<ChunkPool> pool)
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	assert(chunk_count_ == 0);
+
+	chunk_pool_ = pool;
+}
+
+void Segment::use_background_builder()
+{
+	lock_guard<mutex> lock(builder_mutex_);
+
+	assert(sample_count_ == 0);
+
+	use_background_builder_ = true;
+}
+
+bool Segment::uses_background_builder() const
+{
+	return use_background_builder_;
+}
+
+uint64_t Segment::get_built_sample_count() const
+{
+	return built_sample_count_;
+}
+
+uint64_t Segment::get_compressed_chunk_count() const
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	return compressed_chunk_count_;
+}
+
+uint64_t Segment::get_memory_usage() const
+{
+	uint64_t size = chunk_memory_usage_;
+
+	lock_guard<mutex> cache_lock(chunk_cache_mutex_);
+	size += chunk_cache_.size() * (chunk_size_ + 7);
+
+	return size;
+}
+
 void Segment::free_unused_memory()
 {
 	lock_guard<recursive_mutex> lock(mutex_);
 
-	// Do not mess with the data chunks if we have iterators pointing at them
-	if (iterator_count_ > 0) {
-		mem_optimization_requested_ = true;
+	free_retired_memory();
+
+	// Mapped chunks only occupy RAM for the pages that were written to
+	if (spill_file_)
+		return;
+
+	// No more data will come in, so the last chunk may be compressed now
+	if (current_chunk_ && compress_chunks_ &&
+		compress_chunk(chunk_count_ - 1, used_samples_))
 		return;
-	}
 
-	if (current_chunk_) {
+	if (current_chunk_ && (unused_samples_ > 0)) {
 		// No more data will come in, so re-create the last chunk accordingly
+		// This chunk doesn't have the regular size, so it's never pooled
 		uint8_t* resized_chunk = new uint8_t[used_samples_ * unit_size_ + 7];  /* FIXME +7 is workaround for #1284 */
 		memcpy(resized_chunk, current_chunk_, used_samples_ * unit_size_);
 
-		delete[] current_chunk_;
+		// Readers may still be accessing the old chunk, so only
+		// publish the new one and retire the old one
+		const uint64_t chunk_num = chunk_count_ - 1;
+		get_chunk_entry(chunk_num).data.store(resized_chunk);
+
+		chunk_memory_usage_ -= get_chunk_memory_usage(current_chunk_);
+		retired_chunks_.push_back(current_chunk_);
+		have_retired_memory_ = true;
 		current_chunk_ = resized_chunk;
+		resized_chunk_ = resized_chunk;
+		chunk_memory_usage_ += get_chunk_memory_usage(resized_chunk);
 
-		data_chunks_.pop_back();
-		data_chunks_.push_back(resized_chunk);
+		free_retired_memory();
 	}
 }
 
-void Segment::append_single_sample(void *data)
+uint8_t* Segment::allocate_chunk()
+{
+	if (spill_file_)
+		return spill_file_->map_chunk(chunk_size_ + 7);  /* FIXME +7 is workaround for #1284 */
+
+	// If we're out of memory, this throws std::bad_alloc. The chunk pool
+	// keeps some headroom that it frees in this case so that PV remains
+	// alive and can stop the acquisition.
+	if (chunk_pool_)
+		return chunk_pool_->allocate(chunk_size_ + 7);  /* FIXME +7 is workaround for #1284 */
+
+	return new uint8_t[chunk_size_ + 7];  /* FIXME +7 is workaround for #1284 */
+}
+
+uint64_t Segment::get_chunk_memory_usage(const uint8_t *chunk) const
+{
+	// Mapped chunks only occupy RAM for the pages that were written to,
+	// which the kernel may write back to the file at any time
+	if (spill_file_)
+		return 0;
+
+	return (chunk == resized_chunk_) ?
+		(used_samples_ * unit_size_ + 7) : (chunk_size_ + 7);
+}
+
+void Segment::free_chunk(uint8_t *chunk)
+{
+	if (spill_file_)
+		spill_file_->unmap_chunk(chunk);
+	else if (chunk_pool_ && (chunk != resized_chunk_))
+		chunk_pool_->release(chunk, chunk_size_ + 7);
+	else
+		delete[] chunk;
+}
+
+Segment::ChunkEntry& Segment::get_chunk_entry(uint64_t chunk_num) const
+{
+	return chunk_directory_[(chunk_num / ChunkDirectoryBlockSize) % ChunkDirectorySize]
+		[chunk_num % ChunkDirectoryBlockSize];
+}
+
+uint8_t* Segment::get_chunk(uint64_t chunk_num) const
 {
+	if (chunk_num < first_chunk_.load(std::memory_order_acquire))
+		return const_cast<uint8_t*>(get_zero_chunk());
+
+	// Note: the caller must pin the memory while using the result
+	uint8_t* data = get_chunk_entry(chunk_num).data.load(std::memory_order_acquire);
+
+	return data ? data : get_decompressed_chunk(chunk_num);
+}
+
+void Segment::push_chunk(uint8_t *chunk)
+{
+	// Entries of dropped chunks are reused once the directory wraps around
+	if (chunk_count_ - first_chunk_ >= (uint64_t)ChunkDirectorySize * ChunkDirectoryBlockSize)
+		throw bad_alloc();
+
+	const uint64_t block = (chunk_count_ / ChunkDirectoryBlockSize) % ChunkDirectorySize;
+
+	if (!chunk_directory_[block]) {
+		chunk_directory_[block] = new ChunkEntry[ChunkDirectoryBlockSize];
+		for (unsigned int i = 0; i < ChunkDirectoryBlockSize; i++) {
+			chunk_directory_[block][i].data = nullptr;
+			chunk_directory_[block][i].compressed = nullptr;
+		}
+	}
+
+	// Readers only see this chunk once sample_count_ covers it, which
+	// happens after this store
+	chunk_directory_[block][chunk_count_ % ChunkDirectoryBlockSize].data.store(
+		chunk, std::memory_order_release);
+	chunk_count_++;
+
+	chunk_memory_usage_ += get_chunk_memory_usage(chunk);
+}
+
+void Segment::compress_chunks_before(uint64_t sample_num)
+{
+	if (!compress_chunks_ || spill_file_)
+		return;
+
+	const uint64_t samples_per_chunk = chunk_size_ / unit_size_;
+	uint64_t end_chunk;
+
+	{
+		lock_guard<recursive_mutex> lock(mutex_);
+
+		if (chunk_count_ == 0)
+			return;
+
+		// Dropped chunks don't need to be compressed anymore
+		next_chunk_to_compress_ = max(next_chunk_to_compress_, (uint64_t)first_chunk_);
+
+		// The chunk that is currently being filled is never compressed here
+		end_chunk = min(sample_num / samples_per_chunk, chunk_count_ - 1);
+	}
+
+	for (; next_chunk_to_compress_ < end_chunk; next_chunk_to_compress_++)
+		compress_chunk(next_chunk_to_compress_, samples_per_chunk);
+}
+
+bool Segment::compress_chunk(uint64_t chunk_num, uint64_t sample_count)
+{
+	ChunkEntry &entry = get_chunk_entry(chunk_num);
+
+	uint8_t* chunk = entry.data;
+	if (!chunk || (sample_count == 0))
+		return false;
+
+	// Give up as soon as the runs need more space than we'd like to save
+	const uint64_t run_size = sizeof(uint32_t) + unit_size_;
+	const uint64_t max_run_count =
+		(sample_count * unit_size_) / (MinCompressionRatio * run_size);
+
+	vector<uint8_t> runs;
+	runs.reserve(max_run_count * run_size);
+	uint64_t run_count = 0;
+
+	for (uint64_t start = 0; start < sample_count;) {
+		uint64_t end;
+		if (unit_size_ == 1)
+			end = find_run_end<uint8_t>(chunk, start, sample_count);
+		else if (unit_size_ == 2)
+			end = find_run_end<uint16_t>(chunk, start, sample_count);
+		else if (unit_size_ == 4)
+			end = find_run_end<uint32_t>(chunk, start, sample_count);
+		else if (unit_size_ == 8)
+			end = find_run_end<uint64_t>(chunk, start, sample_count);
+		else
+			end = find_run_end_generic(chunk, start, sample_count, unit_size_);
+
+		if (++run_count > max_run_count)
+			return false;
+
+		const uint32_t run_length = end - start;
+		const size_t pos = runs.size();
+		runs.resize(pos + run_size);
+		memcpy(runs.data() + pos, &run_length, sizeof(uint32_t));
+		memcpy(runs.data() + pos + sizeof(uint32_t), chunk + start * unit_size_,
+			unit_size_);
+
+		start = end;
+	}
+
+	CompressedChunk* compressed = new CompressedChunk;
+	compressed->run_count = run_count;
+	compressed->size = runs.size();
+	compressed->data = (uint8_t*)malloc(runs.size());
+	if (!compressed->data) {
+		delete compressed;
+		throw bad_alloc();
+	}
+	memcpy(compressed->data, runs.data(), runs.size());
+
 	lock_guard<recursive_mutex> lock(mutex_);
 
-	// There will always be space for at least one sample in
-	// the current chunk, so we do not need to test for space
+	// Publish the compressed data before the uncompressed data disappears,
+	// readers may still use the latter until they unpin the memory
+	entry.compressed.store(compressed, std::memory_order_release);
+	entry.data.store(nullptr, std::memory_order_release);
+
+	retired_chunks_.push_back(chunk);
+	have_retired_memory_ = true;
+	free_retired_memory();
+
+	chunk_memory_usage_ += sizeof(CompressedChunk) + compressed->size;
+	chunk_memory_usage_ -= get_chunk_memory_usage(chunk);
 
-	memcpy(current_chunk_ + (used_samples_ * unit_size_), data, unit_size_);
-	used_samples_++;
-	unused_samples_--;
+	if (chunk == current_chunk_)
+		current_chunk_ = nullptr;
 
-	if (unused_samples_ == 0) {
-		current_chunk_ = new uint8_t[chunk_size_ + 7];  /* FIXME +7 is workaround for #1284 */
-		data_chunks_.push_back(current_chunk_);
-		used_samples_ = 0;
-		unused_samples_ = chunk_size_ / unit_size_;
+	compressed_chunk_count_++;
+
+	return true;
+}
+
+void Segment::decompress_chunk(const CompressedChunk *compressed, uint8_t *dest,
+	uint64_t start, uint64_t count) const
+{
+	const uint8_t* run = compressed->data;
+	uint64_t index = 0;
+
+	for (uint64_t i = 0; (i < compressed->run_count) && (count > 0); i++) {
+		uint32_t run_length;
+		memcpy(&run_length, run, sizeof(uint32_t));
+		const uint8_t* sample = run + sizeof(uint32_t);
+		run += sizeof(uint32_t) + unit_size_;
+
+		// Runs before the range are only skipped
+		if (index + run_length <= start) {
+			index += run_length;
+			continue;
+		}
+
+		const uint64_t skip = (start > index) ? (start - index) : 0;
+		const uint64_t length = min(run_length - skip, count);
+
+		if (unit_size_ == 1) {
+			memset(dest, *sample, length);
+			dest += length;
+		} else
+			for (uint64_t j = 0; j < length; j++, dest += unit_size_)
+				memcpy(dest, sample, unit_size_);
+
+		index += run_length;
+		count -= length;
 	}
+}
+
+const uint8_t* Segment::find_cached_chunk(uint64_t chunk_num) const
+{
+	lock_guard<mutex> cache_lock(chunk_cache_mutex_);
+
+	for (const pair<uint64_t, uint8_t*>& cached : chunk_cache_)
+		if (cached.first == chunk_num)
+			return cached.second;
 
-	sample_count_++;
+	return nullptr;
+}
+
+uint8_t* Segment::get_decompressed_chunk(uint64_t chunk_num) const
+{
+	// Note: the caller must pin the memory while using the result, so the
+	// compressed chunk isn't freed while it's decompressed without mutex_
+	const uint8_t* cached = find_cached_chunk(chunk_num);
+	if (cached)
+		return const_cast<uint8_t*>(cached);
+
+	// The chunk may have been dropped since the caller looked it up
+	if (chunk_num < first_chunk_.load(std::memory_order_acquire))
+		return const_cast<uint8_t*>(get_zero_chunk());
+
+	const CompressedChunk* compressed =
+		get_chunk_entry(chunk_num).compressed.load(std::memory_order_acquire);
+	if (!compressed)
+		return const_cast<uint8_t*>(get_zero_chunk());
+
+	uint8_t* chunk = (uint8_t*)malloc(chunk_size_ + 7);  /* FIXME +7 is workaround for #1284 */
+	if (!chunk)
+		throw bad_alloc();
+
+	decompress_chunk(compressed, chunk, 0, chunk_size_ / unit_size_);
+
+	uint8_t* evicted = nullptr;
+	{
+		lock_guard<mutex> cache_lock(chunk_cache_mutex_);
+
+		// Another reader may have decompressed the chunk meanwhile
+		for (pair<uint64_t, uint8_t*>& cached : chunk_cache_)
+			if (cached.first == chunk_num) {
+				free(chunk);
+				return cached.second;
+			}
+
+		if (chunk_cache_.size() >= ChunkCacheSize) {
+			evicted = chunk_cache_.front().second;
+			chunk_cache_.pop_front();
+		}
+
+		chunk_cache_.emplace_back(chunk_num, chunk);
+	}
+
+	// Readers may still use the chunk we evicted, so it's only retired
+	if (evicted) {
+		lock_guard<recursive_mutex> lock(mutex_);
+		const_cast<Segment*>(this)->retire_buffer(evicted);
+	}
+
+	return chunk;
+}
+
+void Segment::drop_old_chunks(uint64_t sample_num)
+{
+	if (sample_limit_ == 0)
+		return;
+
+	const uint64_t samples_per_chunk = chunk_size_ / unit_size_;
+	uint64_t first_chunk = first_chunk_;
+
+	// The chunk that is currently being filled is never dropped
+	while ((first_chunk + 1 < chunk_count_) &&
+		((first_chunk + 1) * samples_per_chunk <= sample_num) &&
+		(sample_count_ - (first_chunk + 1) * samples_per_chunk >= sample_limit_)) {
+
+		// Readers check first_chunk_ before they access the entry, those
+		// that already did may still use the memory until they unpin it
+		first_chunk_.store(first_chunk + 1, std::memory_order_release);
+
+		ChunkEntry &entry = get_chunk_entry(first_chunk);
+
+		uint8_t* chunk = entry.data.exchange(nullptr);
+		if (chunk) {
+			retired_chunks_.push_back(chunk);
+			chunk_memory_usage_ -= get_chunk_memory_usage(chunk);
+		}
+
+		CompressedChunk* compressed = entry.compressed.exchange(nullptr);
+		if (compressed) {
+			retired_compressed_chunks_.push_back(compressed);
+			chunk_memory_usage_ -= sizeof(CompressedChunk) + compressed->size;
+			compressed_chunk_count_--;
+		}
+
+		first_chunk++;
+		have_retired_memory_ = true;
+	}
+
+	{
+		lock_guard<mutex> cache_lock(chunk_cache_mutex_);
+
+		while (!chunk_cache_.empty() && (chunk_cache_.front().first < first_chunk)) {
+			retired_buffers_.push_back(chunk_cache_.front().second);
+			chunk_cache_.pop_front();
+			have_retired_memory_ = true;
+		}
+	}
+
+	free_retired_memory();
+}
+
+void Segment::build_derived_data()
+{
+}
+
+void Segment::update_derived_data()
+{
+	unique_lock<mutex> lock(builder_mutex_);
+
+	if (!use_background_builder_ || builder_stopped_) {
+		lock.unlock();
+
+		lock_guard<recursive_mutex> data_lock(mutex_);
+		const uint64_t sample_count = sample_count_;
+		build_derived_data();
+		built_sample_count_ = sample_count;
+		return;
+	}
+
+	if (!builder_thread_.joinable())
+		builder_thread_ = thread(&Segment::builder_thread_proc, this);
+	builder_cond_.notify_all();
+
+	// The writer is held back if the builder falls too far behind, the
+	// samples it didn't process yet can neither be compressed nor dropped
+	const uint64_t max_backlog = MaxBuildBacklog / unit_size_;
+	builder_cond_.wait(lock, [&] { return builder_error_ ||
+		(sample_count_ - built_sample_count_ <= max_backlog); });
+
+	if (builder_error_)
+		rethrow_exception(builder_error_);
+}
+
+void Segment::stop_builder()
+{
+	{
+		lock_guard<mutex> lock(builder_mutex_);
+		builder_stopped_ = true;
+	}
+
+	builder_cond_.notify_all();
+
+	if (builder_thread_.joinable())
+		builder_thread_.join();
+}
+
+void Segment::builder_thread_proc()
+{
+	unique_lock<mutex> lock(builder_mutex_);
+
+	while (!builder_error_) {
+		const uint64_t sample_count = sample_count_;
+
+		if (built_sample_count_ == sample_count) {
+			if (builder_stopped_)
+				break;
+
+			builder_cond_.wait(lock);
+			continue;
+		}
+
+		lock.unlock();
+
+		try {
+			build_derived_data();
+		} catch (...) {
+			// Handed over to the writer, which reports it like it would
+			// if it had built the data itself
+			lock.lock();
+			builder_error_ = current_exception();
+			builder_cond_.notify_all();
+			break;
+		}
+
+		lock.lock();
+		built_sample_count_ = sample_count;
+		builder_cond_.notify_all();
+	}
+}
+
+void Segment::pin_memory() const
+{
+	pin_count_++;
+
+	// The pointers the reader loads next must not be older than the pin,
+	// this pairs with the fence in free_retired_memory()
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void Segment::unpin_memory() const
+{
+	const int pin_count = --pin_count_;
+
+	// Either the writer sees the pin gone or we see the retired memory
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if ((pin_count == 0) && have_retired_memory_) {
+		lock_guard<recursive_mutex> lock(mutex_);
+		const_cast<Segment*>(this)->free_retired_memory();
+	}
+}
+
+void Segment::retire_buffer(void *buffer)
+{
+	if (!buffer)
+		return;
+
+	retired_buffers_.push_back(buffer);
+	have_retired_memory_ = true;
+
+	free_retired_memory();
+}
+
+void Segment::free_retired_memory()
+{
+	// A reader that pins the memory after this check can only have obtained
+	// pointers that were published after the retired ones were replaced.
+	// The new pointers were only stored with release semantics, so without
+	// the fence the load of the pin count could pass those stores.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if ((pin_count_ > 0) || !have_retired_memory_)
+		return;
+
+	for (uint8_t* chunk : retired_chunks_)
+		free_chunk(chunk);
+	retired_chunks_.clear();
+
+	for (void* buffer : retired_buffers_)
+		free(buffer);
+	retired_buffers_.clear();
+
+	for (CompressedChunk* compressed : retired_compressed_chunks_) {
+		free(compressed->data);
+		delete compressed;
+	}
+	retired_compressed_chunks_.clear();
+
+	have_retired_memory_ = false;
+}
+
+void Segment::append_single_sample(void *data)
+{
+	append_samples(data, 1);
 }
 
 void Segment::append_samples(void* data, uint64_t samples)
@@ -162,6 +798,13 @@ void Segment::append_samples(void* data, uint64_t samples)
 	uint64_t data_offset = 0;
 
 	do {
+		if (unused_samples_ == 0) {
+			current_chunk_ = allocate_chunk();
+			push_chunk(current_chunk_);
+			used_samples_ = 0;
+			unused_samples_ = chunk_size_ / unit_size_;
+		}
+
 		uint64_t copy_count = 0;
 
 		if (remaining_samples <= unused_samples_) {
@@ -180,47 +823,23 @@ void Segment::append_samples(void* data, uint64_t samples)
 		unused_samples_ -= copy_count;
 		remaining_samples -= copy_count;
 		data_offset += (copy_count * unit_size_);
-
-		if (unused_samples_ == 0) {
-			try {
-				// If we're out of memory, allocating a chunk will throw
-				// std::bad_alloc. To give the application some usable memory
-				// to work with in case chunk allocation fails, we allocate
-				// extra memory and throw it away if it all succeeded.
-				// This way, memory allocation will fail early enough to let
-				// PV remain alive. Otherwise, PV will crash in a random
-				// memory-allocating part of the application.
-				current_chunk_ = new uint8_t[chunk_size_ + 7];  /* FIXME +7 is workaround for #1284 */
-
-				const int dummy_size = 2 * chunk_size_;
-				auto dummy_chunk = new uint8_t[dummy_size];
-				memset(dummy_chunk, 0xFF, dummy_size);
-				delete[] dummy_chunk;
-			} catch (bad_alloc&) {
-				delete[] current_chunk_;  // The new may have succeeded
-				current_chunk_ = nullptr;
-				throw;
-			}
-
-			data_chunks_.push_back(current_chunk_);
-			used_samples_ = 0;
-			unused_samples_ = chunk_size_ / unit_size_;
-		}
 	} while (remaining_samples > 0);
 
-	sample_count_ += samples;
+	// Publish the new samples to the readers
+	sample_count_.fetch_add(samples, std::memory_order_release);
 }
 
 const uint8_t* Segment::get_raw_sample(uint64_t sample_num) const
 {
-	assert(sample_num <= sample_count_);
+	// Chunks are only allocated when needed, so there may not be one
+	// for the position just past the last sample
+	assert(sample_num < sample_count_);
 
+	// Note: the caller must pin the memory while using the result
 	uint64_t chunk_num = (sample_num * unit_size_) / chunk_size_;
 	uint64_t chunk_offs = (sample_num * unit_size_) % chunk_size_;
 
-	lock_guard<recursive_mutex> lock(mutex_);  // Because of free_unused_memory()
-
-	const uint8_t* chunk = data_chunks_[chunk_num];
+	const uint8_t* chunk = get_chunk(chunk_num);
 
 	return chunk + chunk_offs;
 }
@@ -237,15 +856,40 @@ void Segment::get_raw_samples(uint64_t start, uint64_t count, uint8_t* dest) con
 	uint64_t chunk_num = (start * unit_size_) / chunk_size_;
 	uint64_t chunk_offs = (start * unit_size_) % chunk_size_;
 
-	lock_guard<recursive_mutex> lock(mutex_);  // Because of free_unused_memory()
+	MemoryPin pin(*this);  // Because of free_unused_memory()
 
 	while (count > 0) {
-		const uint8_t* chunk = data_chunks_[chunk_num];
-
-		uint64_t copy_size = min(count * unit_size_,
+		const uint64_t copy_size = min(count * unit_size_,
 			chunk_size_ - chunk_offs);
 
-		memcpy(dest_ptr, chunk + chunk_offs, copy_size);
+		if (chunk_num < first_chunk_.load(std::memory_order_acquire)) {
+			// The samples were dropped in ring buffer mode
+			memset(dest_ptr, 0, copy_size);
+
+			dest_ptr += copy_size;
+			count -= (copy_size / unit_size_);
+			chunk_num++;
+			chunk_offs = 0;
+			continue;
+		}
+
+		const ChunkEntry& entry = get_chunk_entry(chunk_num);
+		const uint8_t* chunk = entry.data.load(std::memory_order_acquire);
+
+		const CompressedChunk* compressed = chunk ? nullptr :
+			entry.compressed.load(std::memory_order_acquire);
+
+		if (compressed && (compressed->run_count == 1)) {
+			// Constant chunks don't need to be decompressed
+			const uint8_t* sample = compressed->data + sizeof(uint32_t);
+			for (uint64_t i = 0; i < copy_size; i += unit_size_)
+				memcpy(dest_ptr + i, sample, unit_size_);
+		} else {
+			if (!chunk)
+				chunk = get_decompressed_chunk(chunk_num);
+
+			memcpy(dest_ptr, chunk + chunk_offs, copy_size);
+		}
 
 		dest_ptr += copy_size;
 		count -= (copy_size / unit_size_);
@@ -255,18 +899,107 @@ void Segment::get_raw_samples(uint64_t start, uint64_t count, uint8_t* dest) con
 	}
 }
 
+Segment::DataView::DataView(const Segment &segment, uint64_t start, uint64_t end) :
+	segment_(segment)
+{
+	assert(start <= end);
+	assert(end <= segment_.sample_count_);
+
+	segment_.pin_memory();
+
+	const uint64_t unit_size = segment_.unit_size_;
+	const uint64_t chunk_size = segment_.chunk_size_;
+
+	uint64_t chunk_num = (start * unit_size) / chunk_size;
+	uint64_t chunk_offs = (start * unit_size) % chunk_size;
+	uint64_t count = end - start;
+
+	while (count > 0) {
+		const uint64_t span_count = min(count,
+			(chunk_size - chunk_offs) / unit_size);
+
+		const uint8_t* chunk = nullptr;
+		const CompressedChunk* compressed = nullptr;
+
+		if (chunk_num >= segment_.first_chunk_.load(std::memory_order_acquire)) {
+			const ChunkEntry& entry = segment_.get_chunk_entry(chunk_num);
+			chunk = entry.data.load(std::memory_order_acquire);
+			if (!chunk)
+				compressed = entry.compressed.load(std::memory_order_acquire);
+		} else
+			chunk = get_zero_chunk();
+
+		// Constant chunks are filled in right away, others are looked up in
+		// the cache first. Only the samples of the span are decompressed.
+		if (compressed && (compressed->run_count > 1))
+			chunk = segment_.find_cached_chunk(chunk_num);
+
+		if (compressed && !chunk) {
+			uint8_t* buffer = new uint8_t[span_count * unit_size + 7];  /* FIXME +7 is workaround for #1284 */
+			buffers_.emplace_back(buffer);
+			segment_.decompress_chunk(compressed, buffer,
+				chunk_offs / unit_size, span_count);
+			spans_.push_back({buffer, span_count});
+		} else if (!chunk)
+			// The chunk was dropped since first_chunk_ was checked
+			spans_.push_back({get_zero_chunk() + chunk_offs, span_count});
+		else
+			spans_.push_back({chunk + chunk_offs, span_count});
+
+		count -= span_count;
+		chunk_num++;
+		chunk_offs = 0;
+	}
+}
+
+Segment::DataView::~DataView()
+{
+	segment_.unpin_memory();
+}
+
+const vector<Segment::DataSpan>& Segment::DataView::spans() const
+{
+	return spans_;
+}
+
+const uint8_t* Segment::DataView::contiguous_data(vector<uint8_t> &buffer) const
+{
+	if (spans_.empty())
+		return nullptr;
+
+	if (spans_.size() == 1)
+		return spans_.front().data;
+
+	const unsigned int unit_size = segment_.unit_size_;
+
+	uint64_t size = 0;
+	for (const DataSpan& span : spans_)
+		size += span.sample_count * unit_size;
+
+	buffer.resize(size);
+
+	uint8_t* dest = buffer.data();
+	for (const DataSpan& span : spans_) {
+		memcpy(dest, span.data, span.sample_count * unit_size);
+		dest += span.sample_count * unit_size;
+	}
+
+	return buffer.data();
+}
+
 SegmentDataIterator* Segment::begin_sample_iteration(uint64_t start)
 {
 	SegmentDataIterator* it = new SegmentDataIterator;
 
 	assert(start < sample_count_);
 
-	iterator_count_++;
+	// The chunk pointers held by the iterator must stay valid
+	pin_memory();
 
 	it->sample_index = start;
 	it->chunk_num = (start * unit_size_) / chunk_size_;
 	it->chunk_offs = (start * unit_size_) % chunk_size_;
-	it->chunk = data_chunks_[it->chunk_num];
+	it->chunk = get_chunk(it->chunk_num);
 
 	return it;
 }
@@ -279,7 +1012,11 @@ void Segment::continue_sample_iteration(SegmentDataIterator* it, uint64_t increa
 	if (it->chunk_offs > (chunk_size_ - 1)) {
 		it->chunk_num++;
 		it->chunk_offs -= chunk_size_;
-		it->chunk = data_chunks_[it->chunk_num];
+
+		// Chunks are only created on demand, so the iterator may now point
+		// past the last chunk if it reached the end of the data
+		it->chunk = (it->sample_index < sample_count_) ?
+			get_chunk(it->chunk_num) : nullptr;
 	}
 }
 
@@ -287,12 +1024,7 @@ void Segment::end_sample_iteration(SegmentDataIterator* it)
 {
 	delete it;
 
-	iterator_count_--;
-
-	if ((iterator_count_ == 0) && mem_optimization_requested_) {
-		mem_optimization_requested_ = false;
-		free_unused_memory();
-	}
+	unpin_memory();
 }
 
 uint8_t* Segment::get_iterator_value(SegmentDataIterator* it)
@@ -24,16 +24,28 @@
 #include "pv/util.hpp"
 
 #include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 #include <deque>
 
 #include <QObject>
+#include <QString>
 
 using std::atomic;
+using std::condition_variable;
+using std::exception_ptr;
+using std::mutex;
 using std::recursive_mutex;
+using std::shared_ptr;
 using std::deque;
+using std::pair;
+using std::thread;
+using std::unique_ptr;
+using std::vector;
 
 namespace SegmentTest {
 struct SmallSize8Single;
@@ -46,16 +58,36 @@ struct MediumSize32Multi;
 struct MaxSize32Multi;
 struct MaxSize32MultiAtOnce;
 struct MaxSize32MultiIterated;
+struct DiskStorage;
+struct DataViewSpans;
+struct CompressedChunks;
+struct PooledChunks;
+struct MemoryUsage;
+struct RingBuffer;
+struct BackgroundBuilder;
 }  // namespace SegmentTest
 
 namespace pv {
 namespace data {
 
+class ChunkPool;
+class SpillFile;
+
 typedef struct {
 	uint64_t sample_index, chunk_num, chunk_offs;
 	uint8_t* chunk;
 } SegmentDataIterator;
 
+/**
+ * Sample data storage with a single writer and any number of readers.
+ *
+ * The writer (append_samples() and friends) is serialized by mutex_. Readers
+ * don't take that lock: chunks are immutable once samples were written to
+ * them and sample_count_ is only increased after the samples it covers were
+ * stored, so every sample below get_sample_count() can be read at any time.
+ * Memory that a reader may still access is never freed right away but
+ * retired until no reader holds a pin on the segment anymore.
+ */
 class Segment : public QObject
 {
 	Q_OBJECT
@@ -63,6 +95,105 @@ class Segment : public QObject
 private:
 	static const uint64_t MaxChunkSize;
 
+	/// Number of bytes of sample data that the builder thread may fall
+	/// behind before the writer waits for it
+	static const uint64_t MaxBuildBacklog;
+
+	/// The chunk directory is a two-level table so that it never has to be
+	/// relocated while readers access it. This allows for 4M chunks. In
+	/// ring buffer mode it is addressed modulo its size.
+	static const unsigned int ChunkDirectorySize = 4096;
+	static const unsigned int ChunkDirectoryBlockSize = 1024;
+
+	/// Chunks are only kept compressed if this reduces their size by at
+	/// least this factor
+	static const unsigned int MinCompressionRatio = 4;
+
+	/// Number of decompressed chunks that are kept for the sample iterators
+	/// and get_raw_samples(), data views decompress what they need themselves
+	static const unsigned int ChunkCacheSize = 4;
+
+	/**
+	 * A run-length encoded chunk. Each run consists of a uint32_t
+	 * repetition count followed by the sample itself.
+	 */
+	struct CompressedChunk
+	{
+		uint64_t run_count;
+		uint64_t size;
+		uint8_t *data;
+	};
+
+	/**
+	 * A chunk is either accessible in uncompressed form through @c data or,
+	 * once it was compressed, only through @c compressed.
+	 */
+	struct ChunkEntry
+	{
+		atomic<uint8_t*> data;
+		atomic<CompressedChunk*> compressed;
+	};
+
+	/// Returns a chunk of zeros that is read in place of dropped chunks
+	static const uint8_t* get_zero_chunk();
+
+protected:
+	/**
+	 * Pins the memory of a segment for the lifetime of the instance so that
+	 * chunk and buffer pointers obtained meanwhile stay valid.
+	 */
+	class MemoryPin
+	{
+	public:
+		MemoryPin(const Segment &segment) : segment_(segment) { segment_.pin_memory(); }
+		~MemoryPin() { segment_.unpin_memory(); }
+
+	private:
+		const Segment &segment_;
+	};
+
+public:
+	/// A contiguous range of samples inside a single chunk
+	struct DataSpan
+	{
+		const uint8_t *data;
+		uint64_t sample_count;
+	};
+
+	/**
+	 * Read-only view on the samples [start, end) of a segment that points
+	 * directly into the chunk storage instead of copying the samples. The
+	 * range is split into one span per chunk it touches. The segment memory
+	 * stays pinned for the lifetime of the view, so the spans remain valid
+	 * even if free_unused_memory() is called meanwhile. Samples of compressed
+	 * chunks are decompressed into buffers owned by the view, unless the
+	 * chunk cache holds them already, so that concurrent readers don't
+	 * evict each other's chunks.
+	 */
+	class DataView
+	{
+	public:
+		DataView(const Segment &segment, uint64_t start, uint64_t end);
+		~DataView();
+
+		DataView(const DataView&) = delete;
+		DataView& operator=(const DataView&) = delete;
+
+		const vector<DataSpan>& spans() const;
+
+		/**
+		 * Returns a pointer to all samples of the view in one contiguous
+		 * block. This only requires copying if the view spans multiple
+		 * chunks, in which case @c buffer is used as storage.
+		 */
+		const uint8_t* contiguous_data(vector<uint8_t> &buffer) const;
+
+	private:
+		const Segment &segment_;
+		vector<DataSpan> spans_;
+		vector< unique_ptr<uint8_t[]> > buffers_;
+	};
+
 public:
 	Segment(uint32_t segment_id, uint64_t samplerate, unsigned int unit_size);
 
@@ -70,6 +201,18 @@ public:
 
 	uint64_t get_sample_count() const;
 
+	/**
+	 * Turns the segment into a ring buffer that only keeps the last
+	 * @c count samples, older chunks are dropped as new samples arrive.
+	 * Sample indices stay absolute, samples before get_first_sample() read
+	 * as zeros. 0 keeps all samples, which is the default.
+	 */
+	void set_sample_limit(uint64_t count);
+	uint64_t sample_limit() const;
+
+	/// Returns the index of the oldest sample that is still stored
+	uint64_t get_first_sample() const;
+
 	const pv::util::Timestamp& start_time() const;
 
 	double samplerate() const;
@@ -84,10 +227,110 @@ public:
 
 	void free_unused_memory();
 
+	/**
+	 * Stores the sample data of this segment in a memory-mapped temporary
+	 * file in @c directory instead of the heap. Must be called before any
+	 * samples are added. Returns false if the file couldn't be created, in
+	 * which case the samples are kept on the heap.
+	 */
+	bool use_disk_storage(const QString &directory);
+	bool uses_disk_storage() const;
+
+	/**
+	 * Allocates the chunks from @c pool instead of the heap. Must be
+	 * called before any samples are added.
+	 */
+	void use_chunk_pool(shared_ptr<ChunkPool> pool);
+
+	/**
+	 * Lets a separate thread build the data derived from the samples, like
+	 * the mip-map, so that appending samples returns quickly. The derived
+	 * data then lags behind the samples. Must be called before any samples
+	 * are added.
+	 */
+	void use_background_builder();
+	bool uses_background_builder() const;
+
+	/// Returns the number of samples that the derived data covers
+	uint64_t get_built_sample_count() const;
+
+	uint64_t get_compressed_chunk_count() const;
+
+	/**
+	 * Returns the number of bytes of heap memory that the sample data
+	 * occupies, including compressed chunks and decompressed chunks kept
+	 * for reading. Chunks stored in a spill file aren't accounted for.
+	 */
+	uint64_t get_memory_usage() const;
+
 Q_SIGNALS:
 	void completed();
 
 protected:
+	uint8_t* allocate_chunk();
+	void free_chunk(uint8_t *chunk);
+
+	/// Returns the number of bytes that an uncompressed chunk takes in RAM
+	uint64_t get_chunk_memory_usage(const uint8_t *chunk) const;
+
+	ChunkEntry& get_chunk_entry(uint64_t chunk_num) const;
+	uint8_t* get_chunk(uint64_t chunk_num) const;
+	void push_chunk(uint8_t *chunk);
+
+	/**
+	 * Run-length encodes all full chunks that only contain samples before
+	 * @c sample_num. Chunks that don't compress well are kept as they are.
+	 * Must only be called by the thread that builds the derived data. The
+	 * chunks are encoded without holding mutex_, so that the writer isn't
+	 * held up meanwhile.
+	 */
+	void compress_chunks_before(uint64_t sample_num);
+	bool compress_chunk(uint64_t chunk_num, uint64_t sample_count);
+	/// Decompresses the samples [start, start + count) of a chunk to @c dest
+	void decompress_chunk(const CompressedChunk *compressed, uint8_t *dest,
+		uint64_t start, uint64_t count) const;
+	uint8_t* get_decompressed_chunk(uint64_t chunk_num) const;
+	/// Returns the decompressed chunk if it's cached, nullptr otherwise
+	const uint8_t* find_cached_chunk(uint64_t chunk_num) const;
+
+	/**
+	 * Drops the oldest chunks that are no longer needed to hold the last
+	 * sample_limit_ samples, as long as they only contain samples before
+	 * @c sample_num. Subclasses call this once their own data doesn't refer
+	 * to the dropped samples anymore. Must be called with mutex_ held.
+	 */
+	void drop_old_chunks(uint64_t sample_num);
+
+	/**
+	 * Extends the data derived from the samples so that it covers all
+	 * samples added so far. This runs on the builder thread if there is
+	 * one, while the writer keeps adding samples, so it must take mutex_
+	 * itself where needed. Subclasses that override it must call
+	 * stop_builder() in their destructor.
+	 */
+	virtual void build_derived_data();
+
+	/**
+	 * Called by the writer after adding samples, without holding mutex_.
+	 * Builds the derived data right away or hands it over to the builder
+	 * thread.
+	 */
+	void update_derived_data();
+
+	/// Waits for the builder thread to cover all samples and ends it
+	void stop_builder();
+	void builder_thread_proc();
+
+	void pin_memory() const;
+	void unpin_memory() const;
+
+	/**
+	 * Frees a buffer that was allocated with malloc() once no reader can
+	 * access it anymore. Must be called with mutex_ held.
+	 */
+	void retire_buffer(void *buffer);
+	void free_retired_memory();
+
 	void append_single_sample(void *data);
 	void append_samples(void *data, uint64_t samples);
 	const uint8_t* get_raw_sample(uint64_t sample_num) const;
@@ -101,18 +344,45 @@ protected:
 
 	uint32_t segment_id_;
 	mutable recursive_mutex mutex_;
-	deque<uint8_t*> data_chunks_;
+	ChunkEntry* chunk_directory_[ChunkDirectorySize];
+	uint64_t chunk_count_;
+	uint64_t sample_limit_;
+	atomic<uint64_t> first_chunk_;
+	bool compress_chunks_;
+	uint64_t next_chunk_to_compress_, compressed_chunk_count_;
+	/// The bytes taken by the chunks that are stored, kept up to date so
+	/// that get_memory_usage() needn't walk them
+	atomic<uint64_t> chunk_memory_usage_;
+	/// The decompressed chunks have a lock of their own, so that readers
+	/// don't wait for the writer while they decompress a chunk and vice versa
+	mutable mutex chunk_cache_mutex_;
+	mutable deque< pair<uint64_t, uint8_t*> > chunk_cache_;
+	unique_ptr<SpillFile> spill_file_;
+	shared_ptr<ChunkPool> chunk_pool_;
 	uint8_t* current_chunk_;
+	uint8_t* resized_chunk_;
 	uint64_t used_samples_, unused_samples_;
 	atomic<uint64_t> sample_count_;
+	mutable atomic<int> pin_count_;
+	atomic<bool> have_retired_memory_;
+	deque<uint8_t*> retired_chunks_;
+	deque<void*> retired_buffers_;
+	deque<CompressedChunk*> retired_compressed_chunks_;
 	pv::util::Timestamp start_time_;
 	double samplerate_;
 	uint64_t chunk_size_;
 	unsigned int unit_size_;
-	int iterator_count_;
-	bool mem_optimization_requested_;
 	bool is_complete_;
 
+	/// The builder state is protected by builder_mutex_
+	bool use_background_builder_;
+	thread builder_thread_;
+	mutex builder_mutex_;
+	condition_variable builder_cond_;
+	bool builder_stopped_;
+	exception_ptr builder_error_;
+	atomic<uint64_t> built_sample_count_;
+
 	friend struct SegmentTest::SmallSize8Single;
 	friend struct SegmentTest::MediumSize8Single;
 	friend struct SegmentTest::MaxSize8Single;
@@ -123,6 +393,13 @@ protected:
 	friend struct SegmentTest::MaxSize32Multi;
 	friend struct SegmentTest::MaxSize32MultiAtOnce;
 	friend struct SegmentTest::MaxSize32MultiIterated;
+	friend struct SegmentTest::DiskStorage;
+	friend struct SegmentTest::DataViewSpans;
+	friend struct SegmentTest::CompressedChunks;
+	friend struct SegmentTest::PooledChunks;
+	friend struct SegmentTest::MemoryUsage;
+	friend struct SegmentTest::RingBuffer;
+	friend struct SegmentTest::BackgroundBuilder;
 };
 
 } // namespace data
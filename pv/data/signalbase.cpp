@@ -34,6 +34,7 @@
 
 using std::dynamic_pointer_cast;
 using std::make_shared;
+using std::min;
 using std::out_of_range;
 using std::shared_ptr;
 using std::tie;
@@ -124,6 +125,7 @@ SignalBase::SignalBase(shared_ptr<sigrok::Channel> channel, ChannelType channel_
 	conversion_type_(NoConversion),
 	min_value_(0),
 	max_value_(0),
+	converted_data_discarded_(false),
 	index_(0),
 	error_message_("")
 {
@@ -170,6 +172,10 @@ void SignalBase::set_enabled(bool value)
 {
 	if (channel_) {
 		channel_->set_enabled(value);
+
+		if (value && converted_data_discarded_)
+			start_conversion();
+
 		enabled_changed(value);
 	}
 }
@@ -635,9 +641,6 @@ void SignalBase::convert_single_segment_range(shared_ptr<AnalogSegment> asegment
 	if (end_sample > start_sample) {
 		tie(min_value_, max_value_) = asegment->get_min_max();
 
-		// Create sigrok::Analog instance
-		float *asamples = new float[ConversionBlockSize];
-		assert(asamples);
 		uint8_t *lsamples = new uint8_t[ConversionBlockSize];
 		assert(lsamples);
 
@@ -649,84 +652,46 @@ void SignalBase::convert_single_segment_range(shared_ptr<AnalogSegment> asegment
 		const sigrok::Quantity * const mq = sigrok::Quantity::VOLTAGE;
 		const sigrok::Unit * const unit = sigrok::Unit::VOLT;
 
-		shared_ptr<sigrok::Packet> packet =
-			Session::sr_context->create_analog_packet(channels,
-			asamples, ConversionBlockSize, mq, unit, mq_flags);
-
-		shared_ptr<sigrok::Analog> analog =
-			dynamic_pointer_cast<sigrok::Analog>(packet->payload());
+		const vector<double> thresholds = get_conversion_thresholds();
+		uint8_t state = 0;  // TODO Use value of logic sample n-1 instead of 0
 
-		// Convert
+		// Convert the analog samples in place, block by block
+		const Segment::DataView view(*asegment, start_sample, end_sample);
 		uint64_t i = start_sample;
 
-		if (conversion_type_ == A2LConversionByThreshold) {
-			const double threshold = get_conversion_thresholds()[0];
-
-			// Convert as many sample blocks as we can
-			while ((end_sample - i) > ConversionBlockSize) {
-				asegment->get_samples(i, i + ConversionBlockSize, asamples);
-
-				shared_ptr<sigrok::Logic> logic =
-					analog->get_logic_via_threshold(threshold, lsamples);
-
-				lsegment->append_payload(logic->data_pointer(), logic->data_length());
-				samples_added(lsegment->segment_id(), i, i + ConversionBlockSize);
-				i += ConversionBlockSize;
-			}
-
-			// Re-create sigrok::Analog and convert remaining samples
-			packet = Session::sr_context->create_analog_packet(channels,
-				asamples, end_sample - i, mq, unit, mq_flags);
-
-			analog = dynamic_pointer_cast<sigrok::Analog>(packet->payload());
-
-			asegment->get_samples(i, end_sample, asamples);
-			shared_ptr<sigrok::Logic> logic =
-				analog->get_logic_via_threshold(threshold, lsamples);
-			lsegment->append_payload(logic->data_pointer(), logic->data_length());
-			samples_added(lsegment->segment_id(), i, end_sample);
-		}
+		for (const Segment::DataSpan& span : view.spans()) {
+			const float *asamples = (const float*)span.data;
 
-		if (conversion_type_ == A2LConversionBySchmittTrigger) {
-			const vector<double> thresholds = get_conversion_thresholds();
-			const double lo_thr = thresholds[0];
-			const double hi_thr = thresholds[1];
+			for (uint64_t offs = 0; offs < span.sample_count; offs += ConversionBlockSize) {
+				const uint64_t count = min(span.sample_count - offs, ConversionBlockSize);
 
-			uint8_t state = 0;  // TODO Use value of logic sample n-1 instead of 0
+				// Create sigrok::Analog instance referring to the block
+				shared_ptr<sigrok::Packet> packet =
+					Session::sr_context->create_analog_packet(channels,
+					(float*)(asamples + offs), count, mq, unit, mq_flags);
 
-			// Convert as many sample blocks as we can
-			while ((end_sample - i) > ConversionBlockSize) {
-				asegment->get_samples(i, i + ConversionBlockSize, asamples);
+				shared_ptr<sigrok::Analog> analog =
+					dynamic_pointer_cast<sigrok::Analog>(packet->payload());
 
-				shared_ptr<sigrok::Logic> logic =
-					analog->get_logic_via_schmitt_trigger(lo_thr, hi_thr,
-						&state, lsamples);
+				shared_ptr<sigrok::Logic> logic;
+				if (conversion_type_ == A2LConversionByThreshold)
+					logic = analog->get_logic_via_threshold(thresholds[0], lsamples);
+				else if (conversion_type_ == A2LConversionBySchmittTrigger)
+					logic = analog->get_logic_via_schmitt_trigger(thresholds[0],
+						thresholds[1], &state, lsamples);
+				else
+					break;
 
 				lsegment->append_payload(logic->data_pointer(), logic->data_length());
-				samples_added(lsegment->segment_id(), i, i + ConversionBlockSize);
-
-				i += ConversionBlockSize;
+				samples_added(lsegment->segment_id(), i, i + count);
+				i += count;
 			}
-
-			// Re-create sigrok::Analog and convert remaining samples
-			packet = Session::sr_context->create_analog_packet(channels,
-				asamples, end_sample - i, mq, unit, mq_flags);
-
-			analog = dynamic_pointer_cast<sigrok::Analog>(packet->payload());
-
-			asegment->get_samples(i, end_sample, asamples);
-			shared_ptr<sigrok::Logic> logic =
-				analog->get_logic_via_schmitt_trigger(lo_thr, hi_thr,
-					&state, lsamples);
-			lsegment->append_payload(logic->data_pointer(), logic->data_length());
-			samples_added(lsegment->segment_id(), i, end_sample);
 		}
 
 		// If acquisition is ongoing, start-/endsample may have changed
 		end_sample = asegment->get_sample_count();
 
 		delete[] lsamples;
-		delete[] asamples;
 	}
 
 	samples_added(lsegment->segment_id(), start_sample, end_sample);
@@ -801,6 +766,7 @@ void SignalBase::conversion_thread_proc()
 	if (logic_data->logic_segments().size() == 0) {
 		shared_ptr<LogicSegment> new_segment =
 			make_shared<LogicSegment>(*logic_data.get(), 0, 1, asegment->samplerate());
+		new_segment->set_sample_limit(asegment->sample_limit());
 		logic_data->push_segment(new_segment);
 	}
 
@@ -831,6 +797,7 @@ void SignalBase::conversion_thread_proc()
 
 			shared_ptr<LogicSegment> new_segment = make_shared<LogicSegment>(
 				*logic_data.get(), segment_id, 1, asegment->samplerate());
+			new_segment->set_sample_limit(asegment->sample_limit());
 			logic_data->push_segment(new_segment);
 
 			lsegment = logic_data->logic_segments().back();
@@ -860,10 +827,25 @@ void SignalBase::start_conversion(bool delayed_start)
 		samples_cleared();
 	}
 
+	converted_data_discarded_ = false;
 	conversion_interrupt_ = false;
 	conversion_thread_ = std::thread(&SignalBase::conversion_thread_proc, this);
 }
 
+void SignalBase::discard_converted_data()
+{
+	if (!conversion_is_a2l() || !converted_data_ ||
+		(converted_data_->get_segment_count() == 0))
+		return;
+
+	stop_conversion();
+
+	converted_data_->clear();
+	samples_cleared();
+
+	converted_data_discarded_ = true;
+}
+
 void SignalBase::set_error_message(QString msg)
 {
 	error_message_ = msg;
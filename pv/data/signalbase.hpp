@@ -357,6 +357,12 @@ public:
 
 	void start_conversion(bool delayed_start=false);
 
+	/**
+	 * Frees the logic data generated by an analog-to-logic conversion.
+	 * The conversion is run again when the signal is enabled.
+	 */
+	void discard_converted_data();
+
 protected:
 	virtual void set_error_message(QString msg);
 
@@ -418,6 +424,7 @@ protected:
 	mutex conversion_input_mutex_;
 	condition_variable conversion_input_cond_;
 	QTimer delayed_conversion_starter_;
+	bool converted_data_discarded_;
 
 	QString internal_name_, name_;
 	QColor color_, bgcolor_;
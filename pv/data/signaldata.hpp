@@ -55,6 +55,18 @@ public:
 
 	virtual double get_samplerate() const = 0;
 
+	/**
+	 * Returns the number of bytes of heap memory used by the samples of
+	 * all segments.
+	 */
+	virtual uint64_t get_memory_usage() const = 0;
+
+	/**
+	 * Returns the number of bytes of heap memory used by the mip-maps or
+	 * envelopes of all segments.
+	 */
+	virtual uint64_t get_mipmap_memory_usage() const = 0;
+
 Q_SIGNALS:
 	void segment_completed();
 };
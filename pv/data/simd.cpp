@@ -0,0 +1,601 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cstring>
+
+#include <QDebug>
+
+#include "simd.hpp"
+
+// The kernels for the individual instruction sets are compiled with the
+// target attribute, so no special compiler flags are needed and the
+// binary still runs on CPUs that lack them
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace pv {
+namespace data {
+namespace simd {
+
+// All kernels assume that a block of one byte samples fills one register
+static_assert(BlockLength == 16, "Kernels require blocks of 16 samples");
+
+namespace {
+
+typedef void (*KernelFunction)(const uint8_t *in, uint8_t *out,
+	uint64_t block_count, unsigned int unit_size);
+
+typedef void (*TransposeFunction)(const uint8_t *in, uint64_t *out,
+	uint64_t word_count, uint64_t stride, unsigned int unit_size);
+
+typedef void (*GatherFunction)(const uint8_t *in, uint64_t *out,
+	uint64_t count, const BitGatherMap &map);
+
+struct Kernels
+{
+	const char *instruction_set;
+	KernelFunction downsample_edges;
+	KernelFunction reduce_or;
+	TransposeFunction transpose_bits;
+	GatherFunction gather_bits;
+};
+
+/**
+ * Ors the bytes of a little endian word together so that every one of the
+ * lowest @c unit_size bytes holds the bits of all bytes at the same position
+ * within a sample. @c unit_size must be a power of two.
+ */
+inline uint64_t fold_word(uint64_t word, unsigned int unit_size)
+{
+	for (unsigned int shift = 32; shift >= 8 * unit_size; shift /= 2)
+		word |= word >> shift;
+
+	return word;
+}
+
+/**
+ * Does the same for a block of samples with any unit size by halving it
+ * repeatedly. @c buffer must have 8 bytes of padding.
+ */
+inline void fold_bytes(uint8_t *buffer, unsigned int unit_size)
+{
+	for (unsigned int length = BlockLength * unit_size; length > unit_size;
+			length /= 2) {
+		const unsigned int half = length / 2;
+
+		// Bytes past the half only end up past the half as well
+		for (unsigned int i = 0; i < half; i += 8) {
+			uint64_t lower, upper;
+			memcpy(&lower, buffer + i, sizeof(uint64_t));
+			memcpy(&upper, buffer + half + i, sizeof(uint64_t));
+			lower |= upper;
+			memcpy(buffer + i, &lower, sizeof(uint64_t));
+		}
+	}
+}
+
+void transpose_bits_generic(const uint8_t *in, uint64_t *out,
+	uint64_t word_count, uint64_t stride, unsigned int unit_size)
+{
+	const unsigned int channel_count = 8 * unit_size;
+	uint64_t words[64];
+
+	for (uint64_t w = 0; w < word_count; w++) {
+		memset(words, 0, sizeof(words));
+
+		for (unsigned int i = 0; i < BitPlaneWordLength; i++)
+			for (unsigned int byte = 0; byte < unit_size; byte++) {
+				const uint8_t value = *in++;
+				for (unsigned int bit = 0; bit < 8; bit++)
+					words[8 * byte + bit] |= (uint64_t)((value >> bit) & 1) << i;
+			}
+
+		for (unsigned int c = 0; c < channel_count; c++)
+			out[c * stride + w] = words[c];
+	}
+}
+
+void gather_bits_tables(const uint8_t *in, uint64_t *out, uint64_t count,
+	const BitGatherMap &map)
+{
+	const unsigned int unit_size = map.unit_size;
+	const unsigned int byte_count = map.bytes.size();
+
+	// Most devices have no more than 8 channels, so one byte is looked up
+	if (byte_count == 1) {
+		const uint64_t *const table = map.tables.data();
+		in += map.bytes[0];
+		for (uint64_t i = 0; i < count; i++, in += unit_size)
+			out[i] |= table[*in];
+		return;
+	}
+
+	for (uint64_t i = 0; i < count; i++, in += unit_size) {
+		uint64_t value = 0;
+		for (unsigned int b = 0; b < byte_count; b++)
+			value |= map.tables[256 * b + in[map.bytes[b]]];
+		out[i] |= value;
+	}
+}
+
+#ifdef SIMD_X86
+
+__attribute__((target("sse2")))
+inline uint64_t fold_vector_sse2(__m128i v)
+{
+	v = _mm_or_si128(v, _mm_srli_si128(v, 8));
+
+	uint64_t word;
+	_mm_storel_epi64((__m128i*)&word, v);
+
+	return word;
+}
+
+template <unsigned int UnitSize, bool Edges>
+__attribute__((target("sse2")))
+void reduce_blocks_sse2(const uint8_t *in, uint8_t *out, uint64_t block_count)
+{
+	for (uint64_t i = 0; i < block_count; i++) {
+		__m128i acc = _mm_setzero_si128();
+
+		// A block consists of UnitSize registers
+		for (unsigned int r = 0; r < UnitSize; r++) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(in + 16 * r));
+			if (Edges)
+				x = _mm_xor_si128(x,
+					_mm_loadu_si128((const __m128i*)(in + 16 * r - UnitSize)));
+			acc = _mm_or_si128(acc, x);
+		}
+
+		const uint64_t word = fold_word(fold_vector_sse2(acc), UnitSize);
+		memcpy(out, &word, UnitSize);
+
+		in += BlockLength * UnitSize;
+		out += UnitSize;
+	}
+}
+
+template <bool Edges>
+__attribute__((target("sse2")))
+void reduce_blocks_sse2_generic(const uint8_t *in, uint8_t *out,
+	uint64_t block_count, unsigned int unit_size)
+{
+	uint8_t buffer[BlockLength * 8 + 8] = {};
+
+	for (uint64_t i = 0; i < block_count; i++) {
+		for (unsigned int r = 0; r < unit_size; r++) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(in + 16 * r));
+			if (Edges)
+				x = _mm_xor_si128(x,
+					_mm_loadu_si128((const __m128i*)(in + 16 * r - unit_size)));
+			_mm_storeu_si128((__m128i*)(buffer + 16 * r), x);
+		}
+
+		fold_bytes(buffer, unit_size);
+		memcpy(out, buffer, unit_size);
+
+		in += BlockLength * unit_size;
+		out += unit_size;
+	}
+}
+
+template <bool Edges>
+__attribute__((target("sse2")))
+void reduce_sse2(const uint8_t *in, uint8_t *out, uint64_t block_count,
+	unsigned int unit_size)
+{
+	switch (unit_size) {
+	case 1: reduce_blocks_sse2<1, Edges>(in, out, block_count); break;
+	case 2: reduce_blocks_sse2<2, Edges>(in, out, block_count); break;
+	case 4: reduce_blocks_sse2<4, Edges>(in, out, block_count); break;
+	case 8: reduce_blocks_sse2<8, Edges>(in, out, block_count); break;
+	default: reduce_blocks_sse2_generic<Edges>(in, out, block_count, unit_size);
+	}
+}
+
+template <unsigned int UnitSize, bool Edges>
+__attribute__((target("avx2")))
+void reduce_blocks_avx2(const uint8_t *in, uint8_t *out, uint64_t block_count)
+{
+	uint64_t i = 0;
+
+	if (UnitSize == 1) {
+		// Two blocks fit into one register, the lanes are folded separately
+		for (; i + 2 <= block_count; i += 2) {
+			__m256i x = _mm256_loadu_si256((const __m256i*)in);
+			if (Edges)
+				x = _mm256_xor_si256(x, _mm256_loadu_si256((const __m256i*)(in - 1)));
+			x = _mm256_or_si256(x, _mm256_srli_si256(x, 8));
+
+			uint64_t words[2];
+			_mm_storel_epi64((__m128i*)&words[0], _mm256_castsi256_si128(x));
+			_mm_storel_epi64((__m128i*)&words[1], _mm256_extracti128_si256(x, 1));
+			out[0] = fold_word(words[0], 1);
+			out[1] = fold_word(words[1], 1);
+
+			in += 2 * BlockLength;
+			out += 2;
+		}
+	} else {
+		for (; i < block_count; i++) {
+			__m256i acc = _mm256_setzero_si256();
+
+			for (unsigned int r = 0; r < UnitSize / 2; r++) {
+				__m256i x = _mm256_loadu_si256((const __m256i*)(in + 32 * r));
+				if (Edges)
+					x = _mm256_xor_si256(x,
+						_mm256_loadu_si256((const __m256i*)(in + 32 * r - UnitSize)));
+				acc = _mm256_or_si256(acc, x);
+			}
+
+			const __m128i acc128 = _mm_or_si128(_mm256_castsi256_si128(acc),
+				_mm256_extracti128_si256(acc, 1));
+			const uint64_t word = fold_word(fold_vector_sse2(acc128), UnitSize);
+			memcpy(out, &word, UnitSize);
+
+			in += BlockLength * UnitSize;
+			out += UnitSize;
+		}
+	}
+
+	// An odd block is left over for one byte samples
+	reduce_blocks_sse2<UnitSize, Edges>(in, out, block_count - i);
+}
+
+template <bool Edges>
+__attribute__((target("avx2")))
+void reduce_avx2(const uint8_t *in, uint8_t *out, uint64_t block_count,
+	unsigned int unit_size)
+{
+	switch (unit_size) {
+	case 1: reduce_blocks_avx2<1, Edges>(in, out, block_count); break;
+	case 2: reduce_blocks_avx2<2, Edges>(in, out, block_count); break;
+	case 4: reduce_blocks_avx2<4, Edges>(in, out, block_count); break;
+	case 8: reduce_blocks_avx2<8, Edges>(in, out, block_count); break;
+	default: reduce_blocks_sse2_generic<Edges>(in, out, block_count, unit_size);
+	}
+}
+
+/**
+ * Collects bit 7 down to 0 of the 16 bytes in @c v, which must hold the same
+ * byte of 16 consecutive samples, into the bit plane words of its channels.
+ * x86 is little endian, so @c group selects the quarter of the words that
+ * receives the bits.
+ */
+__attribute__((target("sse2")))
+inline void movemask_bits_sse2(__m128i v, uint16_t *words, unsigned int group)
+{
+	// Shifting moves the next lower bit of every byte into its MSB
+	for (int bit = 7; bit >= 0; bit--) {
+		words[4 * bit + group] = _mm_movemask_epi8(v);
+		v = _mm_slli_epi64(v, 1);
+	}
+}
+
+template <unsigned int UnitSize>
+__attribute__((target("sse2")))
+void transpose_words_sse2(const uint8_t *in, uint64_t *out, uint64_t word_count,
+	uint64_t stride)
+{
+	uint16_t words[8 * UnitSize * 4];
+
+	for (uint64_t w = 0; w < word_count; w++) {
+		for (unsigned int group = 0; group < BitPlaneWordLength / 16; group++) {
+			__m128i v[UnitSize];
+			for (unsigned int r = 0; r < UnitSize; r++)
+				v[r] = _mm_loadu_si128((const __m128i*)(in + 16 * r));
+
+			// Four rounds of interleaving leave the same byte of all 16
+			// samples in one register, in sample order
+			if (UnitSize > 1)
+				for (unsigned int round = 0; round < 4; round++) {
+					__m128i t[UnitSize];
+					for (unsigned int i = 0; i < UnitSize / 2; i++) {
+						t[2 * i] = _mm_unpacklo_epi8(v[i], v[i + UnitSize / 2]);
+						t[2 * i + 1] = _mm_unpackhi_epi8(v[i], v[i + UnitSize / 2]);
+					}
+					for (unsigned int r = 0; r < UnitSize; r++)
+						v[r] = t[r];
+				}
+
+			for (unsigned int byte = 0; byte < UnitSize; byte++)
+				movemask_bits_sse2(v[byte], words + 32 * byte, group);
+
+			in += 16 * UnitSize;
+		}
+
+		for (unsigned int c = 0; c < 8 * UnitSize; c++)
+			memcpy(out + c * stride + w, words + 4 * c, sizeof(uint64_t));
+	}
+}
+
+__attribute__((target("sse2")))
+void transpose_words_sse2_generic(const uint8_t *in, uint64_t *out,
+	uint64_t word_count, uint64_t stride, unsigned int unit_size)
+{
+	uint8_t column[BitPlaneWordLength];
+	uint16_t words[8 * 4];
+
+	for (uint64_t w = 0; w < word_count; w++) {
+		for (unsigned int byte = 0; byte < unit_size; byte++) {
+			// Gather the same byte of all samples so that the movemask
+			// instruction can collect one bit of 16 samples at once
+			for (unsigned int i = 0; i < BitPlaneWordLength; i++)
+				column[i] = in[i * unit_size + byte];
+
+			for (unsigned int group = 0; group < BitPlaneWordLength / 16; group++)
+				movemask_bits_sse2(
+					_mm_loadu_si128((const __m128i*)(column + 16 * group)),
+					words, group);
+
+			for (unsigned int bit = 0; bit < 8; bit++)
+				memcpy(out + (8 * byte + bit) * stride + w, words + 4 * bit,
+					sizeof(uint64_t));
+		}
+
+		in += BitPlaneWordLength * unit_size;
+	}
+}
+
+__attribute__((target("sse2")))
+void transpose_bits_sse2(const uint8_t *in, uint64_t *out, uint64_t word_count,
+	uint64_t stride, unsigned int unit_size)
+{
+	switch (unit_size) {
+	case 1: transpose_words_sse2<1>(in, out, word_count, stride); break;
+	case 2: transpose_words_sse2<2>(in, out, word_count, stride); break;
+	case 4: transpose_words_sse2<4>(in, out, word_count, stride); break;
+	case 8: transpose_words_sse2<8>(in, out, word_count, stride); break;
+	default: transpose_words_sse2_generic(in, out, word_count, stride, unit_size);
+	}
+}
+
+#ifdef __x86_64__
+template <unsigned int UnitSize>
+__attribute__((target("bmi2")))
+void gather_bits_bmi2_unit(const uint8_t *in, uint64_t *out, uint64_t count,
+	uint64_t in_mask, uint64_t out_mask)
+{
+	for (uint64_t i = 0; i < count; i++, in += UnitSize) {
+		uint64_t sample = 0;
+		memcpy(&sample, in, UnitSize);
+		out[i] |= _pdep_u64(_pext_u64(sample, in_mask), out_mask);
+	}
+}
+
+void gather_bits_bmi2(const uint8_t *in, uint64_t *out, uint64_t count,
+	const BitGatherMap &map)
+{
+	if (!map.ordered) {
+		gather_bits_tables(in, out, count, map);
+		return;
+	}
+
+	const uint64_t in_mask = map.in_mask, out_mask = map.out_mask;
+
+	switch (map.unit_size) {
+	case 1: gather_bits_bmi2_unit<1>(in, out, count, in_mask, out_mask); break;
+	case 2: gather_bits_bmi2_unit<2>(in, out, count, in_mask, out_mask); break;
+	case 3: gather_bits_bmi2_unit<3>(in, out, count, in_mask, out_mask); break;
+	case 4: gather_bits_bmi2_unit<4>(in, out, count, in_mask, out_mask); break;
+	case 5: gather_bits_bmi2_unit<5>(in, out, count, in_mask, out_mask); break;
+	case 6: gather_bits_bmi2_unit<6>(in, out, count, in_mask, out_mask); break;
+	case 7: gather_bits_bmi2_unit<7>(in, out, count, in_mask, out_mask); break;
+	default: gather_bits_bmi2_unit<8>(in, out, count, in_mask, out_mask); break;
+	}
+}
+#endif
+
+#endif // SIMD_X86
+
+#ifdef SIMD_NEON
+
+template <unsigned int UnitSize, bool Edges>
+void reduce_blocks_neon(const uint8_t *in, uint8_t *out, uint64_t block_count)
+{
+	for (uint64_t i = 0; i < block_count; i++) {
+		uint8x16_t acc = vdupq_n_u8(0);
+
+		// A block consists of UnitSize registers
+		for (unsigned int r = 0; r < UnitSize; r++) {
+			uint8x16_t x = vld1q_u8(in + 16 * r);
+			if (Edges)
+				x = veorq_u8(x, vld1q_u8(in + 16 * r - UnitSize));
+			acc = vorrq_u8(acc, x);
+		}
+
+		const uint64x2_t acc64 = vreinterpretq_u64_u8(acc);
+		const uint64_t word = fold_word(
+			vgetq_lane_u64(acc64, 0) | vgetq_lane_u64(acc64, 1), UnitSize);
+		memcpy(out, &word, UnitSize);
+
+		in += BlockLength * UnitSize;
+		out += UnitSize;
+	}
+}
+
+template <bool Edges>
+void reduce_blocks_neon_generic(const uint8_t *in, uint8_t *out,
+	uint64_t block_count, unsigned int unit_size)
+{
+	uint8_t buffer[BlockLength * 8 + 8] = {};
+
+	for (uint64_t i = 0; i < block_count; i++) {
+		for (unsigned int r = 0; r < unit_size; r++) {
+			uint8x16_t x = vld1q_u8(in + 16 * r);
+			if (Edges)
+				x = veorq_u8(x, vld1q_u8(in + 16 * r - unit_size));
+			vst1q_u8(buffer + 16 * r, x);
+		}
+
+		fold_bytes(buffer, unit_size);
+		memcpy(out, buffer, unit_size);
+
+		in += BlockLength * unit_size;
+		out += unit_size;
+	}
+}
+
+template <bool Edges>
+void reduce_neon(const uint8_t *in, uint8_t *out, uint64_t block_count,
+	unsigned int unit_size)
+{
+	switch (unit_size) {
+	case 1: reduce_blocks_neon<1, Edges>(in, out, block_count); break;
+	case 2: reduce_blocks_neon<2, Edges>(in, out, block_count); break;
+	case 4: reduce_blocks_neon<4, Edges>(in, out, block_count); break;
+	case 8: reduce_blocks_neon<8, Edges>(in, out, block_count); break;
+	default: reduce_blocks_neon_generic<Edges>(in, out, block_count, unit_size);
+	}
+}
+
+#endif // SIMD_NEON
+
+Kernels select_kernels()
+{
+	Kernels selected = {"none", nullptr, nullptr, transpose_bits_generic,
+		gather_bits_tables};
+
+#if defined(SIMD_X86)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+		selected = {"AVX2", reduce_avx2<true>, reduce_avx2<false>,
+			transpose_bits_sse2, gather_bits_tables};
+	else if (__builtin_cpu_supports("sse2"))
+		selected = {"SSE2", reduce_sse2<true>, reduce_sse2<false>,
+			transpose_bits_sse2, gather_bits_tables};
+
+#ifdef __x86_64__
+	// PDEP and PEXT are microcoded on AMD CPUs before Zen 3 and much slower
+	// than the tables there, which can't be told apart from later ones here
+	if (__builtin_cpu_supports("bmi2") && !__builtin_cpu_is("amd"))
+		selected.gather_bits = gather_bits_bmi2;
+#endif
+#elif defined(SIMD_NEON)
+	selected = {"NEON", reduce_neon<true>, reduce_neon<false>,
+		transpose_bits_generic, gather_bits_tables};
+#endif
+
+	qDebug() << "Using SIMD kernels for logic data:" << selected.instruction_set;
+
+	return selected;
+}
+
+const Kernels& kernels()
+{
+	static const Kernels selected = select_kernels();
+
+	return selected;
+}
+
+} // namespace
+
+BitGatherMap::BitGatherMap(unsigned int unit_size,
+	const vector< pair<unsigned int, unsigned int> > &bits) :
+	unit_size(unit_size),
+	ordered(true),
+	in_mask(0),
+	out_mask(0)
+{
+	assert((unit_size > 0) && (unit_size <= 8));
+
+	for (unsigned int byte = 0; byte < unit_size; byte++) {
+		vector< pair<unsigned int, unsigned int> > byte_bits;
+		for (const pair<unsigned int, unsigned int> &b : bits)
+			if (b.first / 8 == byte)
+				byte_bits.push_back(b);
+
+		if (byte_bits.empty())
+			continue;
+
+		bytes.push_back(byte);
+		for (unsigned int value = 0; value < 256; value++) {
+			uint64_t entry = 0;
+			for (const pair<unsigned int, unsigned int> &b : byte_bits)
+				if ((value >> (b.first % 8)) & 1)
+					entry |= 1ULL << b.second;
+			tables.push_back(entry);
+		}
+	}
+
+	// The masks only describe the mapping if the n-th lowest input channel
+	// goes to the n-th lowest output bit
+	for (const pair<unsigned int, unsigned int> &a : bits) {
+		assert((a.first < 8 * unit_size) && (a.second < 64));
+		in_mask |= 1ULL << a.first;
+		out_mask |= 1ULL << a.second;
+
+		for (const pair<unsigned int, unsigned int> &b : bits)
+			if ((a.first < b.first) != (a.second < b.second))
+				ordered = false;
+	}
+}
+
+bool available()
+{
+	return kernels().downsample_edges != nullptr;
+}
+
+const char* instruction_set()
+{
+	return kernels().instruction_set;
+}
+
+void downsample_edges(const uint8_t *in, uint8_t *out, uint64_t block_count,
+	unsigned int unit_size)
+{
+	assert(available());
+	assert((unit_size > 0) && (unit_size <= 8));
+
+	kernels().downsample_edges(in, out, block_count, unit_size);
+}
+
+void reduce_or(const uint8_t *in, uint8_t *out, uint64_t block_count,
+	unsigned int unit_size)
+{
+	assert(available());
+	assert((unit_size > 0) && (unit_size <= 8));
+
+	kernels().reduce_or(in, out, block_count, unit_size);
+}
+
+void transpose_bits(const uint8_t *in, uint64_t *out, uint64_t word_count,
+	uint64_t stride, unsigned int unit_size)
+{
+	assert((unit_size > 0) && (unit_size <= 8));
+
+	kernels().transpose_bits(in, out, word_count, stride, unit_size);
+}
+
+void gather_bits(const uint8_t *in, uint64_t *out, uint64_t count,
+	const BitGatherMap &map)
+{
+	kernels().gather_bits(in, out, count, map);
+}
+
+} // namespace simd
+} // namespace data
+} // namespace pv
@@ -0,0 +1,129 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_SIMD_HPP
+#define PULSEVIEW_PV_DATA_SIMD_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using std::pair;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+/**
+ * Vectorized kernels for processing logic samples.
+ *
+ * The kernels are selected once at runtime, depending on the instruction
+ * sets that the CPU supports (SSE2 or AVX2 on x86, NEON on ARM). Samples
+ * are handled as plain bytes, so every unit size from 1 to 8 bytes is
+ * supported.
+ */
+namespace simd {
+
+/// Number of samples that are reduced to a single mip-map entry
+static const unsigned int BlockLength = 16;
+
+/// Returns false if the CPU supports none of the instruction sets
+bool available();
+
+/// Returns the name of the instruction set that the kernels use
+const char* instruction_set();
+
+/**
+ * Computes mip-map entries from logic samples. Each entry has a bit set
+ * for every channel that changed within the BlockLength samples it covers,
+ * including the change from the sample preceding the block. Hence, the
+ * sample before @c in must be readable as well.
+ * @param[in] in The samples of @c block_count consecutive blocks.
+ * @param[out] out Receives @c block_count entries of @c unit_size bytes.
+ */
+void downsample_edges(const uint8_t *in, uint8_t *out, uint64_t block_count,
+	unsigned int unit_size);
+
+/**
+ * Computes the entries of a higher mip-map level by or'ing BlockLength
+ * consecutive entries of the level below.
+ */
+void reduce_or(const uint8_t *in, uint8_t *out, uint64_t block_count,
+	unsigned int unit_size);
+
+/// Number of samples of one channel that are gathered into a bit plane word
+static const unsigned int BitPlaneWordLength = 64;
+
+/**
+ * Transposes logic samples into bit planes, so that every word holds
+ * BitPlaneWordLength consecutive samples of one channel with the earliest
+ * sample in the least significant bit. Unlike the other kernels, this one
+ * is always available and falls back to plain C++ if needed.
+ * @param[in] in The samples of @c word_count * BitPlaneWordLength
+ * consecutive samples.
+ * @param[out] out Receives word @c w of channel @c c at
+ * <tt>out[c * stride + w]</tt>.
+ */
+void transpose_bits(const uint8_t *in, uint64_t *out, uint64_t word_count,
+	uint64_t stride, unsigned int unit_size);
+
+/**
+ * Describes how the channels of logic samples are moved to the bits of
+ * other samples, for example to build the samples of a decoder from the
+ * channels assigned to it. It is built once for a mapping and then used
+ * with gather_bits().
+ */
+struct BitGatherMap
+{
+	/**
+	 * @param unit_size The unit size of the input samples.
+	 * @param bits Input channel @c bits[i].first is moved to output bit
+	 * @c bits[i].second.
+	 */
+	BitGatherMap(unsigned int unit_size,
+		const vector< pair<unsigned int, unsigned int> > &bits);
+
+	unsigned int unit_size;
+
+	/// The bytes of an input sample that hold any of the channels, along
+	/// with a table of 256 entries per byte holding the output bits of
+	/// every value that the byte can have
+	vector<unsigned int> bytes;
+	vector<uint64_t> tables;
+
+	/// Set if the channels keep their order in the output, so that they can
+	/// be moved with the masks alone
+	bool ordered;
+	uint64_t in_mask, out_mask;
+};
+
+/**
+ * Ors the bits that @c map gathers from each of @c count input samples
+ * into one word of @c out per sample. PEXT and PDEP are used where the CPU
+ * supports BMI2 and the channels keep their order, lookup tables otherwise.
+ * Like transpose_bits(), this kernel is always available.
+ */
+void gather_bits(const uint8_t *in, uint64_t *out, uint64_t count,
+	const BitGatherMap &map);
+
+} // namespace simd
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_SIMD_HPP
@@ -0,0 +1,118 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <new>
+
+#include <QDebug>
+#include <QDir>
+
+#include "spillfile.hpp"
+
+using std::bad_alloc;
+using std::make_pair;
+
+namespace pv {
+namespace data {
+
+const uint64_t SpillFile::MapAlignment = 64 * 1024;
+
+SpillFile::SpillFile(const QString &directory) :
+	file_(QDir(directory.isEmpty() ? QDir::tempPath() : directory).
+		filePath("pulseview-XXXXXX.spill")),
+	file_size_(0)
+{
+	is_open_ = file_.open();
+
+	if (!is_open_)
+		qWarning() << "Failed to create spill file in" << directory << ":" <<
+			file_.errorString();
+}
+
+SpillFile::~SpillFile()
+{
+	// Closing the file releases all mappings, the file itself is then
+	// removed by QTemporaryFile
+	file_.close();
+}
+
+bool SpillFile::is_open() const
+{
+	return is_open_;
+}
+
+QString SpillFile::file_name() const
+{
+	return file_.fileName();
+}
+
+uint8_t* SpillFile::map_chunk(uint64_t size)
+{
+	assert(is_open_);
+
+	const uint64_t mapped_size =
+		((size + MapAlignment - 1) / MapAlignment) * MapAlignment;
+
+	for (auto it = free_regions_.begin(); it != free_regions_.end(); it++) {
+		if (it->second != mapped_size)
+			continue;
+
+		uchar *const chunk = file_.map(it->first, mapped_size);
+		if (!chunk)
+			throw bad_alloc();
+
+		mapped_regions_[(uint8_t*)chunk] = *it;
+		free_regions_.erase(it);
+
+		return (uint8_t*)chunk;
+	}
+
+	const uint64_t offset = file_size_;
+
+	// Growing the file doesn't allocate any disk space on most file systems
+	// yet, this only happens when the pages are written back
+	if (!file_.resize(offset + mapped_size))
+		throw bad_alloc();
+
+	uchar *const chunk = file_.map(offset, mapped_size);
+	if (!chunk) {
+		file_.resize(offset);
+		throw bad_alloc();
+	}
+
+	file_size_ += mapped_size;
+	mapped_regions_[(uint8_t*)chunk] = make_pair(offset, mapped_size);
+
+	return (uint8_t*)chunk;
+}
+
+void SpillFile::unmap_chunk(uint8_t *chunk)
+{
+	file_.unmap((uchar*)chunk);
+
+	auto it = mapped_regions_.find(chunk);
+	if (it == mapped_regions_.end())
+		return;
+
+	free_regions_.push_back(it->second);
+	mapped_regions_.erase(it);
+}
+
+} // namespace data
+} // namespace pv
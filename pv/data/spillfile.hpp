@@ -0,0 +1,85 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_SPILLFILE_HPP
+#define PULSEVIEW_PV_DATA_SPILLFILE_HPP
+
+#include <cstdint>
+#include <deque>
+#include <map>
+
+#include <QString>
+#include <QTemporaryFile>
+
+using std::deque;
+using std::map;
+using std::pair;
+
+namespace pv {
+namespace data {
+
+/**
+ * A temporary file that backs the sample data chunks of a segment.
+ *
+ * Every chunk is a separate memory mapping of a region of the file, so
+ * the chunks can be used just like heap memory while the OS is free to
+ * write cold pages back to disk and evict them from RAM. This allows for
+ * captures that are larger than the physical memory.
+ * Regions of unmapped chunks are reused for new chunks of the same size,
+ * so the file doesn't grow if chunks are continuously replaced.
+ * The file is removed when the SpillFile instance is destroyed.
+ */
+class SpillFile
+{
+private:
+	/// Mapped regions must start at a multiple of the OS allocation
+	/// granularity, which is 64 KiB on Windows and a page elsewhere
+	static const uint64_t MapAlignment;
+
+public:
+	SpillFile(const QString &directory);
+	~SpillFile();
+
+	bool is_open() const;
+	QString file_name() const;
+
+	/**
+	 * Maps a region of at least @c size bytes, growing the file if no
+	 * unused region of that size is available.
+	 * Throws std::bad_alloc if the file can't be grown or mapped, so that
+	 * callers can treat a full disk the same way as an exhausted heap.
+	 */
+	uint8_t* map_chunk(uint64_t size);
+
+	void unmap_chunk(uint8_t *chunk);
+
+private:
+	QTemporaryFile file_;
+	uint64_t file_size_;
+	bool is_open_;
+
+	/// Offset and size of every mapped region by its address
+	map< uint8_t*, pair<uint64_t, uint64_t> > mapped_regions_;
+	deque< pair<uint64_t, uint64_t> > free_regions_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_SPILLFILE_HPP
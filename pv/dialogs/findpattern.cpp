@@ -0,0 +1,480 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "findpattern.hpp"
+
+#include <pv/data/logic.hpp>
+#include <pv/data/logicsegment.hpp>
+#include <pv/data/patternsearch.hpp>
+#include <pv/data/pulsesearch.hpp>
+#include <pv/data/signalbase.hpp>
+#include <pv/session.hpp>
+#include <pv/views/trace/view.hpp>
+
+using std::deque;
+using std::dynamic_pointer_cast;
+using std::lock_guard;
+using std::make_shared;
+using std::max;
+using std::min;
+using std::numeric_limits;
+
+using pv::data::LogicSearch;
+using pv::data::LogicSegment;
+using pv::data::PatternSearch;
+using pv::data::PulseSearch;
+using pv::data::SignalBase;
+using pv::util::SIPrefix;
+using pv::util::Timestamp;
+
+namespace pv {
+namespace dialogs {
+
+const int FindPattern::MaxMarkers = 1000;
+
+FindPattern::FindPattern(Session &session, views::trace::View &view,
+	QWidget *parent) :
+	QDialog(parent),
+	session_(session),
+	view_(view),
+	layout_(this),
+	tabs_(this),
+	form_(this),
+	form_layout_(&form_),
+	pulse_form_(this),
+	pulse_form_layout_(&pulse_form_),
+	pulse_max_width_label_(tr("and")),
+	button_box_(QDialogButtonBox::Close, Qt::Horizontal, this),
+	search_running_(false),
+	direction_(Next),
+	have_position_(false),
+	position_(0),
+	match_length_(1),
+	match_count_(0)
+{
+	setWindowTitle(tr("Find Pattern"));
+
+	// Only the channels of the device are offered, they share their data
+	for (const shared_ptr<SignalBase>& signal : session_.signalbases()) {
+		if ((signal->type() != SignalBase::LogicChannel) || signal->is_generated())
+			continue;
+
+		QComboBox *const condition = new QComboBox(&form_);
+		condition->addItem(tr("Don't care"), PatternSearch::DontCare);
+		condition->addItem(tr("Low"), PatternSearch::Low);
+		condition->addItem(tr("High"), PatternSearch::High);
+		condition->addItem(tr("Rising edge"), PatternSearch::Rising);
+		condition->addItem(tr("Falling edge"), PatternSearch::Falling);
+		condition->addItem(tr("Any edge"), PatternSearch::AnyEdge);
+		connect(condition, SIGNAL(currentIndexChanged(int)),
+			this, SLOT(on_condition_changed()));
+
+		form_layout_.addRow(signal->name(), condition);
+		conditions_.emplace_back(signal, condition);
+
+		pulse_channel_.addItem(signal->name(), signal->logic_bit_index());
+	}
+
+	min_duration_.setRange(0, numeric_limits<int>::max());
+	min_duration_.setSuffix(tr(" samples"));
+	min_duration_.setSpecialValueText(tr("Any"));
+	connect(&min_duration_, SIGNAL(valueChanged(int)),
+		this, SLOT(on_condition_changed()));
+	form_layout_.addRow(tr("Levels held for at least"), &min_duration_);
+
+	pulse_polarity_.addItem(tr("High pulses"), PulseSearch::HighPulses);
+	pulse_polarity_.addItem(tr("Low pulses"), PulseSearch::LowPulses);
+	pulse_polarity_.addItem(tr("High and low pulses"), PulseSearch::AllPulses);
+
+	pulse_condition_.addItem(tr("Shorter than"), ShorterThan);
+	pulse_condition_.addItem(tr("Longer than"), LongerThan);
+	pulse_condition_.addItem(tr("Between"), Between);
+
+	pulse_width_.setValue(Timestamp(1) / 1000000);
+	pulse_max_width_.setValue(Timestamp(1) / 100000);
+
+	connect(&pulse_channel_, SIGNAL(currentIndexChanged(int)),
+		this, SLOT(on_condition_changed()));
+	connect(&pulse_polarity_, SIGNAL(currentIndexChanged(int)),
+		this, SLOT(on_condition_changed()));
+	connect(&pulse_condition_, SIGNAL(currentIndexChanged(int)),
+		this, SLOT(on_pulse_condition_changed()));
+	connect(&pulse_width_, SIGNAL(valueChanged(const pv::util::Timestamp&)),
+		this, SLOT(on_condition_changed()));
+	connect(&pulse_max_width_, SIGNAL(valueChanged(const pv::util::Timestamp&)),
+		this, SLOT(on_condition_changed()));
+
+	pulse_form_layout_.addRow(tr("Channel"), &pulse_channel_);
+	pulse_form_layout_.addRow(tr("Find"), &pulse_polarity_);
+	pulse_form_layout_.addRow(&pulse_condition_, &pulse_width_);
+	pulse_form_layout_.addRow(&pulse_max_width_label_, &pulse_max_width_);
+	on_pulse_condition_changed();
+
+	tabs_.addTab(&form_, tr("Pattern"));
+	tabs_.addTab(&pulse_form_, tr("Pulse Width"));
+	connect(&tabs_, SIGNAL(currentChanged(int)), this, SLOT(on_condition_changed()));
+
+	find_previous_button_ = button_box_.addButton(tr("Find &Previous"),
+		QDialogButtonBox::ActionRole);
+	find_next_button_ = button_box_.addButton(tr("Find &Next"),
+		QDialogButtonBox::ActionRole);
+	find_all_button_ = button_box_.addButton(tr("Find &All"),
+		QDialogButtonBox::ActionRole);
+	find_next_button_->setDefault(true);
+
+	connect(find_previous_button_, SIGNAL(clicked()), this, SLOT(on_find_previous()));
+	connect(find_next_button_, SIGNAL(clicked()), this, SLOT(on_find_next()));
+	connect(find_all_button_, SIGNAL(clicked()), this, SLOT(on_find_all()));
+	connect(&button_box_, SIGNAL(rejected()), this, SLOT(reject()));
+
+	// Emitted by the search thread
+	connect(this, SIGNAL(matches_found()), this, SLOT(on_matches_found()));
+	connect(this, SIGNAL(search_finished()), this, SLOT(on_search_finished()));
+
+	layout_.addWidget(&tabs_);
+	layout_.addWidget(&status_);
+	layout_.addWidget(&button_box_);
+}
+
+FindPattern::~FindPattern()
+{
+	stop_search();
+}
+
+void FindPattern::reject()
+{
+	stop_search();
+	QDialog::reject();
+}
+
+shared_ptr<LogicSearch> FindPattern::create_search()
+{
+	if (tabs_.currentWidget() == &pulse_form_)
+		return create_pulse_search();
+
+	return create_pattern_search();
+}
+
+shared_ptr<LogicSearch> FindPattern::create_pattern_search()
+{
+	const shared_ptr<PatternSearch> search = make_shared<PatternSearch>(segment_);
+	for (const auto& entry : conditions_)
+		search->set_condition(entry.first->logic_bit_index(),
+			(PatternSearch::Condition)entry.second->currentData().toInt());
+	search->set_min_duration(min_duration_.value());
+
+	if (search->is_empty()) {
+		status_.setText(tr("Choose a condition for at least one channel."));
+		return nullptr;
+	}
+
+	return search;
+}
+
+shared_ptr<LogicSearch> FindPattern::create_pulse_search()
+{
+	if (pulse_channel_.currentIndex() < 0) {
+		status_.setText(tr("There is no logic channel to search."));
+		return nullptr;
+	}
+
+	const shared_ptr<PulseSearch> search = make_shared<PulseSearch>(segment_,
+		pulse_channel_.currentData().toInt());
+	search->set_polarity((PulseSearch::Polarity)pulse_polarity_.currentData().toInt());
+
+	double samplerate = segment_->samplerate();
+	if (samplerate == 0.0)
+		samplerate = 1.0;
+
+	// The widths are limited so that they can be converted to sample counts
+	const double max_samples = 1e18;
+	const double width = min(max_samples,
+		pulse_width_.value().convert_to<double>() * samplerate);
+	const double max_width = min(max_samples,
+		pulse_max_width_.value().convert_to<double>() * samplerate);
+
+	switch (pulse_condition_.currentData().toInt()) {
+	case ShorterThan:
+		search->set_width_range(1, (uint64_t)max(ceil(width), 1.0) - 1);
+		break;
+	case LongerThan:
+		search->set_width_range((uint64_t)floor(width) + 1,
+			numeric_limits<uint64_t>::max());
+		break;
+	default:
+		search->set_width_range((uint64_t)ceil(width), (uint64_t)floor(max_width));
+		break;
+	}
+
+	if (search->is_empty()) {
+		status_.setText(tr("No pulse width lies in that range at the current sample rate."));
+		return nullptr;
+	}
+
+	return search;
+}
+
+void FindPattern::start_search(Direction direction)
+{
+	stop_search();
+
+	segment_ = get_segment();
+	if (!segment_ || (segment_->get_sample_count() == 0)) {
+		status_.setText(tr("There is no logic data to search."));
+		return;
+	}
+
+	search_ = create_search();
+	if (!search_)
+		return;
+
+	// Continue at the last match, or at the left edge of the view
+	uint64_t start = 0;
+	if (have_position_) {
+		start = (direction == Previous) ? position_ : position_ + 1;
+	} else {
+		double samplerate = segment_->samplerate();
+		if (samplerate == 0.0)
+			samplerate = 1.0;
+
+		const Timestamp offset = (view_.offset() - segment_->start_time()) * samplerate;
+		if (offset > 0)
+			start = offset.convert_to<uint64_t>();
+	}
+
+	direction_ = direction;
+	pending_matches_.clear();
+
+	if (direction == All) {
+		clear_markers();
+		match_count_ = 0;
+	}
+
+	status_.setText(tr("Searching..."));
+	search_running_ = true;
+
+	const shared_ptr<LogicSearch> search = search_;
+	search_thread_ = std::thread([this, search, direction, start]() {
+		uint64_t match;
+
+		if (direction == All) {
+			search->find_all(0, numeric_limits<uint64_t>::max(),
+				[this](const vector<uint64_t> &matches, uint64_t) {
+					if (!matches.empty()) {
+						{
+							lock_guard<mutex> lock(pending_mutex_);
+							pending_matches_.insert(pending_matches_.end(),
+								matches.begin(), matches.end());
+						}
+						matches_found();
+					}
+					return true;
+				});
+		} else if ((direction == Next) ? search->find_next(start, match) :
+			search->find_previous(start, match)) {
+			match_length_ = search->get_match_length(match);
+
+			lock_guard<mutex> lock(pending_mutex_);
+			pending_matches_.push_back(match);
+		}
+
+		search_running_ = false;
+		search_finished();
+	});
+}
+
+void FindPattern::stop_search()
+{
+	if (search_)
+		search_->cancel();
+
+	if (search_thread_.joinable())
+		search_thread_.join();
+
+	search_.reset();
+	search_running_ = false;
+}
+
+shared_ptr<LogicSegment> FindPattern::get_segment() const
+{
+	for (const shared_ptr<SignalBase>& signal : session_.signalbases()) {
+		if ((signal->type() != SignalBase::LogicChannel) || signal->is_generated())
+			continue;
+
+		const shared_ptr<data::Logic> logic = signal->logic_data();
+		if (!logic)
+			continue;
+
+		const deque< shared_ptr<LogicSegment> > &segments = logic->logic_segments();
+		const uint32_t segment_id = view_.current_segment();
+		if (segment_id < segments.size())
+			return segments[segment_id];
+	}
+
+	return nullptr;
+}
+
+Timestamp FindPattern::get_sample_time(uint64_t sample) const
+{
+	double samplerate = segment_->samplerate();
+	if (samplerate == 0.0)
+		samplerate = 1.0;
+
+	return segment_->start_time() + Timestamp(sample) / samplerate;
+}
+
+QString FindPattern::format_width(uint64_t samples) const
+{
+	const double samplerate = segment_->samplerate();
+	if (samplerate == 0.0)
+		return tr("%1 samples").arg(samples);
+
+	return pv::util::format_time_si(Timestamp(samples) / samplerate,
+		SIPrefix::unspecified, 3, "s", false);
+}
+
+void FindPattern::clear_markers()
+{
+	for (const shared_ptr<views::trace::Flag>& marker : markers_)
+		view_.remove_flag(marker);
+
+	markers_.clear();
+}
+
+void FindPattern::add_marker(uint64_t sample)
+{
+	markers_.push_back(view_.add_flag(get_sample_time(sample)));
+}
+
+void FindPattern::on_find_previous()
+{
+	start_search(Previous);
+}
+
+void FindPattern::on_find_next()
+{
+	start_search(Next);
+}
+
+void FindPattern::on_find_all()
+{
+	start_search(All);
+}
+
+void FindPattern::on_matches_found()
+{
+	// Find Previous and Find Next take their match once they're finished
+	if (direction_ != All)
+		return;
+
+	vector<uint64_t> matches;
+	{
+		lock_guard<mutex> lock(pending_mutex_);
+		matches.swap(pending_matches_);
+	}
+
+	for (uint64_t match : matches) {
+		if ((int)markers_.size() >= MaxMarkers)
+			break;
+		add_marker(match);
+	}
+
+	match_count_ += matches.size();
+	status_.setText(tr("%1 matches found so far...").arg(match_count_));
+}
+
+void FindPattern::on_search_finished()
+{
+	// The signal may belong to a search that was replaced by a new one
+	if (!search_ || search_running_)
+		return;
+
+	search_thread_.join();
+	const shared_ptr<PulseSearch> pulse_search =
+		dynamic_pointer_cast<PulseSearch>(search_);
+	search_.reset();
+
+	if (direction_ == All) {
+		on_matches_found();
+
+		QString text;
+		if (match_count_ == 0)
+			text = tr("No match found.");
+		else if (match_count_ > (uint64_t)MaxMarkers)
+			text = tr("%1 matches found, markers were added for the first %2.")
+				.arg(match_count_).arg(MaxMarkers);
+		else
+			text = tr("%1 matches found.").arg(match_count_);
+
+		if (pulse_search && (match_count_ > 0))
+			text += "\n" + tr("The pulses are %1 to %2 wide.")
+				.arg(format_width(pulse_search->narrowest_match()))
+				.arg(format_width(pulse_search->widest_match()));
+
+		status_.setText(text);
+		return;
+	}
+
+	vector<uint64_t> matches;
+	{
+		lock_guard<mutex> lock(pending_mutex_);
+		matches.swap(pending_matches_);
+	}
+
+	if (matches.empty()) {
+		status_.setText(tr("No match found."));
+		return;
+	}
+
+	position_ = matches.front();
+	have_position_ = true;
+
+	clear_markers();
+	add_marker(position_);
+	view_.focus_on_range(position_, position_ + match_length_);
+
+	if (pulse_search)
+		status_.setText(tr("Pulse at sample %1, %2 wide.").arg(position_)
+			.arg(format_width(match_length_)));
+	else
+		status_.setText(tr("Match at sample %1.").arg(position_));
+}
+
+void FindPattern::on_condition_changed()
+{
+	// A new pattern is searched from the view again
+	have_position_ = false;
+}
+
+void FindPattern::on_pulse_condition_changed()
+{
+	const bool between = (pulse_condition_.currentData().toInt() == Between);
+	pulse_max_width_label_.setEnabled(between);
+	pulse_max_width_.setEnabled(between);
+
+	on_condition_changed();
+}
+
+} // namespace dialogs
+} // namespace pv
@@ -0,0 +1,183 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DIALOGS_FINDPATTERN_HPP
+#define PULSEVIEW_PV_DIALOGS_FINDPATTERN_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QComboBox>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTabWidget>
+#include <QVBoxLayout>
+
+#include <pv/util.hpp>
+#include <pv/widgets/timestampspinbox.hpp>
+
+using std::atomic;
+using std::mutex;
+using std::pair;
+using std::shared_ptr;
+using std::vector;
+
+namespace pv {
+
+class Session;
+
+namespace data {
+class LogicSearch;
+class LogicSegment;
+class SignalBase;
+}
+
+namespace views {
+namespace trace {
+class Flag;
+class View;
+}
+}
+
+namespace dialogs {
+
+/**
+ * Searches the logic channels of the current segment for a pattern, or one
+ * channel for pulses of a certain width, and shows the matches as markers
+ * in the trace view.
+ */
+class FindPattern : public QDialog
+{
+	Q_OBJECT
+
+public:
+	/// Find All stops adding markers beyond this number of matches
+	static const int MaxMarkers;
+
+public:
+	FindPattern(Session &session, views::trace::View &view,
+		QWidget *parent = nullptr);
+
+	virtual ~FindPattern();
+
+private:
+	enum Direction {
+		Previous,
+		Next,
+		All
+	};
+
+	enum PulseCondition {
+		ShorterThan,
+		LongerThan,
+		Between
+	};
+
+	/// Creates the search for the current tab, or reports why it can't
+	shared_ptr<data::LogicSearch> create_search();
+	shared_ptr<data::LogicSearch> create_pattern_search();
+	shared_ptr<data::LogicSearch> create_pulse_search();
+
+	void start_search(Direction direction);
+	void stop_search();
+
+	shared_ptr<data::LogicSegment> get_segment() const;
+
+	pv::util::Timestamp get_sample_time(uint64_t sample) const;
+
+	QString format_width(uint64_t samples) const;
+
+	void clear_markers();
+	void add_marker(uint64_t sample);
+
+Q_SIGNALS:
+	void matches_found();
+	void search_finished();
+
+public Q_SLOTS:
+	void reject();
+
+private Q_SLOTS:
+	void on_find_previous();
+	void on_find_next();
+	void on_find_all();
+	void on_matches_found();
+	void on_search_finished();
+	void on_condition_changed();
+	void on_pulse_condition_changed();
+
+private:
+	Session &session_;
+	views::trace::View &view_;
+
+	QVBoxLayout layout_;
+	QTabWidget tabs_;
+
+	QWidget form_;
+	QFormLayout form_layout_;
+	vector< pair<shared_ptr<data::SignalBase>, QComboBox*> > conditions_;
+	QSpinBox min_duration_;
+
+	QWidget pulse_form_;
+	QFormLayout pulse_form_layout_;
+	QComboBox pulse_channel_;
+	QComboBox pulse_polarity_;
+	QComboBox pulse_condition_;
+	widgets::TimestampSpinBox pulse_width_;
+	QLabel pulse_max_width_label_;
+	widgets::TimestampSpinBox pulse_max_width_;
+
+	QLabel status_;
+	QDialogButtonBox button_box_;
+	QPushButton *find_previous_button_;
+	QPushButton *find_next_button_;
+	QPushButton *find_all_button_;
+
+	shared_ptr<data::LogicSegment> segment_;
+	shared_ptr<data::LogicSearch> search_;
+	std::thread search_thread_;
+	atomic<bool> search_running_;
+	Direction direction_;
+
+	/// Matches the search thread found but that weren't shown yet
+	mutex pending_mutex_;
+	vector<uint64_t> pending_matches_;
+
+	/// The match that Find Previous and Find Next continue from
+	bool have_position_;
+	uint64_t position_;
+	/// The number of samples the match found by Find Previous or Find Next
+	/// spans
+	uint64_t match_length_;
+
+	uint64_t match_count_;
+	vector< shared_ptr<views::trace::Flag> > markers_;
+};
+
+} // namespace dialogs
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DIALOGS_FINDPATTERN_HPP
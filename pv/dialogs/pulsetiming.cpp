@@ -0,0 +1,286 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <deque>
+
+#include "pulsetiming.hpp"
+
+#include <pv/data/logic.hpp>
+#include <pv/data/logicsegment.hpp>
+#include <pv/data/pulsehistogram.hpp>
+#include <pv/data/signalbase.hpp>
+#include <pv/session.hpp>
+#include <pv/views/trace/cursor.hpp>
+#include <pv/views/trace/view.hpp>
+
+using std::deque;
+using std::make_shared;
+using std::max;
+using std::min;
+using std::swap;
+
+using pv::data::LogicSegment;
+using pv::data::PulseHistogram;
+using pv::data::SignalBase;
+using pv::util::SIPrefix;
+using pv::util::Timestamp;
+
+namespace pv {
+namespace dialogs {
+
+const unsigned int PulseTiming::MaxBinCount = 200;
+
+PulseTiming::PulseTiming(Session &session, views::trace::View &view,
+	QWidget *parent) :
+	QDialog(parent),
+	session_(session),
+	view_(view),
+	layout_(this),
+	form_(this),
+	form_layout_(&form_),
+	histogram_view_(this),
+	stats_(this),
+	stats_layout_(&stats_),
+	button_box_(QDialogButtonBox::Close, Qt::Horizontal, this),
+	computing_(false),
+	have_results_(false)
+{
+	setWindowTitle(tr("Pulse Timing"));
+
+	// Only the channels of the device are offered, they share their data
+	for (const shared_ptr<SignalBase>& signal : session_.signalbases())
+		if ((signal->type() == SignalBase::LogicChannel) && !signal->is_generated())
+			channel_.addItem(signal->name(), signal->logic_bit_index());
+
+	range_.addItem(tr("Whole segment"), WholeSegment);
+	range_.addItem(tr("Between cursors"), BetweenCursors);
+
+	measurement_.addItem(tr("High time"), PulseHistogram::HighTime);
+	measurement_.addItem(tr("Low time"), PulseHistogram::LowTime);
+	measurement_.addItem(tr("Period"), PulseHistogram::Period);
+	measurement_.addItem(tr("Edge to edge"), PulseHistogram::EdgeInterval);
+	connect(&measurement_, SIGNAL(currentIndexChanged(int)),
+		this, SLOT(on_measurement_changed()));
+
+	form_layout_.addRow(tr("Channel"), &channel_);
+	form_layout_.addRow(tr("Range"), &range_);
+	form_layout_.addRow(tr("Measure"), &measurement_);
+
+	stats_layout_.addRow(tr("Count"), &count_);
+	stats_layout_.addRow(tr("Minimum"), &min_width_);
+	stats_layout_.addRow(tr("Maximum"), &max_width_);
+	stats_layout_.addRow(tr("Mean"), &mean_);
+	stats_layout_.addRow(tr("Standard deviation"), &std_dev_);
+	stats_layout_.addRow(tr("Mean frequency"), &frequency_);
+	stats_layout_.addRow(tr("Duty cycle"), &duty_cycle_);
+
+	compute_button_ = button_box_.addButton(tr("&Compute"),
+		QDialogButtonBox::ActionRole);
+	compute_button_->setDefault(true);
+
+	connect(compute_button_, SIGNAL(clicked()), this, SLOT(on_compute()));
+	connect(&button_box_, SIGNAL(rejected()), this, SLOT(reject()));
+
+	// Emitted by the computation thread
+	connect(this, SIGNAL(computation_finished()),
+		this, SLOT(on_computation_finished()));
+
+	layout_.addWidget(&form_);
+	layout_.addWidget(&histogram_view_);
+	layout_.addWidget(&stats_);
+	layout_.addWidget(&status_);
+	layout_.addWidget(&button_box_);
+
+	show_results();
+}
+
+PulseTiming::~PulseTiming()
+{
+	stop_computation();
+}
+
+void PulseTiming::reject()
+{
+	stop_computation();
+	QDialog::reject();
+}
+
+void PulseTiming::start_computation()
+{
+	stop_computation();
+	have_results_ = false;
+	show_results();
+
+	segment_ = get_segment();
+	if (!segment_ || (segment_->get_sample_count() == 0)) {
+		status_.setText(tr("There is no logic data to measure."));
+		return;
+	}
+
+	if (channel_.currentIndex() < 0) {
+		status_.setText(tr("There is no logic channel to measure."));
+		return;
+	}
+
+	uint64_t start = 0, end = segment_->get_sample_count();
+	if (range_.currentData().toInt() == BetweenCursors) {
+		if (!view_.cursors_shown()) {
+			status_.setText(tr("Show the cursors to measure between them."));
+			return;
+		}
+
+		start = get_sample(view_.cursors()->first()->time());
+		end = get_sample(view_.cursors()->second()->time());
+		if (start > end)
+			swap(start, end);
+	}
+
+	histogram_ = make_shared<PulseHistogram>(segment_, channel_.currentData().toInt());
+
+	status_.setText(tr("Measuring..."));
+	computing_ = true;
+
+	const shared_ptr<PulseHistogram> histogram = histogram_;
+	thread_ = std::thread([this, histogram, start, end]() {
+		histogram->compute(start, end);
+		computing_ = false;
+		computation_finished();
+	});
+}
+
+void PulseTiming::stop_computation()
+{
+	if (histogram_)
+		histogram_->cancel();
+
+	if (thread_.joinable())
+		thread_.join();
+
+	computing_ = false;
+}
+
+shared_ptr<LogicSegment> PulseTiming::get_segment() const
+{
+	for (const shared_ptr<SignalBase>& signal : session_.signalbases()) {
+		if ((signal->type() != SignalBase::LogicChannel) || signal->is_generated())
+			continue;
+
+		const shared_ptr<data::Logic> logic = signal->logic_data();
+		if (!logic)
+			continue;
+
+		const deque< shared_ptr<LogicSegment> > &segments = logic->logic_segments();
+		const uint32_t segment_id = view_.current_segment();
+		if (segment_id < segments.size())
+			return segments[segment_id];
+	}
+
+	return nullptr;
+}
+
+uint64_t PulseTiming::get_sample(const Timestamp &time) const
+{
+	double samplerate = segment_->samplerate();
+	if (samplerate == 0.0)
+		samplerate = 1.0;
+
+	const Timestamp sample = (time - segment_->start_time()) * samplerate;
+	return (sample > 0) ? sample.convert_to<uint64_t>() : 0;
+}
+
+QString PulseTiming::format_width(double samples) const
+{
+	const double samplerate = segment_->samplerate();
+	if (samplerate == 0.0)
+		return tr("%1 samples").arg(samples);
+
+	return pv::util::format_time_si(Timestamp(samples / samplerate),
+		SIPrefix::unspecified, 4, "s", false);
+}
+
+void PulseTiming::show_results()
+{
+	for (QLabel *label : {&count_, &min_width_, &max_width_, &mean_, &std_dev_,
+		&frequency_, &duty_cycle_})
+		label->setText(tr("-"));
+
+	if (!have_results_ || !histogram_) {
+		histogram_view_.clear();
+		return;
+	}
+
+	const PulseHistogram::Histogram &h = histogram_->histogram(
+		(PulseHistogram::Measurement)measurement_.currentData().toInt());
+
+	count_.setText(QString::number(h.count()));
+	if (h.count() == 0) {
+		histogram_view_.clear();
+	} else {
+		const uint64_t first = h.min_width(), last = h.max_width();
+		const unsigned int bin_count = min<uint64_t>(MaxBinCount, last - first + 1);
+
+		histogram_view_.set_bins(h.get_bins(first, last, bin_count),
+			format_width(first), format_width(last));
+
+		min_width_.setText(format_width(first));
+		max_width_.setText(format_width(last));
+		mean_.setText(format_width(h.mean()));
+		std_dev_.setText(format_width(h.std_dev()));
+	}
+
+	const PulseHistogram::Histogram &period =
+		histogram_->histogram(PulseHistogram::Period);
+	if ((period.count() > 0) && (segment_->samplerate() != 0.0))
+		frequency_.setText(pv::util::format_value_si(
+			segment_->samplerate() / period.mean(), SIPrefix::unspecified, 4,
+			"Hz", false));
+
+	const double high = histogram_->histogram(PulseHistogram::HighTime).mean();
+	const double low = histogram_->histogram(PulseHistogram::LowTime).mean();
+	if ((high > 0) && (low > 0))
+		duty_cycle_.setText(QString("%1 %").arg(100 * high / (high + low), 0, 'f', 2));
+}
+
+void PulseTiming::on_compute()
+{
+	start_computation();
+}
+
+void PulseTiming::on_computation_finished()
+{
+	// The signal may belong to a computation that was replaced by a new one
+	if (!histogram_ || computing_ || !thread_.joinable())
+		return;
+
+	thread_.join();
+
+	have_results_ = true;
+	show_results();
+	status_.setText(tr("Measured %1 pulses.").arg(
+		histogram_->histogram(PulseHistogram::EdgeInterval).count()));
+}
+
+void PulseTiming::on_measurement_changed()
+{
+	show_results();
+}
+
+} // namespace dialogs
+} // namespace pv
@@ -0,0 +1,137 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DIALOGS_PULSETIMING_HPP
+#define PULSEVIEW_PV_DIALOGS_PULSETIMING_HPP
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include <QComboBox>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+#include <pv/util.hpp>
+#include <pv/widgets/histogramview.hpp>
+
+using std::atomic;
+using std::shared_ptr;
+
+namespace pv {
+
+class Session;
+
+namespace data {
+class LogicSegment;
+class PulseHistogram;
+}
+
+namespace views {
+namespace trace {
+class View;
+}
+}
+
+namespace dialogs {
+
+/**
+ * Shows histograms of the high times, low times, periods and edge-to-edge
+ * intervals of a logic channel, measured over the current segment or the
+ * range between the cursors.
+ */
+class PulseTiming : public QDialog
+{
+	Q_OBJECT
+
+public:
+	/// The histogram is shown with at most this many bins
+	static const unsigned int MaxBinCount;
+
+public:
+	PulseTiming(Session &session, views::trace::View &view,
+		QWidget *parent = nullptr);
+
+	virtual ~PulseTiming();
+
+private:
+	enum Range {
+		WholeSegment,
+		BetweenCursors
+	};
+
+	void start_computation();
+	void stop_computation();
+
+	shared_ptr<data::LogicSegment> get_segment() const;
+
+	/// Converts a time of the view to a sample of segment_
+	uint64_t get_sample(const pv::util::Timestamp &time) const;
+
+	QString format_width(double samples) const;
+
+	void show_results();
+
+Q_SIGNALS:
+	void computation_finished();
+
+public Q_SLOTS:
+	void reject();
+
+private Q_SLOTS:
+	void on_compute();
+	void on_computation_finished();
+	void on_measurement_changed();
+
+private:
+	Session &session_;
+	views::trace::View &view_;
+
+	QVBoxLayout layout_;
+	QWidget form_;
+	QFormLayout form_layout_;
+	QComboBox channel_;
+	QComboBox range_;
+	QComboBox measurement_;
+	widgets::HistogramView histogram_view_;
+	QWidget stats_;
+	QFormLayout stats_layout_;
+	QLabel count_, min_width_, max_width_, mean_, std_dev_, frequency_,
+		duty_cycle_;
+	QLabel status_;
+	QDialogButtonBox button_box_;
+	QPushButton *compute_button_;
+
+	shared_ptr<data::LogicSegment> segment_;
+	shared_ptr<data::PulseHistogram> histogram_;
+	std::thread thread_;
+	atomic<bool> computing_;
+
+	/// Set if histogram_ holds complete results
+	bool have_results_;
+};
+
+} // namespace dialogs
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DIALOGS_PULSETIMING_HPP
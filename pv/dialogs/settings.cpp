@@ -24,6 +24,7 @@
 #include <QApplication>
 #include <QComboBox>
 #include <QDialogButtonBox>
+#include <QDir>
 #include <QFileDialog>
 #include <QFormLayout>
 #include <QGroupBox>
@@ -285,6 +286,89 @@ QWidget *Settings::get_general_settings_form(QWidget *parent) const
 		SLOT(on_general_start_all_sessions_changed(int)));
 	general_layout->addRow(tr("Start acquisition for all open sessions when clicking 'Run'"), cb);
 
+	// Acquisition settings
+	QGroupBox *acq_group = new QGroupBox(tr("Acquisition"));
+	form_layout->addWidget(acq_group);
+
+	QFormLayout *acq_layout = new QFormLayout();
+	acq_group->setLayout(acq_layout);
+
+	cb = create_checkbox(GlobalSettings::Key_Acq_UseDiskStorage,
+		SLOT(on_acq_useDiskStorage_changed(int)));
+	acq_layout->addRow(tr("Store sample data in memory-mapped files on &disk"), cb);
+
+	QLineEdit *disk_storage_dir_le = new QLineEdit();
+	disk_storage_dir_le->setText(
+		settings.value(GlobalSettings::Key_Acq_DiskStorageDir).toString());
+	disk_storage_dir_le->setPlaceholderText(QDir::tempPath());
+	connect(disk_storage_dir_le, SIGNAL(textChanged(const QString&)),
+		this, SLOT(on_acq_diskStorageDir_changed(const QString&)));
+	acq_layout->addRow(tr("Directory for sample data files"), disk_storage_dir_le);
+
+	QLabel *description_3 = new QLabel(tr("(Allows for captures larger than RAM, takes effect on the next acquisition)"));
+	description_3->setAlignment(Qt::AlignRight);
+	acq_layout->addRow(description_3);
+
+	QSpinBox *memory_ceiling_sb = new QSpinBox();
+	memory_ceiling_sb->setRange(0, 1024 * 1024);
+	memory_ceiling_sb->setSingleStep(256);
+	memory_ceiling_sb->setSuffix(tr(" MiB"));
+	memory_ceiling_sb->setSpecialValueText(tr("No limit"));
+	memory_ceiling_sb->setValue(
+		settings.value(GlobalSettings::Key_Acq_MemoryCeiling).toInt());
+	connect(memory_ceiling_sb, SIGNAL(valueChanged(int)), this,
+		SLOT(on_acq_memoryCeiling_changed(int)));
+	acq_layout->addRow(tr("Stop acquisition when sample data exceeds"), memory_ceiling_sb);
+
+	QSpinBox *memory_budget_sb = new QSpinBox();
+	memory_budget_sb->setRange(0, 1024 * 1024);
+	memory_budget_sb->setSingleStep(256);
+	memory_budget_sb->setSuffix(tr(" MiB"));
+	memory_budget_sb->setSpecialValueText(tr("No limit"));
+	memory_budget_sb->setValue(
+		settings.value(GlobalSettings::Key_Acq_MemoryBudget).toInt());
+	connect(memory_budget_sb, SIGNAL(valueChanged(int)), this,
+		SLOT(on_acq_memoryBudget_changed(int)));
+	acq_layout->addRow(tr("Free regenerable data when memory use exceeds"), memory_budget_sb);
+
+	QLabel *description_4 = new QLabel(tr("(Mip-maps, decoder input and converted signals of hidden channels are recreated when needed)"));
+	description_4->setAlignment(Qt::AlignRight);
+	acq_layout->addRow(description_4);
+
+	QSpinBox *ring_buffer_time_sb = new QSpinBox();
+	ring_buffer_time_sb->setRange(0, 7 * 24 * 3600);
+	ring_buffer_time_sb->setSingleStep(10);
+	ring_buffer_time_sb->setSuffix(tr(" s"));
+	ring_buffer_time_sb->setSpecialValueText(tr("No limit"));
+	ring_buffer_time_sb->setValue(
+		settings.value(GlobalSettings::Key_Acq_RingBufferTime).toInt());
+	connect(ring_buffer_time_sb, SIGNAL(valueChanged(int)), this,
+		SLOT(on_acq_ringBufferTime_changed(int)));
+	acq_layout->addRow(tr("Only keep the most recent samples of"), ring_buffer_time_sb);
+
+	QSpinBox *ring_buffer_size_sb = new QSpinBox();
+	ring_buffer_size_sb->setRange(0, 1024 * 1024);
+	ring_buffer_size_sb->setSingleStep(256);
+	ring_buffer_size_sb->setSuffix(tr(" MiB"));
+	ring_buffer_size_sb->setSpecialValueText(tr("No limit"));
+	ring_buffer_size_sb->setValue(
+		settings.value(GlobalSettings::Key_Acq_RingBufferSize).toInt());
+	connect(ring_buffer_size_sb, SIGNAL(valueChanged(int)), this,
+		SLOT(on_acq_ringBufferSize_changed(int)));
+	acq_layout->addRow(tr("Only keep the most recent sample data of"), ring_buffer_size_sb);
+
+	QLabel *description_5 = new QLabel(tr("(Per segment and channel, for long running captures of real devices)"));
+	description_5->setAlignment(Qt::AlignRight);
+	acq_layout->addRow(description_5);
+
+	cb = create_checkbox(GlobalSettings::Key_Acq_LogicBitPlanes,
+		SLOT(on_acq_logicBitPlanes_changed(int)));
+	acq_layout->addRow(tr("Store logic data per channel for faster edge searches"), cb);
+
+	QLabel *description_6 = new QLabel(tr("(Speeds up devices with many channels, doubles the memory used by logic data)"));
+	description_6->setAlignment(Qt::AlignRight);
+	acq_layout->addRow(description_6);
+
 
 	return form;
 }
@@ -426,6 +510,22 @@ QWidget *Settings::get_decoder_settings_form(QWidget *parent)
 		SLOT(on_dec_alwaysshowallrows_changed(int)));
 	decoder_layout->addRow(tr("Always show all &rows, even if no annotation is visible"), cb);
 
+	QSpinBox *worker_count_sb = new QSpinBox();
+	worker_count_sb->setRange(1, 64);
+	worker_count_sb->setValue(
+		settings.value(GlobalSettings::Key_Dec_WorkerCount).toInt());
+	connect(worker_count_sb, SIGNAL(valueChanged(int)), this,
+		SLOT(on_dec_workerCount_changed(int)));
+	decoder_layout->addRow(tr("Number of segments to decode at the same time"), worker_count_sb);
+
+	cb = create_checkbox(GlobalSettings::Key_Dec_RunInProcesses,
+		SLOT(on_dec_runInProcesses_changed(int)));
+	decoder_layout->addRow(tr("Run decoders in separate &processes"), cb);
+
+	QLabel *processes_description = new QLabel(tr("(Lets decoders use more CPU cores, takes effect when decoding restarts)"));
+	processes_description->setAlignment(Qt::AlignRight);
+	decoder_layout->addRow(processes_description);
+
 	// Annotation export settings
 	ann_export_format_ = new QLineEdit();
 	ann_export_format_->setText(
@@ -703,6 +803,48 @@ void Settings::on_general_start_all_sessions_changed(int state)
 	settings.setValue(GlobalSettings::Key_General_StartAllSessions, state ? true : false);
 }
 
+void Settings::on_acq_useDiskStorage_changed(int state)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Acq_UseDiskStorage, state ? true : false);
+}
+
+void Settings::on_acq_diskStorageDir_changed(const QString &text)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Acq_DiskStorageDir, text);
+}
+
+void Settings::on_acq_memoryCeiling_changed(int value)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Acq_MemoryCeiling, value);
+}
+
+void Settings::on_acq_memoryBudget_changed(int value)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Acq_MemoryBudget, value);
+}
+
+void Settings::on_acq_ringBufferTime_changed(int value)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Acq_RingBufferTime, value);
+}
+
+void Settings::on_acq_ringBufferSize_changed(int value)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Acq_RingBufferSize, value);
+}
+
+void Settings::on_acq_logicBitPlanes_changed(int state)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Acq_LogicBitPlanes, state ? true : false);
+}
+
 void Settings::on_view_zoomToFitDuringAcq_changed(int state)
 {
 	GlobalSettings settings;
@@ -823,6 +965,18 @@ void Settings::on_dec_alwaysshowallrows_changed(int state)
 	GlobalSettings settings;
 	settings.setValue(GlobalSettings::Key_Dec_AlwaysShowAllRows, state ? true : false);
 }
+
+void Settings::on_dec_workerCount_changed(int value)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Dec_WorkerCount, value);
+}
+
+void Settings::on_dec_runInProcesses_changed(int state)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Dec_RunInProcesses, state ? true : false);
+}
 #endif
 
 void Settings::on_log_logLevel_changed(int value)
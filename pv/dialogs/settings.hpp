@@ -63,6 +63,13 @@ private Q_SLOTS:
 	void on_general_style_changed(int value);
 	void on_general_save_with_setup_changed(int state);
 	void on_general_start_all_sessions_changed(int state);
+	void on_acq_useDiskStorage_changed(int state);
+	void on_acq_diskStorageDir_changed(const QString &text);
+	void on_acq_memoryCeiling_changed(int value);
+	void on_acq_memoryBudget_changed(int value);
+	void on_acq_ringBufferTime_changed(int value);
+	void on_acq_ringBufferSize_changed(int value);
+	void on_acq_logicBitPlanes_changed(int state);
 	void on_view_zoomToFitDuringAcq_changed(int state);
 	void on_view_zoomToFitAfterAcq_changed(int state);
 	void on_view_triggerIsZero_changed(int state);
@@ -84,6 +91,8 @@ private Q_SLOTS:
 	void on_dec_initialStateConfigurable_changed(int state);
 	void on_dec_exportFormat_changed(const QString &text);
 	void on_dec_alwaysshowallrows_changed(int state);
+	void on_dec_workerCount_changed(int value);
+	void on_dec_runInProcesses_changed(int state);
 #endif
 	void on_log_logLevel_changed(int value);
 	void on_log_bufferSize_changed(int value);
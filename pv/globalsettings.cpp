@@ -29,6 +29,7 @@
 #include <QPixmapCache>
 #include <QString>
 #include <QStyle>
+#include <QThread>
 #include <QtGlobal>
 
 #include "globalsettings.hpp"
@@ -53,6 +54,13 @@ const QString GlobalSettings::Key_General_Theme = "General_Theme";
 const QString GlobalSettings::Key_General_Style = "General_Style";
 const QString GlobalSettings::Key_General_SaveWithSetup = "General_SaveWithSetup";
 const QString GlobalSettings::Key_General_StartAllSessions = "General_StartAllSessions";
+const QString GlobalSettings::Key_Acq_UseDiskStorage = "Acq_UseDiskStorage";
+const QString GlobalSettings::Key_Acq_DiskStorageDir = "Acq_DiskStorageDir";
+const QString GlobalSettings::Key_Acq_MemoryCeiling = "Acq_MemoryCeiling";
+const QString GlobalSettings::Key_Acq_MemoryBudget = "Acq_MemoryBudget";
+const QString GlobalSettings::Key_Acq_RingBufferTime = "Acq_RingBufferTime";
+const QString GlobalSettings::Key_Acq_RingBufferSize = "Acq_RingBufferSize";
+const QString GlobalSettings::Key_Acq_LogicBitPlanes = "Acq_LogicBitPlanes";
 const QString GlobalSettings::Key_View_ZoomToFitDuringAcq = "View_ZoomToFitDuringAcq";
 const QString GlobalSettings::Key_View_ZoomToFitAfterAcq = "View_ZoomToFitAfterAcq";
 const QString GlobalSettings::Key_View_TriggerIsZeroTime = "View_TriggerIsZeroTime";
@@ -76,6 +84,8 @@ const QString GlobalSettings::Key_View_CursorShowSamples = "View_CursorShowSampl
 const QString GlobalSettings::Key_Dec_InitialStateConfigurable = "Dec_InitialStateConfigurable";
 const QString GlobalSettings::Key_Dec_ExportFormat = "Dec_ExportFormat";
 const QString GlobalSettings::Key_Dec_AlwaysShowAllRows = "Dec_AlwaysShowAllRows";
+const QString GlobalSettings::Key_Dec_WorkerCount = "Dec_WorkerCount";
+const QString GlobalSettings::Key_Dec_RunInProcesses = "Dec_RunInProcesses";
 const QString GlobalSettings::Key_Log_BufferSize = "Log_BufferSize";
 const QString GlobalSettings::Key_Log_NotifyOfStacktrace = "Log_NotifyOfStacktrace";
 
@@ -122,6 +132,23 @@ void GlobalSettings::set_defaults_where_needed()
 	if (!contains(Key_General_SaveWithSetup))
 		setValue(Key_General_SaveWithSetup, true);
 
+	// Keep sample data in RAM and use the system's temp dir if it is
+	// stored on disk instead
+	if (!contains(Key_Acq_UseDiskStorage))
+		setValue(Key_Acq_UseDiskStorage, false);
+	if (!contains(Key_Acq_DiskStorageDir))
+		setValue(Key_Acq_DiskStorageDir, "");
+	if (!contains(Key_Acq_MemoryCeiling))
+		setValue(Key_Acq_MemoryCeiling, 0);
+	if (!contains(Key_Acq_MemoryBudget))
+		setValue(Key_Acq_MemoryBudget, 0);
+	if (!contains(Key_Acq_RingBufferTime))
+		setValue(Key_Acq_RingBufferTime, 0);
+	if (!contains(Key_Acq_RingBufferSize))
+		setValue(Key_Acq_RingBufferSize, 0);
+	if (!contains(Key_Acq_LogicBitPlanes))
+		setValue(Key_Acq_LogicBitPlanes, false);
+
 	// Enable zoom-to-fit after acquisition by default
 	if (!contains(Key_View_ZoomToFitAfterAcq))
 		setValue(Key_View_ZoomToFitAfterAcq, true);
@@ -170,6 +197,10 @@ void GlobalSettings::set_defaults_where_needed()
 		value(Key_Dec_ExportFormat).toString() == "%s %d: %c: %1")
 		setValue(Key_Dec_ExportFormat, "%s %d: %r: %1");
 
+	// Decode as many segments at once as there are CPU cores by default
+	if (!contains(Key_Dec_WorkerCount))
+		setValue(Key_Dec_WorkerCount, qMax(1, QThread::idealThreadCount()));
+
 	// Default to 500 lines of backlog
 	if (!contains(Key_Log_BufferSize))
 		setValue(Key_Log_BufferSize, 500);
@@ -58,6 +58,13 @@ public:
 	static const QString Key_General_Style;
 	static const QString Key_General_SaveWithSetup;
 	static const QString Key_General_StartAllSessions;
+	static const QString Key_Acq_UseDiskStorage;
+	static const QString Key_Acq_DiskStorageDir;
+	static const QString Key_Acq_MemoryCeiling;
+	static const QString Key_Acq_MemoryBudget;
+	static const QString Key_Acq_RingBufferTime;
+	static const QString Key_Acq_RingBufferSize;
+	static const QString Key_Acq_LogicBitPlanes;
 	static const QString Key_View_ZoomToFitDuringAcq;
 	static const QString Key_View_ZoomToFitAfterAcq;
 	static const QString Key_View_TriggerIsZeroTime;
@@ -81,6 +88,8 @@ public:
 	static const QString Key_Dec_InitialStateConfigurable;
 	static const QString Key_Dec_ExportFormat;
 	static const QString Key_Dec_AlwaysShowAllRows;
+	static const QString Key_Dec_WorkerCount;
+	static const QString Key_Dec_RunInProcesses;
 	static const QString Key_Log_BufferSize;
 	static const QString Key_Log_NotifyOfStacktrace;
 
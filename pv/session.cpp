@@ -29,16 +29,19 @@
 #include <QFileInfo>
 
 #include "devicemanager.hpp"
+#include "globalsettings.hpp"
 #include "mainwindow.hpp"
 #include "session.hpp"
 #include "util.hpp"
 
 #include "data/analog.hpp"
 #include "data/analogsegment.hpp"
+#include "data/chunkpool.hpp"
 #include "data/decode/decoder.hpp"
 #include "data/logic.hpp"
 #include "data/logicsegment.hpp"
 #include "data/mathsignal.hpp"
+#include "data/memorybudget.hpp"
 #include "data/signalbase.hpp"
 
 #include "devices/hardwaredevice.hpp"
@@ -75,6 +78,7 @@ using std::make_pair;
 using std::make_shared;
 using std::map;
 using std::max;
+using std::min;
 using std::move;
 using std::mutex;
 using std::pair;
@@ -124,10 +128,19 @@ Session::Session(DeviceManager &device_manager, QString name) :
 	name_(name),
 	capture_state_(Stopped),
 	cur_samplerate_(0),
+	use_disk_storage_(false),
+	use_bit_planes_(false),
+	ring_buffer_time_(0),
+	ring_buffer_size_(0),
+	chunk_pool_(make_shared<data::ChunkPool>()),
+	memory_budget_(make_shared<data::MemoryBudget>(*this)),
 	data_saved_(true)
 {
 	// Use this name also for the QObject instance
 	setObjectName(name_);
+
+	connect(chunk_pool_.get(), SIGNAL(memory_pressure()),
+		this, SLOT(on_memory_pressure()));
 }
 
 Session::~Session()
@@ -825,6 +838,17 @@ void Session::start_capture(function<void (const QString)> error_handler)
 	trigger_list_.clear();
 	segment_sample_count_.clear();
 
+	// Determine where the sample data of this acquisition will be stored
+	GlobalSettings settings;
+	use_disk_storage_ = settings.value(GlobalSettings::Key_Acq_UseDiskStorage).toBool();
+	disk_storage_dir_ = settings.value(GlobalSettings::Key_Acq_DiskStorageDir).toString();
+	use_bit_planes_ = settings.value(GlobalSettings::Key_Acq_LogicBitPlanes).toBool();
+
+	// The ceiling is configured in MiB, 0 disables it
+	chunk_pool_->set_memory_ceiling(
+		settings.value(GlobalSettings::Key_Acq_MemoryCeiling).toULongLong() * 1024 * 1024);
+	chunk_pool_->reserve_headroom();
+
 	// Revert name back to default name (e.g. "Session 1") for real devices
 	// as the (possibly saved) data is gone. File devices keep their name.
 	shared_ptr<devices::HardwareDevice> hw_device =
@@ -835,6 +859,13 @@ void Session::start_capture(function<void (const QString)> error_handler)
 		name_changed();
 	}
 
+	// Only live captures can run long enough to need a ring buffer, file
+	// devices always load all of their data
+	ring_buffer_time_ = hw_device ?
+		settings.value(GlobalSettings::Key_Acq_RingBufferTime).toULongLong() : 0;
+	ring_buffer_size_ = hw_device ?
+		settings.value(GlobalSettings::Key_Acq_RingBufferSize).toULongLong() * 1024 * 1024 : 0;
+
 	acq_start_time_ = Glib::DateTime::create_now_local();
 
 	// Begin the session
@@ -1058,6 +1089,11 @@ MetadataObjManager* Session::metadata_obj_manager()
 	return &metadata_obj_manager_;
 }
 
+shared_ptr<data::MemoryBudget> Session::memory_budget() const
+{
+	return memory_budget_;
+}
+
 void Session::set_capture_state(capture_state state)
 {
 	if (state == capture_state_)
@@ -1313,6 +1349,9 @@ void Session::sample_thread_proc(function<void (const QString)> error_handler)
 	// Optimize memory usage
 	free_unused_memory();
 
+	// Chunks of the previous acquisition that weren't reused aren't needed anymore
+	chunk_pool_->trim();
+
 	// We now have unsaved data unless we just "captured" from a file
 	shared_ptr<devices::File> file_device =
 		dynamic_pointer_cast<devices::File>(device_);
@@ -1320,8 +1359,12 @@ void Session::sample_thread_proc(function<void (const QString)> error_handler)
 	if (!file_device)
 		data_saved_ = false;
 
-	if (out_of_memory_)
-		error_handler(tr("Out of memory, acquisition stopped."));
+	if (out_of_memory_) {
+		if (chunk_pool_->memory_ceiling() > 0)
+			error_handler(tr("Memory limit reached or out of memory, acquisition stopped."));
+		else
+			error_handler(tr("Out of memory, acquisition stopped."));
+	}
 }
 
 void Session::free_unused_memory()
@@ -1386,6 +1429,21 @@ void Session::signal_segment_completed()
 		segment_completed(segment_id);
 }
 
+uint64_t Session::ring_buffer_sample_limit(unsigned int unit_size) const
+{
+	uint64_t limit = 0;
+
+	if ((ring_buffer_time_ > 0) && (cur_samplerate_ > 0))
+		limit = ring_buffer_time_ * cur_samplerate_;
+
+	if (ring_buffer_size_ > 0) {
+		const uint64_t size_limit = ring_buffer_size_ / unit_size;
+		limit = (limit > 0) ? min(limit, size_limit) : size_limit;
+	}
+
+	return limit;
+}
+
 #ifdef ENABLE_FLOW
 bool Session::on_gst_bus_message(const Glib::RefPtr<Gst::Bus>& bus, const Glib::RefPtr<Gst::Message>& message)
 {
@@ -1554,6 +1612,14 @@ void Session::feed_in_logic(shared_ptr<sigrok::Logic> logic)
 		cur_logic_segment_ = make_shared<data::LogicSegment>(
 			*logic_data_, logic_data_->get_segment_count(),
 			logic->unit_size(), cur_samplerate_);
+		if (!use_disk_storage_ || !cur_logic_segment_->use_disk_storage(disk_storage_dir_))
+			cur_logic_segment_->use_chunk_pool(chunk_pool_);
+		cur_logic_segment_->set_sample_limit(
+			ring_buffer_sample_limit(logic->unit_size()));
+		// Keep the mip-map from delaying the datafeed callback
+		cur_logic_segment_->use_background_builder();
+		if (use_bit_planes_)
+			cur_logic_segment_->enable_bit_planes();
 		logic_data_->push_segment(cur_logic_segment_);
 
 		signal_new_segment();
@@ -1617,6 +1683,10 @@ void Session::feed_in_analog(shared_ptr<sigrok::Analog> analog)
 			// Create a segment, keep it in the maps of channels
 			segment = make_shared<data::AnalogSegment>(
 				*data, data->get_segment_count(), cur_samplerate_);
+			if (!use_disk_storage_ || !segment->use_disk_storage(disk_storage_dir_))
+				segment->use_chunk_pool(chunk_pool_);
+			segment->set_sample_limit(ring_buffer_sample_limit(sizeof(float)));
+			segment->use_background_builder();
 			cur_analog_segments_[channel] = segment;
 
 			// Push the segment into the analog data.
@@ -1716,6 +1786,15 @@ void Session::data_feed_in(shared_ptr<sigrok::Device> device,
 	}
 }
 
+void Session::on_memory_pressure()
+{
+	// Stop the acquisition while there's still memory left to do so cleanly
+	if (get_capture_state() != Stopped) {
+		out_of_memory_ = true;
+		device_->stop();
+	}
+}
+
 void Session::on_data_saved()
 {
 	data_saved_ = true;
@@ -92,9 +92,11 @@ class DeviceManager;
 namespace data {
 class Analog;
 class AnalogSegment;
+class ChunkPool;
 class DecodeSignal;
 class Logic;
 class LogicSegment;
+class MemoryBudget;
 class SignalBase;
 class SignalData;
 class SignalGroup;
@@ -215,6 +217,8 @@ public:
 
 	MetadataObjManager* metadata_obj_manager();
 
+	shared_ptr<data::MemoryBudget> memory_budget() const;
+
 private:
 	void set_capture_state(capture_state state);
 
@@ -234,6 +238,10 @@ private:
 	void signal_new_segment();
 	void signal_segment_completed();
 
+	/// Returns the number of samples that the ring buffer holds for
+	/// segments with the given unit size, 0 if it's not used
+	uint64_t ring_buffer_sample_limit(unsigned int unit_size) const;
+
 #ifdef ENABLE_FLOW
 	bool on_gst_bus_message(const Glib::RefPtr<Gst::Bus>& bus, const Glib::RefPtr<Gst::Message>& message);
 
@@ -276,6 +284,9 @@ public Q_SLOTS:
 	void on_new_decoders_selected(vector<const srd_decoder*> decoders);
 #endif
 
+private Q_SLOTS:
+	void on_memory_pressure();
+
 private:
 	bool shutting_down_;
 
@@ -308,6 +319,19 @@ private:
 	int32_t highest_segment_id_;
 	vector<uint64_t> segment_sample_count_;
 
+	bool use_disk_storage_;
+	QString disk_storage_dir_;
+	bool use_bit_planes_;
+
+	/// Ring buffer length in seconds and size in bytes, 0 if unlimited
+	uint64_t ring_buffer_time_, ring_buffer_size_;
+
+	/// Provides the sample data chunks of all acquired segments
+	shared_ptr<data::ChunkPool> chunk_pool_;
+
+	/// Accounts for the memory used by the signals and enforces the budget
+	shared_ptr<data::MemoryBudget> memory_budget_;
+
 	std::thread sampling_thread_;
 
 	bool out_of_memory_;
@@ -148,8 +148,8 @@ bool StoreSession::start()
 
 	if (sample_range_.first == sample_range_.second) {
 		// No sample range specified, save everything we have
-		start_sample_ = 0;
-		sample_count_ =	any_segment->get_sample_count();
+		start_sample_ = any_segment->get_first_sample();
+		sample_count_ =	any_segment->get_sample_count() - start_sample_;
 	} else {
 		if (sample_range_.first > sample_range_.second) {
 			start_sample_ = sample_range_.second;
@@ -160,6 +160,13 @@ bool StoreSession::start()
 			end_sample = min(sample_range_.second, any_segment->get_sample_count());
 			sample_count_ = end_sample - start_sample_;
 		}
+
+		// Ring buffers may have dropped the beginning of the range already
+		if (start_sample_ < any_segment->get_first_sample()) {
+			sample_count_ -= min(sample_count_,
+				any_segment->get_first_sample() - start_sample_);
+			start_sample_ = any_segment->get_first_sample();
+		}
 	}
 
 	// Make sure the sample range is valid
@@ -253,6 +260,10 @@ void StoreSession::store_proc(vector< shared_ptr<data::SignalBase> > achannel_li
 	const unsigned int samples_per_block =
 		min(asamples_per_block, lsamples_per_block);
 
+	// Only used when a block spans multiple chunks, otherwise the sample
+	// data is passed to the output right from the segments
+	vector<uint8_t> adata_buffer, ldata_buffer;
+
 	const auto context = session_.device_manager().context();
 	while (!interrupt_ && sample_count_) {
 		progress_updated();
@@ -265,8 +276,9 @@ void StoreSession::store_proc(vector< shared_ptr<data::SignalBase> > achannel_li
 				shared_ptr<sigrok::Channel> achannel = (achannel_list.at(i))->channel();
 				shared_ptr<data::AnalogSegment> asegment = asegment_list.at(i);
 
-				float *adata = new float[packet_len];
-				asegment->get_samples(start_sample_, start_sample_ + packet_len, adata);
+				const data::Segment::DataView aview(*asegment,
+					start_sample_, start_sample_ + packet_len);
+				const float *adata = (const float*)aview.contiguous_data(adata_buffer);
 
 				auto analog = context->create_analog_packet(
 					vector<shared_ptr<sigrok::Channel> >{achannel},
@@ -277,22 +289,19 @@ void StoreSession::store_proc(vector< shared_ptr<data::SignalBase> > achannel_li
 
 				if (output_stream_.is_open())
 					output_stream_ << adata_str;
-
-				delete[] adata;
 			}
 
 			if (lsegment) {
 				const size_t data_size = packet_len * lunit_size;
-				uint8_t* ldata = new uint8_t[data_size];
-				lsegment->get_samples(start_sample_, start_sample_ + packet_len, ldata);
+				const data::Segment::DataView lview(*lsegment,
+					start_sample_, start_sample_ + packet_len);
+				const uint8_t *ldata = lview.contiguous_data(ldata_buffer);
 
 				auto logic = context->create_logic_packet((void*)ldata, data_size, lunit_size);
 				const string ldata_str = output_->receive(logic);
 
 				if (output_stream_.is_open())
 					output_stream_ << ldata_str;
-
-				delete[] ldata;
 			}
 		} catch (Error& error) {
 			error_ = tr("Error while saving: ") + error.what();
@@ -29,6 +29,7 @@
 #include <QMenu>
 #include <QMessageBox>
 #include <QSettings>
+#include <QStringList>
 #include <QToolTip>
 
 #include "mainbar.hpp"
@@ -36,6 +37,7 @@
 #include <boost/algorithm/string/join.hpp>
 
 #include <pv/data/mathsignal.hpp>
+#include <pv/data/memorybudget.hpp>
 #include <pv/devicemanager.hpp>
 #include <pv/devices/hardwaredevice.hpp>
 #include <pv/devices/inputfile.hpp>
@@ -291,6 +293,8 @@ MainBar::MainBar(Session &session, QWidget *parent, pv::views::trace::View *view
 		this, SLOT(on_capture_state_changed(int)));
 	connect(&session, SIGNAL(device_changed()),
 		this, SLOT(on_device_changed()));
+	connect(session_.memory_budget().get(), SIGNAL(usage_changed()),
+		this, SLOT(on_memory_usage_changed()));
 
 	update_device_list();
 }
@@ -924,6 +928,39 @@ void MainBar::on_add_math_signal_clicked()
 	session_.add_generated_signal(signal);
 }
 
+void MainBar::on_memory_usage_changed()
+{
+	const shared_ptr<data::MemoryBudget> budget = session_.memory_budget();
+	const double MiB = 1024 * 1024;
+
+	if (budget->budget() > 0)
+		memory_usage_label_.setText(tr("Memory: %1 / %2 MiB")
+			.arg(budget->total_usage() / MiB, 0, 'f', 0)
+			.arg(budget->budget() / MiB, 0, 'f', 0));
+	else
+		memory_usage_label_.setText(tr("Memory: %1 MiB")
+			.arg(budget->total_usage() / MiB, 0, 'f', 0));
+
+	QStringList lines;
+	for (const data::MemoryBudget::SignalUsage& usage : budget->signal_usage()) {
+		QStringList parts;
+		if (usage.sample_data > 0)
+			parts << tr("%1 MiB samples").arg(usage.sample_data / MiB, 0, 'f', 1);
+		if (usage.mipmaps > 0)
+			parts << tr("%1 MiB mip-maps").arg(usage.mipmaps / MiB, 0, 'f', 1);
+		if (usage.converted_data > 0)
+			parts << tr("%1 MiB converted").arg(usage.converted_data / MiB, 0, 'f', 1);
+		if (usage.decoder_data > 0)
+			parts << tr("%1 MiB decoder input").arg(usage.decoder_data / MiB, 0, 'f', 1);
+		if (usage.annotations > 0)
+			parts << tr("%1 MiB annotations").arg(usage.annotations / MiB, 0, 'f', 1);
+
+		lines << QString("%1: %2").arg(usage.name, parts.join(", "));
+	}
+
+	memory_usage_label_.setToolTip(lines.join("\n"));
+}
+
 void MainBar::add_toolbar_widgets()
 {
 	addWidget(new_view_button_);
@@ -944,6 +981,8 @@ void MainBar::add_toolbar_widgets()
 	addWidget(add_decoder_button_);
 #endif
 	addWidget(add_math_signal_button_);
+	addSeparator();
+	addWidget(&memory_usage_label_);
 }
 
 bool MainBar::eventFilter(QObject *watched, QEvent *event)
@@ -28,6 +28,7 @@
 
 #include <QComboBox>
 #include <QDoubleSpinBox>
+#include <QLabel>
 #include <QMenu>
 #include <QToolBar>
 #include <QToolButton>
@@ -147,6 +148,8 @@ private Q_SLOTS:
 	void on_add_decoder_clicked();
 	void on_add_math_signal_clicked();
 
+	void on_memory_usage_changed();
+
 protected:
 	void add_toolbar_widgets();
 
@@ -188,6 +191,8 @@ private:
 #endif
 
 	QToolButton *add_math_signal_button_;
+
+	QLabel memory_usage_label_;
 };
 
 } // namespace toolbars
@@ -278,7 +278,10 @@ uint8_t QHexView::get_next_byte(bool* is_new_chunk)
 		return 0xEE;
 	}
 
-	if ((current_chunk_offset_ == current_chunk_.data.size()) && (current_offset_ < data_size_)) {
+	// In ring buffer mode, old chunks may have been dropped since data_size_
+	// was determined
+	if ((current_chunk_offset_ == current_chunk_.data.size()) && (current_offset_ < data_size_) &&
+		((current_chunk_id_ + 1) < data_->chunks.size())) {
 		current_chunk_id_++;
 		current_chunk_offset_ = 0;
 		current_chunk_ = data_->chunks[current_chunk_id_];
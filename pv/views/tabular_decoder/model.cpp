@@ -30,6 +30,7 @@
 
 using std::make_shared;
 
+using pv::data::AnnotationRef;
 using pv::util::Timestamp;
 using pv::util::format_time_si;
 using pv::util::format_time_minutes;
@@ -41,7 +42,8 @@ namespace tabular_decoder {
 
 AnnotationCollectionModel::AnnotationCollectionModel(QObject* parent) :
 	QAbstractTableModel(parent),
-	all_annotations_(nullptr),
+	segment_(nullptr),
+	all_annotations_merge_count_(0),
 	dataset_(nullptr),
 	signal_(nullptr),
 	first_hidden_column_(0),
@@ -64,22 +66,31 @@ AnnotationCollectionModel::AnnotationCollectionModel(QObject* parent) :
 	header_data_.emplace_back("End Sample");         // Column #6, hidden
 }
 
-int AnnotationCollectionModel::get_hierarchy_level(const Annotation* ann) const
+Annotation AnnotationCollectionModel::get_annotation(const QModelIndex& index) const
+{
+	if (!segment_ || !dataset_ || !index.isValid() ||
+		((size_t)index.row() >= dataset_->size()))
+		return Annotation();
+
+	return segment_->annotation(dataset_->at(index.row()));
+}
+
+int AnnotationCollectionModel::get_hierarchy_level(const Annotation& ann) const
 {
 	int level = 0;
 
-	const unsigned int ann_stack_level = ann->row_data()->row()->decoder()->get_stack_level();
+	const unsigned int ann_stack_level = ann.row_data()->row()->decoder()->get_stack_level();
 	level = (signal_->decoder_stack().size() - 1 - ann_stack_level);
 
 	return level;
 }
 
-QVariant AnnotationCollectionModel::data_from_ann(const Annotation* ann, int index) const
+QVariant AnnotationCollectionModel::data_from_ann(const Annotation& ann, int index) const
 {
 	switch (index) {
-	case 0: return QVariant((qulonglong)ann->start_sample());  // Column #0, Start Sample
+	case 0: return QVariant((qulonglong)ann.start_sample());   // Column #0, Start Sample
 	case 1: {                                                  // Column #1, Start Time
-			Timestamp t = ann->start_sample() / signal_->get_samplerate();
+			Timestamp t = ann.start_sample() / signal_->get_samplerate();
 			QString unit = signal_->get_samplerate() ? tr("s") : tr("sa");
 			QString s;
 			if ((t < 60) || (signal_->get_samplerate() == 0))  // i.e. if unit is sa
@@ -88,22 +99,23 @@ QVariant AnnotationCollectionModel::data_from_ann(const Annotation* ann, int ind
 				s = format_time_minutes(t, 3, false);
 			return QVariant(s);
 		}
-	case 2: return QVariant(ann->row()->decoder()->name());    // Column #2, Decoder
-	case 3: return QVariant(ann->row()->description());        // Column #3, Ann Row
-	case 4: return QVariant(ann->ann_class_description());     // Column #4, Ann Class
-	case 5: return QVariant(ann->longest_annotation());        // Column #5, Value
-	case 6: return QVariant((qulonglong)ann->end_sample());    // Column #6, End Sample
+	case 2: return QVariant(ann.row()->decoder()->name());     // Column #2, Decoder
+	case 3: return QVariant(ann.row()->description());         // Column #3, Ann Row
+	case 4: return QVariant(ann.ann_class_description());      // Column #4, Ann Class
+	case 5: return QVariant(ann.longest_annotation());         // Column #5, Value
+	case 6: return QVariant((qulonglong)ann.end_sample());     // Column #6, End Sample
 	default: return QVariant();
 	}
 }
 
 QVariant AnnotationCollectionModel::data(const QModelIndex& index, int role) const
 {
-	if (!signal_ || !index.isValid() || !index.internalPointer())
+	if (!signal_)
 		return QVariant();
 
-	const Annotation* ann =
-		static_cast<const Annotation*>(index.internalPointer());
+	const Annotation ann = get_annotation(index);
+	if (!ann.row_data())
+		return QVariant();
 
 	if ((role == Qt::DisplayRole) || (role == Qt::ToolTipRole))
 		return data_from_ann(ann, index.column());
@@ -112,8 +124,8 @@ QVariant AnnotationCollectionModel::data(const QModelIndex& index, int role) con
 		if (index.column() >= get_hierarchy_level(ann)) {
 			// Invert the text color if this cell is highlighted
 			const bool must_highlight = (highlight_sample_num_ > 0) &&
-				((int64_t)ann->start_sample() <= highlight_sample_num_) &&
-				((int64_t)ann->end_sample() >= highlight_sample_num_);
+				((int64_t)ann.start_sample() <= highlight_sample_num_) &&
+				((int64_t)ann.end_sample() >= highlight_sample_num_);
 
 			if (must_highlight) {
 				if (GlobalSettings::current_theme_is_dark())
@@ -132,14 +144,14 @@ QVariant AnnotationCollectionModel::data(const QModelIndex& index, int role) con
 
 			QColor color;
 			const bool must_highlight = (highlight_sample_num_ > 0) &&
-				((int64_t)ann->start_sample() <= highlight_sample_num_) &&
-				((int64_t)ann->end_sample() >= highlight_sample_num_);
+				((int64_t)ann.start_sample() <= highlight_sample_num_) &&
+				((int64_t)ann.end_sample() >= highlight_sample_num_);
 
 			if (must_highlight)
-				color = ann->color();
+				color = ann.color();
 			else
 				color = GlobalSettings::current_theme_is_dark() ?
-					ann->dark_color() : ann->bright_color();
+					ann.dark_color() : ann.bright_color();
 
 			return QBrush(color);
 		}
@@ -185,7 +197,7 @@ QModelIndex AnnotationCollectionModel::index(int row, int column,
 	QModelIndex idx;
 
 	if ((size_t)row < dataset_->size())
-		idx = createIndex(row, column, (void*)dataset_->at(row));
+		idx = createIndex(row, column);
 
 	return idx;
 }
@@ -219,7 +231,9 @@ void AnnotationCollectionModel::set_signal_and_segment(data::DecodeSignal* signa
 	layoutAboutToBeChanged();
 
 	if (!signal) {
-		all_annotations_ = nullptr;
+		segment_ = nullptr;
+		all_annotations_.clear();
+		all_annotations_merge_count_ = 0;
 		dataset_ = nullptr;
 		signal_ = nullptr;
 
@@ -232,7 +246,15 @@ void AnnotationCollectionModel::set_signal_and_segment(data::DecodeSignal* signa
 		for (const shared_ptr<Decoder>& dec : signal_->decoder_stack())
 			disconnect(dec.get(), nullptr, this, SLOT(on_annotation_visibility_changed()));
 
-	all_annotations_ = signal->get_all_annotations_by_segment(current_segment);
+	// A copy of another segment's list can't be updated
+	if ((signal != signal_) || (current_segment != prev_segment_)) {
+		all_annotations_.clear();
+		all_annotations_merge_count_ = 0;
+	}
+
+	segment_ = signal->get_decode_segment(current_segment);
+	signal->update_all_annotations_copy(current_segment, all_annotations_,
+		all_annotations_merge_count_);
 	signal_ = signal;
 
 	for (const shared_ptr<Decoder>& dec : signal_->decoder_stack())
@@ -243,7 +265,7 @@ void AnnotationCollectionModel::set_signal_and_segment(data::DecodeSignal* signa
 		update_annotations_without_hidden();
 		dataset_ = &all_annotations_without_hidden_;
 	} else
-		dataset_ = all_annotations_;
+		dataset_ = segment_ ? &all_annotations_ : nullptr;
 
 	if (!dataset_ || dataset_->empty()) {
 		prev_segment_ = current_segment;
@@ -278,7 +300,7 @@ void AnnotationCollectionModel::set_hide_hidden(bool hide_hidden)
 		dataset_ = &all_annotations_without_hidden_;
 		update_annotations_without_hidden();
 	} else {
-		dataset_ = all_annotations_;
+		dataset_ = segment_ ? &all_annotations_ : nullptr;
 		all_annotations_without_hidden_.clear();  // To conserve memory
 	}
 
@@ -294,19 +316,19 @@ void AnnotationCollectionModel::update_annotations_without_hidden()
 {
 	uint64_t count = 0;
 
-	if (!all_annotations_ || all_annotations_->empty()) {
+	if (!segment_ || all_annotations_.empty()) {
 		all_annotations_without_hidden_.clear();
 		return;
 	}
 
-	for (const Annotation* ann : *all_annotations_) {
-		if (!ann->visible())
+	for (const AnnotationRef& ref : all_annotations_) {
+		if (!segment_->annotation(ref).visible())
 			continue;
 
 		if (all_annotations_without_hidden_.size() < (count + 100))
 			all_annotations_without_hidden_.resize(count + 100);
 
-		all_annotations_without_hidden_[count++] = ann;
+		all_annotations_without_hidden_[count++] = ref;
 	}
 
 	all_annotations_without_hidden_.resize(count);
@@ -330,12 +352,12 @@ QModelIndex AnnotationCollectionModel::update_highlighted_rows(QModelIndex first
 		// we would need to highlight - only then do we do so
 		QModelIndex index = first;
 		do {
-			const Annotation* ann =	static_cast<const Annotation*>(index.internalPointer());
-			if (!ann)  // Can happen if the table is being modified at this exact time
+			const Annotation ann = get_annotation(index);
+			if (!ann.row_data())  // Can happen if the table is being modified at this exact time
 				return result;
 
-			if (((int64_t)ann->start_sample() <= sample_num) &&
-				((int64_t)ann->end_sample() >= sample_num)) {
+			if (((int64_t)ann.start_sample() <= sample_num) &&
+				((int64_t)ann.end_sample() >= sample_num)) {
 				result = index;
 				has_highlight = true;
 				break;
@@ -619,12 +619,13 @@ void View::on_table_item_double_clicked(const QModelIndex& index)
 {
 	const QModelIndex src_idx = filter_proxy_model_->mapToSource(index);
 
-	const Annotation* ann = static_cast<const Annotation*>(src_idx.internalPointer());
-	assert(ann);
+	const Annotation ann = model_->get_annotation(src_idx);
+	if (!ann.row_data())
+		return;
 
 	shared_ptr<views::ViewBase> main_view = session_.main_view();
 
-	main_view->focus_on_range(ann->start_sample(), ann->end_sample());
+	main_view->focus_on_range(ann.start_sample(), ann.end_sample());
 }
 
 void View::on_table_header_requested(const QPoint& pos)
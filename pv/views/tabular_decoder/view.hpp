@@ -65,8 +65,11 @@ class AnnotationCollectionModel : public QAbstractTableModel
 public:
 	AnnotationCollectionModel(QObject* parent = nullptr);
 
-	int get_hierarchy_level(const Annotation* ann) const;
-	QVariant data_from_ann(const Annotation* ann, int index) const;
+	/// Returns the annotation shown in the row of @c index, if any
+	Annotation get_annotation(const QModelIndex& index) const;
+
+	int get_hierarchy_level(const Annotation& ann) const;
+	QVariant data_from_ann(const Annotation& ann, int index) const;
 	QVariant data(const QModelIndex& index, int role) const override;
 	Qt::ItemFlags flags(const QModelIndex& index) const override;
 
@@ -93,9 +96,12 @@ private Q_SLOTS:
 
 private:
 	vector<QVariant> header_data_;
-	const deque<const Annotation*>* all_annotations_;
-	deque<const Annotation*> all_annotations_without_hidden_;
-	const deque<const Annotation*>* dataset_;
+	const data::DecodeSegment* segment_;
+	/// A copy of the segment's list, which the decoders change while it's shown
+	deque<data::AnnotationRef> all_annotations_;
+	uint64_t all_annotations_merge_count_;
+	deque<data::AnnotationRef> all_annotations_without_hidden_;
+	const deque<data::AnnotationRef>* dataset_;
 	data::DecodeSignal* signal_;
 	uint8_t first_hidden_column_;
 	uint32_t prev_segment_;
@@ -86,7 +86,6 @@ const QColor AnalogSignal::ThresholdColorLo = QColor(255, 0, 0, 8 * 256 / 100);
 const QColor AnalogSignal::ThresholdColorNe = QColor(0,   0, 0, 10 * 256 / 100);
 const QColor AnalogSignal::ThresholdColorHi = QColor(0, 255, 0, 8 * 256 / 100);
 
-const int64_t AnalogSignal::TracePaintBlockSize = 1024 * 1024;  // 4 MiB (due to float)
 const float AnalogSignal::EnvelopeThreshold = 64.0f;
 
 const int AnalogSignal::MaximumVDivs = 10;
@@ -270,10 +269,13 @@ void AnalogSignal::paint_mid(QPainter &p, ViewItemPaintParams &pp)
 			const pv::util::Timestamp start = samplerate * (pp.offset() - start_time);
 			const pv::util::Timestamp end = start + samples_per_pixel * pp.width();
 
+			// Ring buffers only keep the most recent samples
+			const int64_t first_sample = min((int64_t)segment->get_first_sample(),
+				last_sample);
 			const int64_t start_sample = min(max(floor(start).convert_to<int64_t>(),
-				(int64_t)0), last_sample);
+				first_sample), last_sample);
 			const int64_t end_sample = min(max((ceil(end) + 1).convert_to<int64_t>(),
-				(int64_t)0), last_sample);
+				first_sample), last_sample);
 
 			if (samples_per_pixel < EnvelopeThreshold)
 				paint_trace(p, segment, y, pp.left(), start_sample, end_sample,
@@ -417,10 +419,11 @@ void AnalogSignal::paint_trace(QPainter &p,
 
 	vector<QRectF> sampling_points[3];
 
-	int64_t sample_count = min(points_count, TracePaintBlockSize);
-	int64_t block_sample = 0;
-	float *sample_block = new float[TracePaintBlockSize];
-	segment->get_samples(start, start + sample_count, sample_block);
+	// Access the samples in place, they're split into one span per chunk
+	const data::Segment::DataView view(*segment, start, end + 1);
+	auto span = view.spans().begin();
+	const float *sample_block = (const float*)span->data;
+	uint64_t block_sample = 0;
 
 	if (show_hover_marker_)
 		reset_pixel_values();
@@ -428,11 +431,11 @@ void AnalogSignal::paint_trace(QPainter &p,
 	const int w = 2;
 	for (int64_t sample = start; sample <= end; sample++, block_sample++) {
 
-		// Fetch next block of samples if we finished the current one
-		if (block_sample == TracePaintBlockSize) {
+		// Move on to the next span if we finished the current one
+		if (block_sample == span->sample_count) {
 			block_sample = 0;
-			sample_count = min(points_count - sample, TracePaintBlockSize);
-			segment->get_samples(sample, sample + sample_count, sample_block);
+			span++;
+			sample_block = (const float*)span->data;
 		}
 
 		const float abs_x = sample / samples_per_pixel - pixels_offset;
@@ -462,7 +465,6 @@ void AnalogSignal::paint_trace(QPainter &p,
 			sampling_points[idx].emplace_back(x - (w / 2), y - sample_block[block_sample] * scale_ - (w / 2), w, w);
 		}
 	}
-	delete[] sample_block;
 
 	// QPainter::drawPolyline() is slow, let's paint the lines ourselves
 	for (int64_t i = 1; i < points_count; i++)
@@ -646,14 +648,9 @@ vector<data::LogicSegment::EdgePair> AnalogSignal::get_nearest_level_changes(uin
 	if (!segment || (segment->get_sample_count() == 0))
 		return vector<LogicSegment::EdgePair>();
 
-	const View *view = owner_->view();
-	assert(view);
-	const double samples_per_pixel = base_->get_samplerate() * view->scale();
-
 	vector<LogicSegment::EdgePair> edges;
 
-	segment->get_surrounding_edges(edges, sample_pos,
-		samples_per_pixel / LogicSignal::Oversampling, 0);
+	segment->get_surrounding_edges(edges, sample_pos, 0);
 
 	if (edges.empty())
 		return vector<LogicSegment::EdgePair>();
@@ -58,7 +58,6 @@ private:
 	static const QColor ThresholdColorNe;
 	static const QColor ThresholdColorHi;
 
-	static const int64_t TracePaintBlockSize;
 	static const float EnvelopeThreshold;
 
 	static const int MaximumVDivs;
@@ -21,6 +21,8 @@
 #include <cassert>
 
 #include <QColor>
+#include <QFormLayout>
+#include <QLabel>
 #include <QMenu>
 #include <QToolTip>
 
@@ -28,9 +30,12 @@
 
 #include "pv/globalsettings.hpp"
 #include "pv/util.hpp"
+#include "pv/widgets/popup.hpp"
+#include "logicsignal.hpp"
 #include "ruler.hpp"
 #include "view.hpp"
 
+using std::dynamic_pointer_cast;
 using std::max;
 using std::make_pair;
 using std::min;
@@ -117,8 +122,35 @@ QPoint CursorPair::drag_point(const QRect &rect) const
 
 pv::widgets::Popup* CursorPair::create_popup(QWidget *parent)
 {
-	(void)parent;
-	return nullptr;
+	using pv::widgets::Popup;
+
+	// Shows the statistics of the logic channels between the cursors, which
+	// are taken from the running statistics of the segments
+	Popup *const popup = new Popup(parent);
+	popup->set_position(parent->mapToGlobal(
+		drag_point(parent->rect())), Popup::Bottom);
+
+	QFormLayout *const form = new QFormLayout(popup);
+	popup->setLayout(form);
+
+	for (const shared_ptr<Signal>& signal : view_.signals()) {
+		const shared_ptr<LogicSignal> logic_signal =
+			dynamic_pointer_cast<LogicSignal>(signal);
+		if (!logic_signal || !signal->base()->enabled())
+			continue;
+
+		const QString text = logic_signal->format_stats(first_->time(),
+			second_->time());
+		if (!text.isEmpty())
+			form->addRow(signal->base()->name(), new QLabel(text, popup));
+	}
+
+	if (form->rowCount() == 0) {
+		delete popup;
+		return nullptr;
+	}
+
+	return popup;
 }
 
 QMenu *CursorPair::create_header_context_menu(QWidget *parent)
@@ -313,7 +313,7 @@ void DecodeTrace::paint_mid(QPainter &p, ViewItemPaintParams &pp)
 			continue;
 		}
 
-		deque<const Annotation*> annotations;
+		deque<Annotation> annotations;
 		decode_signal_->get_annotation_subset(annotations, r.decode_row,
 			current_segment_, sample_range.first, sample_range.second);
 
@@ -714,7 +714,7 @@ void DecodeTrace::mouse_left_press_event(const QMouseEvent* event)
 	}
 }
 
-void DecodeTrace::draw_annotations(deque<const Annotation*>& annotations,
+void DecodeTrace::draw_annotations(deque<Annotation>& annotations,
 		QPainter &p, const ViewItemPaintParams &pp, int y, const DecodeTraceRow& row)
 {
 	uint32_t block_class = 0;
@@ -722,7 +722,7 @@ void DecodeTrace::draw_annotations(deque<const Annotation*>& annotations,
 	qreal block_start = 0;
 	int block_ann_count = 0;
 
-	const Annotation* prev_ann;
+	Annotation prev_ann;
 	qreal prev_end = INT_MIN;
 
 	qreal a_end;
@@ -732,10 +732,10 @@ void DecodeTrace::draw_annotations(deque<const Annotation*>& annotations,
 		get_pixels_offset_samples_per_pixel();
 
 	// Gather all annotations that form a visual "block" and draw them as such
-	for (const Annotation* a : annotations) {
+	for (const Annotation& a : annotations) {
 
-		const qreal abs_a_start = a->start_sample() / samples_per_pixel;
-		const qreal abs_a_end   = a->end_sample() / samples_per_pixel;
+		const qreal abs_a_start = a.start_sample() / samples_per_pixel;
+		const qreal abs_a_end   = a.end_sample() / samples_per_pixel;
 
 		const qreal a_start = abs_a_start - pixels_offset;
 		a_end = abs_a_end - pixels_offset;
@@ -747,7 +747,7 @@ void DecodeTrace::draw_annotations(deque<const Annotation*>& annotations,
 
 		// Annotation wider than the threshold for a useful label width?
 		if (a_width >= min_useful_label_width_) {
-			for (const QString &ann_text : *(a->annotations())) {
+			for (const QString &ann_text : a.annotations()) {
 				const qreal w = p.boundingRect(QRectF(), 0, ann_text).width();
 				// Annotation wide enough to fit a label? Don't put it in a block then
 				if (w <= a_width) {
@@ -782,10 +782,10 @@ void DecodeTrace::draw_annotations(deque<const Annotation*>& annotations,
 
 			if (block_ann_count == 0) {
 				block_start = a_start;
-				block_class = a->ann_class_id();
+				block_class = a.ann_class_id();
 				block_class_uniform = true;
 			} else
-				if (a->ann_class_id() != block_class)
+				if (a.ann_class_id() != block_class)
 					block_class_uniform = false;
 
 			block_ann_count++;
@@ -799,23 +799,23 @@ void DecodeTrace::draw_annotations(deque<const Annotation*>& annotations,
 			block_class_uniform, p, y, row);
 }
 
-void DecodeTrace::draw_annotation(const Annotation* a, QPainter &p,
+void DecodeTrace::draw_annotation(const Annotation& a, QPainter &p,
 	const ViewItemPaintParams &pp, int y, const DecodeTraceRow& row) const
 {
 	double samples_per_pixel, pixels_offset;
 	tie(pixels_offset, samples_per_pixel) =
 		get_pixels_offset_samples_per_pixel();
 
-	const double start = a->start_sample() / samples_per_pixel - pixels_offset;
-	const double end = a->end_sample() / samples_per_pixel - pixels_offset;
+	const double start = a.start_sample() / samples_per_pixel - pixels_offset;
+	const double end = a.end_sample() / samples_per_pixel - pixels_offset;
 
-	p.setPen(a->dark_color());
-	p.setBrush(a->color());
+	p.setPen(a.dark_color());
+	p.setBrush(a.color());
 
 	if ((start > (pp.right() + DrawPadding)) || (end < (pp.left() - DrawPadding)))
 		return;
 
-	if (a->start_sample() == a->end_sample())
+	if (a.start_sample() == a.end_sample())
 		draw_instant(a, p, start, y);
 	else
 		draw_range(a, p, start, end, y, pp, row.title_width);
@@ -849,10 +849,10 @@ void DecodeTrace::draw_annotation_block(qreal start, qreal end,
 	}
 }
 
-void DecodeTrace::draw_instant(const Annotation* a, QPainter &p, qreal x, int y) const
+void DecodeTrace::draw_instant(const Annotation& a, QPainter &p, qreal x, int y) const
 {
-	const QString text = a->annotations()->empty() ?
-		QString() : a->annotations()->back();
+	const vector<QString> annotations = a.annotations();
+	const QString text = annotations.empty() ? QString() : annotations.back();
 	const qreal w = min((qreal)p.boundingRect(QRectF(), 0, text).width(),
 		0.0) + annotation_height_;
 	const QRectF rect(x - w / 2, y - annotation_height_ / 2, w, annotation_height_);
@@ -863,13 +863,12 @@ void DecodeTrace::draw_instant(const Annotation* a, QPainter &p, qreal x, int y)
 	p.drawText(rect, Qt::AlignCenter | Qt::AlignVCenter, text);
 }
 
-void DecodeTrace::draw_range(const Annotation* a, QPainter &p,
+void DecodeTrace::draw_range(const Annotation& a, QPainter &p,
 	qreal start, qreal end, int y, const ViewItemPaintParams &pp,
 	int row_title_width) const
 {
 	const qreal top = y + .5 - annotation_height_ / 2;
 	const qreal bottom = y + .5 + annotation_height_ / 2;
-	const vector<QString>* annotations = a->annotations();
 
 	// If the two ends are within 1 pixel, draw a vertical line
 	if (start + 1.0 > end) {
@@ -890,7 +889,8 @@ void DecodeTrace::draw_range(const Annotation* a, QPainter &p,
 
 	p.drawConvexPolygon(pts, countof(pts));
 
-	if (annotations->empty())
+	const vector<QString> annotations = a.annotations();
+	if (annotations.empty())
 		return;
 
 	const int ann_start = start + cap_width;
@@ -910,14 +910,14 @@ void DecodeTrace::draw_range(const Annotation* a, QPainter &p,
 	QString best_annotation;
 	int best_width = 0;
 
-	for (const QString &s : *annotations) {
+	for (const QString &s : annotations) {
 		const int w = p.boundingRect(QRectF(), 0, s).width();
 		if (w <= rect.width() && w > best_width)
 			best_annotation = s, best_width = w;
 	}
 
 	if (best_annotation.isEmpty())
-		best_annotation = annotations->back();
+		best_annotation = annotations.back();
 
 	// If not ellide the last in the list
 	p.drawText(rect, Qt::AlignCenter, p.fontMetrics().elidedText(
@@ -932,28 +932,41 @@ void DecodeTrace::draw_unresolved_period(QPainter &p, int left, int right) const
 	if (sample_count == 0)
 		return;
 
+	// The samples that the decoders skipped as the ring buffer dropped them
+	// before they were decoded are shown the same way as those not decoded yet
+	vector< pair<uint64_t, uint64_t> > periods =
+		decode_signal_->get_skipped_ranges(current_segment_);
+
 	const int64_t samples_decoded = decode_signal_->get_decoded_sample_count(current_segment_, true);
-	if (sample_count == samples_decoded)
+	if (sample_count != samples_decoded)
+		periods.emplace_back(samples_decoded, sample_count);
+
+	if (periods.empty())
 		return;
 
 	const int y = get_visual_y();
 
 	tie(pixels_offset, samples_per_pixel) = get_pixels_offset_samples_per_pixel();
 
-	const double start = max(samples_decoded /
-		samples_per_pixel - pixels_offset, left - 1.0);
-	const double end = min(sample_count / samples_per_pixel -
-		pixels_offset, right + 1.0);
-	const QRectF no_decode_rect(start, y - (annotation_height_ / 2) - 0.5,
-		end - start, annotation_height_);
+	for (const pair<uint64_t, uint64_t>& period : periods) {
+		const double start = max(period.first /
+			samples_per_pixel - pixels_offset, left - 1.0);
+		const double end = min(period.second / samples_per_pixel -
+			pixels_offset, right + 1.0);
+		if (end <= start)
+			continue;
+
+		const QRectF no_decode_rect(start, y - (annotation_height_ / 2) - 0.5,
+			end - start, annotation_height_);
 
-	p.setPen(QPen(Qt::NoPen));
-	p.setBrush(Qt::white);
-	p.drawRect(no_decode_rect);
+		p.setPen(QPen(Qt::NoPen));
+		p.setBrush(Qt::white);
+		p.drawRect(no_decode_rect);
 
-	p.setPen(NoDecodeColor);
-	p.setBrush(QBrush(NoDecodeColor, Qt::Dense6Pattern));
-	p.drawRect(no_decode_rect);
+		p.setPen(NoDecodeColor);
+		p.setBrush(QBrush(NoDecodeColor, Qt::Dense6Pattern));
+		p.drawRect(no_decode_rect);
+	}
 }
 
 pair<double, double> DecodeTrace::get_pixels_offset_samples_per_pixel() const
@@ -1044,19 +1057,18 @@ const QString DecodeTrace::get_annotation_at_point(const QPoint &point)
 	if (point.y() > (int)(get_row_y(r) + (annotation_height_ / 2)))
 		return QString();
 
-	deque<const Annotation*> annotations;
+	deque<Annotation> annotations;
 
 	decode_signal_->get_annotation_subset(annotations, r->decode_row,
 		current_segment_, sample_range.first, sample_range.second);
 
-	const Annotation* a = annotations.empty() ? nullptr : annotations[0];
-
 	// Create a string of the format "CLASS: VALUE"
 	QString s;
-	if (a) {
-		if (!a->ann_class_description().isEmpty())
-			s = a->ann_class_description() + ": ";
-		s += a->annotations()->front();
+	if (!annotations.empty()) {
+		const Annotation& a = annotations.front();
+		if (!a.ann_class_description().isEmpty())
+			s = a.ann_class_description() + ": ";
+		s += a.longest_annotation();
 	}
 
 	return s;
@@ -1183,7 +1195,7 @@ QComboBox* DecodeTrace::create_channel_selector_init_state(QWidget *parent,
 	return selector;
 }
 
-void DecodeTrace::export_annotations(deque<const Annotation*>& annotations) const
+void DecodeTrace::export_annotations(deque<Annotation>& annotations) const
 {
 	GlobalSettings settings;
 	const QString dir = settings.value("MainWindow/SaveDirectory").toString();
@@ -1209,37 +1221,37 @@ void DecodeTrace::export_annotations(deque<const Annotation*>& annotations) cons
 	if (file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
 		QTextStream out_stream(&file);
 
-		for (const Annotation* ann : annotations) {
+		for (const Annotation& ann : annotations) {
 			QString out_text = format;
 
 			if (has_sample_range) {
 				const QString sample_range = QString("%1-%2") \
-					.arg(QString::number(ann->start_sample()), QString::number(ann->end_sample()));
+					.arg(QString::number(ann.start_sample()), QString::number(ann.end_sample()));
 				out_text = out_text.replace("%s", sample_range);
 			}
 
 			if (has_dec_name)
 				out_text = out_text.replace("%d",
-					quote + QString::fromUtf8(ann->row()->decoder()->name()) + quote);
+					quote + QString::fromUtf8(ann.row()->decoder()->name()) + quote);
 
 			if (has_row_name) {
-				const QString row_name = quote + ann->row()->description() + quote;
+				const QString row_name = quote + ann.row()->description() + quote;
 				out_text = out_text.replace("%r", row_name);
 			}
 
 			if (has_class_name) {
-				const QString class_name = quote + ann->ann_class_name() + quote;
+				const QString class_name = quote + ann.ann_class_name() + quote;
 				out_text = out_text.replace("%c", class_name);
 			}
 
 			if (has_first_ann_text) {
-				const QString first_ann_text = quote + ann->annotations()->front() + quote;
+				const QString first_ann_text = quote + ann.longest_annotation() + quote;
 				out_text = out_text.replace("%1", first_ann_text);
 			}
 
 			if (has_all_ann_text) {
 				QString all_ann_text;
-				for (const QString &s : *(ann->annotations()))
+				for (const QString &s : ann.annotations())
 					all_ann_text = all_ann_text + quote + s + quote + ",";
 				all_ann_text.chop(1);
 
@@ -1697,7 +1709,7 @@ void DecodeTrace::on_copy_annotation_to_clipboard()
 	if (!selected_row_)
 		return;
 
-	deque<const Annotation*> annotations;
+	deque<Annotation> annotations;
 
 	decode_signal_->get_annotation_subset(annotations, selected_row_,
 		current_segment_, selected_sample_range_.first, selected_sample_range_.first);
@@ -1706,10 +1718,10 @@ void DecodeTrace::on_copy_annotation_to_clipboard()
 		return;
 
 	QClipboard *clipboard = QApplication::clipboard();
-	clipboard->setText(annotations.front()->annotations()->front(), QClipboard::Clipboard);
+	clipboard->setText(annotations.front().longest_annotation(), QClipboard::Clipboard);
 
 	if (clipboard->supportsSelection())
-		clipboard->setText(annotations.front()->annotations()->front(), QClipboard::Selection);
+		clipboard->setText(annotations.front().longest_annotation(), QClipboard::Selection);
 }
 
 void DecodeTrace::on_export_row()
@@ -1781,7 +1793,7 @@ void DecodeTrace::on_export_row_from_here()
 	if (!selected_row_)
 		return;
 
-	deque<const Annotation*> annotations;
+	deque<Annotation> annotations;
 
 	decode_signal_->get_annotation_subset(annotations, selected_row_,
 		current_segment_, selected_sample_range_.first, selected_sample_range_.second);
@@ -1794,7 +1806,7 @@ void DecodeTrace::on_export_row_from_here()
 
 void DecodeTrace::on_export_all_rows_from_here()
 {
-	deque<const Annotation*> annotations;
+	deque<Annotation> annotations;
 
 	decode_signal_->get_annotation_subset(annotations, current_segment_,
 			selected_sample_range_.first, selected_sample_range_.second);
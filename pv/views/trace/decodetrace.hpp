@@ -191,18 +191,18 @@ public:
 	virtual void mouse_left_press_event(const QMouseEvent* event);
 
 private:
-	void draw_annotations(deque<const Annotation*>& annotations, QPainter &p,
+	void draw_annotations(deque<Annotation>& annotations, QPainter &p,
 		const ViewItemPaintParams &pp, int y, const DecodeTraceRow& row);
 
-	void draw_annotation(const Annotation* a, QPainter &p,
+	void draw_annotation(const Annotation& a, QPainter &p,
 		const ViewItemPaintParams &pp, int y, const DecodeTraceRow& row) const;
 
 	void draw_annotation_block(qreal start, qreal end, uint32_t ann_class,
 		bool use_ann_format, QPainter &p, int y, const DecodeTraceRow& row) const;
 
-	void draw_instant(const Annotation* a, QPainter &p, qreal x, int y) const;
+	void draw_instant(const Annotation& a, QPainter &p, qreal x, int y) const;
 
-	void draw_range(const Annotation* a, QPainter &p, qreal start, qreal end,
+	void draw_range(const Annotation& a, QPainter &p, qreal start, qreal end,
 		int y, const ViewItemPaintParams &pp, int row_title_width) const;
 
 	void draw_error(QPainter &p, const QString &message, const ViewItemPaintParams &pp);
@@ -236,7 +236,7 @@ private:
 	QComboBox* create_channel_selector_init_state(QWidget *parent,
 		const data::decode::DecodeChannel *ch);
 
-	void export_annotations(deque<const Annotation*>& annotations) const;
+	void export_annotations(deque<Annotation>& annotations) const;
 
 	void initialize_row_widgets(DecodeTraceRow* r, unsigned int row_id);
 	void update_rows();
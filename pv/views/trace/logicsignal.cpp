@@ -23,12 +23,17 @@
 #include <cmath>
 
 #include <algorithm>
+#include <map>
+#include <tuple>
 
 #include <QApplication>
 #include <QFormLayout>
+#include <QLabel>
 #include <QToolBar>
 
+#include "cursorpair.hpp"
 #include "logicsignal.hpp"
+#include "ruler.hpp"
 #include "view.hpp"
 
 #include <pv/data/logic.hpp>
@@ -42,6 +47,8 @@
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
 using std::deque;
+using std::get;
+using std::map;
 using std::max;
 using std::make_pair;
 using std::min;
@@ -49,6 +56,8 @@ using std::none_of;
 using std::out_of_range;
 using std::pair;
 using std::shared_ptr;
+using std::swap;
+using std::tuple;
 using std::vector;
 
 using sigrok::ConfigKey;
@@ -58,6 +67,8 @@ using sigrok::TriggerMatch;
 using sigrok::TriggerMatchType;
 
 using pv::data::LogicSegment;
+using pv::util::SIPrefix;
+using pv::util::Timestamp;
 
 namespace pv {
 namespace views {
@@ -94,7 +105,10 @@ LogicSignal::LogicSignal(pv::Session &session, shared_ptr<data::SignalBase> base
 	trigger_high_(nullptr),
 	trigger_falling_(nullptr),
 	trigger_low_(nullptr),
-	trigger_change_(nullptr)
+	trigger_change_(nullptr),
+	prefetched_start_(0),
+	prefetched_end_(0),
+	prefetched_samples_per_pixel_(0)
 {
 	GlobalSettings settings;
 	signal_height_ = settings.value(GlobalSettings::Key_View_DefaultLogicHeight).toInt();
@@ -168,33 +182,32 @@ void LogicSignal::paint_mid(QPainter &p, ViewItemPaintParams &pp)
 	const float high_offset = y + high_level_offset_;
 	const float fill_height = low_offset - high_offset;
 
-	shared_ptr<LogicSegment> segment = get_logic_segment_to_paint();
-	if (!segment || (segment->get_sample_count() == 0))
+	int64_t start_sample;
+	uint64_t end_sample;
+	double samples_per_pixel;
+	shared_ptr<LogicSegment> segment = get_paint_range(pp, start_sample,
+		end_sample, samples_per_pixel);
+	if (!segment)
 		return;
 
-	double samplerate = segment->samplerate();
-
-	// Show sample rate as 1Hz when it is unknown
-	if (samplerate == 0.0)
-		samplerate = 1.0;
-
 	const double pixels_offset = pp.pixels_offset();
-	const pv::util::Timestamp& start_time = segment->start_time();
-	const int64_t last_sample = (int64_t)segment->get_sample_count() - 1;
-	const double samples_per_pixel = samplerate * pp.scale();
 	const double pixels_per_sample = 1 / samples_per_pixel;
-	const pv::util::Timestamp start = samplerate * (pp.offset() - start_time);
-	const pv::util::Timestamp end = start + samples_per_pixel * pp.width();
 
-	const int64_t start_sample = min(max(floor(start).convert_to<int64_t>(),
-		(int64_t)0), last_sample);
-	const uint64_t end_sample = min(max(ceil(end).convert_to<int64_t>(),
-		(int64_t)0), last_sample);
-
-	segment->get_subsampled_edges(edges, start_sample, end_sample,
-		samples_per_pixel / Oversampling, base_->logic_bit_index());
+	// Use the prefetched edges unless the segment or the view changed since.
+	// During an acquisition, samples may have been added meanwhile, which are
+	// then painted with the next frame.
+	if ((prefetched_segment_ == segment) && (prefetched_start_ == start_sample) &&
+		(prefetched_end_ <= end_sample) &&
+		(prefetched_samples_per_pixel_ == samples_per_pixel))
+		edges.swap(prefetched_edges_);
+	else
+		segment->get_subsampled_edges(edges, start_sample, end_sample,
+			samples_per_pixel / Oversampling, base_->logic_bit_index());
 	assert(edges.size() >= 2);
 
+	prefetched_segment_.reset();
+	prefetched_edges_.clear();
+
 	const float first_sample_x =
 		pp.left() + (edges.front().first / samples_per_pixel - pixels_offset);
 	const float last_sample_x =
@@ -359,14 +372,9 @@ vector<LogicSegment::EdgePair> LogicSignal::get_nearest_level_changes(uint64_t s
 	if (!segment || (segment->get_sample_count() == 0))
 		return vector<LogicSegment::EdgePair>();
 
-	const View *view = owner_->view();
-	assert(view);
-	const double samples_per_pixel = base_->get_samplerate() * view->scale();
-
 	vector<LogicSegment::EdgePair> edges;
 
-	segment->get_surrounding_edges(edges, sample_pos,
-		samples_per_pixel / Oversampling, base_->index());
+	segment->get_surrounding_edges(edges, sample_pos, base_->index());
 
 	if (edges.empty())
 		return vector<LogicSegment::EdgePair>();
@@ -393,6 +401,85 @@ void LogicSignal::paint_caps(QPainter &p, QLineF *const lines,
 	p.drawLines(lines, line - lines);
 }
 
+void LogicSignal::prefetch_edges(const vector< shared_ptr<LogicSignal> > &signals,
+	const ViewItemPaintParams &pp)
+{
+	// Signals showing the same range of a segment are fetched together
+	typedef tuple<shared_ptr<LogicSegment>, int64_t, uint64_t, double> Range;
+	map< Range, vector<LogicSignal*> > signals_by_range;
+
+	for (const shared_ptr<LogicSignal>& signal : signals) {
+		assert(signal);
+
+		signal->prefetched_segment_.reset();
+		signal->prefetched_edges_.clear();
+
+		if (!signal->base_->enabled())
+			continue;
+
+		int64_t start_sample;
+		uint64_t end_sample;
+		double samples_per_pixel;
+		shared_ptr<LogicSegment> segment = signal->get_paint_range(pp,
+			start_sample, end_sample, samples_per_pixel);
+		if (!segment)
+			continue;
+
+		signals_by_range[Range(segment, start_sample, end_sample,
+			samples_per_pixel)].push_back(signal.get());
+	}
+
+	for (const auto& entry : signals_by_range) {
+		const Range &range = entry.first;
+		const vector<LogicSignal*> &range_signals = entry.second;
+
+		vector<int> sig_indices;
+		for (const LogicSignal *signal : range_signals)
+			sig_indices.push_back(signal->base_->logic_bit_index());
+
+		vector< vector<LogicSegment::EdgePair> > edges;
+		get<0>(range)->get_subsampled_edges(edges, get<1>(range), get<2>(range),
+			get<3>(range) / Oversampling, sig_indices);
+
+		for (size_t i = 0; i < range_signals.size(); i++) {
+			LogicSignal *const signal = range_signals[i];
+			signal->prefetched_segment_ = get<0>(range);
+			signal->prefetched_start_ = get<1>(range);
+			signal->prefetched_end_ = get<2>(range);
+			signal->prefetched_samples_per_pixel_ = get<3>(range);
+			signal->prefetched_edges_.swap(edges[i]);
+		}
+	}
+}
+
+shared_ptr<pv::data::LogicSegment> LogicSignal::get_paint_range(
+	const ViewItemPaintParams &pp, int64_t &start_sample,
+	uint64_t &end_sample, double &samples_per_pixel) const
+{
+	shared_ptr<LogicSegment> segment = get_logic_segment_to_paint();
+	if (!segment || (segment->get_sample_count() == 0))
+		return nullptr;
+
+	double samplerate = segment->samplerate();
+
+	// Show sample rate as 1Hz when it is unknown
+	if (samplerate == 0.0)
+		samplerate = 1.0;
+
+	const pv::util::Timestamp& start_time = segment->start_time();
+	const int64_t last_sample = (int64_t)segment->get_sample_count() - 1;
+	samples_per_pixel = samplerate * pp.scale();
+	const pv::util::Timestamp start = samplerate * (pp.offset() - start_time);
+	const pv::util::Timestamp end = start + samples_per_pixel * pp.width();
+
+	start_sample = min(max(floor(start).convert_to<int64_t>(),
+		(int64_t)0), last_sample);
+	end_sample = min(max(ceil(end).convert_to<int64_t>(),
+		(int64_t)0), last_sample);
+
+	return segment;
+}
+
 shared_ptr<pv::data::LogicSegment> LogicSignal::get_logic_segment_to_paint() const
 {
 	shared_ptr<pv::data::LogicSegment> segment;
@@ -538,6 +625,8 @@ void LogicSignal::populate_popup_form(QWidget *parent, QFormLayout *form)
 		this, SLOT(on_signal_height_changed(int)));
 	form->addRow(tr("Trace height"), signal_height_sb_);
 
+	add_stats_rows(parent, form);
+
 	// Trigger settings
 	const vector<int32_t> trig_types = get_trigger_types();
 
@@ -564,6 +653,83 @@ void LogicSignal::populate_popup_form(QWidget *parent, QFormLayout *form)
 	}
 }
 
+QString LogicSignal::format_stats(const Timestamp &start,
+	const Timestamp &end) const
+{
+	const shared_ptr<LogicSegment> segment = get_logic_segment_to_paint();
+	if (!segment)
+		return QString();
+
+	double samplerate = segment->samplerate();
+	if (samplerate == 0.0)
+		samplerate = 1.0;
+
+	Timestamp first = (start - segment->start_time()) * samplerate;
+	Timestamp last = (end - segment->start_time()) * samplerate;
+	if (first > last)
+		swap(first, last);
+
+	// Times before the segment start at its first sample
+	const LogicSegment::ChannelStats stats = segment->get_channel_stats(
+		base_->logic_bit_index(),
+		(first > 0) ? first.convert_to<uint64_t>() : 0,
+		(last > 0) ? last.convert_to<uint64_t>() : 0);
+
+	return format_stats(stats);
+}
+
+QString LogicSignal::format_stats(const LogicSegment::ChannelStats &stats) const
+{
+	if (stats.sample_count == 0)
+		return QString();
+
+	return tr("%1 edges, %2 % high").arg(stats.edge_count).arg(
+		100.0 * stats.high_count / stats.sample_count, 0, 'f', 2);
+}
+
+QString LogicSignal::format_edge_time(const LogicSegment &segment,
+	uint64_t sample) const
+{
+	const double samplerate = segment.samplerate();
+	if ((samplerate == 0.0) || !owner_)
+		return tr("Sample %1").arg(sample);
+
+	const Timestamp time = segment.start_time() + Timestamp(sample) / samplerate;
+
+	return pv::util::format_time_si(
+		owner_->view()->ruler()->get_ruler_time_from_absolute_time(time),
+		SIPrefix::unspecified, 3, "s", false);
+}
+
+void LogicSignal::add_stats_rows(QWidget *parent, QFormLayout *form)
+{
+	const shared_ptr<LogicSegment> segment = get_logic_segment_to_paint();
+	if (!segment)
+		return;
+
+	// The counts come from the running statistics of the segment, so they
+	// are available right away even for long captures
+	const LogicSegment::ChannelStats stats = segment->get_channel_stats(
+		base_->logic_bit_index(), 0, segment->get_sample_count());
+	if (stats.sample_count == 0)
+		return;
+
+	form->addRow(tr("Statistics"), new QLabel(format_stats(stats), parent));
+
+	if (stats.has_edges)
+		form->addRow(tr("Edges"), new QLabel(tr("%1 to %2").arg(
+			format_edge_time(*segment, stats.first_edge),
+			format_edge_time(*segment, stats.last_edge)), parent));
+
+	if (owner_ && owner_->view()->cursors_shown()) {
+		const shared_ptr<CursorPair> cursors = owner_->view()->cursors();
+		const QString text = format_stats(cursors->first()->time(),
+			cursors->second()->time());
+		if (!text.isEmpty())
+			form->addRow(tr("Between cursors"), new QLabel(text, parent));
+	}
+}
+
 void LogicSignal::modify_trigger()
 {
 	auto trigger = session_.session()->trigger();
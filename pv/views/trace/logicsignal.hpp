@@ -105,7 +105,33 @@ public:
 	 */
 	virtual vector<data::LogicSegment::EdgePair> get_nearest_level_changes(uint64_t sample_pos);
 
+	/**
+	 * Fetches the edges that paint_mid() needs for several signals before
+	 * they're painted. The edges of signals showing the same segment are
+	 * extracted in a single pass over the segment.
+	 * @param signals the signals to fetch the edges for.
+	 * @param pp the painting parameters that paint_mid() will be called with.
+	 */
+	static void prefetch_edges(const vector< shared_ptr<LogicSignal> > &signals,
+		const ViewItemPaintParams &pp);
+
+	/**
+	 * Returns the number of edges and the duty cycle of the channel between
+	 * two points in time of the segment that is shown, or an empty string
+	 * if there are no samples in between.
+	 */
+	QString format_stats(const pv::util::Timestamp &start,
+		const pv::util::Timestamp &end) const;
+
 protected:
+	/**
+	 * Determines the segment and the range of samples that paint_mid()
+	 * shows. Returns nullptr if there is nothing to paint.
+	 */
+	shared_ptr<pv::data::LogicSegment> get_paint_range(
+		const ViewItemPaintParams &pp, int64_t &start_sample,
+		uint64_t &end_sample, double &samples_per_pixel) const;
+
 	void paint_caps(QPainter &p, QLineF *const lines,
 		vector< pair<int64_t, bool> > &edges,
 		bool level, double samples_per_pixel, double pixels_offset,
@@ -113,6 +139,12 @@ protected:
 
 	shared_ptr<pv::data::LogicSegment> get_logic_segment_to_paint() const;
 
+	QString format_stats(const data::LogicSegment::ChannelStats &stats) const;
+	QString format_edge_time(const pv::data::LogicSegment &segment,
+		uint64_t sample) const;
+
+	void add_stats_rows(QWidget *parent, QFormLayout *form);
+
 	void init_trigger_actions(QWidget *parent);
 
 	const vector<int32_t> get_trigger_types() const;
@@ -151,6 +183,13 @@ protected:
 	QAction *trigger_low_;
 	QAction *trigger_change_;
 
+	// The edges fetched by prefetch_edges() for the next paint_mid() call
+	shared_ptr<pv::data::LogicSegment> prefetched_segment_;
+	int64_t prefetched_start_;
+	uint64_t prefetched_end_;
+	double prefetched_samples_per_pixel_;
+	vector<data::LogicSegment::EdgePair> prefetched_edges_;
+
 	static QCache<QString, const QIcon> icon_cache_;
 	static QCache<QString, const QPixmap> pixmap_cache_;
 
@@ -25,6 +25,8 @@
 #include "view.hpp"
 
 #include <pv/mainwindow.hpp>
+#include <pv/dialogs/findpattern.hpp>
+#include <pv/dialogs/pulsetiming.hpp>
 
 using pv::views::trace::View;
 
@@ -42,6 +44,10 @@ StandardBar::StandardBar(Session &session, QWidget *parent,
 	action_view_zoom_out_(new QAction(this)),
 	action_view_zoom_fit_(new QAction(this)),
 	action_view_show_cursors_(new QAction(this)),
+	action_view_find_pattern_(new QAction(this)),
+	find_pattern_dialog_(nullptr),
+	action_view_pulse_timing_(new QAction(this)),
+	pulse_timing_dialog_(nullptr),
 	segment_display_mode_selector_(new QToolButton(this)),
 	action_sdm_last_(new QAction(this)),
 	action_sdm_last_complete_(new QAction(this)),
@@ -81,6 +87,16 @@ StandardBar::StandardBar(Session &session, QWidget *parent,
 		this, SLOT(on_actionViewShowCursors_triggered()));
 	action_view_show_cursors_->setText(tr("Show &Cursors"));
 
+	action_view_find_pattern_->setIcon(QIcon::fromTheme("edit-find"));
+	action_view_find_pattern_->setShortcut(QKeySequence::Find);
+	connect(action_view_find_pattern_, SIGNAL(triggered(bool)),
+		this, SLOT(on_actionViewFindPattern_triggered()));
+	action_view_find_pattern_->setText(tr("Find &Pattern..."));
+
+	connect(action_view_pulse_timing_, SIGNAL(triggered(bool)),
+		this, SLOT(on_actionViewPulseTiming_triggered()));
+	action_view_pulse_timing_->setText(tr("Pulse &Timing..."));
+
 	action_sdm_last_->setIcon(QIcon(":/icons/view-displaymode-last_segment.svg"));
 	action_sdm_last_->setText(tr("Display last segment only"));
 	connect(action_sdm_last_, SIGNAL(triggered(bool)),
@@ -145,6 +161,8 @@ void StandardBar::add_toolbar_widgets()
 	addAction(action_view_zoom_fit_);
 	addSeparator();
 	addAction(action_view_show_cursors_);
+	addAction(action_view_find_pattern_);
+	addAction(action_view_pulse_timing_);
 	multi_segment_actions_.push_back(addSeparator());
 	multi_segment_actions_.push_back(addWidget(segment_display_mode_selector_));
 	multi_segment_actions_.push_back(addWidget(segment_selector_));
@@ -183,6 +201,16 @@ QAction* StandardBar::action_view_show_cursors() const
 	return action_view_show_cursors_;
 }
 
+QAction* StandardBar::action_view_find_pattern() const
+{
+	return action_view_find_pattern_;
+}
+
+QAction* StandardBar::action_view_pulse_timing() const
+{
+	return action_view_pulse_timing_;
+}
+
 void StandardBar::on_actionViewZoomIn_triggered()
 {
 	view_->zoom(1);
@@ -208,6 +236,26 @@ void StandardBar::on_actionViewShowCursors_triggered()
 	view_->show_cursors(show);
 }
 
+void StandardBar::on_actionViewFindPattern_triggered()
+{
+	if (!find_pattern_dialog_)
+		find_pattern_dialog_ = new dialogs::FindPattern(session_, *view_, this);
+
+	find_pattern_dialog_->show();
+	find_pattern_dialog_->raise();
+	find_pattern_dialog_->activateWindow();
+}
+
+void StandardBar::on_actionViewPulseTiming_triggered()
+{
+	if (!pulse_timing_dialog_)
+		pulse_timing_dialog_ = new dialogs::PulseTiming(session_, *view_, this);
+
+	pulse_timing_dialog_->show();
+	pulse_timing_dialog_->raise();
+	pulse_timing_dialog_->activateWindow();
+}
+
 void StandardBar::on_actionSDMLast_triggered()
 {
 	view_->set_segment_display_mode(Trace::ShowLastSegmentOnly);
@@ -38,6 +38,11 @@ namespace pv {
 class MainWindow;
 class Session;
 
+namespace dialogs {
+class FindPattern;
+class PulseTiming;
+}
+
 namespace views {
 
 namespace trace {
@@ -60,6 +65,8 @@ public:
 	QAction* action_view_zoom_out() const;
 	QAction* action_view_zoom_fit() const;
 	QAction* action_view_show_cursors() const;
+	QAction* action_view_find_pattern() const;
+	QAction* action_view_pulse_timing() const;
 
 protected:
 	virtual void add_toolbar_widgets();
@@ -73,6 +80,10 @@ protected:
 	QAction *const action_view_zoom_out_;
 	QAction *const action_view_zoom_fit_;
 	QAction *const action_view_show_cursors_;
+	QAction *const action_view_find_pattern_;
+	dialogs::FindPattern *find_pattern_dialog_;
+	QAction *const action_view_pulse_timing_;
+	dialogs::PulseTiming *pulse_timing_dialog_;
 
 	QToolButton *segment_display_mode_selector_;
 	QAction *const action_sdm_last_;
@@ -94,6 +105,9 @@ protected Q_SLOTS:
 	void on_actionViewShowCursors_triggered();
 	void on_cursor_state_changed(bool show);
 
+	void on_actionViewFindPattern_triggered();
+	void on_actionViewPulseTiming_triggered();
+
 	void on_actionSDMLast_triggered();
 	void on_actionSDMLastComplete_triggered();
 	void on_actionSDMSingle_triggered();
@@ -944,9 +944,13 @@ pair<Timestamp, Timestamp> View::get_time_extents() const
 			samplerate = (samplerate <= 0.0) ? 1.0 : samplerate;
 
 			const Timestamp start_time = s->start_time();
+
+			// Ring buffers only keep the most recent samples
+			const Timestamp first_time =
+				start_time + s->get_first_sample() / samplerate;
 			left_time = left_time ?
-				min(*left_time, start_time) :
-				                start_time;
+				min(*left_time, first_time) :
+				                first_time;
 			right_time = right_time ?
 				max(*right_time, start_time + d->max_sample_count() / samplerate) :
 				                 start_time + d->max_sample_count() / samplerate;
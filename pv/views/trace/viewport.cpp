@@ -22,6 +22,7 @@
 #include <cmath>
 #include <limits>
 
+#include "logicsignal.hpp"
 #include "signal.hpp"
 #include "view.hpp"
 #include "viewitempaintparams.hpp"
@@ -40,6 +41,7 @@ using std::back_inserter;
 using std::copy;
 using std::dynamic_pointer_cast;
 using std::none_of; // NOLINT. Used in assert()s.
+using std::pair;
 using std::shared_ptr;
 using std::stable_sort;
 using std::vector;
@@ -223,6 +225,23 @@ void Viewport::paintEvent(QPaintEvent*)
 	assert(none_of(time_items.begin(), time_items.end(),
 		[](const shared_ptr<TimeItem> &t) { return !t; }));
 
+	// Fetch the edges of all visible logic signals up front, so that the
+	// signals sharing a segment only walk it once
+	const QRect r = rect();
+	vector< shared_ptr<LogicSignal> > logic_signals;
+	for (const shared_ptr<ViewItem>& item : row_items) {
+		const shared_ptr<LogicSignal> signal = dynamic_pointer_cast<LogicSignal>(item);
+		if (!signal)
+			continue;
+
+		const int y = signal->get_visual_y();
+		const pair<int, int> extents = signal->v_extents();
+		if ((y + extents.second >= r.top()) && (y + extents.first <= r.bottom()))
+			logic_signals.push_back(signal);
+	}
+	LogicSignal::prefetch_edges(logic_signals,
+		ViewItemPaintParams(r, view_.scale(), view_.offset()));
+
 	QPainter p(this);
 
 	// Disable antialiasing for high-DPI displays
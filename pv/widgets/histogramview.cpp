@@ -0,0 +1,105 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <QFontMetrics>
+#include <QPainter>
+
+#include "histogramview.hpp"
+
+using std::max;
+using std::max_element;
+
+namespace pv {
+namespace widgets {
+
+const int HistogramView::Margin = 4;
+
+HistogramView::HistogramView(QWidget *parent) :
+	QWidget(parent)
+{
+	setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+}
+
+void HistogramView::set_bins(const vector<uint64_t> &bins,
+	const QString &first_label, const QString &last_label)
+{
+	bins_ = bins;
+	first_label_ = first_label;
+	last_label_ = last_label;
+	update();
+}
+
+void HistogramView::clear()
+{
+	bins_.clear();
+	first_label_.clear();
+	last_label_.clear();
+	update();
+}
+
+QSize HistogramView::sizeHint() const
+{
+	return QSize(400, 200);
+}
+
+void HistogramView::paintEvent(QPaintEvent *event)
+{
+	(void)event;
+
+	QPainter p(this);
+	p.fillRect(rect(), palette().color(QPalette::Base));
+
+	if (bins_.empty())
+		return;
+
+	const int text_height = QFontMetrics(font()).height();
+	const QRect area = rect().adjusted(Margin, Margin, -Margin,
+		-Margin - text_height);
+	if ((area.width() <= 0) || (area.height() <= 0))
+		return;
+
+	const uint64_t highest = *max_element(bins_.begin(), bins_.end());
+	const double bin_width = (double)area.width() / bins_.size();
+
+	p.setPen(Qt::NoPen);
+	p.setBrush(palette().color(QPalette::Highlight));
+
+	for (size_t i = 0; i < bins_.size(); i++) {
+		if (bins_[i] == 0)
+			continue;
+
+		// Bins that aren't empty are at least a pixel high
+		const int height = max(1, (int)((double)area.height() * bins_[i] /
+			max<uint64_t>(highest, 1)));
+		const int left = area.left() + (int)(i * bin_width);
+		const int right = area.left() + (int)((i + 1) * bin_width);
+
+		p.drawRect(left, area.bottom() - height + 1, max(1, right - left), height);
+	}
+
+	p.setPen(palette().color(QPalette::Text));
+	const QRect labels(area.left(), area.bottom() + 1, area.width(), text_height);
+	p.drawText(labels, Qt::AlignLeft | Qt::AlignVCenter, first_label_);
+	p.drawText(labels, Qt::AlignRight | Qt::AlignVCenter, last_label_);
+}
+
+}  // namespace widgets
+}  // namespace pv
@@ -0,0 +1,66 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_WIDGETS_HISTOGRAMVIEW_HPP
+#define PULSEVIEW_PV_WIDGETS_HISTOGRAMVIEW_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <QString>
+#include <QWidget>
+
+using std::vector;
+
+namespace pv {
+namespace widgets {
+
+/**
+ * Draws the bins of a histogram as bars, with the labels of the first and
+ * the last bin below them.
+ */
+class HistogramView : public QWidget
+{
+	Q_OBJECT
+
+private:
+	static const int Margin;
+
+public:
+	HistogramView(QWidget *parent = nullptr);
+
+	void set_bins(const vector<uint64_t> &bins, const QString &first_label,
+		const QString &last_label);
+
+	void clear();
+
+	QSize sizeHint() const override;
+
+private:
+	void paintEvent(QPaintEvent *event) override;
+
+private:
+	vector<uint64_t> bins_;
+	QString first_label_, last_label_;
+};
+
+}  // namespace widgets
+}  // namespace pv
+
+#endif // PULSEVIEW_PV_WIDGETS_HISTOGRAMVIEW_HPP
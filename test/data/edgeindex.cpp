@@ -0,0 +1,92 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/edgeindex.hpp>
+
+using std::vector;
+
+using pv::data::EdgeIndex;
+
+BOOST_AUTO_TEST_SUITE(EdgeIndexTest)
+
+BOOST_AUTO_TEST_CASE(RankSelect)
+{
+	// Mix short and long gaps so that multi-byte deltas are covered
+	vector<uint64_t> positions;
+	uint64_t position = 1;
+	srand(1);
+	for (unsigned int i = 0; i < 1000; i++) {
+		positions.push_back(position);
+		position += ((rand() % 10) == 0) ? 1 + rand() % 1000000 : 1 + rand() % 100;
+	}
+
+	EdgeIndex index;
+	index.append(vector<uint64_t>(positions.begin(), positions.begin() + 300));
+	index.append(vector<uint64_t>(positions.begin() + 300, positions.end()));
+
+	BOOST_CHECK_EQUAL(index.first_rank(), 0);
+	BOOST_CHECK_EQUAL(index.end_rank(), positions.size());
+	BOOST_CHECK(index.memory_usage() > 0);
+
+	for (uint64_t r = 0; r < positions.size(); r++) {
+		BOOST_CHECK_EQUAL(index.select(r), positions[r]);
+		BOOST_CHECK_EQUAL(index.rank(positions[r]), r);
+		BOOST_CHECK_EQUAL(index.rank(positions[r] + 1), r + 1);
+	}
+
+	BOOST_CHECK_EQUAL(index.rank(0), 0);
+	BOOST_CHECK_EQUAL(index.rank(position), positions.size());
+}
+
+BOOST_AUTO_TEST_CASE(DropBefore)
+{
+	vector<uint64_t> positions;
+	for (uint64_t i = 0; i < 10 * EdgeIndex::BlockEdges; i++)
+		positions.push_back(10 + 3 * i);
+
+	EdgeIndex index;
+	index.append(positions);
+
+	// Blocks are only dropped as a whole
+	const uint64_t sample = positions[2 * EdgeIndex::BlockEdges + 5];
+	index.drop_before(sample);
+
+	BOOST_CHECK_EQUAL(index.first_rank(), 2 * EdgeIndex::BlockEdges);
+	BOOST_CHECK_EQUAL(index.end_rank(), positions.size());
+	BOOST_CHECK_EQUAL(index.rank(0), index.first_rank());
+	BOOST_CHECK_EQUAL(index.rank(sample), 2 * EdgeIndex::BlockEdges + 5);
+	BOOST_CHECK_EQUAL(index.select(index.first_rank()),
+		positions[2 * EdgeIndex::BlockEdges]);
+
+	// Ranks stay the same for new edges
+	index.append(vector<uint64_t>(1, positions.back() + 100));
+	BOOST_CHECK_EQUAL(index.select(positions.size()), positions.back() + 100);
+
+	index.clear();
+	BOOST_CHECK_EQUAL(index.end_rank(), 0);
+	BOOST_CHECK_EQUAL(index.rank(sample), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,114 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_TEST_DATA_LOGICDATA_HPP
+#define PULSEVIEW_TEST_DATA_LOGICDATA_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <pv/data/logic.hpp>
+#include <pv/data/logicsegment.hpp>
+
+using std::make_shared;
+using std::max;
+using std::min;
+using std::shared_ptr;
+using std::vector;
+
+/**
+ * A logic segment holding a copy of some samples, along with the data it
+ * belongs to. Samples of type T have 8 * sizeof(T) channels. With a sample
+ * limit, the samples are appended in parts like during an acquisition, so
+ * that the oldest ones are dropped.
+ */
+struct TestLogicData
+{
+	template <class T>
+	TestLogicData(const vector<T> &samples, uint64_t sample_limit = 0) :
+		logic(8 * sizeof(T)),
+		segment(make_shared<pv::data::LogicSegment>(logic, 0, sizeof(T), 1000))
+	{
+		if (sample_limit == 0) {
+			segment->append_payload((void*)samples.data(),
+				samples.size() * sizeof(T));
+			return;
+		}
+
+		segment->set_sample_limit(sample_limit);
+
+		const uint64_t payload_length = max(sample_limit / 4, (uint64_t)1);
+		for (uint64_t i = 0; i < samples.size(); i += payload_length)
+			segment->append_payload((void*)(samples.data() + i),
+				min(payload_length, samples.size() - i) * sizeof(T));
+	}
+
+	pv::data::Logic logic;
+	shared_ptr<pv::data::LogicSegment> segment;
+};
+
+/**
+ * Returns 8 channels of random samples. Channel 0 is a clock whose half
+ * periods last from @c min_width to @c max_width samples, channel b of
+ * the others toggles with a probability of 1 in (rare_rate << (b - 1)).
+ * The same samples are returned on every call.
+ */
+inline vector<uint8_t> make_clock_samples(uint64_t length, uint64_t min_width,
+	uint64_t max_width, int rare_rate)
+{
+	vector<uint8_t> samples(length);
+	uint8_t state = 0;
+	uint64_t next_toggle = 0;
+
+	srand(1);
+	for (uint64_t i = 0; i < length; i++) {
+		if (i == next_toggle) {
+			state ^= 0x01;
+			next_toggle += min_width + rand() % (max_width - min_width + 1);
+		}
+		for (int bit = 1; bit < 8; bit++)
+			if ((rand() % (rare_rate << (bit - 1))) == 0)
+				state ^= 1 << bit;
+		samples[i] = state;
+	}
+
+	return samples;
+}
+
+/**
+ * Returns the samples in [start, end) at which channel @c bit differs from
+ * the sample before. The first sample has none, so it's never an edge.
+ */
+template <class T>
+vector<uint64_t> find_edges(const vector<T> &samples, int bit,
+	uint64_t start, uint64_t end)
+{
+	vector<uint64_t> edges;
+
+	for (uint64_t i = max(start, (uint64_t)1); i < end; i++)
+		if (((samples[i] ^ samples[i - 1]) >> bit) & 1)
+			edges.push_back(i);
+
+	return edges;
+}
+
+#endif // PULSEVIEW_TEST_DATA_LOGICDATA_HPP
@@ -20,15 +20,16 @@
 #include <extdef.h>
 
 #include <cstdint>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
 #include <pv/data/logicsegment.hpp>
 
-#if 0
+#include "logicdata.hpp"
+
 using pv::data::LogicSegment;
 using std::vector;
-#endif
 
 // Dummy, remove again when unit tests are fixed.
 BOOST_AUTO_TEST_SUITE(DummyTestSuite)
@@ -38,6 +39,43 @@ BOOST_AUTO_TEST_CASE(DummyTestCase)
 }
 BOOST_AUTO_TEST_SUITE_END()
 
+BOOST_AUTO_TEST_SUITE(SubsampledEdgesTest)
+
+BOOST_AUTO_TEST_CASE(MultipleChannels)
+{
+	// Not a multiple of the mip-map block length, so that the last
+	// samples are searched one by one
+	const uint64_t length = 1000003;
+
+	// Channel 0 toggles every 7 samples, the others at random with
+	// decreasing rates
+	const vector<uint8_t> samples = make_clock_samples(length, 7, 7, 200);
+	TestLogicData data(samples);
+	LogicSegment &segment = *data.segment;
+
+	// Channel 3 is used by two signals
+	const vector<int> sig_indices = {0, 3, 7, 3, 1, 6};
+	const vector< vector<uint64_t> > ranges = {
+		{0, length}, {1234, length - 777}, {500000, 500100}, {42, 42}};
+
+	for (float min_length : {1.0f, 3.5f, 16.0f, 100.0f, 1000.0f, 40000.0f})
+		for (const vector<uint64_t> &range : ranges) {
+			vector< vector<LogicSegment::EdgePair> > edges;
+			segment.get_subsampled_edges(edges, range[0], range[1],
+				min_length, sig_indices);
+			BOOST_REQUIRE_EQUAL(edges.size(), sig_indices.size());
+
+			for (size_t i = 0; i < sig_indices.size(); i++) {
+				vector<LogicSegment::EdgePair> expected;
+				segment.get_subsampled_edges(expected, range[0], range[1],
+					min_length, sig_indices[i]);
+				BOOST_CHECK(edges[i] == expected);
+			}
+		}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 #if 0
 BOOST_AUTO_TEST_SUITE(LogicSegmentTest)
 
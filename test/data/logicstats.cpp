@@ -0,0 +1,166 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/logicstats.hpp>
+
+#include "logicdata.hpp"
+
+using pv::data::LogicSegment;
+using pv::data::LogicStats;
+using std::max;
+using std::vector;
+
+// Not a multiple of the block length, so that the last block is partial
+static const uint64_t Length = 100 * LogicStats::BlockLength + 123;
+
+// The channels of the low byte toggle with a probability of 1 in 4, those
+// of the high byte with 1 in 64
+static vector<uint16_t> make_samples(uint64_t length)
+{
+	vector<uint16_t> samples(length);
+	uint64_t x = 1;
+	uint16_t state = 0x5555;
+
+	for (uint64_t i = 0; i < length; i++) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+
+		state ^= (x & (x >> 16)) & (0x00ff | ((x >> 32) & (x >> 48)));
+		samples[i] = state;
+	}
+
+	return samples;
+}
+
+static LogicSegment::ChannelStats count(const vector<uint16_t> &samples,
+	int bit, uint64_t first_sample, uint64_t start, uint64_t end)
+{
+	LogicSegment::ChannelStats stats = LogicSegment::ChannelStats();
+	stats.sample_count = end - start;
+
+	for (uint64_t i = start; i < end; i++)
+		stats.high_count += (samples[i] >> bit) & 1;
+
+	const vector<uint64_t> edges = find_edges(samples, bit,
+		max(start, first_sample + 1), end);
+	stats.edge_count = edges.size();
+	stats.has_edges = !edges.empty();
+	if (stats.has_edges) {
+		stats.first_edge = edges.front();
+		stats.last_edge = edges.back();
+	}
+
+	return stats;
+}
+
+static void check_stats(LogicSegment &segment, const vector<uint16_t> &samples,
+	int bit, uint64_t start, uint64_t end)
+{
+	// Dropped samples are left out
+	const uint64_t first_sample = segment.get_first_sample();
+	const LogicSegment::ChannelStats expected = count(samples, bit,
+		first_sample, max(start, first_sample), end);
+	const LogicSegment::ChannelStats stats =
+		segment.get_channel_stats(bit, start, end);
+
+	BOOST_CHECK_EQUAL(stats.sample_count, expected.sample_count);
+	BOOST_CHECK_EQUAL(stats.edge_count, expected.edge_count);
+	BOOST_CHECK_EQUAL(stats.high_count, expected.high_count);
+	BOOST_REQUIRE_EQUAL(stats.has_edges, expected.has_edges);
+
+	if (expected.has_edges) {
+		BOOST_CHECK_EQUAL(stats.first_edge, expected.first_edge);
+		BOOST_CHECK_EQUAL(stats.last_edge, expected.last_edge);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(LogicStatsTest)
+
+BOOST_AUTO_TEST_CASE(Blocks)
+{
+	const vector<uint16_t> samples = make_samples(Length);
+
+	LogicStats stats(2);
+	stats.append((const uint8_t*)samples.data(), 3);
+	BOOST_CHECK_EQUAL(stats.end_block(), 3);
+
+	for (unsigned int c = 0; c < 16; c++) {
+		const LogicSegment::ChannelStats expected =
+			count(samples, c, 0, 0, 3 * LogicStats::BlockLength);
+		BOOST_CHECK_EQUAL(stats.edge_count(c, 3) - stats.edge_count(c, 0),
+			expected.edge_count);
+		BOOST_CHECK_EQUAL(stats.high_count(c, 3) - stats.high_count(c, 0),
+			expected.high_count);
+	}
+
+	// The counts of the remaining boundaries stay the same
+	const uint64_t edges = stats.edge_count(0, 3);
+	stats.drop_before(2 * LogicStats::BlockLength + 1);
+	BOOST_CHECK_EQUAL(stats.first_block(), 2);
+	BOOST_CHECK_EQUAL(stats.edge_count(0, 3), edges);
+}
+
+BOOST_AUTO_TEST_CASE(Ranges)
+{
+	const vector<uint16_t> samples = make_samples(Length);
+	TestLogicData data(samples);
+	LogicSegment &segment = *data.segment;
+
+	const uint64_t block = LogicStats::BlockLength;
+	const vector< vector<uint64_t> > ranges = {
+		{0, Length}, {1, Length - 1}, {0, 1}, {block, 2 * block},
+		{block - 1, block + 1}, {3 * block + 7, 90 * block + 5},
+		{17, 500}, {99 * block, Length}};
+
+	for (unsigned int c = 0; c < 16; c++)
+		for (const vector<uint64_t> &range : ranges)
+			check_stats(segment, samples, c, range[0], range[1]);
+
+	// Ranges past the end are clipped
+	BOOST_CHECK_EQUAL(segment.get_channel_stats(0, Length - 10, 2 * Length).sample_count, 10);
+	BOOST_CHECK_EQUAL(segment.get_channel_stats(0, 2 * Length, 3 * Length).sample_count, 0);
+}
+
+BOOST_AUTO_TEST_CASE(RingBuffer)
+{
+	// Chunks of 10 MiB are only dropped as a whole, so the segment must
+	// span several of them
+	const uint64_t chunk_length = 10 * 1024 * 1024 / sizeof(uint16_t);
+	const uint64_t length = 3 * chunk_length + 5000;
+	const vector<uint16_t> samples = make_samples(length);
+	TestLogicData data(samples, chunk_length);
+	LogicSegment &segment = *data.segment;
+
+	const uint64_t first_sample = segment.get_first_sample();
+	BOOST_REQUIRE(first_sample > 0);
+
+	for (unsigned int c : {0, 9}) {
+		check_stats(segment, samples, c, 0, length);
+		check_stats(segment, samples, c, first_sample + 1, length - 1000);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/patternsearch.hpp>
+
+#include "logicdata.hpp"
+
+using pv::data::PatternSearch;
+using std::vector;
+
+static const uint64_t Length = 1000000;
+
+// Channel 0 is a clock, the others change rarely
+static vector<uint8_t> make_samples()
+{
+	return make_clock_samples(Length, 7, 7, 2000);
+}
+
+static vector<uint64_t> find_all(PatternSearch &search)
+{
+	vector<uint64_t> result;
+	search.find_all(0, Length, [&](const vector<uint64_t> &matches, uint64_t) {
+		result.insert(result.end(), matches.begin(), matches.end());
+		return true; });
+	return result;
+}
+
+BOOST_AUTO_TEST_SUITE(PatternSearchTest)
+
+BOOST_AUTO_TEST_CASE(EdgesAndLevels)
+{
+	const vector<uint8_t> samples = make_samples();
+	TestLogicData data(samples);
+
+	PatternSearch search(data.segment);
+	search.set_condition(0, PatternSearch::Rising);
+	search.set_condition(3, PatternSearch::Low);
+	search.set_condition(5, PatternSearch::High);
+
+	vector<uint64_t> expected;
+	for (uint64_t i : find_edges(samples, 0, 0, Length))
+		if ((samples[i] & 0x01) && !(samples[i] & 0x08) && (samples[i] & 0x20))
+			expected.push_back(i);
+
+	BOOST_REQUIRE(!expected.empty());
+	BOOST_CHECK(find_all(search) == expected);
+
+	uint64_t match;
+	BOOST_REQUIRE(search.find_next(expected[1], match));
+	BOOST_CHECK_EQUAL(match, expected[1]);
+	BOOST_REQUIRE(search.find_previous(expected[1], match));
+	BOOST_CHECK_EQUAL(match, expected[0]);
+	BOOST_CHECK(!search.find_previous(expected[0], match));
+}
+
+BOOST_AUTO_TEST_CASE(MinDuration)
+{
+	const vector<uint8_t> samples = make_samples();
+	const uint64_t min_duration = 5000;
+	TestLogicData data(samples);
+
+	PatternSearch search(data.segment);
+	search.set_condition(1, PatternSearch::High);
+	search.set_condition(2, PatternSearch::Low);
+	search.set_min_duration(min_duration);
+
+	// Runs of the levels that last long enough
+	vector<uint64_t> expected;
+	uint64_t run_start = 0;
+	for (uint64_t i = 0; i <= Length; i++) {
+		const bool in_run = (i < Length) && ((samples[i] & 0x06) == 0x02);
+		const bool was_in_run = (i > 0) && ((samples[i - 1] & 0x06) == 0x02);
+		if (in_run && !was_in_run)
+			run_start = i;
+		if (!in_run && was_in_run && (i - run_start >= min_duration))
+			expected.push_back(run_start);
+	}
+
+	BOOST_REQUIRE(!expected.empty());
+	BOOST_CHECK(find_all(search) == expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
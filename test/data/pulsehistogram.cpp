@@ -0,0 +1,115 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/pulsehistogram.hpp>
+
+#include "logicdata.hpp"
+
+using pv::data::PulseHistogram;
+using std::map;
+using std::vector;
+
+// Long enough to be split into several parts
+static const uint64_t Length = 10000000;
+
+// Channel 0 is a jittery clock with long gaps, channel 1 is idle
+static vector<uint8_t> make_samples()
+{
+	vector<uint8_t> samples(Length);
+	uint8_t state = 0;
+	uint64_t next_toggle = 0;
+
+	srand(1);
+	for (uint64_t i = 0; i < Length; i++) {
+		if (i == next_toggle) {
+			state ^= 0x01;
+			next_toggle += ((rand() % 1000) == 0) ? 5000 + rand() % 100000 :
+				45 + rand() % 10;
+		}
+		samples[i] = state;
+	}
+
+	return samples;
+}
+
+static void check_histogram(const PulseHistogram::Histogram &histogram,
+	const map<uint64_t, uint64_t> &expected)
+{
+	uint64_t count = 0;
+	for (const auto &entry : expected)
+		count += entry.second;
+
+	BOOST_REQUIRE_EQUAL(histogram.count(), count);
+	BOOST_REQUIRE(!expected.empty());
+	BOOST_CHECK_EQUAL(histogram.min_width(), expected.begin()->first);
+	BOOST_CHECK_EQUAL(histogram.max_width(), expected.rbegin()->first);
+
+	// A bin per width
+	const uint64_t first = histogram.min_width(), last = histogram.max_width();
+	const vector<uint64_t> bins = histogram.get_bins(first, last, last - first + 1);
+	for (uint64_t w = first; w <= last; w++) {
+		const auto it = expected.find(w);
+		BOOST_CHECK_EQUAL(bins[w - first], (it == expected.end()) ? 0 : it->second);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(PulseHistogramTest)
+
+BOOST_AUTO_TEST_CASE(Measurements)
+{
+	const vector<uint8_t> samples = make_samples();
+	TestLogicData data(samples);
+
+	const uint64_t start = 12345, end = Length - 6789;
+
+	map<uint64_t, uint64_t> expected[PulseHistogram::MeasurementCount];
+	const vector<uint64_t> edges = find_edges(samples, 0, start, end);
+
+	for (size_t e = 1; e < edges.size(); e++) {
+		const uint64_t width = edges[e] - edges[e - 1];
+		expected[PulseHistogram::EdgeInterval][width]++;
+		expected[samples[edges[e - 1]] ? PulseHistogram::HighTime :
+			PulseHistogram::LowTime][width]++;
+		if ((e >= 2) && samples[edges[e - 2]])
+			expected[PulseHistogram::Period][edges[e] - edges[e - 2]]++;
+	}
+
+	for (unsigned int threads : {1, 4}) {
+		PulseHistogram histogram(data.segment, 0);
+		BOOST_REQUIRE(histogram.compute(start, end, threads));
+
+		for (int m = 0; m < PulseHistogram::MeasurementCount; m++)
+			check_histogram(histogram.histogram((PulseHistogram::Measurement)m),
+				expected[m]);
+	}
+
+	// Without edges, there are no pulses
+	PulseHistogram idle(data.segment, 1);
+	BOOST_REQUIRE(idle.compute(0, Length));
+	BOOST_CHECK_EQUAL(idle.histogram(PulseHistogram::EdgeInterval).count(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,127 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/pulsesearch.hpp>
+
+#include "logicdata.hpp"
+
+using pv::data::PulseSearch;
+using std::numeric_limits;
+using std::vector;
+
+// Longer than a window of edges, so that pulses span windows
+static const uint64_t Length = 2500000;
+
+// Channel 0 toggles with random pulse widths from 1 to 40 samples, the
+// others only rarely
+static vector<uint8_t> make_samples()
+{
+	return make_clock_samples(Length, 1, 40, 100000);
+}
+
+// Returns the start of every complete pulse of a channel that matches
+static vector<uint64_t> find_pulses(const vector<uint8_t> &samples, int bit,
+	PulseSearch::Polarity polarity, uint64_t min_width, uint64_t max_width)
+{
+	vector<uint64_t> pulses;
+	const vector<uint64_t> edges = find_edges(samples, bit, 0, Length);
+
+	for (size_t e = 1; e < edges.size(); e++) {
+		const uint64_t pulse_start = edges[e - 1];
+		const bool high = (samples[pulse_start] >> bit) & 1;
+		const uint64_t width = edges[e] - pulse_start;
+		if (((polarity == PulseSearch::AllPulses) ||
+			(high == (polarity == PulseSearch::HighPulses))) &&
+			(width >= min_width) && (width <= max_width))
+			pulses.push_back(pulse_start);
+	}
+
+	return pulses;
+}
+
+static vector<uint64_t> find_all(PulseSearch &search)
+{
+	vector<uint64_t> result;
+	search.find_all(0, Length, [&](const vector<uint64_t> &matches, uint64_t) {
+		result.insert(result.end(), matches.begin(), matches.end());
+		return true; });
+	return result;
+}
+
+BOOST_AUTO_TEST_SUITE(PulseSearchTest)
+
+BOOST_AUTO_TEST_CASE(Widths)
+{
+	const vector<uint8_t> samples = make_samples();
+	TestLogicData data(samples);
+
+	{
+		PulseSearch search(data.segment, 0);
+		search.set_polarity(PulseSearch::HighPulses);
+		search.set_width_range(1, 2);
+
+		const vector<uint64_t> expected = find_pulses(samples, 0,
+			PulseSearch::HighPulses, 1, 2);
+		BOOST_REQUIRE(!expected.empty());
+		BOOST_CHECK(find_all(search) == expected);
+		BOOST_CHECK_EQUAL(search.narrowest_match(), 1);
+		BOOST_CHECK_EQUAL(search.widest_match(), 2);
+
+		uint64_t match;
+		BOOST_REQUIRE(search.find_next(expected[1], match));
+		BOOST_CHECK_EQUAL(match, expected[1]);
+		BOOST_REQUIRE(search.find_previous(expected[1], match));
+		BOOST_CHECK_EQUAL(match, expected[0]);
+		BOOST_CHECK(!search.find_previous(expected[0], match));
+	}
+
+	{
+		PulseSearch search(data.segment, 0);
+		search.set_polarity(PulseSearch::LowPulses);
+		search.set_width_range(20, 25);
+
+		BOOST_CHECK(find_all(search) == find_pulses(samples, 0,
+			PulseSearch::LowPulses, 20, 25));
+	}
+
+	{
+		PulseSearch search(data.segment, 1);
+		search.set_width_range(10000, numeric_limits<uint64_t>::max());
+
+		const vector<uint64_t> expected = find_pulses(samples, 1,
+			PulseSearch::AllPulses, 10000, numeric_limits<uint64_t>::max());
+		BOOST_REQUIRE(!expected.empty());
+		BOOST_CHECK(find_all(search) == expected);
+
+		uint64_t match, pulse_end = expected[0] + 1;
+		BOOST_REQUIRE(search.find_next(0, match));
+		while ((samples[pulse_end] & 0x02) == (samples[match] & 0x02))
+			pulse_end++;
+		BOOST_CHECK_EQUAL(match, expected[0]);
+		BOOST_CHECK_EQUAL(search.get_match_length(match), pulse_end - match);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,227 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <libsigrokdecode/libsigrokdecode.h> /* First, so we avoid a _POSIX_C_SOURCE warning. */
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/decode/arena.hpp>
+#include <pv/data/decode/decoder.hpp>
+#include <pv/data/decode/row.hpp>
+#include <pv/data/decode/rowdata.hpp>
+
+using std::deque;
+using std::get;
+using std::make_tuple;
+using std::tuple;
+using std::unique_ptr;
+using std::vector;
+
+using pv::data::decode::Annotation;
+using pv::data::decode::Arena;
+using pv::data::decode::Decoder;
+using pv::data::decode::Row;
+using pv::data::decode::RowData;
+using pv::data::decode::StableArray;
+
+BOOST_AUTO_TEST_SUITE(RowDataTest)
+
+BOOST_AUTO_TEST_CASE(StableArrayElements)
+{
+	StableArray<uint32_t> array;
+
+	// Elements don't move while the array grows over several blocks
+	array.push_back(0);
+	const uint32_t* const first = &array[0];
+
+	for (uint32_t i = 1; i < 100000; i++)
+		array.push_back(i * 3);
+
+	BOOST_CHECK(&array[0] == first);
+	BOOST_REQUIRE_EQUAL(array.size(), 100000);
+
+	for (uint32_t i = 0; i < 100000; i++)
+		BOOST_CHECK_EQUAL(array[i], i * 3);
+}
+
+BOOST_AUTO_TEST_CASE(StableIndices)
+{
+	Arena arena;
+	Row row;
+	RowData row_data(&row, &arena);
+
+	// Every fifth annotation starts earlier than its predecessors, and
+	// there are more annotations than fit into a chunk
+	const uint32_t count = 10 * RowData::ChunkLength;
+	const char* const texts = "Text\0";
+
+	for (uint32_t i = 0; i < count; i++) {
+		const uint64_t start = 100 + i * 10 - ((i % 5 == 4) ? 95 : 0);
+		BOOST_CHECK_EQUAL(row_data.emplace_annotation(start, start + 3,
+			i % 7, texts), i);
+	}
+
+	BOOST_REQUIRE_EQUAL(row_data.get_annotation_count(), count);
+
+	// Annotations that arrived out of order don't move the others
+	for (uint32_t i = 0; i < count; i++) {
+		const uint64_t start = 100 + i * 10 - ((i % 5 == 4) ? 95 : 0);
+		BOOST_CHECK_EQUAL(row_data.start_sample(i), start);
+		BOOST_CHECK_EQUAL(row_data.end_sample(i), start + 3);
+		BOOST_CHECK_EQUAL(row_data.ann_class_id(i), i % 7);
+	}
+
+	// The last annotation arrived out of order
+	BOOST_CHECK_EQUAL(row_data.get_max_sample(), 100 + (count - 2) * 10 + 3);
+}
+
+BOOST_AUTO_TEST_CASE(InternedTexts)
+{
+	Arena arena;
+	Row row;
+	RowData row_data(&row, &arena);
+
+	// The texts are packed, so snprintf() adds the terminating empty text
+	char text[16];
+	for (uint32_t i = 0; i < 1000; i++) {
+		snprintf(text, sizeof(text), "Value %u%cV%c", i % 100, '\0', '\0');
+		row_data.emplace_annotation(i, i + 1, 0, text);
+	}
+
+	// Annotations with the same longest text share their texts
+	BOOST_CHECK(row_data.texts(1) == row_data.texts(101));
+	BOOST_CHECK(row_data.texts(1) != row_data.texts(2));
+
+	const Annotation ann = row_data.get_annotation(42);
+	const vector<QString> texts = ann.annotations();
+
+	BOOST_REQUIRE_EQUAL(texts.size(), 2);
+	BOOST_CHECK(texts[0] == QString("Value 42"));
+	BOOST_CHECK(texts[1] == QString("V"));
+	BOOST_CHECK(ann.longest_annotation() == QString("Value 42"));
+}
+
+BOOST_AUTO_TEST_CASE(DroppedAnnotations)
+{
+	Arena arena;
+	Row row;
+	RowData row_data(&row, &arena);
+
+	// Enough annotations with distinct texts to fill several arena blocks
+	const uint32_t count = 100 * RowData::ChunkLength;
+	char text[16];
+	for (uint32_t i = 0; i < count; i++) {
+		snprintf(text, sizeof(text), "Value %u%c", i, '\0');
+		row_data.emplace_annotation(i * 10, i * 10 + 5, 0, text);
+	}
+
+	// Nothing is released while all annotations are in use
+	BOOST_CHECK(arena.release_blocks(0).empty());
+
+	const uint64_t first_sample = count * 10 / 2;
+	const vector< unique_ptr<uint8_t[]> > blocks = arena.release_blocks(first_sample);
+	BOOST_REQUIRE(!blocks.empty());
+	row_data.drop_released_annotations();
+
+	// Only annotations that end before the first sample were dropped
+	const uint32_t first_index = row_data.first_index();
+	BOOST_REQUIRE(first_index > 0);
+	BOOST_CHECK_EQUAL(first_index % RowData::ChunkLength, 0);
+	BOOST_CHECK((first_index - 1) * 10 + 5 <= first_sample);
+	BOOST_CHECK_EQUAL(row_data.get_annotation_count(), count - first_index);
+	BOOST_CHECK_EQUAL(row_data.start_sample(first_index), first_index * 10);
+
+	// Dropped annotations read as empty ones
+	BOOST_CHECK_EQUAL(row_data.end_sample(0), 0);
+	BOOST_CHECK(row_data.get_annotation(0).annotations().empty());
+
+	deque<Annotation> subset;
+	row_data.get_annotation_subset(subset, 0, count * 10);
+	BOOST_REQUIRE_EQUAL(subset.size(), count - first_index);
+	BOOST_CHECK_EQUAL(subset.front().index(), first_index);
+
+	// New annotations keep counting up
+	BOOST_CHECK_EQUAL(row_data.emplace_annotation(count * 10, count * 10 + 5, 0, "Text\0"), count);
+	BOOST_CHECK_EQUAL(row_data.get_annotation_count(), count + 1 - first_index);
+}
+
+BOOST_AUTO_TEST_CASE(AnnotationSubset)
+{
+	// A decoder with three annotation classes and no rows, so that all
+	// classes belong to its fallback row
+	char* ann_classes[3][2] = {
+		{(char*)"a", (char*)"A"}, {(char*)"b", (char*)"B"}, {(char*)"c", (char*)"C"}};
+
+	srd_decoder srd_dec = srd_decoder();
+	for (char** ann_class : ann_classes)
+		srd_dec.annotations = g_slist_append(srd_dec.annotations, ann_class);
+
+	Decoder dec(&srd_dec, 0);
+	Arena arena;
+	RowData row_data(dec.get_rows().front(), &arena);
+
+	// Mostly short annotations arriving slightly out of order, with a few
+	// long ones in between that the range queries must not miss
+	const char* const texts = "Text\0";
+	vector< tuple<uint64_t, uint64_t, uint32_t> > annotations;
+
+	srand(0);
+	for (uint32_t i = 0; i < 20000; i++) {
+		const uint64_t start = 3000 + i * 10 - ((rand() % 3 == 0) ? rand() % 3000 : 0);
+		const uint64_t end = start + ((rand() % 50 == 0) ? rand() % 100000 : rand() % 30);
+
+		row_data.emplace_annotation(start, end, i % 3, texts);
+		annotations.push_back(make_tuple(start, end, i % 3));
+	}
+
+	for (int pass = 0; pass < 2; pass++) {
+		// Hide a class for the second pass
+		dec.get_ann_class_by_id(1)->set_visible(pass == 0);
+
+		for (int i = 0; i < 500; i++) {
+			const uint64_t start = rand() % 250000;
+			const uint64_t end = start + rand() % 5000;
+
+			deque<Annotation> subset;
+			row_data.get_annotation_subset(subset, start, end);
+
+			size_t expected = 0;
+			for (const tuple<uint64_t, uint64_t, uint32_t>& a : annotations)
+				if ((get<1>(a) > start) && (get<0>(a) <= end) &&
+					((pass == 0) || (get<2>(a) != 1)))
+					expected++;
+
+			BOOST_REQUIRE_EQUAL(subset.size(), expected);
+
+			for (size_t j = 1; j < subset.size(); j++)
+				BOOST_CHECK(subset[j - 1].start_sample() <= subset[j].start_sample());
+		}
+	}
+
+	g_slist_free(srd_dec.annotations);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,12 +21,18 @@
 #include <extdef.h>
 
 #include <cstdint>
+#include <thread>
 
 #include <boost/test/unit_test.hpp>
 
+#include <pv/data/chunkpool.hpp>
 #include <pv/data/segment.hpp>
 
+using pv::data::ChunkPool;
 using pv::data::Segment;
+using std::make_shared;
+using std::shared_ptr;
+using std::thread;
 
 BOOST_AUTO_TEST_SUITE(SegmentTest)
 
@@ -296,4 +302,302 @@ BOOST_AUTO_TEST_CASE(MaxSize32MultiIterated)
 	s.end_sample_iteration(it);
 }
 
+BOOST_AUTO_TEST_CASE(DiskStorage)
+{
+	Segment s(0, 1, sizeof(uint32_t));
+	BOOST_REQUIRE(s.use_disk_storage(QString()));
+	BOOST_CHECK(s.uses_disk_storage());
+
+	// Span several mapped chunks
+	uint32_t num_samples = 3*(pv::data::Segment::MaxChunkSize / sizeof(uint32_t)) + 17;
+
+	uint32_t *data = new uint32_t[num_samples];
+	for (uint32_t i = 0; i < num_samples; i++)
+		data[i] = i;
+
+	s.append_samples(data, num_samples);
+	delete[] data;
+
+	BOOST_CHECK(s.get_sample_count() == num_samples);
+
+	// Must be a no-op for mapped chunks
+	s.free_unused_memory();
+
+	uint8_t *sample_data = new uint8_t[sizeof(uint32_t) * num_samples];
+	s.get_raw_samples(0, num_samples, sample_data);
+	for (uint32_t i = 0; i < num_samples; i++) {
+		BOOST_CHECK_EQUAL(*((uint32_t*)(sample_data + i * sizeof(uint32_t))), i);
+	}
+	delete[] sample_data;
+}
+
+BOOST_AUTO_TEST_CASE(DataViewSpans)
+{
+	Segment s(0, 1, sizeof(uint32_t));
+
+	const uint32_t chunk_samples = pv::data::Segment::MaxChunkSize / sizeof(uint32_t);
+	uint32_t num_samples = 2 * chunk_samples + 17;
+
+	uint32_t *data = new uint32_t[num_samples];
+	for (uint32_t i = 0; i < num_samples; i++)
+		data[i] = i;
+
+	s.append_samples(data, num_samples);
+	delete[] data;
+
+	// A range inside a single chunk must be a single span
+	{
+		const Segment::DataView view(s, 5, 100);
+		BOOST_REQUIRE_EQUAL(view.spans().size(), 1);
+		BOOST_CHECK_EQUAL(view.spans()[0].sample_count, 95);
+		BOOST_CHECK_EQUAL(*((const uint32_t*)view.spans()[0].data), 5);
+	}
+
+	// A range crossing chunk boundaries is split up at the boundaries
+	const uint32_t start = chunk_samples - 10;
+	const Segment::DataView view(s, start, num_samples);
+	BOOST_REQUIRE_EQUAL(view.spans().size(), 3);
+	BOOST_CHECK_EQUAL(view.spans()[0].sample_count, 10);
+	BOOST_CHECK_EQUAL(view.spans()[1].sample_count, chunk_samples);
+	BOOST_CHECK_EQUAL(view.spans()[2].sample_count, 17);
+
+	// The spans must stay valid while the view exists
+	s.free_unused_memory();
+
+	uint32_t expected = start;
+	for (const Segment::DataSpan& span : view.spans())
+		for (uint64_t i = 0; i < span.sample_count; i++)
+			BOOST_CHECK_EQUAL(((const uint32_t*)span.data)[i], expected++);
+
+	vector<uint8_t> buffer;
+	const uint32_t *contiguous = (const uint32_t*)view.contiguous_data(buffer);
+	for (uint32_t i = 0; i < num_samples - start; i++)
+		BOOST_CHECK_EQUAL(contiguous[i], start + i);
+}
+
+BOOST_AUTO_TEST_CASE(CompressedChunks)
+{
+	Segment s(0, 1, sizeof(uint32_t));
+	s.compress_chunks_ = true;
+
+	const uint32_t chunk_samples = pv::data::Segment::MaxChunkSize / sizeof(uint32_t);
+	uint32_t num_samples = 3 * chunk_samples + 17;
+
+	// First chunk is constant, second one has a few runs, third one is noise
+	uint32_t *data = new uint32_t[num_samples];
+	for (uint32_t i = 0; i < num_samples; i++) {
+		if (i < chunk_samples)
+			data[i] = 0x55;
+		else if (i < 2 * chunk_samples)
+			data[i] = i / 1000;
+		else
+			data[i] = i * 2654435761U;
+	}
+
+	s.append_samples(data, num_samples);
+
+	// The chunk that is still being filled must not be compressed
+	s.compress_chunks_before(num_samples);
+	BOOST_CHECK_EQUAL(s.get_compressed_chunk_count(), 2);
+
+	uint32_t *sample_data = new uint32_t[num_samples];
+	s.get_raw_samples(0, num_samples, (uint8_t*)sample_data);
+	for (uint32_t i = 0; i < num_samples; i++)
+		BOOST_CHECK_EQUAL(sample_data[i], data[i]);
+
+	// Access through data views, which decompress the samples themselves
+	const uint64_t ranges[][2] = {
+		{chunk_samples - 5, 2 * chunk_samples + 5},
+		{chunk_samples + 12345, chunk_samples + 23456},
+		{100, 200}};
+
+	for (const auto& range : ranges) {
+		const Segment::DataView view(s, range[0], range[1]);
+
+		uint32_t i = range[0];
+		for (const Segment::DataSpan& span : view.spans())
+			for (uint64_t j = 0; j < span.sample_count; j++, i++)
+				BOOST_CHECK_EQUAL(((const uint32_t*)span.data)[j], data[i]);
+		BOOST_CHECK_EQUAL(i, range[1]);
+	}
+
+	delete[] sample_data;
+	delete[] data;
+}
+
+BOOST_AUTO_TEST_CASE(PooledChunks)
+{
+	shared_ptr<ChunkPool> pool = make_shared<ChunkPool>();
+
+	const uint32_t chunk_samples = pv::data::Segment::MaxChunkSize / sizeof(uint32_t);
+	uint32_t num_samples = 2 * chunk_samples;
+
+	uint32_t *data = new uint32_t[num_samples];
+	for (uint32_t i = 0; i < num_samples; i++)
+		data[i] = i;
+
+	{
+		Segment s(0, 1, sizeof(uint32_t));
+		s.use_chunk_pool(pool);
+		s.append_samples(data, num_samples);
+
+		BOOST_CHECK(pool->used_size() >= num_samples * sizeof(uint32_t));
+		BOOST_CHECK_EQUAL(pool->pooled_size(), 0);
+	}
+
+	// The chunks are kept for the next segment
+	const uint64_t pooled_size = pool->pooled_size();
+	BOOST_CHECK_EQUAL(pool->used_size(), 0);
+	BOOST_CHECK(pooled_size >= num_samples * sizeof(uint32_t));
+
+	{
+		Segment s(0, 1, sizeof(uint32_t));
+		s.use_chunk_pool(pool);
+		s.append_samples(data, chunk_samples);
+
+		BOOST_CHECK(pool->pooled_size() < pooled_size);
+
+		uint32_t sample;
+		s.get_raw_samples(chunk_samples - 1, 1, (uint8_t*)&sample);
+		BOOST_CHECK_EQUAL(sample, chunk_samples - 1);
+	}
+
+	pool->trim();
+	BOOST_CHECK_EQUAL(pool->pooled_size(), 0);
+
+	// Allocations beyond the memory ceiling must fail
+	pool->set_memory_ceiling(pv::data::Segment::MaxChunkSize);
+	{
+		Segment s(0, 1, sizeof(uint32_t));
+		s.use_chunk_pool(pool);
+		BOOST_CHECK_THROW(s.append_samples(data, num_samples), std::bad_alloc);
+	}
+
+	delete[] data;
+}
+
+BOOST_AUTO_TEST_CASE(MemoryUsage)
+{
+	Segment s(0, 1, sizeof(uint32_t));
+	BOOST_CHECK_EQUAL(s.get_memory_usage(), 0);
+
+	const uint32_t chunk_samples = pv::data::Segment::MaxChunkSize / sizeof(uint32_t);
+	uint32_t num_samples = 2 * chunk_samples;
+
+	uint32_t *data = new uint32_t[num_samples];
+	for (uint32_t i = 0; i < num_samples; i++)
+		data[i] = 0x55;
+
+	s.append_samples(data, num_samples);
+
+	const uint64_t uncompressed_size = s.get_memory_usage();
+	BOOST_CHECK(uncompressed_size >= num_samples * sizeof(uint32_t));
+
+	// The first chunk is constant and shrinks to a single run
+	s.compress_chunks_ = true;
+	s.compress_chunks_before(num_samples);
+	BOOST_CHECK(s.get_memory_usage() < uncompressed_size);
+	BOOST_CHECK(s.get_memory_usage() >= chunk_samples * sizeof(uint32_t));
+
+	delete[] data;
+}
+
+BOOST_AUTO_TEST_CASE(RingBuffer)
+{
+	Segment s(0, 1, sizeof(uint32_t));
+
+	const uint32_t chunk_samples = pv::data::Segment::MaxChunkSize / sizeof(uint32_t);
+	s.set_sample_limit(chunk_samples);
+
+	uint32_t *data = new uint32_t[chunk_samples];
+
+	// Each chunk holds its number in all samples
+	for (uint32_t chunk = 0; chunk < 5; chunk++) {
+		for (uint32_t i = 0; i < chunk_samples; i++)
+			data[i] = chunk + 1;
+
+		s.append_samples(data, chunk_samples);
+		s.drop_old_chunks(s.get_sample_count());
+	}
+
+	BOOST_CHECK_EQUAL(s.get_sample_count(), 5 * chunk_samples);
+	BOOST_CHECK_EQUAL(s.get_first_sample(), 4 * chunk_samples);
+	BOOST_CHECK(s.get_memory_usage() <= 2 * (pv::data::Segment::MaxChunkSize + 7));
+
+	// Dropped samples read as zeros, indices stay absolute
+	uint32_t sample;
+	s.get_raw_samples(chunk_samples, 1, (uint8_t*)&sample);
+	BOOST_CHECK_EQUAL(sample, 0);
+	s.get_raw_samples(4 * chunk_samples + 1, 1, (uint8_t*)&sample);
+	BOOST_CHECK_EQUAL(sample, 5);
+
+	// The chunk being filled is kept even if it holds enough samples
+	data[0] = 6;
+	s.append_samples(data, 1);
+	s.drop_old_chunks(s.get_sample_count());
+	BOOST_CHECK_EQUAL(s.get_first_sample(), 4 * chunk_samples);
+
+	delete[] data;
+}
+
+// Records what the builder thread was asked to process
+class BuilderSegment : public Segment
+{
+public:
+	BuilderSegment() :
+		Segment(0, 1, sizeof(uint32_t)),
+		built_samples(0),
+		build_count(0)
+	{
+	}
+
+	~BuilderSegment()
+	{
+		stop_builder();
+	}
+
+	void build_derived_data()
+	{
+		built_samples = get_sample_count();
+		builder_id = std::this_thread::get_id();
+		build_count++;
+	}
+
+	uint64_t built_samples;
+	thread::id builder_id;
+	unsigned int build_count;
+};
+
+BOOST_AUTO_TEST_CASE(BackgroundBuilder)
+{
+	BuilderSegment s;
+	s.use_background_builder();
+
+	const uint32_t sample_count = 1000;
+	uint32_t *data = new uint32_t[sample_count];
+	for (uint32_t i = 0; i < sample_count; i++)
+		data[i] = i;
+
+	for (unsigned int i = 0; i < 100; i++) {
+		s.append_samples(data, sample_count);
+		s.update_derived_data();
+	}
+
+	// Completing the segment waits for the builder to catch up
+	s.set_complete();
+
+	BOOST_CHECK_EQUAL(s.built_samples, 100 * sample_count);
+	BOOST_CHECK_EQUAL(s.get_built_sample_count(), 100 * sample_count);
+	BOOST_CHECK(s.builder_id != std::this_thread::get_id());
+	BOOST_CHECK(s.build_count >= 1);
+
+	// Samples added later are processed right away
+	s.append_samples(data, sample_count);
+	s.update_derived_data();
+	BOOST_CHECK_EQUAL(s.built_samples, 101 * sample_count);
+	BOOST_CHECK(s.builder_id == std::this_thread::get_id());
+
+	delete[] data;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
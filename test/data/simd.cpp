@@ -0,0 +1,159 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * Copyright (C) 2026 The PulseView developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/simd.hpp>
+
+using std::pair;
+using std::vector;
+
+namespace simd = pv::data::simd;
+
+static const uint64_t BlockCount = 37;
+
+static vector<uint8_t> random_samples(unsigned int unit_size)
+{
+	// One extra sample in front, the edge kernel reads it as well
+	vector<uint8_t> samples((BlockCount * simd::BlockLength + 1) * unit_size);
+
+	srand(unit_size);
+	for (uint8_t& byte : samples)
+		byte = ((rand() % 8) == 0) ? rand() : 0x5a;
+
+	return samples;
+}
+
+BOOST_AUTO_TEST_SUITE(SimdTest)
+
+BOOST_AUTO_TEST_CASE(DownsampleEdges)
+{
+	if (!simd::available())
+		return;
+
+	for (unsigned int unit_size = 1; unit_size <= 8; unit_size++) {
+		const vector<uint8_t> samples = random_samples(unit_size);
+		const uint8_t *in = samples.data() + unit_size;
+
+		vector<uint8_t> out(BlockCount * unit_size);
+		simd::downsample_edges(in, out.data(), BlockCount, unit_size);
+
+		for (uint64_t block = 0; block < BlockCount; block++)
+			for (unsigned int byte = 0; byte < unit_size; byte++) {
+				uint8_t expected = 0;
+				for (unsigned int i = 0; i < simd::BlockLength; i++) {
+					const uint64_t pos = (block * simd::BlockLength + i) * unit_size + byte;
+					expected |= in[pos] ^ in[pos - unit_size];
+				}
+
+				BOOST_CHECK_EQUAL((int)out[block * unit_size + byte], (int)expected);
+			}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(ReduceOr)
+{
+	if (!simd::available())
+		return;
+
+	for (unsigned int unit_size = 1; unit_size <= 8; unit_size++) {
+		const vector<uint8_t> samples = random_samples(unit_size);
+		const uint8_t *in = samples.data();
+
+		vector<uint8_t> out(BlockCount * unit_size);
+		simd::reduce_or(in, out.data(), BlockCount, unit_size);
+
+		for (uint64_t block = 0; block < BlockCount; block++)
+			for (unsigned int byte = 0; byte < unit_size; byte++) {
+				uint8_t expected = 0;
+				for (unsigned int i = 0; i < simd::BlockLength; i++)
+					expected |= in[(block * simd::BlockLength + i) * unit_size + byte];
+
+				BOOST_CHECK_EQUAL((int)out[block * unit_size + byte], (int)expected);
+			}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TransposeBits)
+{
+	const uint64_t word_count = BlockCount * simd::BlockLength / simd::BitPlaneWordLength;
+
+	for (unsigned int unit_size = 1; unit_size <= 8; unit_size++) {
+		const vector<uint8_t> samples = random_samples(unit_size);
+		const uint8_t *in = samples.data();
+
+		// Leave a gap between the channels to check the stride
+		const uint64_t stride = word_count + 3;
+		vector<uint64_t> out(8 * unit_size * stride, 0);
+		simd::transpose_bits(in, out.data(), word_count, stride, unit_size);
+
+		for (unsigned int c = 0; c < 8 * unit_size; c++)
+			for (uint64_t w = 0; w < word_count; w++) {
+				uint64_t expected = 0;
+				for (unsigned int i = 0; i < simd::BitPlaneWordLength; i++) {
+					const uint64_t sample = w * simd::BitPlaneWordLength + i;
+					if (in[sample * unit_size + c / 8] & (1 << (c % 8)))
+						expected |= 1ULL << i;
+				}
+
+				BOOST_CHECK_EQUAL(out[c * stride + w], expected);
+			}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(GatherBits)
+{
+	const uint64_t count = BlockCount * simd::BlockLength;
+
+	for (unsigned int unit_size = 1; unit_size <= 8; unit_size++) {
+		const vector<uint8_t> samples = random_samples(unit_size);
+		const uint8_t *in = samples.data();
+
+		// Channels in order, reversed, and one used twice
+		const unsigned int top = 8 * unit_size - 1;
+		const vector< vector< pair<unsigned int, unsigned int> > > mappings = {
+			{{0, 0}, {3, 1}, {top, 5}},
+			{{top, 0}, {top / 2, 1}, {0, 2}},
+			{{1, 3}, {1, 4}, {top, 63}}};
+
+		for (const vector< pair<unsigned int, unsigned int> > &bits : mappings) {
+			const simd::BitGatherMap map(unit_size, bits);
+
+			// Other bits of the output are kept
+			vector<uint64_t> out(count, 1ULL << 62);
+			simd::gather_bits(in, out.data(), count, map);
+
+			for (uint64_t i = 0; i < count; i++) {
+				uint64_t expected = 1ULL << 62;
+				for (const pair<unsigned int, unsigned int> &b : bits)
+					if (in[i * unit_size + b.first / 8] & (1 << (b.first % 8)))
+						expected |= 1ULL << b.second;
+
+				BOOST_CHECK_EQUAL(out[i], expected);
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()